@@ -1,4 +1,5 @@
 #include "config.h"
+#include "../data_logger/data_logger.h"
 #include "usart.h"
 #include "stdio.h"
 #include "string.h"
@@ -7,6 +8,14 @@
 // 全局变量
 SystemConfig_t system_config;
 
+#define CONFIG_PAGE_ADDR(page)  (CONFIG_FLASH_ADDR + (u32)(page) * CONFIG_PAGE_SIZE)
+#define CONFIG_NO_PAGE          0xFF
+
+static u8 config_page = CONFIG_NO_PAGE;         // 当前追加的日志页（0或1）
+static u16 config_seq;                          // 当前日志页序号
+static u16 config_write_pos;                    // 下一条记录的页内偏移
+static u16 config_saved[CONFIG_ITEM_COUNT];     // 日志中各参数的最新值
+
 // 参数信息表
 const ConfigItemInfo_t config_items[CONFIG_ITEM_COUNT] = {
     {"temp_fan_on",     10, 50, DEFAULT_TEMP_FAN_ON,    "°C", "风扇开启温度"},
@@ -24,18 +33,92 @@ const ConfigItemInfo_t config_items[CONFIG_ITEM_COUNT] = {
     {"led_brightness",  0, 255, 255,                     "",   "LED亮度"},
     {"morning_start",   0,  23, DEFAULT_MORNING_START,   "h",  "白天开始时间"},
     {"night_start",     0,  23, DEFAULT_NIGHT_START,     "h",  "夜晚开始时间"},
-    {"auto_light_time", 0,1440, DEFAULT_AUTO_LIGHT_TIME, "min","自动补光时间"}
+    {"auto_light_time", 0,1440, DEFAULT_AUTO_LIGHT_TIME, "min","自动补光时间"},
+    {"log_op_pages",    2,   8, DEFAULT_LOG_OPERATION_PAGES, "", "操作记录页数"},
+    {"log_alarm_pages", 2,   8, DEFAULT_LOG_ALARM_PAGES, "",   "报警记录页数"}
 };
 
-// Flash操作函数
+// Flash操作函数：与数据记录器共用Flash占用，掉电中断不会在写配置中途写入记录并锁上Flash
 static void Config_Flash_Unlock(void)
 {
+    DataLogger_Acquire();
     FLASH_Unlock();
 }
 
 static void Config_Flash_Lock(void)
 {
     FLASH_Lock();
+    DataLogger_Release();
+}
+
+// CRC-8（多项式0x07），覆盖记录的item和value
+static u8 Config_CRC8(u8 item, u16 value)
+{
+    u8 data[3];
+    u8 crc = 0;
+    u8 i, bit;
+
+    data[0] = item;
+    data[1] = value & 0xFF;
+    data[2] = value >> 8;
+    for(i = 0; i < 3; i++)
+    {
+        crc ^= data[i];
+        for(bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+// 读取日志页头，无效页返回1
+static u8 Config_Read_Header(u8 page, u16* seq)
+{
+    const u32* header = (const u32*)CONFIG_PAGE_ADDR(page);
+
+    if(header[0] != CONFIG_JOURNAL_MAGIC) return 1;
+    if((u16)(header[1] >> 16) != (u16)~header[1]) return 1;
+    *seq = header[1] & 0xFFFF;
+    return 0;
+}
+
+// 写一条记录：先写value再写item/crc，只写了一半的记录CRC不符
+static u8 Config_Write_Entry(u32 addr, u8 item, u16 value)
+{
+    if(FLASH_ProgramHalfWord(addr + 2, value) != FLASH_COMPLETE) return 1;
+    if(FLASH_ProgramHalfWord(addr, item | ((u16)Config_CRC8(item, value) << 8)) != FLASH_COMPLETE) return 1;
+    return 0;
+}
+
+// 整理：擦除另一页，写入全部参数，最后写页头使新页生效；中途失败或掉电时原页仍然有效
+static u8 Config_Compact(void)
+{
+    u8 page = (config_page == 1) ? 0 : 1;
+    u32 addr = CONFIG_PAGE_ADDR(page);
+    u16 seq = config_seq + 1;
+    u16 pos = CONFIG_HEADER_SIZE;
+    u8 i;
+
+    if(FLASH_ErasePage(addr) != FLASH_COMPLETE) return 1;
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++, pos += CONFIG_ENTRY_SIZE)
+    {
+        if(Config_Write_Entry(addr + pos, i, Config_Get_U16((ConfigItem_t)i)) != 0) return 1;
+    }
+    if(FLASH_ProgramHalfWord(addr + 4, seq) != FLASH_COMPLETE ||
+       FLASH_ProgramHalfWord(addr + 6, (u16)~seq) != FLASH_COMPLETE ||
+       FLASH_ProgramHalfWord(addr, CONFIG_JOURNAL_MAGIC & 0xFFFF) != FLASH_COMPLETE ||
+       FLASH_ProgramHalfWord(addr + 2, CONFIG_JOURNAL_MAGIC >> 16) != FLASH_COMPLETE)
+    {
+        return 1;
+    }
+
+    config_page = page;
+    config_seq = seq;
+    config_write_pos = pos;
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++)
+    {
+        config_saved[i] = Config_Get_U16((ConfigItem_t)i);
+    }
+    return 0;
 }
 
 // 计算校验和
@@ -44,8 +127,9 @@ u32 Config_Calculate_Checksum(SystemConfig_t* config)
     u32 checksum = 0;
     u8* data = (u8*)config;
     u16 len = sizeof(SystemConfig_t) - sizeof(u32); // 不包括校验和字段
+    u16 i;
     
-    for(u16 i = 0; i < len; i++)
+    for(i = 0; i < len; i++)
     {
         checksum += data[i];
     }
@@ -91,6 +175,10 @@ static void Config_Set_Defaults(void)
     system_config.led_brightness = 255;   // 最大亮度
     system_config.auto_shutdown_enable = 0; // 禁用自动关机
     
+    // 数据记录配额
+    system_config.log_operation_pages = DEFAULT_LOG_OPERATION_PAGES;
+    system_config.log_alarm_pages = DEFAULT_LOG_ALARM_PAGES;
+    
     // 清空保留字段
     memset(system_config.reserved, 0, sizeof(system_config.reserved));
     
@@ -98,98 +186,180 @@ static void Config_Set_Defaults(void)
     system_config.checksum = Config_Calculate_Checksum(&system_config);
 }
 
+// 写入参数字段（不检查范围），设置命令和日志回放共用
+static u8 Config_Store(ConfigItem_t item, u16 value)
+{
+    switch(item)
+    {
+        case CONFIG_TEMP_FAN_ON:        system_config.temp_fan_on = value; break;
+        case CONFIG_TEMP_HIGH_ALARM:    system_config.temp_high_alarm = value; break;
+        case CONFIG_TEMP_LOW_ALARM:     system_config.temp_low_alarm = value; break;
+        case CONFIG_HUMI_PUMP_ON:       system_config.humi_pump_on = value; break;
+        case CONFIG_HUMI_HIGH_ALARM:    system_config.humi_high_alarm = value; break;
+        case CONFIG_HUMI_LOW_ALARM:     system_config.humi_low_alarm = value; break;
+        case CONFIG_LIGHT_AUTO_ON:      system_config.light_auto_on = value; break;
+        case CONFIG_LIGHT_LOW_ALARM:    system_config.light_low_alarm = value; break;
+        case CONFIG_SENSOR_INTERVAL:    system_config.sensor_interval = value; break;
+        case CONFIG_LOG_INTERVAL:       system_config.log_interval = value; break;
+        case CONFIG_AUTO_MODE_DEFAULT:  system_config.auto_mode_default = value; break;
+        case CONFIG_ALARM_SOUND_ENABLE: system_config.alarm_sound_enable = value; break;
+        case CONFIG_LED_BRIGHTNESS:     system_config.led_brightness = value; break;
+        case CONFIG_MORNING_START:      system_config.morning_start = value; break;
+        case CONFIG_NIGHT_START:        system_config.night_start = value; break;
+        case CONFIG_AUTO_LIGHT_TIME:    system_config.auto_light_time = value; break;
+        case CONFIG_LOG_OPERATION_PAGES: system_config.log_operation_pages = value; break;
+        case CONFIG_LOG_ALARM_PAGES:    system_config.log_alarm_pages = value; break;
+        default: return 1;
+    }
+    return 0;
+}
+
+// 读取旧格式（整页SystemConfig_t）的配置，用于迁移
+static u8 Config_Load_Legacy(void)
+{
+    const SystemConfig_t* flash_config = (const SystemConfig_t*)CONFIG_FLASH_ADDR;
+    SystemConfig_t config;
+    
+    if(flash_config->magic != CONFIG_MAGIC || flash_config->version != CONFIG_VERSION)
+    {
+        return 1;
+    }
+    
+    config = *flash_config;
+    if(Config_Calculate_Checksum(&config) != config.checksum)
+    {
+        return 1;
+    }
+    
+    // 记录配额占用的是旧格式的保留字段（为0），取默认值；保留字段同默认配置清零
+    config.log_operation_pages = DEFAULT_LOG_OPERATION_PAGES;
+    config.log_alarm_pages = DEFAULT_LOG_ALARM_PAGES;
+    memset(config.reserved, 0, sizeof(config.reserved));
+    config.checksum = Config_Calculate_Checksum(&config);
+    system_config = config;
+    return 0;
+}
+
 // 初始化配置系统
 u8 Config_Init(void)
 {
     printf("初始化配置系统...\r\n");
     
-    // 尝试从Flash加载配置
+    // 回放配置日志，没有日志时迁移旧格式配置或使用默认配置，并写入第一个日志页
     if(Config_Load() != 0)
     {
-        printf("配置加载失败，使用默认配置\r\n");
-        Config_Set_Defaults();
-        Config_Save();
+        if(Config_Load_Legacy() == 0)
+        {
+            printf("迁移旧格式配置到日志\r\n");
+        }
+        else
+        {
+            printf("配置加载失败，使用默认配置\r\n");
+            Config_Set_Defaults();
+        }
+        Config_Flash_Unlock();
+        if(Config_Compact() != 0) printf("配置日志写入失败\r\n");
+        Config_Flash_Lock();
     }
     
     printf("配置系统初始化完成\r\n");
     return 0;
 }
 
-// 从Flash加载配置
+// 从Flash加载配置：从默认值开始回放seq最大的有效日志页
 u8 Config_Load(void)
 {
-    SystemConfig_t* flash_config = (SystemConfig_t*)CONFIG_FLASH_ADDR;
+    u32 addr, entry;
+    u16 seq0, seq1, pos, value;
+    u8 valid0, valid1, item, i;
     
-    // 检查魔术字
-    if(flash_config->magic != CONFIG_MAGIC)
+    valid0 = (Config_Read_Header(0, &seq0) == 0);
+    valid1 = (Config_Read_Header(1, &seq1) == 0);
+    if(!valid0 && !valid1)
     {
-        printf("配置魔术字不匹配: 0x%08X\r\n", flash_config->magic);
+        printf("未找到配置日志\r\n");
         return 1;
     }
     
-    // 检查版本
-    if(flash_config->version != CONFIG_VERSION)
+    if(valid0 && (!valid1 || (s16)(seq0 - seq1) > 0))
     {
-        printf("配置版本不匹配: %d\r\n", flash_config->version);
-        return 1;
+        config_page = 0;
+        config_seq = seq0;
+    }
+    else
+    {
+        config_page = 1;
+        config_seq = seq1;
     }
     
-    // 复制配置到RAM
-    memcpy(&system_config, flash_config, sizeof(SystemConfig_t));
-    
-    // 验证校验和
-    u32 calculated_checksum = Config_Calculate_Checksum(&system_config);
-    if(calculated_checksum != system_config.checksum)
+    Config_Set_Defaults();
+    addr = CONFIG_PAGE_ADDR(config_page);
+    for(pos = CONFIG_HEADER_SIZE; pos + CONFIG_ENTRY_SIZE <= CONFIG_PAGE_SIZE; pos += CONFIG_ENTRY_SIZE)
     {
-        printf("配置校验和错误: 计算=%08X, 存储=%08X\r\n", 
-               calculated_checksum, system_config.checksum);
-        return 1;
+        entry = *(const u32*)(addr + pos);
+        if(entry == 0xFFFFFFFF) break;      // 追加顺序写入，第一个空槽之后都未使用
+        item = entry & 0xFF;
+        value = entry >> 16;
+        if(item < CONFIG_ITEM_COUNT && ((entry >> 8) & 0xFF) == Config_CRC8(item, value))
+        {
+            Config_Store((ConfigItem_t)item, value);
+        }
+        // 残缺记录跳过，槽位不再使用
     }
+    config_write_pos = pos;
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++)
+    {
+        config_saved[i] = Config_Get_U16((ConfigItem_t)i);
+    }
+    system_config.checksum = Config_Calculate_Checksum(&system_config);
     
-    printf("配置加载成功\r\n");
+    printf("配置加载成功（日志页%d，%d条记录）\r\n", config_page,
+           (config_write_pos - CONFIG_HEADER_SIZE) / CONFIG_ENTRY_SIZE);
     return 0;
 }
 
-// 保存配置到Flash
+// 保存配置到Flash：为有变化的参数追加记录，页满时整理到另一页
 u8 Config_Save(void)
 {
-    FLASH_Status status;
-    u32* data_ptr = (u32*)&system_config;
-    u32 addr = CONFIG_FLASH_ADDR;
-    
-    printf("保存配置到Flash...\r\n");
+    u8 status = 0;
+    u8 appended = 0;
+    u8 i;
+    u16 value;
     
-    // 更新校验和
-    system_config.checksum = Config_Calculate_Checksum(&system_config);
-    
-    // 解锁Flash
     Config_Flash_Unlock();
-    
-    // 擦除页
-    status = FLASH_ErasePage(CONFIG_FLASH_ADDR);
-    if(status != FLASH_COMPLETE)
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++)
     {
-        printf("Flash页擦除失败: %d\r\n", status);
-        Config_Flash_Lock();
-        return 1;
-    }
-    
-    // 写入数据
-    for(u16 i = 0; i < sizeof(SystemConfig_t) / 4; i++)
-    {
-        status = FLASH_ProgramWord(addr + i * 4, data_ptr[i]);
-        if(status != FLASH_COMPLETE)
+        value = Config_Get_U16((ConfigItem_t)i);
+        if(value == config_saved[i]) continue;
+        
+        if(config_page == CONFIG_NO_PAGE || config_write_pos + CONFIG_ENTRY_SIZE > CONFIG_PAGE_SIZE)
+        {
+            // 整理写入全部参数，本次剩余的修改也包含在内
+            status = Config_Compact();
+            if(status == 0) printf("配置日志已整理到页%d\r\n", config_page);
+            break;
+        }
+        
+        status = Config_Write_Entry(CONFIG_PAGE_ADDR(config_page) + config_write_pos, i, value);
+        if(status != 0)
         {
-            printf("Flash写入失败: 地址0x%08X, 状态%d\r\n", addr + i * 4, status);
-            Config_Flash_Lock();
-            return 1;
+            // 写入失败的槽位可能仍为空，回放时会当作日志末尾而丢掉其后的记录，下次保存整理到另一页
+            config_write_pos = CONFIG_PAGE_SIZE;
+            break;
         }
+        config_write_pos += CONFIG_ENTRY_SIZE;
+        config_saved[i] = value;
+        appended++;
     }
-    
-    // 锁定Flash
     Config_Flash_Lock();
     
-    printf("配置保存成功\r\n");
+    system_config.checksum = Config_Calculate_Checksum(&system_config);
+    if(status != 0)
+    {
+        printf("配置日志写入失败\r\n");
+        return 1;
+    }
+    printf("配置已保存，追加%d条记录\r\n", appended);
     return 0;
 }
 
@@ -253,6 +423,8 @@ u8 Config_Get_U8(ConfigItem_t item)
         case CONFIG_LED_BRIGHTNESS:     return system_config.led_brightness;
         case CONFIG_MORNING_START:      return system_config.morning_start;
         case CONFIG_NIGHT_START:        return system_config.night_start;
+        case CONFIG_LOG_OPERATION_PAGES: return system_config.log_operation_pages;
+        case CONFIG_LOG_ALARM_PAGES:    return system_config.log_alarm_pages;
         default: return 0;
     }
 }
@@ -280,25 +452,7 @@ u8 Config_Set_U8(ConfigItem_t item, u8 value)
         return 1;
     }
     
-    switch(item)
-    {
-        case CONFIG_TEMP_FAN_ON:        system_config.temp_fan_on = value; break;
-        case CONFIG_TEMP_HIGH_ALARM:    system_config.temp_high_alarm = value; break;
-        case CONFIG_TEMP_LOW_ALARM:     system_config.temp_low_alarm = value; break;
-        case CONFIG_HUMI_PUMP_ON:       system_config.humi_pump_on = value; break;
-        case CONFIG_HUMI_HIGH_ALARM:    system_config.humi_high_alarm = value; break;
-        case CONFIG_HUMI_LOW_ALARM:     system_config.humi_low_alarm = value; break;
-        case CONFIG_LIGHT_AUTO_ON:      system_config.light_auto_on = value; break;
-        case CONFIG_LIGHT_LOW_ALARM:    system_config.light_low_alarm = value; break;
-        case CONFIG_SENSOR_INTERVAL:    system_config.sensor_interval = value; break;
-        case CONFIG_LOG_INTERVAL:       system_config.log_interval = value; break;
-        case CONFIG_AUTO_MODE_DEFAULT:  system_config.auto_mode_default = value; break;
-        case CONFIG_ALARM_SOUND_ENABLE: system_config.alarm_sound_enable = value; break;
-        case CONFIG_LED_BRIGHTNESS:     system_config.led_brightness = value; break;
-        case CONFIG_MORNING_START:      system_config.morning_start = value; break;
-        case CONFIG_NIGHT_START:        system_config.night_start = value; break;
-        default: return 1;
-    }
+    if(Config_Store(item, value) != 0) return 1;
     
     printf("设置参数: %s = %d%s\r\n", info->name, value, info->unit);
     return 0;
@@ -315,7 +469,7 @@ u8 Config_Set_U16(ConfigItem_t item, u16 value)
                 printf("自动补光时间超出范围: %d分钟\r\n", value);
                 return 1;
             }
-            system_config.auto_light_time = value;
+            Config_Store(item, value);
             printf("设置参数: auto_light_time = %d分钟\r\n", value);
             return 0;
         default:
@@ -340,13 +494,17 @@ u8 Config_Set_All(SystemConfig_t* config)
 // 打印所有配置
 void Config_Print_All(void)
 {
+    u8 i;
+    
     printf("=== 系统配置参数 ===\r\n");
     
-    for(u8 i = 0; i < CONFIG_ITEM_COUNT; i++)
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++)
     {
         Config_Print_Item((ConfigItem_t)i);
     }
     
+    printf("日志页%d: 已用%d/%d条\r\n", config_page,
+           (config_write_pos - CONFIG_HEADER_SIZE) / CONFIG_ENTRY_SIZE, CONFIG_PAGE_ENTRIES);
     printf("==================\r\n");
 }
 
@@ -382,6 +540,7 @@ void Config_Handle_Command(char* cmd)
     char* param_name;
     char* param_value;
     int value;
+    u8 i;
     
     // 解析命令
     token = strtok(cmd, " ");
@@ -398,7 +557,7 @@ void Config_Handle_Command(char* cmd)
         }
         
         // 查找参数
-        for(u8 i = 0; i < CONFIG_ITEM_COUNT; i++)
+        for(i = 0; i < CONFIG_ITEM_COUNT; i++)
         {
             if(strstr(config_items[i].name, param_name))
             {
@@ -422,7 +581,7 @@ void Config_Handle_Command(char* cmd)
         value = atoi(param_value);
         
         // 查找并设置参数
-        for(u8 i = 0; i < CONFIG_ITEM_COUNT; i++)
+        for(i = 0; i < CONFIG_ITEM_COUNT; i++)
         {
             if(strstr(config_items[i].name, param_name))
             {
@@ -8,7 +8,21 @@
 
 // 配置存储地址（使用BKP寄存器和Flash）
 #define CONFIG_FLASH_ADDR   0x0806F000  // 使用Flash最后4KB存储配置
-#define CONFIG_MAGIC        0x5A5A5A5A  // 配置有效标志
+#define CONFIG_MAGIC        0x5A5A5A5A  // 配置有效标志（旧格式整页存储，上电时迁移到日志）
+
+// 配置日志：CONFIG_FLASH_ADDR起两页交替使用，只追加不改写
+//   页头    magic(4) + seq(2) + ~seq(2)，先写seq后写magic，magic完整且seq与反码相符才是有效页
+//           （擦除中途掉电的页头可能残缺，反码校验防止旧页被误认为较新）
+//   记录    item(1) + crc(1) + value(2)，crc为CRC-8覆盖item和value，先写value后写item/crc
+// Config_Save只为与日志中最新值不同的参数追加一条记录；当前页写满时把全部参数写到另一页，
+// 页头最后写入（seq加1），之后在新页继续追加，一页只在整理时擦除一次。
+// 上电时取seq最大的有效页，从默认值开始按顺序回放；写入中途掉电留下的残缺页头或记录被忽略
+// 只记录ConfigItem_t中的参数，其余字段（滞回、保留字段等）上电后为默认值
+#define CONFIG_PAGE_SIZE        2048        // Flash页大小
+#define CONFIG_JOURNAL_MAGIC    0x4A474643  // 日志页有效标志 "CFGJ"
+#define CONFIG_HEADER_SIZE      8           // 页头长度
+#define CONFIG_ENTRY_SIZE       4           // 每条记录长度
+#define CONFIG_PAGE_ENTRIES     ((CONFIG_PAGE_SIZE - CONFIG_HEADER_SIZE) / CONFIG_ENTRY_SIZE)   // 每页记录数
 
 // 默认配置参数
 #define DEFAULT_TEMP_FAN_ON         30  // 温度超过30°C开启风扇
@@ -25,6 +39,8 @@
 #define DEFAULT_SENSOR_INTERVAL     2   // 传感器读取间隔（秒）
 #define DEFAULT_LOG_INTERVAL        10  // 数据记录间隔（秒）
 #define DEFAULT_AUTO_HYSTERESIS     2   // 自动控制滞回值
+#define DEFAULT_LOG_OPERATION_PAGES 4   // 操作记录环页数（每页126条）
+#define DEFAULT_LOG_ALARM_PAGES     3   // 报警记录环页数（每页126条）
 
 // 时间相关默认值
 #define DEFAULT_MORNING_START       6   // 早晨开始时间
@@ -69,8 +85,12 @@ typedef struct
     u8  led_brightness;     // LED亮度（0-255）
     u8  auto_shutdown_enable; // 自动关机使能（夜间节能）
     
+    // 数据记录保留配额（修改后重启生效，被重新划分的页上的记录丢弃）
+    u8  log_operation_pages; // 操作记录环页数
+    u8  log_alarm_pages;    // 报警记录环页数
+    
     // 备用参数
-    u8  reserved[16];       // 保留字段
+    u8  reserved[14];       // 保留字段
     
     u32 checksum;           // 校验和
 } __attribute__((packed)) SystemConfig_t;
@@ -94,6 +114,8 @@ typedef enum
     CONFIG_MORNING_START,
     CONFIG_NIGHT_START,
     CONFIG_AUTO_LIGHT_TIME,
+    CONFIG_LOG_OPERATION_PAGES,
+    CONFIG_LOG_ALARM_PAGES,
     CONFIG_ITEM_COUNT
 } ConfigItem_t;
 
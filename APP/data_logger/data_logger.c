@@ -1,134 +1,937 @@
 #include "data_logger.h"
+#include "data_rollup.h"
+#include "../config/config.h"
 #include "stm32f10x.h"
 #include "string.h"
 #include "stdio.h"
 
 DataLoggerInfo_t logger_info;
 
+#define LOG_PAGE_ADDR(page)         (FLASH_START_ADDR + (u32)(page) * FLASH_PAGE_SIZE)
+#define LOG_SLOT_ADDR(page, slot)   (LOG_PAGE_ADDR(page) + (u32)(slot) * LOG_RECORD_SIZE)
+#define LOG_PAGE_HEADER(page)       ((const LogPageHeader_t*)LOG_PAGE_ADDR(page))
+#define LOG_SLOT_USED(addr)         (*(volatile u32*)(addr) != 0xFFFFFFFF)
+
+// 记录环：占用[first_page, first_page + page_count)内的页，环内按页循环写入
+typedef struct
+{
+    u16 first_page;         // 首页
+    u16 page_count;         // 页数
+    u16 current_page;       // 当前写入页
+    u16 current_offset;     // 当前页内下一写入槽（0-本页未打开，LOG_SLOTS_PER_PAGE-已写满）
+    u16 oldest_page;        // 最旧的有效页
+    u8  head_open;          // head是否有效
+    u8  next_ready;         // 写入页的下一页已预擦除
+    LogPageHeader_t head;   // 当前写入页的页头及RAM中的统计
+} LogRing_t;
+
+static LogRing_t log_rings[LOG_RING_COUNT];
+
+// 写合并暂存区：记录先进入RAM，攒满LOG_STAGE_RECORDS条、超过LOG_FLUSH_INTERVAL_MS、
+// 写入报警记录或掉电检测时一次性写入Flash
+static LogRecord_t log_stage[LOG_STAGE_RECORDS];
+static u8 log_stage_count = 0;
+static u32 log_stage_time;              // 暂存区第一条记录的system_time_ms
+static volatile u8 log_busy = 0;        // Flash占用嵌套计数（DataLogger_Acquire），非0时PVD中断不可直接写Flash
+static volatile u8 log_flush_req = 0;   // PVD中断请求的写入，由最外层DataLogger_Release完成
+
+extern volatile u32 system_time_ms;
+
 static u8 DataLogger_WriteRecord(LogRecord_t* record);
-static u8 DataLogger_ReadRecord(u32 addr, LogRecord_t* record);
 static u8 DataLogger_ErasePage(u16 page);
 static u32 DataLogger_GetTimestamp(void);
+#if LOG_USE_PVD
+static void DataLogger_PVD_Init(void);
+#endif
 
-u8 DataLogger_Init(void)
+/**
+ * @brief  物理页所属的记录环
+ */
+static u8 DataLogger_PageRing(u16 page)
 {
-    u32 addr;
-    LogRecord_t record;
-    u16 page_records;
-    u16 page;
-    u16 offset;
+    u8 r;
 
-    printf("Initializing data logger...\r\n");
-    memset(&logger_info, 0, sizeof(logger_info));
+    for(r = 0; r < LOG_RING_COUNT - 1; r++)
+    {
+        if(page < log_rings[r].first_page + log_rings[r].page_count) break;
+    }
+    return r;
+}
+
+/**
+ * @brief  记录类型所在的记录环
+ */
+static u8 DataLogger_TypeRing(u8 log_type)
+{
+    switch(log_type)
+    {
+        case LOG_TYPE_OPERATION:
+        case LOG_TYPE_SYSTEM:    return LOG_RING_OPERATION;
+        case LOG_TYPE_ALARM:     return LOG_RING_ALARM;
+        default:                 return LOG_RING_SENSOR;
+    }
+}
+
+static u8 DataLogger_PageValid(u16 page)
+{
+    return LOG_PAGE_HEADER(page)->magic == LOG_PAGE_MAGIC &&
+           LOG_PAGE_HEADER(page)->ring == DataLogger_PageRing(page);
+}
+
+/**
+ * @brief  计算记录的提交字节：前LOG_RECORD_SIZE-1字节的CRC-8，0xFF（未编程）改为0xFE
+ */
+static u8 DataLogger_CommitByte(const LogRecord_t* rec)
+{
+    u8 crc = 0, i, b;
+
+    for(i = 0; i < LOG_RECORD_SIZE - 1; i++)
+    {
+        crc ^= rec->raw_data[i];
+        for(b = 0; b < 8; b++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return (crc == LOG_COMMIT_NONE) ? 0xFE : crc;
+}
+
+/**
+ * @brief  槽内是否为完整提交的记录
+ * @note   写入中掉电的槽已被占用（LOG_SLOT_USED）但提交字节不符，读取时跳过，下一条记录写在其后
+ */
+static u8 DataLogger_SlotValid(u32 addr)
+{
+    const LogRecord_t* rec = (const LogRecord_t*)addr;
+
+    return LOG_SLOT_USED(addr) && rec->raw_data[LOG_RECORD_SIZE - 1] == DataLogger_CommitByte(rec);
+}
+
+#define PACK_DT(d)      (((d) & 0x0F) + 1)
+#define PACK_DTEMP(d)   ((s8)((((d) >> 4) & 0x07) ^ 0x04) - 4)
+#define PACK_DHUMI(d)   ((s8)((((d) >> 7) & 0x0F) ^ 0x08) - 8)
+#define PACK_DLIGHT(d)  ((s8)((((d) >> 11) & 0x1F) ^ 0x10) - 16)
+
+/**
+ * @brief  压缩记录的样本数
+ */
+static u8 DataLogger_PackCount(const SensorPackRecord_t* pack)
+{
+    u8 n = 1;
+
+    while(n < LOG_PACK_SAMPLES && pack->delta[n - 1] != 0xFFFF) n++;
+    return n;
+}
+
+/**
+ * @brief  展开压缩记录
+ * @param  out: 输出样本数组，至少LOG_PACK_SAMPLES个
+ * @retval 样本数
+ */
+static u8 DataLogger_PackUnpack(const SensorPackRecord_t* pack, SensorLogRecord_t* out)
+{
+    u8 i, n = DataLogger_PackCount(pack);
+    u16 d;
+
+    memset(out, 0, sizeof(SensorLogRecord_t));
+    out->timestamp = pack->timestamp;
+    out->log_type = LOG_TYPE_SENSOR;
+    out->temperature = pack->temperature;
+    out->humidity = pack->humi_fan & 0x7F;
+    out->light = pack->light_pump & 0x7F;
+    out->fan_status = pack->humi_fan >> 7;
+    out->pump_status = pack->light_pump >> 7;
+    out->light_status = (pack->flags >> 6) & 0x01;
+    out->work_mode = pack->flags >> 7;
+    out->alarm_flags = pack->flags & 0x3F;
+
+    for(i = 1; i < n; i++)
+    {
+        d = pack->delta[i - 1];
+        out[i] = out[i - 1];
+        out[i].timestamp += PACK_DT(d);
+        out[i].temperature += PACK_DTEMP(d);
+        out[i].humidity += PACK_DHUMI(d);
+        out[i].light += PACK_DLIGHT(d);
+    }
+    return n;
+}
+
+/**
+ * @brief  以一个样本开始一条压缩记录
+ * @retval 1-成功，0-样本超出压缩格式范围（按普通记录保存）
+ */
+static u8 DataLogger_PackStart(LogRecord_t* record, const SensorLogRecord_t* s)
+{
+    if(s->humidity > 0x7F || s->light > 0x7F || s->alarm_flags > 0x3F ||
+       s->fan_status > 1 || s->pump_status > 1 || s->light_status > 1 || s->work_mode > 1)
+        return 0;
+
+    memset(record, 0xFF, sizeof(LogRecord_t));
+    record->pack.timestamp = s->timestamp;
+    record->pack.log_type = LOG_TYPE_SENSOR_PACK;
+    record->pack.temperature = s->temperature;
+    record->pack.humi_fan = s->humidity | (s->fan_status << 7);
+    record->pack.light_pump = s->light | (s->pump_status << 7);
+    record->pack.flags = s->alarm_flags | (s->light_status << 6) | (s->work_mode << 7);
+    return 1;
+}
+
+/**
+ * @brief  向压缩记录追加一个样本
+ * @retval 1-成功，0-记录已满、状态变化或增量超出范围
+ */
+static u8 DataLogger_PackAppend(SensorPackRecord_t* pack, const SensorLogRecord_t* s)
+{
+    SensorLogRecord_t prev[LOG_PACK_SAMPLES];
+    s32 dt, dtemp, dhumi, dlight;
+    u8 n;
+    u16 d;
+
+    n = DataLogger_PackUnpack(pack, prev);
+    if(n >= LOG_PACK_SAMPLES) return 0;
+    if(s->fan_status != prev[0].fan_status || s->pump_status != prev[0].pump_status ||
+       s->light_status != prev[0].light_status || s->work_mode != prev[0].work_mode ||
+       s->alarm_flags != prev[0].alarm_flags)
+        return 0;
+
+    dt = (s32)(s->timestamp - prev[n - 1].timestamp);
+    dtemp = (s32)s->temperature - prev[n - 1].temperature;
+    dhumi = (s32)s->humidity - prev[n - 1].humidity;
+    dlight = (s32)s->light - prev[n - 1].light;
+    if(dt < 1 || dt > 16 || dtemp < -4 || dtemp > 3 || dhumi < -8 || dhumi > 7 || dlight < -16 || dlight > 15)
+        return 0;
+
+    d = (u16)((dt - 1) | ((dtemp & 0x07) << 4) | ((dhumi & 0x0F) << 7) | ((dlight & 0x1F) << 11));
+    if(d == 0xFFFF) return 0;
+    pack->delta[n - 1] = d;
+    return 1;
+}
+
+/**
+ * @brief  累加一条记录到页统计
+ */
+static void DataLogger_CountRecord(LogPageHeader_t* stat, const LogRecord_t* rec)
+{
+    SensorLogRecord_t samples[LOG_PACK_SAMPLES];
+    u8 n;
 
-    for(page = 0; page < (FLASH_END_ADDR - FLASH_START_ADDR + 1) / FLASH_PAGE_SIZE; page++)
+    switch(rec->sensor.log_type)
     {
-        page_records = 0;
-        for(offset = 0; offset < LOG_RECORDS_PER_PAGE; offset++)
+        case LOG_TYPE_SENSOR:    stat->sensor_count++;    break;
+        case LOG_TYPE_OPERATION: stat->operation_count++; break;
+        case LOG_TYPE_ALARM:     stat->alarm_count++;     break;
+        case LOG_TYPE_SENSOR_PACK:
+            n = DataLogger_PackUnpack(&rec->pack, samples);
+            stat->sensor_count += n;
+            stat->last_timestamp = samples[n - 1].timestamp;
+            return;
+    }
+    stat->last_timestamp = rec->sensor.timestamp;
+}
+
+/**
+ * @brief  逐条扫描一页，统计记录数和首末时间戳
+ * @param  stat: 输出统计，magic/seq取自页头
+ * @retval 已使用的记录槽数（含掉电时未写完的槽，不计入统计）
+ */
+static u16 DataLogger_ScanPage(u16 page, LogPageHeader_t* stat)
+{
+    const LogRecord_t* rec;
+    u16 slot;
+
+    *stat = *LOG_PAGE_HEADER(page);
+    stat->last_timestamp = stat->first_timestamp;
+    stat->sensor_count = 0;
+    stat->operation_count = 0;
+    stat->alarm_count = 0;
+    stat->sealed = 0xFFFF;
+
+    for(slot = LOG_HEADER_SLOTS; slot < LOG_SLOTS_PER_PAGE; slot++)
+    {
+        if(!LOG_SLOT_USED(LOG_SLOT_ADDR(page, slot))) break;
+        if(!DataLogger_SlotValid(LOG_SLOT_ADDR(page, slot))) continue;
+        rec = (const LogRecord_t*)LOG_SLOT_ADDR(page, slot);
+        DataLogger_CountRecord(stat, rec);
+    }
+    return slot - LOG_HEADER_SLOTS;
+}
+
+/**
+ * @brief  获取一页的统计：已封页直接读页头，否则扫描该页
+ */
+static void DataLogger_PageStats(u16 page, LogPageHeader_t* stat)
+{
+    if(LOG_PAGE_HEADER(page)->sealed == LOG_PAGE_SEALED)
+        *stat = *LOG_PAGE_HEADER(page);
+    else
+        DataLogger_ScanPage(page, stat);
+}
+
+/**
+ * @brief  查找环的当前写入页（序号最新的页）
+ * @retval 页号，无有效页时返回LOG_PAGE_NONE
+ * @note   环内的页循环使用，以首页为锚点时[首页, head]内序号逐页加1，
+ *         head之后是上一轮的旧页或空页，因此可二分查找；首页无效（如擦除后掉电）时逐页比较序号
+ */
+static u16 DataLogger_FindHead(const LogRing_t* ring)
+{
+    u16 first = ring->first_page;
+    u16 base_seq;
+    u16 lo, hi, mid;
+    u16 page, head = LOG_PAGE_NONE;
+
+    if(DataLogger_PageValid(first))
+    {
+        base_seq = LOG_PAGE_HEADER(first)->seq;
+        lo = 0;
+        hi = ring->page_count - 1;
+        while(lo < hi)
         {
-            addr = FLASH_START_ADDR + page * FLASH_PAGE_SIZE + offset * LOG_RECORD_SIZE;
-            if(DataLogger_ReadRecord(addr, &record) == 0)
-            {
-                if(record.raw_data[0] != 0xFF)
-                {
-                    page_records++;
-                    logger_info.total_records++;
-                    switch(record.sensor.log_type)
-                    {
-                        case LOG_TYPE_SENSOR:    logger_info.sensor_records++;    break;
-                        case LOG_TYPE_OPERATION: logger_info.operation_records++; break;
-                        case LOG_TYPE_ALARM:     logger_info.alarm_records++;     break;
-                    }
-                    if(logger_info.oldest_timestamp == 0 || record.sensor.timestamp < logger_info.oldest_timestamp)
-                        logger_info.oldest_timestamp = record.sensor.timestamp;
-                    if(record.sensor.timestamp > logger_info.newest_timestamp)
-                        logger_info.newest_timestamp = record.sensor.timestamp;
-                    logger_info.current_page = page;
-                    logger_info.current_offset = offset + 1;
-                }
-                else
-                {
-                    goto end_scan;
-                }
-            }
+            mid = (lo + hi + 1) / 2;
+            if(DataLogger_PageValid(first + mid) && (u16)(LOG_PAGE_HEADER(first + mid)->seq - base_seq) == mid)
+                lo = mid;
+            else
+                hi = mid - 1;
         }
+        return first + lo;
     }
-end_scan:
-    if(logger_info.current_offset >= LOG_RECORDS_PER_PAGE)
+
+    for(page = first + 1; page < first + ring->page_count; page++)
     {
-        logger_info.current_page++;
-        logger_info.current_offset = 0;
+        if(!DataLogger_PageValid(page)) continue;
+        if(head == LOG_PAGE_NONE || (s16)(LOG_PAGE_HEADER(page)->seq - LOG_PAGE_HEADER(head)->seq) > 0)
+            head = page;
     }
-    printf("Data logger initialized. Records: %lu\r\n", logger_info.total_records);
-    return 0;
+    return head;
 }
 
-static u32 DataLogger_GetTimestamp(void)
+/**
+ * @brief  环内page之后第n页的物理页号
+ */
+static u16 DataLogger_RingPage(const LogRing_t* ring, u16 page, u16 n)
 {
-    return RTC_GetCounter();
+    return ring->first_page + (page - ring->first_page + n) % ring->page_count;
 }
 
-static u8 DataLogger_WriteRecord(LogRecord_t* record)
+/**
+ * @brief  更新环的最旧页：从写入页的下一页开始找第一个有效页；最旧记录时间戳取各环中最早的
+ */
+static void DataLogger_UpdateOldest(LogRing_t* ring)
 {
-    u32 addr;
+    u32 ts;
+    u16 i, page;
+    u8 r;
+
+    ring->oldest_page = LOG_PAGE_NONE;
+    for(i = 1; i <= ring->page_count; i++)
+    {
+        page = DataLogger_RingPage(ring, ring->current_page, i);
+        if(DataLogger_PageValid(page))
+        {
+            ring->oldest_page = page;
+            break;
+        }
+    }
+
+    logger_info.oldest_timestamp = 0;
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        if(log_rings[r].oldest_page == LOG_PAGE_NONE) continue;
+        ts = LOG_PAGE_HEADER(log_rings[r].oldest_page)->first_timestamp;
+        if(logger_info.oldest_timestamp == 0 || ts < logger_info.oldest_timestamp)
+            logger_info.oldest_timestamp = ts;
+    }
+}
+
+/**
+ * @brief  环内按时间顺序的第n页（0为最旧页）对应的物理页号
+ */
+static u16 DataLogger_NthPage(const LogRing_t* ring, u16 n)
+{
+    return DataLogger_RingPage(ring, ring->oldest_page, n);
+}
+
+/**
+ * @brief  环内从最旧页到写入页共有多少页
+ */
+static u16 DataLogger_PageSpan(const LogRing_t* ring)
+{
+    return (ring->current_page + ring->page_count - ring->oldest_page) % ring->page_count + 1;
+}
+
+/**
+ * @brief  页内最后一个可能有记录的槽
+ */
+static u16 DataLogger_LastSlot(const LogRing_t* ring, u16 page)
+{
+    return (page == ring->current_page) ? ring->current_offset - 1 : LOG_SLOTS_PER_PAGE - 1;
+}
+
+static void DataLogger_AddStats(const LogPageHeader_t* stat)
+{
+    logger_info.sensor_records += stat->sensor_count;
+    logger_info.operation_records += stat->operation_count;
+    logger_info.alarm_records += stat->alarm_count;
+    logger_info.total_records += stat->sensor_count + stat->operation_count + stat->alarm_count;
+}
+
+static void DataLogger_SubStats(const LogPageHeader_t* stat)
+{
+    logger_info.sensor_records -= stat->sensor_count;
+    logger_info.operation_records -= stat->operation_count;
+    logger_info.alarm_records -= stat->alarm_count;
+    logger_info.total_records -= stat->sensor_count + stat->operation_count + stat->alarm_count;
+}
+
+/**
+ * @brief  编程半字，已是目标值时跳过（掉电后重做未完成的写入）
+ * @note   已有其他值（编程中途掉电）时不能再编程，返回失败
+ */
+static FLASH_Status DataLogger_ProgramHalfWord(u32 addr, u16 data)
+{
+    if(*(volatile u16*)addr == data) return FLASH_COMPLETE;
+    if(*(volatile u16*)addr != 0xFFFF) return FLASH_ERROR_PG;
+    return FLASH_ProgramHalfWord(addr, data);
+}
+
+/**
+ * @brief  封页：写入last_timestamp和各类计数，最后写sealed标志
+ * @note   启动时发现写满未封页会再次调用，已写入的半字不重复编程
+ */
+static u8 DataLogger_SealPage(LogRing_t* ring)
+{
+    const LogPageHeader_t* hdr = LOG_PAGE_HEADER(ring->current_page);
+    const LogPageHeader_t* stat = &ring->head;
     FLASH_Status status;
-    u32* data_ptr = (u32*)record->raw_data;
-    u8 i;
 
-    if(logger_info.current_offset >= LOG_RECORDS_PER_PAGE)
+    FLASH_Unlock();
+    status = DataLogger_ProgramHalfWord((u32)&hdr->last_timestamp, (u16)stat->last_timestamp);
+    if(status == FLASH_COMPLETE)
+        status = DataLogger_ProgramHalfWord((u32)&hdr->last_timestamp + 2, (u16)(stat->last_timestamp >> 16));
+    if(status == FLASH_COMPLETE)
+        status = DataLogger_ProgramHalfWord((u32)&hdr->sensor_count, stat->sensor_count);
+    if(status == FLASH_COMPLETE)
+        status = DataLogger_ProgramHalfWord((u32)&hdr->operation_count, stat->operation_count);
+    if(status == FLASH_COMPLETE)
+        status = DataLogger_ProgramHalfWord((u32)&hdr->alarm_count, stat->alarm_count);
+    if(status == FLASH_COMPLETE)
+        status = DataLogger_ProgramHalfWord((u32)&hdr->sealed, LOG_PAGE_SEALED);
+    FLASH_Lock();
+    if(status != FLASH_COMPLETE)
     {
-        logger_info.current_page++;
-        logger_info.current_offset = 0;
+        printf("Page seal failed!\r\n");
+        return 1;
     }
-    if(logger_info.current_page >= (FLASH_END_ADDR - FLASH_START_ADDR + 1) / FLASH_PAGE_SIZE)
+    ring->head.sealed = LOG_PAGE_SEALED;
+    return 0;
+}
+
+/**
+ * @brief  页是否为空（擦除计数字除外）
+ * @note   检查整页：擦除中途掉电时页头可能已全为0xFF而后面仍有残留的位，
+ *         只看页头会把这样的页当作空页，在残留内容上编程
+ */
+static u8 DataLogger_PageBlank(u16 page)
+{
+    u32 addr = LOG_PAGE_ADDR(page);
+    u32 count_addr = (u32)&LOG_PAGE_HEADER(page)->erase_count;
+    u16 i;
+
+    for(i = 0; i < FLASH_PAGE_SIZE; i += 4)
     {
-        printf("Flash full, erasing page 0.\r\n");
-        DataLogger_ErasePage(0);
-        logger_info.current_page = 0;
-        logger_info.current_offset = 0;
+        if(addr + i != count_addr && LOG_SLOT_USED(addr + i)) return 0;
     }
+    return 1;
+}
 
-    addr = FLASH_START_ADDR + logger_info.current_page * FLASH_PAGE_SIZE + 
-           logger_info.current_offset * LOG_RECORD_SIZE;
+/**
+ * @brief  擦除页并立即写回累计擦除次数，其余页头留空待开页时写入
+ * @note   页已擦除且有擦除计数时直接返回；出厂空页计数从0开始；不修改记录统计；
+ *         擦除前先把magic清零（F1允许向任意半字编程0x0000），擦除中途掉电时页内容不确定，
+ *         不会留下有效页头使随机内容被当作记录
+ */
+static u8 DataLogger_ResetPage(u16 page)
+{
+    u32 count = LOG_PAGE_HEADER(page)->erase_count;
+    FLASH_Status status;
 
-    if(logger_info.current_offset == 0)
+    if(DataLogger_PageBlank(page))
+    {
+        if(count != 0xFFFFFFFF) return 0;
+        count = 0;
+    }
+    else
     {
-        if(*(volatile u32*)(addr) != 0xFFFFFFFF)
+        count = (count == 0xFFFFFFFF) ? 1 : count + 1;
+        if(LOG_PAGE_HEADER(page)->magic != 0x0000)
         {
-            DataLogger_ErasePage(logger_info.current_page);
+            FLASH_Unlock();
+            FLASH_ProgramHalfWord(LOG_PAGE_ADDR(page), 0x0000);
+            FLASH_Lock();
         }
+        if(DataLogger_ErasePage(page) != 0) return 1;
     }
 
     FLASH_Unlock();
-    for(i = 0; i < LOG_RECORD_SIZE / 4; i++)
+    status = FLASH_ProgramWord((u32)&LOG_PAGE_HEADER(page)->erase_count, count);
+    FLASH_Lock();
+    return (status == FLASH_COMPLETE) ? 0 : 1;
+}
+
+/**
+ * @brief  回收页以便写入，页上的记录从统计中扣除
+ */
+static u8 DataLogger_PreparePage(u16 page)
+{
+    LogPageHeader_t old;
+
+    if(DataLogger_PageValid(page))
     {
-        status = FLASH_ProgramWord(addr + i * 4, data_ptr[i]);
+        DataLogger_PageStats(page, &old);
+        DataLogger_SubStats(&old);
+    }
+    return DataLogger_ResetPage(page);
+}
+
+/**
+ * @brief  预擦除写入页的下一页，使开新页时不必等待擦除（掉电中断中也能跨页）
+ * @note   被擦除的是环内最旧页，每个环始终保留一页空闲
+ */
+static void DataLogger_PrepareNext(LogRing_t* ring)
+{
+    ring->next_ready = (DataLogger_PreparePage(DataLogger_RingPage(ring, ring->current_page, 1)) == 0);
+    DataLogger_UpdateOldest(ring);
+}
+
+/**
+ * @brief  打开环的新写入页：必要时擦除，写入页头
+ * @param  page: 目标页
+ * @param  timestamp: 本页第一条记录的时间戳
+ */
+static u8 DataLogger_OpenPage(LogRing_t* ring, u16 page, u32 timestamp)
+{
+    u32 addr = LOG_PAGE_ADDR(page);
+    FLASH_Status status;
+    u16 seq = ring->head_open ? (u16)(ring->head.seq + 1) : 0;
+
+    if(DataLogger_PreparePage(page) != 0) return 1;
+
+    FLASH_Unlock();
+    status = FLASH_ProgramHalfWord(addr + 2, seq);
+    if(status == FLASH_COMPLETE)
+        status = FLASH_ProgramWord(addr + 4, timestamp);
+    if(status == FLASH_COMPLETE)
+        status = FLASH_ProgramHalfWord((u32)&LOG_PAGE_HEADER(page)->ring, DataLogger_PageRing(page));
+    if(status == FLASH_COMPLETE)
+        status = FLASH_ProgramHalfWord(addr, LOG_PAGE_MAGIC);
+    FLASH_Lock();
+    if(status != FLASH_COMPLETE)
+    {
+        printf("Page header write failed!\r\n");
+        return 1;
+    }
+
+    ring->head = *LOG_PAGE_HEADER(page);
+    ring->head.last_timestamp = timestamp;
+    ring->head.sensor_count = 0;
+    ring->head.operation_count = 0;
+    ring->head.alarm_count = 0;
+    ring->head_open = 1;
+
+    ring->current_page = page;
+    ring->current_offset = LOG_HEADER_SLOTS;
+    ring->next_ready = 0;
+    DataLogger_UpdateOldest(ring);
+    return 0;
+}
+
+/**
+ * @brief  获取页累计擦除次数
+ * @retval 擦除次数，未知时返回0xFFFFFFFF
+ */
+u32 DataLogger_GetEraseCount(u16 page)
+{
+    if(page >= LOG_PAGE_COUNT) return 0xFFFFFFFF;
+    return LOG_PAGE_HEADER(page)->erase_count;
+}
+
+/**
+ * @brief  按配置划分各记录环的页，并复位各环的写入状态
+ * @note   操作环和报警环的页数取自配置，超出范围时用默认值，传感器环使用其余的页；
+ *         划分改变后不属于各环序列的页由DataLogger_RingTrim在恢复时擦除
+ */
+static void DataLogger_Layout(void)
+{
+    u16 pages[LOG_RING_COUNT];
+    u16 first = 0;
+    u8 r;
+
+    pages[LOG_RING_OPERATION] = Config_Get_U8(CONFIG_LOG_OPERATION_PAGES);
+    pages[LOG_RING_ALARM] = Config_Get_U8(CONFIG_LOG_ALARM_PAGES);
+    if(pages[LOG_RING_OPERATION] < LOG_RING_MIN_PAGES || pages[LOG_RING_OPERATION] > LOG_RING_MAX_PAGES)
+        pages[LOG_RING_OPERATION] = DEFAULT_LOG_OPERATION_PAGES;
+    if(pages[LOG_RING_ALARM] < LOG_RING_MIN_PAGES || pages[LOG_RING_ALARM] > LOG_RING_MAX_PAGES)
+        pages[LOG_RING_ALARM] = DEFAULT_LOG_ALARM_PAGES;
+    pages[LOG_RING_SENSOR] = LOG_PAGE_COUNT - pages[LOG_RING_OPERATION] - pages[LOG_RING_ALARM];
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        memset(&log_rings[r], 0, sizeof(LogRing_t));
+        log_rings[r].first_page = first;
+        log_rings[r].page_count = pages[r];
+        log_rings[r].current_page = first;
+        log_rings[r].oldest_page = LOG_PAGE_NONE;
+        first += pages[r];
+    }
+}
+
+/**
+ * @brief  清理环内不属于写入页序列的页
+ * @note   从写入页往前，序号逐页减1的连续有效页保留，其余有内容的页擦除：
+ *         环划分改变后留在本环范围内的其他环的页，以及旧划分下本环序号不连续的页。
+ *         之后最旧页到写入页之间都是本环序号连续的页，遍历和记录位置换算不必再检查页头
+ */
+static void DataLogger_RingTrim(const LogRing_t* ring, u16 head)
+{
+    u16 seq = LOG_PAGE_HEADER(head)->seq;
+    u16 k, page;
+    u8 keep = 1;
+
+    for(k = 1; k < ring->page_count; k++)
+    {
+        page = DataLogger_RingPage(ring, head, ring->page_count - k);
+        if(keep && DataLogger_PageValid(page) && (u16)(seq - LOG_PAGE_HEADER(page)->seq) == k) continue;
+        keep = 0;
+        if(!DataLogger_PageBlank(page))
+        {
+            printf("Log page %d not in ring %d sequence, erased\r\n", page, DataLogger_PageRing(page));
+            DataLogger_ResetPage(page);
+        }
+    }
+}
+
+/**
+ * @brief  恢复一个记录环：二分查找写入页，清理不属于本环序列的页，累加各页统计，
+ *         仅写入页（及异常未封页）逐条扫描
+ */
+static void DataLogger_RingInit(LogRing_t* ring)
+{
+    LogPageHeader_t stat;
+    u16 head, page, used;
+
+    head = DataLogger_FindHead(ring);
+    if(head == LOG_PAGE_NONE)
+    {
+        DataLogger_PreparePage(ring->first_page);    // 空环的第一页也预先擦除
+        return;
+    }
+    DataLogger_RingTrim(ring, head);
+
+    for(page = ring->first_page; page < ring->first_page + ring->page_count; page++)
+    {
+        if(page == head || !DataLogger_PageValid(page)) continue;
+        DataLogger_PageStats(page, &stat);
+        DataLogger_AddStats(&stat);
+    }
+
+    if(LOG_PAGE_HEADER(head)->sealed == LOG_PAGE_SEALED)
+    {
+        ring->head = *LOG_PAGE_HEADER(head);
+        used = LOG_RECORDS_PER_PAGE;
+    }
+    else
+    {
+        used = DataLogger_ScanPage(head, &ring->head);
+    }
+    DataLogger_AddStats(&ring->head);
+    ring->head_open = 1;
+
+    ring->current_page = head;
+    ring->current_offset = used + LOG_HEADER_SLOTS;
+    if(ring->head.last_timestamp > logger_info.newest_timestamp)
+        logger_info.newest_timestamp = ring->head.last_timestamp;
+    DataLogger_UpdateOldest(ring);
+
+    // 写满但未封页（封页前掉电），补写页头；写入页已有提交的记录时确保下一页已预擦除，
+    // 没有时（开页后或第一条记录编程中掉电）由下一次写入后预擦除，以免擦掉环内仅有的记录
+    if(ring->current_offset >= LOG_SLOTS_PER_PAGE && ring->head.sealed != LOG_PAGE_SEALED)
+        DataLogger_SealPage(ring);
+    if(ring->head.sensor_count + ring->head.operation_count + ring->head.alarm_count > 0)
+        DataLogger_PrepareNext(ring);
+}
+
+/**
+ * @brief  初始化数据记录器
+ * @note   只读取各页页头恢复统计，每个环二分查找写入页，仅写入页（及异常未封页）需要逐条扫描；
+ *         复位前未写入的当前小时/当天汇总从这些记录重建；
+ *         记录环的划分来自配置，需在Config_Init之后调用
+ */
+u8 DataLogger_Init(void)
+{
+    u16 page;
+    u32 count, wear_min = 0xFFFFFFFF, wear_max = 0;
+    u8 r;
+
+    printf("Initializing data logger...\r\n");
+    memset(&logger_info, 0, sizeof(logger_info));
+    log_stage_count = 0;
+    log_busy = 0;
+    log_flush_req = 0;
+#if LOG_USE_PVD
+    DataLogger_PVD_Init();
+#endif
+
+    DataLogger_Layout();
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        DataLogger_RingInit(&log_rings[r]);
+    }
+    DataRollup_Init(DataLogger_GetTimestamp());     // 用恢复后的记录环重建未写入的汇总
+
+    for(page = 0; page < LOG_PAGE_COUNT; page++)
+    {
+        count = LOG_PAGE_HEADER(page)->erase_count;
+        if(count == 0xFFFFFFFF) continue;
+        if(count < wear_min) wear_min = count;
+        if(count > wear_max) wear_max = count;
+    }
+
+    printf("Data logger initialized. Records: %lu (sensor/op/alarm pages %d/%d/%d, erase %lu-%lu)\r\n",
+           logger_info.total_records, log_rings[LOG_RING_SENSOR].page_count,
+           log_rings[LOG_RING_OPERATION].page_count, log_rings[LOG_RING_ALARM].page_count,
+           wear_min, wear_max);
+    return 0;
+}
+
+static u32 DataLogger_GetTimestamp(void)
+{
+    return RTC_GetCounter();
+}
+
+/**
+ * @brief  记录一条已提交到Flash的记录的页统计和全局记录数
+ * @note   记录数只在编程成功后累加，与上电时从Flash恢复的统计一致
+ */
+static void DataLogger_Account(LogRing_t* ring, const LogRecord_t* record)
+{
+    LogPageHeader_t stat;
+
+    memset(&stat, 0, sizeof(stat));
+    DataLogger_CountRecord(&stat, record);
+    DataLogger_AddStats(&stat);
+    DataLogger_CountRecord(&ring->head, record);
+    if(logger_info.oldest_timestamp == 0)
+        logger_info.oldest_timestamp = record->sensor.timestamp;
+}
+
+/**
+ * @brief  将暂存区写入Flash
+ * @note   同一页内连续的记录在一次解锁内按半字连续编程（F1的最小编程单位）；
+ *         每条记录按地址顺序编程，含提交字节的最后一个半字最后写入；
+ *         编程失败时放弃本页剩余空间和未写完的暂存记录，下次写入从新页开始；
+ *         记录只在编程成功后计入统计；
+ *         新页写入第一批记录后预擦除下一页，写入页写满时下一页总是空页
+ * @param  power_fail: 1-掉电时写入，只编程不擦除：跨页时只打开已预擦除的下一页，不再预擦除，
+ *         需要擦除才能打开的页上的记录放弃（擦除一页需要20~40ms，掉电时来不及）
+ */
+static u8 DataLogger_FlushStage(u8 power_fail)
+{
+    LogRing_t* ring;
+    const u16* data;
+    u32 addr;
+    FLASH_Status status = FLASH_COMPLETE;
+    u16 page, n, k;
+    u8 i = 0, r, ret = 0;
+
+    while(i < log_stage_count)
+    {
+        r = DataLogger_TypeRing(log_stage[i].sensor.log_type);
+        ring = &log_rings[r];
+        if(ring->current_offset == 0 || ring->current_offset >= LOG_SLOTS_PER_PAGE)
+        {
+            page = ring->current_page;
+            if(ring->current_offset != 0)
+                page = DataLogger_RingPage(ring, page, 1);
+            if(power_fail && !DataLogger_PageBlank(page))
+            {
+                ret = 1;
+                i++;
+                continue;
+            }
+            if(DataLogger_OpenPage(ring, page, log_stage[i].sensor.timestamp) != 0) break;
+        }
+
+        // 同一环的连续记录一起写入
+        for(n = 1; i + n < log_stage_count && n < LOG_SLOTS_PER_PAGE - ring->current_offset; n++)
+        {
+            if(DataLogger_TypeRing(log_stage[i + n].sensor.log_type) != r) break;
+        }
+        addr = LOG_SLOT_ADDR(ring->current_page, ring->current_offset);
+        data = (const u16*)log_stage[i].raw_data;
+        for(k = 0; k < n; k++)
+        {
+            log_stage[i + k].raw_data[LOG_RECORD_SIZE - 1] = DataLogger_CommitByte(&log_stage[i + k]);
+        }
+
+        FLASH_Unlock();
+        for(k = 0; k < n * (LOG_RECORD_SIZE / 2); k++)
+        {
+            status = FLASH_ProgramHalfWord(addr + k * 2, data[k]);
+            if(status != FLASH_COMPLETE) break;
+        }
+        FLASH_Lock();
+
+        // 失败前已完整编程的记录（含提交字节）在Flash中有效，照常计入统计
+        if(status != FLASH_COMPLETE)
+            n = k / (LOG_RECORD_SIZE / 2);
+        for(k = 0; k < n; k++)
+        {
+            DataLogger_Account(ring, &log_stage[i + k]);
+        }
+        ring->current_offset += n;
+        i += n;
+
         if(status != FLASH_COMPLETE)
         {
             printf("Flash write failed!\r\n");
-            FLASH_Lock();
-            return 1;
+            ring->current_offset = LOG_SLOTS_PER_PAGE;
+            break;
         }
+
+        if(ring->current_offset >= LOG_SLOTS_PER_PAGE)
+            DataLogger_SealPage(ring);
+        // 新页有了记录之后再擦除最旧页，此间掉电不会使环变空
+        if(!power_fail && !ring->next_ready)
+            DataLogger_PrepareNext(ring);
     }
-    FLASH_Lock();
-    logger_info.current_offset++;
-    logger_info.total_records++;
-    return 0;
+
+    if(i < log_stage_count) ret = 1;
+    log_stage_count = 0;
+    return ret;
 }
 
-static u8 DataLogger_ReadRecord(u32 addr, LogRecord_t* record)
+/**
+ * @brief  占用Flash：擦除/编程Flash或持有指向记录区的指针期间调用，可嵌套
+ * @note   占用期间PVD中断不写入暂存记录，只置位请求，由最外层DataLogger_Release完成；
+ *         记录器、汇总区、配置日志和记录游标共用这一个占用计数
+ */
+void DataLogger_Acquire(void)
 {
-    u8 i;
-    u32* data_ptr = (u32*)record->raw_data;
-    u32* flash_ptr = (u32*)addr;
-    if(addr < FLASH_START_ADDR || addr > FLASH_END_ADDR - LOG_RECORD_SIZE) return 1;
-    for(i = 0; i < LOG_RECORD_SIZE / 4; i++)
+    log_busy++;
+}
+
+/**
+ * @brief  释放Flash占用，最外层释放时完成PVD中断推迟的写入（同样不擦除）
+ * @note   先减计数再屏蔽PVD中断检查请求：清零前到达的中断已置位log_flush_req，
+ *         清零后到达的中断自己写入，不会出现两边都不写的窗口
+ */
+void DataLogger_Release(void)
+{
+    if(--log_busy > 0) return;
+#if LOG_USE_PVD
+    NVIC_DisableIRQ(PVD_IRQn);
+    if(log_flush_req)
     {
-        data_ptr[i] = flash_ptr[i];
+        log_flush_req = 0;
+        DataLogger_FlushStage(1);
     }
-    return 0;
+    NVIC_EnableIRQ(PVD_IRQn);
+#endif
 }
 
+/**
+ * @brief  将一条记录放入暂存区，按需写入Flash
+ * @retval 0-成功，1-暂存区写满或报警记录写入Flash时失败（暂存的记录已丢失）
+ */
+static u8 DataLogger_WriteRecord(LogRecord_t* record)
+{
+    u8 ret = 0;
+
+    DataLogger_Acquire();
+    if(log_stage_count >= LOG_STAGE_RECORDS)
+        ret = DataLogger_FlushStage(0);
+    if(log_stage_count == 0)
+        log_stage_time = system_time_ms;
+    log_stage[log_stage_count++] = *record;
+
+    if(record->sensor.log_type == LOG_TYPE_ALARM && DataLogger_FlushStage(0) != 0)
+        ret = 1;
+    DataLogger_Release();
+    return ret;
+}
+
+/**
+ * @brief  将暂存记录写入Flash
+ */
+u8 DataLogger_Flush(void)
+{
+    u8 ret = 0;
+
+    DataLogger_Acquire();
+    if(log_stage_count > 0)
+        ret = DataLogger_FlushStage(0);
+    DataLogger_Release();
+    return ret;
+}
+
+/**
+ * @brief  记录器周期任务，暂存记录超过LOG_FLUSH_INTERVAL_MS未写入时写入Flash
+ */
+void DataLogger_Task(void)
+{
+    if(log_stage_count > 0 && system_time_ms - log_stage_time >= LOG_FLUSH_INTERVAL_MS)
+        DataLogger_Flush();
+}
+
+#if LOG_USE_PVD
+/**
+ * @brief  掉电检测：VDD低于2.9V时产生EXTI16中断
+ */
+static void DataLogger_PVD_Init(void)
+{
+    EXTI_InitTypeDef EXTI_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    PWR_PVDLevelConfig(PWR_PVDLevel_2V9);
+    PWR_PVDCmd(ENABLE);
+
+    EXTI_ClearITPendingBit(EXTI_Line16);
+    EXTI_InitStructure.EXTI_Line = EXTI_Line16;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;   // PVDO上升沿即VDD下降
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+
+    NVIC_InitStructure.NVIC_IRQChannel = PVD_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/**
+ * @brief  掉电中断：立即写入暂存记录；Flash被占用时（记录器、汇总区、配置或游标）由最外层释放时完成
+ * @note   只编程不擦除，依靠各环预擦除的下一页；下一页未就绪时放弃该环的暂存记录
+ */
+void PVD_IRQHandler(void)
+{
+    if(EXTI_GetITStatus(EXTI_Line16) != RESET)
+    {
+        EXTI_ClearITPendingBit(EXTI_Line16);
+        if(log_busy)
+        {
+            log_flush_req = 1;
+        }
+        else if(log_stage_count > 0)
+        {
+            log_busy = 1;
+            DataLogger_FlushStage(1);
+            log_busy = 0;
+        }
+    }
+}
+#endif
+
 static u8 DataLogger_ErasePage(u16 page)
 {
     u32 page_addr = FLASH_START_ADDR + page * FLASH_PAGE_SIZE;
@@ -149,21 +952,53 @@ u8 DataLogger_WriteSensorData(u8 temp, u8 humi, u8 light,
                               u8 mode, u8 alarms)
 {
     LogRecord_t record;
-    memset(&record, 0, sizeof(record));
-    record.sensor.timestamp = DataLogger_GetTimestamp();
-    record.sensor.log_type = LOG_TYPE_SENSOR;
-    record.sensor.temperature = temp;
-    record.sensor.humidity = humi;
-    record.sensor.light = light;
-    record.sensor.fan_status = fan;
-    record.sensor.pump_status = pump;
-    record.sensor.light_status = light_dev;
-    record.sensor.work_mode = mode;
-    record.sensor.alarm_flags = alarms;
+    SensorLogRecord_t sample;
+    LogRecord_t* last;
+    u8 packed = 0;
+    u8 i;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp = DataLogger_GetTimestamp();
+    sample.log_type = LOG_TYPE_SENSOR;
+    sample.temperature = temp;
+    sample.humidity = humi;
+    sample.light = light;
+    sample.fan_status = fan;
+    sample.pump_status = pump;
+    sample.light_status = light_dev;
+    sample.work_mode = mode;
+    sample.alarm_flags = alarms;
+
+    // 优先追加到暂存区中传感器环的最后一条压缩记录（其后的操作/报警记录写入其他环）
+    DataLogger_Acquire();
+    last = 0;
+    for(i = log_stage_count; i > 0; i--)
+    {
+        if(DataLogger_TypeRing(log_stage[i - 1].sensor.log_type) == LOG_RING_SENSOR)
+        {
+            last = &log_stage[i - 1];
+            break;
+        }
+    }
+    if(last != 0 && last->pack.log_type == LOG_TYPE_SENSOR_PACK)
+        packed = DataLogger_PackAppend(&last->pack, &sample);
+    DataLogger_Release();
+    if(packed)
+    {
+        logger_info.newest_timestamp = sample.timestamp;
+        DataRollup_AddSample(sample.timestamp, temp, humi, light);
+        return 0;
+    }
+
+    if(!DataLogger_PackStart(&record, &sample))
+    {
+        memset(&record, 0, sizeof(record));
+        record.sensor = sample;
+    }
     if(DataLogger_WriteRecord(&record) == 0)
     {
-        logger_info.sensor_records++;
-        logger_info.newest_timestamp = record.sensor.timestamp;
+        logger_info.newest_timestamp = sample.timestamp;
+        DataRollup_AddSample(sample.timestamp, temp, humi, light);
         return 0;
     }
     return 1;
@@ -181,8 +1016,8 @@ u8 DataLogger_WriteOperation(u8 operation, u8 old_val, u8 new_val, u8 trigger)
     record.operation.trigger_mode = trigger;
     if(DataLogger_WriteRecord(&record) == 0)
     {
-        logger_info.operation_records++;
         logger_info.newest_timestamp = record.operation.timestamp;
+        DataRollup_AddEvent(record.operation.timestamp, LOG_TYPE_OPERATION);
         return 0;
     }
     return 1;
@@ -200,173 +1035,504 @@ u8 DataLogger_WriteAlarm(u8 alarm_type, u8 level, u8 trigger_val, u8 threshold)
     record.alarm.threshold = threshold;
     if(DataLogger_WriteRecord(&record) == 0)
     {
-        logger_info.alarm_records++;
         logger_info.newest_timestamp = record.alarm.timestamp;
+        DataRollup_AddEvent(record.alarm.timestamp, LOG_TYPE_ALARM);
         return 0;
     }
     return 1;
 }
 
-u16 DataLogger_Query(LogQuery_t* query, LogRecord_t* records, u16 buffer_size)
+/**
+ * @brief  在环内定位最后一条时间戳不晚于t的记录（压缩记录按第一个样本）
+ * @param  n: 输出该记录所在页按时间顺序的序号
+ * @retval 槽号，所有记录都晚于t时返回0
+ * @note   记录时间戳在环内单调递增：先按页头first_timestamp二分找页，再在页内二分找槽
+ */
+static u16 DataLogger_Locate(const LogRing_t* ring, u32 t, u16* n)
 {
-    u16 found_count = 0;
     u32 addr;
-    LogRecord_t record;
-    u16 page, offset;
+    u16 page, lo, hi, mid, probe;
+
+    if(LOG_PAGE_HEADER(DataLogger_NthPage(ring, 0))->first_timestamp > t) return 0;
+    lo = 0;
+    hi = DataLogger_PageSpan(ring) - 1;
+    while(lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if(LOG_PAGE_HEADER(DataLogger_NthPage(ring, mid))->first_timestamp <= t)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    *n = lo;
+    page = DataLogger_NthPage(ring, lo);
+
+    // lo及之前的有效记录都不晚于t，hi之后的都晚于t；mid处为无效槽时用其前最近的有效记录比较
+    lo = LOG_HEADER_SLOTS - 1;
+    hi = DataLogger_LastSlot(ring, page);
+    while(lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        for(probe = mid; probe > lo; probe--)
+        {
+            if(DataLogger_SlotValid(LOG_SLOT_ADDR(page, probe))) break;
+        }
+        addr = LOG_SLOT_ADDR(page, probe);
+        if(probe == lo || ((const LogRecord_t*)addr)->sensor.timestamp <= t)
+            lo = mid;
+        else
+            hi = probe - 1;
+    }
+    return lo;
+}
+
+/**
+ * @brief  在一个记录环上定位游标起点
+ */
+static void DataLogger_CursorOpenRing(LogCursor_t* cursor, u8 r)
+{
+    const LogRing_t* ring = &log_rings[r];
+    LogRingCursor_t* rc = &cursor->ring[r];
+    u16 n = 0, slot;
+
+    if(!ring->head_open || ring->oldest_page == LOG_PAGE_NONE) return;
+
+    if(cursor->direction == LOG_CURSOR_FORWARD)
+    {
+        // 从最后一条早于start_time的记录开始，时间戳相同的记录不会漏掉
+        slot = (cursor->start_time == 0) ? 0 : DataLogger_Locate(ring, cursor->start_time - 1, &n);
+        if(slot == 0) n = 0;
+        if(slot < LOG_HEADER_SLOTS) slot = LOG_HEADER_SLOTS;
+    }
+    else
+    {
+        slot = DataLogger_Locate(ring, cursor->end_time, &n);
+        if(slot == 0) return;
+    }
+    rc->page_n = n;
+    rc->slot = slot;
+    rc->done = 0;
+}
+
+/**
+ * @brief  打开记录游标
+ * @param  log_type: 记录类型过滤（0-全部），压缩记录按LOG_TYPE_SENSOR匹配；指定类型时只访问该类型的环
+ * @param  direction: LOG_CURSOR_FORWARD从start_time向后，LOG_CURSOR_BACKWARD从end_time向前
+ * @note   先写入暂存记录；定位用二分查找，遍历只访问命中的区间；
+ *         打开期间占用Flash（掉电写入不会擦除正在遍历的页），遍历结束后调用DataLogger_CursorClose
+ */
+void DataLogger_CursorOpen(LogCursor_t* cursor, u32 start_time, u32 end_time,
+                           u8 log_type, u8 direction)
+{
+    u8 r;
+
+    cursor->start_time = start_time;
+    cursor->end_time = end_time;
+    cursor->log_type = log_type;
+    cursor->direction = direction;
+    cursor->sample = 0;
+    cursor->sample_count = 0;
+
+    DataLogger_Flush();
+    DataLogger_Acquire();
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        cursor->ring[r].next = 0;
+        cursor->ring[r].done = 1;
+        if(start_time > end_time) continue;
+        if(log_type != 0 && DataLogger_TypeRing(log_type) != r) continue;
+        DataLogger_CursorOpenRing(cursor, r);
+    }
+}
 
-    for(page = logger_info.current_page; ; page--)
+/**
+ * @brief  环上的游标移到下一个有效槽
+ * @retval 记录在Flash中的地址，已到环的一端返回0
+ */
+static const LogRecord_t* DataLogger_CursorStep(LogCursor_t* cursor, u8 r)
+{
+    const LogRing_t* ring = &log_rings[r];
+    LogRingCursor_t* rc = &cursor->ring[r];
+    u32 addr;
+    u16 page;
+
+    while(1)
     {
-        u16 start_offset = (page == logger_info.current_page) ? logger_info.current_offset - 1 : LOG_RECORDS_PER_PAGE - 1;
-        for(offset = start_offset; ; offset--)
+        page = DataLogger_NthPage(ring, rc->page_n);
+        if(cursor->direction == LOG_CURSOR_FORWARD)
+        {
+            if(rc->slot > DataLogger_LastSlot(ring, page))
+            {
+                if(rc->page_n + 1 >= DataLogger_PageSpan(ring)) return 0;
+                rc->page_n++;
+                rc->slot = LOG_HEADER_SLOTS;
+                continue;
+            }
+            addr = LOG_SLOT_ADDR(page, rc->slot++);
+        }
+        else
         {
-            addr = FLASH_START_ADDR + page * FLASH_PAGE_SIZE + offset * LOG_RECORD_SIZE;
-            if(DataLogger_ReadRecord(addr, &record) == 0)
+            if(rc->slot < LOG_HEADER_SLOTS)
             {
-                if(record.raw_data[0] != 0xFF)
-                {
-                    if(record.sensor.timestamp >= query->start_time && record.sensor.timestamp <= query->end_time)
-                    {
-                        if(query->log_type == 0 || record.sensor.log_type == query->log_type)
-                        {
-                            if(found_count < buffer_size && found_count < query->max_records)
-                            {
-                                records[found_count] = record;
-                                found_count++;
-                            }
-                            else
-                            {
-                                return found_count;
-                            }
-                        }
-                    }
-                }
+                if(rc->page_n == 0) return 0;
+                rc->page_n--;
+                rc->slot = DataLogger_LastSlot(ring, DataLogger_NthPage(ring, rc->page_n));
+                continue;
             }
-            if(offset == 0) break;
+            addr = LOG_SLOT_ADDR(page, rc->slot--);
         }
-        if(page == 0) break;
+        if(DataLogger_SlotValid(addr)) return (const LogRecord_t*)addr;
+    }
+}
+
+/**
+ * @brief  取一个环上的下一条匹配记录
+ * @retval 记录指针，本环结束返回0
+ */
+static const LogRecord_t* DataLogger_CursorFetch(LogCursor_t* cursor, u8 r)
+{
+    LogRingCursor_t* rc = &cursor->ring[r];
+    const LogRecord_t* rec;
+    u32 ts;
+    u8 k;
+
+    while(1)
+    {
+        if(r == LOG_RING_SENSOR && cursor->sample < cursor->sample_count)
+        {
+            k = (cursor->direction == LOG_CURSOR_FORWARD) ?
+                cursor->sample : cursor->sample_count - 1 - cursor->sample;
+            cursor->sample++;
+            // SensorLogRecord_t与LogRecord_t同为16字节紧凑结构
+            rec = (const LogRecord_t*)&cursor->samples[k];
+        }
+        else
+        {
+            rec = DataLogger_CursorStep(cursor, r);
+            if(rec == 0)
+            {
+                rc->done = 1;
+                return 0;
+            }
+            if(rec->pack.log_type == LOG_TYPE_SENSOR_PACK)
+            {
+                cursor->sample_count = DataLogger_PackUnpack(&rec->pack, cursor->samples);
+                cursor->sample = 0;
+                continue;
+            }
+        }
+
+        ts = rec->sensor.timestamp;
+        if(cursor->direction == LOG_CURSOR_FORWARD ? ts > cursor->end_time : ts < cursor->start_time)
+        {
+            rc->done = 1;
+            if(r == LOG_RING_SENSOR) cursor->sample_count = 0;
+            return 0;
+        }
+        if(ts < cursor->start_time || ts > cursor->end_time) continue;
+        if(cursor->log_type != 0 && rec->sensor.log_type != cursor->log_type) continue;
+        return rec;
+    }
+}
+
+/**
+ * @brief  取游标的下一条匹配记录，多个环时按时间顺序合并
+ * @note   时间戳相同时向后按环号从小到大，向前顺序相反
+ * @retval 记录指针（普通记录指向Flash，压缩记录的样本指向游标内部），结束返回0
+ */
+const LogRecord_t* DataLogger_CursorNext(LogCursor_t* cursor)
+{
+    LogRingCursor_t* rc;
+    LogRingCursor_t* best = 0;
+    const LogRecord_t* rec;
+    u8 r;
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        rc = &cursor->ring[r];
+        if(rc->next == 0 && !rc->done)
+            rc->next = DataLogger_CursorFetch(cursor, r);
+        if(rc->next == 0) continue;
+        if(best == 0 ||
+           (cursor->direction == LOG_CURSOR_FORWARD ?
+            rc->next->sensor.timestamp < best->next->sensor.timestamp :
+            rc->next->sensor.timestamp >= best->next->sensor.timestamp))
+            best = rc;
     }
+    if(best == 0) return 0;
+
+    rec = best->next;
+    best->next = 0;
+    return rec;
+}
+
+/**
+ * @brief  关闭记录游标，释放Flash占用，之后游标返回的指针不再有效
+ */
+void DataLogger_CursorClose(LogCursor_t* cursor)
+{
+    DataLogger_Release();
+}
+
+/**
+ * @brief  按时间范围查询记录，从新到旧复制到records
+ * @note   需要逐条处理时直接使用DataLogger_CursorOpen/DataLogger_CursorNext，不占用缓冲区
+ */
+u16 DataLogger_Query(LogQuery_t* query, LogRecord_t* records, u16 buffer_size)
+{
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u16 found_count = 0;
+
+    DataLogger_CursorOpen(&cursor, query->start_time, query->end_time,
+                          query->log_type, LOG_CURSOR_BACKWARD);
+    while(found_count < buffer_size && found_count < query->max_records)
+    {
+        rec = DataLogger_CursorNext(&cursor);
+        if(rec == 0) break;
+        records[found_count++] = *rec;
+    }
+    DataLogger_CursorClose(&cursor);
     return found_count;
 }
 
+/**
+ * @brief  从记录位置起读取一段连续的原始记录槽，不复制、不展开压缩记录（用于导出）
+ * @param  pos: 输入起始位置，输出实际位置：早于最旧页或不在环内时移到最旧记录，
+ *              页内已读完时移到下一页；读到最新记录时为最新记录之后的位置
+ * @param  data: 输出第一个槽在Flash中的地址
+ * @retval 槽数（不超过max_records），已读到最新记录返回0
+ * @note   掉电时未写完的槽被跳过；调用方在使用完data前需持有Flash占用（DataLogger_Acquire）
+ */
+u16 DataLogger_ReadRaw(u32* pos, const LogRecord_t** data, u16 max_records)
+{
+    const LogRing_t* ring;
+    u16 n, span, page, slot, last, count;
+    s16 diff;
+    u8 r;
+
+    r = LOG_POS_RING(*pos);
+    if(r >= LOG_RING_COUNT) return 0;
+    ring = &log_rings[r];
+    if(!ring->head_open || ring->oldest_page == LOG_PAGE_NONE) return 0;
+
+    span = DataLogger_PageSpan(ring);
+    diff = (s16)(LOG_POS_SEQ(*pos) - LOG_PAGE_HEADER(ring->oldest_page)->seq);
+    slot = LOG_POS_SLOT(*pos);
+    if(diff < 0 || diff >= (s16)span)
+    {
+        // 已被覆盖，或记录器清空后序号重新开始
+        n = 0;
+        slot = LOG_HEADER_SLOTS;
+    }
+    else
+    {
+        n = diff;
+        if(slot < LOG_HEADER_SLOTS) slot = LOG_HEADER_SLOTS;
+    }
+
+    for(; n < span; n++, slot = LOG_HEADER_SLOTS)
+    {
+        page = DataLogger_NthPage(ring, n);
+        last = DataLogger_LastSlot(ring, page);
+        while(slot <= last && !DataLogger_SlotValid(LOG_SLOT_ADDR(page, slot))) slot++;
+        for(count = 0; count < max_records && slot + count <= last; count++)
+        {
+            if(!DataLogger_SlotValid(LOG_SLOT_ADDR(page, slot + count))) break;
+        }
+        *pos = LOG_POS(r, LOG_PAGE_HEADER(page)->seq, slot);
+        if(count > 0)
+        {
+            *data = (const LogRecord_t*)LOG_SLOT_ADDR(page, slot);
+            return count;
+        }
+    }
+    return 0;
+}
+
 u8 DataLogger_GetInfo(DataLoggerInfo_t* info)
 {
     *info = logger_info;
+    info->current_page = log_rings[LOG_RING_SENSOR].current_page;
+    info->current_offset = log_rings[LOG_RING_SENSOR].current_offset;
     return 0;
 }
 
 u8 DataLogger_EraseAll(void)
 {
     u16 page;
+    u8 ret = 0;
+
     printf("Erasing all data...\r\n");
-    for(page = 0; page < (FLASH_END_ADDR - FLASH_START_ADDR + 1) / FLASH_PAGE_SIZE; page++)
+    DataLogger_Acquire();
+    log_stage_count = 0;
+    for(page = 0; page < LOG_PAGE_COUNT; page++)
     {
-        if(DataLogger_ErasePage(page) != 0)
+        if(DataLogger_PreparePage(page) != 0)
         {
             printf("Failed to erase page %d\r\n", page);
-            return 1;
+            ret = 1;
+            break;
         }
     }
-    memset(&logger_info, 0, sizeof(logger_info));
-    printf("All data cleared.\r\n");
-    return 0;
+    if(ret == 0)
+    {
+        DataRollup_EraseAll();
+        memset(&logger_info, 0, sizeof(logger_info));
+        DataLogger_Layout();
+        printf("All data cleared.\r\n");
+    }
+    DataLogger_Release();
+    return ret;
 }
 
+/**
+ * @brief  由汇总记录计算平均值
+ */
+static void DataLogger_RollupAverages(const LogRollup_t* r, u8* avg_temp, u8* avg_humi,
+                                      u8* avg_light, u16* operations)
+{
+    *operations = r->operations;
+    if(r->samples > 0)
+    {
+        *avg_temp = r->temp_sum / r->samples;
+        *avg_humi = r->humi_sum / r->samples;
+        *avg_light = r->light_sum / r->samples;
+    }
+    else
+    {
+        *avg_temp = 0;
+        *avg_humi = 0;
+        *avg_light = 0;
+    }
+}
+
+/**
+ * @brief  获取日统计
+ * @param  date: 当天任意时刻的时间戳
+ * @note   优先读取日汇总；没有汇总时（如汇总已被覆盖）用游标扫描当天的记录
+ */
 u8 DataLogger_GetDailyStats(u32 date, u8* avg_temp, u8* avg_humi, 
                            u8* avg_light, u16* operations)
 {
-    LogQuery_t query;
-    LogRecord_t records[100];
-    u16 found;
-    u32 temp_sum = 0, humi_sum = 0, light_sum = 0;
-    u16 sensor_count = 0;
-    u16 i;
-    
-    query.start_time = date;
-    query.end_time = date + 86400;
-    query.log_type = 0;
-    query.max_records = 100;
-    
-    found = DataLogger_Query(&query, records, 100);
-    *operations = 0;
-    
-    for(i = 0; i < found; i++)
+    LogRollup_t day;
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u32 start;
+
+    if(DataRollup_Get(ROLLUP_DAY, date, &day) != 0)
     {
-        if(records[i].sensor.log_type == LOG_TYPE_SENSOR)
-        {
-            temp_sum += records[i].sensor.temperature;
-            humi_sum += records[i].sensor.humidity;
-            light_sum += records[i].sensor.light;
-            sensor_count++;
-        }
-        else if(records[i].operation.log_type == LOG_TYPE_OPERATION)
+        memset(&day, 0, sizeof(day));
+        start = date - date % ROLLUP_DAY_SECONDS;
+        DataLogger_CursorOpen(&cursor, start, start + ROLLUP_DAY_SECONDS - 1, 0, LOG_CURSOR_FORWARD);
+        while((rec = DataLogger_CursorNext(&cursor)) != 0)
         {
-            (*operations)++;
+            if(rec->sensor.log_type == LOG_TYPE_SENSOR)
+            {
+                day.samples++;
+                day.temp_sum += rec->sensor.temperature;
+                day.humi_sum += rec->sensor.humidity;
+                day.light_sum += rec->sensor.light;
+            }
+            else if(rec->sensor.log_type == LOG_TYPE_OPERATION && day.operations < 0xFFFF)
+            {
+                day.operations++;
+            }
         }
+        DataLogger_CursorClose(&cursor);
     }
-    
-    if(sensor_count > 0)
+    DataLogger_RollupAverages(&day, avg_temp, avg_humi, avg_light, operations);
+    return 0;
+}
+
+/**
+ * @brief  获取周统计：合并从week_start所在日起7个日汇总
+ */
+u8 DataLogger_GetWeeklyStats(u32 week_start, u8* avg_temp, u8* avg_humi,
+                            u8* avg_light, u16* operations)
+{
+    LogRollup_t week;
+
+    if(DataRollup_GetRange(ROLLUP_DAY, week_start, week_start + 7 * ROLLUP_DAY_SECONDS, &week) != 0)
+        memset(&week, 0, sizeof(week));
+    DataLogger_RollupAverages(&week, avg_temp, avg_humi, avg_light, operations);
+    return 0;
+}
+
+/**
+ * @brief  时间戳转换为日期时间（与RTC_Get_Time相同，从1970年起算）
+ */
+static void DataLogger_ToTime(u32 timestamp, RTC_Time_t* time)
+{
+    u32 days = timestamp / 86400;
+    u32 secs = timestamp % 86400;
+    u16 n;
+
+    time->year = 1970;
+    while(days >= (n = RTC_Is_Leap_Year(time->year) ? 366 : 365))
     {
-        *avg_temp = temp_sum / sensor_count;
-        *avg_humi = humi_sum / sensor_count;
-        *avg_light = light_sum / sensor_count;
+        days -= n;
+        time->year++;
     }
-    else
+    time->month = 1;
+    while(days >= (n = RTC_Get_Month_Days(time->year, time->month)))
     {
-        *avg_temp = 0;
-        *avg_humi = 0;
-        *avg_light = 0;
+        days -= n;
+        time->month++;
     }
-    return 0;
+    time->date = days + 1;
+    time->hour = secs / 3600;
+    time->min = (secs % 3600) / 60;
+    time->sec = secs % 60;
+    time->week = (timestamp / 86400 + 4) % 7;     // 0为周日，1970-01-01为周四
 }
 
+/**
+ * @brief  从新到旧打印最近count条记录，逐条从游标读取，不占用记录缓冲区
+ */
 void DataLogger_PrintRecords(u16 count)
 {
-    LogQuery_t query;
-    LogRecord_t records[20];
-    u16 found, i;
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u16 i;
     RTC_Time_t time;
     
     printf("--- Last %d Records ---\r\n", count);
     
-    query.start_time = 0;
-    query.end_time = 0xFFFFFFFF;
-    query.log_type = 0;
-    query.max_records = count > 20 ? 20 : count;
-    
-    found = DataLogger_Query(&query, records, 20);
+    DataLogger_CursorOpen(&cursor, 0, 0xFFFFFFFF, 0, LOG_CURSOR_BACKWARD);
     
-    for(i = 0; i < found; i++)
+    for(i = 0; i < count && (rec = DataLogger_CursorNext(&cursor)) != 0; i++)
     {
-        RTC_SetCounter(records[i].sensor.timestamp);
-        RTC_Get_Time(&time);
+        DataLogger_ToTime(rec->sensor.timestamp, &time);
         
         printf("[%04d-%02d-%02d %02d:%02d:%02d] ", 
                time.year, time.month, time.date, 
                time.hour, time.min, time.sec);
         
-        switch(records[i].sensor.log_type)
+        switch(rec->sensor.log_type)
         {
             case LOG_TYPE_SENSOR:
                 printf("Sensor: T=%dC H=%d%% L=%d%% F=%d P=%d Li=%d M=%d A=0x%02X\r\n",
-                       records[i].sensor.temperature, records[i].sensor.humidity,
-                       records[i].sensor.light, records[i].sensor.fan_status,
-                       records[i].sensor.pump_status, records[i].sensor.light_status,
-                       records[i].sensor.work_mode, records[i].sensor.alarm_flags);
+                       rec->sensor.temperature, rec->sensor.humidity,
+                       rec->sensor.light, rec->sensor.fan_status,
+                       rec->sensor.pump_status, rec->sensor.light_status,
+                       rec->sensor.work_mode, rec->sensor.alarm_flags);
                 break;
             case LOG_TYPE_OPERATION:
                 printf("Operation: OP=%d %d->%d Trig=%d\r\n",
-                       records[i].operation.operation, records[i].operation.old_value,
-                       records[i].operation.new_value, records[i].operation.trigger_mode);
+                       rec->operation.operation, rec->operation.old_value,
+                       rec->operation.new_value, rec->operation.trigger_mode);
                 break;
             case LOG_TYPE_ALARM:
                 printf("Alarm: Type=%d Lvl=%d Val=%d Thres=%d\r\n",
-                       records[i].alarm.alarm_type, records[i].alarm.alarm_level,
-                       records[i].alarm.trigger_value, records[i].alarm.threshold);
+                       rec->alarm.alarm_type, rec->alarm.alarm_level,
+                       rec->alarm.trigger_value, rec->alarm.threshold);
                 break;
             default:
-                printf("Unknown type: %d\r\n", records[i].sensor.log_type);
+                printf("Unknown type: %d\r\n", rec->sensor.log_type);
                 break;
         }
     }
+    DataLogger_CursorClose(&cursor);
     printf("==================\r\n");
 }
@@ -9,6 +9,7 @@
 #define LOG_TYPE_OPERATION  0x02    // 操作记录
 #define LOG_TYPE_ALARM      0x03    // 报警记录
 #define LOG_TYPE_SYSTEM     0x04    // 系统事件
+#define LOG_TYPE_SENSOR_PACK 0x05   // 压缩传感器记录（Flash内部格式，查询时展开为LOG_TYPE_SENSOR）
 
 // 操作类型
 #define OP_FAN_ON           0x01
@@ -35,8 +36,40 @@
 #define FLASH_SECTOR_SIZE   4096        // 扇区大小4KB
 
 #define LOG_RECORD_SIZE     16          // 每条记录16字节
-#define LOG_RECORDS_PER_PAGE (FLASH_PAGE_SIZE / LOG_RECORD_SIZE)  // 每页记录数
-#define MAX_LOG_RECORDS     ((FLASH_END_ADDR - FLASH_START_ADDR + 1) / LOG_RECORD_SIZE)
+#define LOG_PAGE_COUNT      ((FLASH_END_ADDR - FLASH_START_ADDR + 1) / FLASH_PAGE_SIZE)  // 页数
+#define LOG_SLOTS_PER_PAGE  (FLASH_PAGE_SIZE / LOG_RECORD_SIZE)   // 每页16字节槽数
+#define LOG_HEADER_SLOTS    2                                     // 页头占用的槽数
+#define LOG_RECORDS_PER_PAGE (LOG_SLOTS_PER_PAGE - LOG_HEADER_SLOTS) // 每页记录数
+#define MAX_LOG_RECORDS     (LOG_PAGE_COUNT * LOG_RECORDS_PER_PAGE)
+
+#define LOG_STAGE_RECORDS   8           // RAM暂存记录数，攒满即写入Flash
+#define LOG_FLUSH_INTERVAL_MS 30000     // 暂存记录最长停留时间(ms)
+#define LOG_USE_PVD         1           // 1-掉电检测(PVD)中断时写入暂存记录
+
+#define LOG_PACK_SAMPLES    4           // 每条压缩记录最多样本数
+
+#define LOG_PAGE_MAGIC      0x4C4A      // 页头有效标志（记录格式变化时修改，旧格式页按空页回收）
+#define LOG_PAGE_SEALED     0x00A5      // 封页标志
+#define LOG_PAGE_NONE       0xFFFF      // 无效页号
+#define LOG_COMMIT_NONE     0xFF        // 记录提交字节未写入
+
+// 记录提交：每条记录最后一个字节为前15字节的CRC-8（不取0xFF），与最后一个半字一起最后编程，
+// 掉电时写了一半的记录提交字节不符，启动和读取时跳过
+
+// 记录环：存储区按记录类型划分为独立循环写入的环，大量传感器记录不会覆盖操作和报警记录
+// 操作环和报警环的页数由配置决定，传感器环使用其余的页
+#define LOG_RING_SENSOR     0           // 传感器记录（含压缩记录）
+#define LOG_RING_OPERATION  1           // 操作记录和系统事件
+#define LOG_RING_ALARM      2           // 报警记录
+#define LOG_RING_COUNT      3
+#define LOG_RING_MIN_PAGES  2           // 每环最少页数（一页写入，一页预擦除）
+#define LOG_RING_MAX_PAGES  8           // 操作环/报警环最多页数
+
+// 记录位置：bit24-31为记录环，bit8-23为页序号，bit0-7为页内槽号，用于导出和断点续传
+#define LOG_POS(ring, seq, slot) (((u32)(ring) << 24) | ((u32)(seq) << 8) | (slot))
+#define LOG_POS_RING(pos)   ((u8)((pos) >> 24))
+#define LOG_POS_SEQ(pos)    ((u16)((pos) >> 8))
+#define LOG_POS_SLOT(pos)   ((u16)((pos) & 0xFF))
 
 // 传感器数据记录结构
 typedef struct
@@ -51,7 +84,8 @@ typedef struct
     u8  light_status;   // 补光灯状态
     u8  work_mode;      // 工作模式
     u8  alarm_flags;    // 报警标志
-    u8  reserved[3];    // 保留字段
+    u8  reserved[2];    // 保留字段
+    u8  commit;         // 提交字节
 } __attribute__((packed)) SensorLogRecord_t;
 
 // 操作记录结构
@@ -63,7 +97,8 @@ typedef struct
     u8  old_value;      // 操作前值
     u8  new_value;      // 操作后值
     u8  trigger_mode;   // 触发模式（0-自动，1-手动，2-定时）
-    u8  reserved[7];    // 保留字段
+    u8  reserved[6];    // 保留字段
+    u8  commit;         // 提交字节
 } __attribute__((packed)) OperationLogRecord_t;
 
 // 报警记录结构
@@ -76,14 +111,51 @@ typedef struct
     u8  trigger_value;  // 触发值
     u8  threshold;      // 阈值
     u8  duration;       // 持续时间（分钟）
-    u8  reserved[6];    // 保留字段
+    u8  reserved[5];    // 保留字段
+    u8  commit;         // 提交字节
 } __attribute__((packed)) AlarmLogRecord_t;
 
+// 页头结构，占每页前LOG_HEADER_SLOTS个槽
+// 擦除后立即写入erase_count；开页时写入seq、first_timestamp、ring，最后写magic；
+// 写满时写入last_timestamp和各类计数，最后写sealed
+// （Flash半字只能编程一次，所以页头分三次写，未封页的统计在启动时扫描该页得到）
+typedef struct
+{
+    u16 magic;              // LOG_PAGE_MAGIC
+    u16 seq;                // 页序号，每开一新页加1
+    u32 first_timestamp;    // 本页第一条记录时间戳
+    u32 last_timestamp;     // 本页最后一条记录时间戳（封页时写入）
+    u16 sensor_count;       // 本页传感器样本数（封页时写入）
+    u16 operation_count;    // 本页操作记录数（封页时写入）
+    u32 erase_count;        // 本页累计擦除次数，0xFFFFFFFF表示未知
+    u16 alarm_count;        // 本页报警记录数（封页时写入）
+    u16 sealed;             // LOG_PAGE_SEALED表示页头统计有效
+    u16 ring;               // 所属记录环，与当前划分不符的页按空页回收
+    u8  reserved[6];        // 保留字段
+} __attribute__((packed)) LogPageHeader_t;
+
+// 压缩传感器记录，一个16字节槽保存最多LOG_PACK_SAMPLES个样本
+// 第一个样本完整保存，其后每个样本为相对前一样本的16位增量：
+// bit0-3时间增量-1(s)，bit4-6温度，bit7-10湿度，bit11-15光照（有符号），0xFFFF表示未使用
+// 设备状态、工作模式或报警标志变化时另起一条
+typedef struct
+{
+    u32 timestamp;      // 第一个样本时间戳
+    u8  log_type;       // LOG_TYPE_SENSOR_PACK
+    u8  temperature;    // 温度
+    u8  humi_fan;       // bit0-6湿度，bit7风扇状态
+    u8  light_pump;     // bit0-6光照，bit7水泵状态
+    u8  flags;          // bit0-5报警标志，bit6补光灯状态，bit7工作模式
+    u16 delta[LOG_PACK_SAMPLES - 1]; // 后续样本增量
+    u8  commit;         // 提交字节
+} __attribute__((packed)) SensorPackRecord_t;
+
 // 通用记录结构
 typedef union
 {
     u8 raw_data[16];
     SensorLogRecord_t sensor;
+    SensorPackRecord_t pack;
     OperationLogRecord_t operation;
     AlarmLogRecord_t alarm;
 } LogRecord_t;
@@ -97,8 +169,8 @@ typedef struct
     u32 alarm_records;      // 报警记录数
     u32 oldest_timestamp;   // 最旧记录时间戳
     u32 newest_timestamp;   // 最新记录时间戳
-    u16 current_page;       // 当前写入页
-    u16 current_offset;     // 当前页内偏移
+    u16 current_page;       // 传感器环当前写入页
+    u16 current_offset;     // 传感器环当前页内下一写入槽（0-本页未打开，LOG_SLOTS_PER_PAGE-已写满）
 } DataLoggerInfo_t;
 
 // 查询条件结构
@@ -110,6 +182,34 @@ typedef struct
     u16 max_records;    // 最大返回记录数
 } LogQuery_t;
 
+#define LOG_CURSOR_FORWARD  0           // 从旧到新
+#define LOG_CURSOR_BACKWARD 1           // 从新到旧
+
+// 游标在一个记录环上的位置
+typedef struct
+{
+    const LogRecord_t* next;    // 已读出、等待按时间合并输出的记录，0-需要读取
+    u16 page_n;                 // 按时间顺序的页序号（0为最旧页）
+    u16 slot;                   // 下一个读取的槽
+    u8  done;                   // 本环已遍历结束
+} LogRingCursor_t;
+
+// 记录游标：逐条遍历[start_time, end_time]内的记录，不复制记录
+// 指定记录类型时只遍历该类型的环，否则按时间顺序合并各环
+// 普通记录直接返回Flash中的地址，压缩记录展开到游标内的samples后逐个返回
+// 返回的指针在下一次DataLogger_CursorNext前有效；遍历期间不要写入记录，结束后调用DataLogger_CursorClose
+typedef struct
+{
+    u32 start_time;     // 开始时间
+    u32 end_time;       // 结束时间
+    u8  log_type;       // 记录类型（0-全部）
+    u8  direction;      // LOG_CURSOR_FORWARD/LOG_CURSOR_BACKWARD
+    u8  sample;         // samples中已返回的样本数
+    u8  sample_count;   // samples中的样本数
+    LogRingCursor_t ring[LOG_RING_COUNT];        // 各记录环上的位置
+    SensorLogRecord_t samples[LOG_PACK_SAMPLES]; // 传感器环展开的压缩记录
+} LogCursor_t;
+
 // 函数声明
 u8 DataLogger_Init(void);                              // 初始化数据记录器
 u8 DataLogger_WriteSensorData(u8 temp, u8 humi, u8 light, 
@@ -120,16 +220,27 @@ u8 DataLogger_WriteOperation(u8 operation, u8 old_val,
 u8 DataLogger_WriteAlarm(u8 alarm_type, u8 level, 
                         u8 trigger_val, u8 threshold); // 记录报警
 u16 DataLogger_Query(LogQuery_t* query, LogRecord_t* records, u16 buffer_size); // 查询记录
+void DataLogger_CursorOpen(LogCursor_t* cursor, u32 start_time, u32 end_time,
+                           u8 log_type, u8 direction);  // 打开记录游标
+const LogRecord_t* DataLogger_CursorNext(LogCursor_t* cursor); // 下一条记录，结束返回0
+void DataLogger_CursorClose(LogCursor_t* cursor);      // 关闭记录游标
+u16 DataLogger_ReadRaw(u32* pos, const LogRecord_t** data, u16 max_records); // 按记录位置读取原始记录槽
 u8 DataLogger_GetInfo(DataLoggerInfo_t* info);         // 获取统计信息
 u8 DataLogger_EraseAll(void);                          // 清空所有记录
 u8 DataLogger_GetDailyStats(u32 date, u8* avg_temp, u8* avg_humi, 
                            u8* avg_light, u16* operations); // 获取日统计
+u8 DataLogger_GetWeeklyStats(u32 week_start, u8* avg_temp, u8* avg_humi,
+                            u8* avg_light, u16* operations); // 获取周统计
 void DataLogger_PrintRecords(u16 count);               // 打印最近记录
+u8 DataLogger_Flush(void);                             // 将暂存记录写入Flash
+u32 DataLogger_GetEraseCount(u16 page);                // 获取页累计擦除次数
+void DataLogger_Task(void);                            // 周期任务：暂存超时则写入Flash
+void DataLogger_Acquire(void);                         // 占用Flash，掉电写入推迟到释放时
+void DataLogger_Release(void);                         // 释放Flash占用
 
 // 内部函数
 static u8 DataLogger_FindNextPage(void);               // 查找下一可用页
 static u8 DataLogger_WriteRecord(LogRecord_t* record); // 写入记录
-static u8 DataLogger_ReadRecord(u32 addr, LogRecord_t* record); // 读取记录
 static u8 DataLogger_ErasePage(u16 page);              // 擦除页
 static u32 DataLogger_GetTimestamp(void);              // 获取时间戳
 
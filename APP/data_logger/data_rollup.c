@@ -0,0 +1,390 @@
+#include "data_rollup.h"
+#include "data_logger.h"
+#include "string.h"
+#include "stdio.h"
+
+#define ROLLUP_PER_PAGE     (FLASH_PAGE_SIZE / sizeof(LogRollup_t))
+
+// 汇总环：按时间顺序追加，写入每页第一条前擦除该页
+typedef struct
+{
+    u32 base;           // 起始地址
+    u16 slots;          // 记录槽数
+    u16 head;           // 下一写入槽
+    u32 seconds;        // 时段长度(s)
+    LogRollup_t open;   // 当前时段的累加值
+    u8  open_valid;     // open是否已开始
+} RollupRing_t;
+
+static RollupRing_t rollup_ring[ROLLUP_PERIODS] =
+{
+    {ROLLUP_START_ADDR, ROLLUP_HOUR_PAGES * ROLLUP_PER_PAGE, 0, ROLLUP_HOUR_SECONDS, {0}, 0},
+    {ROLLUP_START_ADDR + ROLLUP_HOUR_PAGES * FLASH_PAGE_SIZE, ROLLUP_DAY_PAGES * ROLLUP_PER_PAGE, 0, ROLLUP_DAY_SECONDS, {0}, 0}
+};
+
+#define ROLLUP_SLOT(ring, i)    ((const LogRollup_t*)((ring)->base + (u32)(i) * sizeof(LogRollup_t)))
+#define ROLLUP_USED(ring, i)    (ROLLUP_SLOT(ring, i)->period_start != 0xFFFFFFFF)
+
+static void DataRollup_Reset(LogRollup_t* r, u32 period_start)
+{
+    memset(r, 0, sizeof(LogRollup_t));
+    r->period_start = period_start;
+    r->temp_min = 0xFF;
+    r->humi_min = 0xFF;
+    r->light_min = 0xFF;
+}
+
+/**
+ * @brief  恢复写入位置：找到第一条记录最新的页，页内二分查找第一个空槽
+ * @note   period_start最先写入，写入中途掉电的槽也会被跳过
+ */
+static void DataRollup_RingInit(RollupRing_t* ring)
+{
+    u16 pages = ring->slots / ROLLUP_PER_PAGE;
+    u16 page, best = 0xFFFF;
+    u16 lo, hi, mid;
+
+    ring->open_valid = 0;
+    for(page = 0; page < pages; page++)
+    {
+        if(!ROLLUP_USED(ring, page * ROLLUP_PER_PAGE)) continue;
+        if(best == 0xFFFF || ROLLUP_SLOT(ring, page * ROLLUP_PER_PAGE)->period_start >
+                             ROLLUP_SLOT(ring, best * ROLLUP_PER_PAGE)->period_start)
+            best = page;
+    }
+    if(best == 0xFFFF)
+    {
+        ring->head = 0;
+        return;
+    }
+
+    // lo槽已用，hi槽为空或页尾
+    lo = best * ROLLUP_PER_PAGE;
+    hi = lo + ROLLUP_PER_PAGE;
+    while(hi - lo > 1)
+    {
+        mid = (lo + hi) / 2;
+        if(ROLLUP_USED(ring, mid)) lo = mid;
+        else hi = mid;
+    }
+    ring->head = hi % ring->slots;
+}
+
+/**
+ * @brief  最旧记录位置及记录数
+ * @note   写入位置在页中间时其后为已擦除空槽，最旧记录在下一页开头；
+ *         写入位置在页首且该页未擦除时，该页即最旧页
+ */
+static u16 DataRollup_Oldest(const RollupRing_t* ring, u16* count)
+{
+    u16 next = (u16)(((ring->head / ROLLUP_PER_PAGE + 1) * ROLLUP_PER_PAGE) % ring->slots);
+    u16 oldest = 0;
+
+    if(ROLLUP_USED(ring, ring->head))
+        oldest = ring->head;
+    else if(ROLLUP_USED(ring, next))
+        oldest = next;
+
+    *count = (ring->head + ring->slots - oldest) % ring->slots;
+    if(*count == 0 && ROLLUP_USED(ring, ring->head))
+        *count = ring->slots;
+    return oldest;
+}
+
+/**
+ * @brief  按时段起始时间二分查找已写入的汇总记录
+ */
+static const LogRollup_t* DataRollup_Find(const RollupRing_t* ring, u32 period_start)
+{
+    const LogRollup_t* rec;
+    u16 oldest, count, lo, hi, mid;
+
+    oldest = DataRollup_Oldest(ring, &count);
+    lo = 0;
+    hi = count;
+    while(lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if(ROLLUP_SLOT(ring, (oldest + mid) % ring->slots)->period_start < period_start)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo >= count) return 0;
+    rec = ROLLUP_SLOT(ring, (oldest + lo) % ring->slots);
+    if(rec->period_start != period_start || rec->commit != ROLLUP_COMMIT) return 0;
+    return rec;
+}
+
+/**
+ * @brief  追加一条汇总记录：先写period_start占用该槽，再写内容，最后写commit
+ * @note   LogRollup_t为紧凑结构，不保证半字对齐，先复制到半字缓冲区再编程；
+ *         编程期间占用Flash，掉电中断不会在中途写入记录并锁上Flash
+ */
+static u8 DataRollup_Append(RollupRing_t* ring, const LogRollup_t* r)
+{
+    u32 addr = ring->base + (u32)ring->head * sizeof(LogRollup_t);
+    u16 data[sizeof(LogRollup_t) / 2];
+    FLASH_Status status = FLASH_COMPLETE;
+    u16 i;
+
+    memcpy(data, r, sizeof(LogRollup_t));
+    DataLogger_Acquire();
+
+    if(ring->head % ROLLUP_PER_PAGE == 0)
+    {
+        for(i = 0; i < FLASH_PAGE_SIZE; i += 4)
+        {
+            if(*(volatile u32*)(addr + i) != 0xFFFFFFFF) break;
+        }
+        if(i < FLASH_PAGE_SIZE)
+        {
+            FLASH_Unlock();
+            status = FLASH_ErasePage(addr);
+            FLASH_Lock();
+        }
+    }
+
+    FLASH_Unlock();
+    for(i = 0; i < sizeof(LogRollup_t) / 2 - 1 && status == FLASH_COMPLETE; i++)
+        status = FLASH_ProgramHalfWord(addr + i * 2, data[i]);
+    if(status == FLASH_COMPLETE)
+        status = FLASH_ProgramHalfWord(addr + sizeof(LogRollup_t) - 2, ROLLUP_COMMIT);
+    FLASH_Lock();
+    DataLogger_Release();
+
+    ring->head = (ring->head + 1) % ring->slots;
+    if(status != FLASH_COMPLETE)
+    {
+        printf("Rollup write failed!\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  时间进入新时段时写入上一时段并开始累加新时段
+ */
+static LogRollup_t* DataRollup_Roll(RollupRing_t* ring, u32 timestamp)
+{
+    u32 start = timestamp - timestamp % ring->seconds;
+
+    if(ring->open_valid && ring->open.period_start != start)
+    {
+        ring->open.commit = ROLLUP_COMMIT;
+        DataRollup_Append(ring, &ring->open);
+        ring->open_valid = 0;
+    }
+    if(!ring->open_valid)
+    {
+        DataRollup_Reset(&ring->open, start);
+        ring->open_valid = 1;
+    }
+    return &ring->open;
+}
+
+/**
+ * @brief  累加一个传感器样本到一个汇总环的当前时段
+ */
+static void DataRollup_RingSample(RollupRing_t* ring, u32 timestamp, u8 temp, u8 humi, u8 light)
+{
+    LogRollup_t* r = DataRollup_Roll(ring, timestamp);
+
+    r->samples++;
+    r->temp_sum += temp;
+    r->humi_sum += humi;
+    r->light_sum += light;
+    if(temp < r->temp_min) r->temp_min = temp;
+    if(temp > r->temp_max) r->temp_max = temp;
+    if(humi < r->humi_min) r->humi_min = humi;
+    if(humi > r->humi_max) r->humi_max = humi;
+    if(light < r->light_min) r->light_min = light;
+    if(light > r->light_max) r->light_max = light;
+}
+
+/**
+ * @brief  累加一条操作或报警记录到一个汇总环的当前时段
+ */
+static void DataRollup_RingEvent(RollupRing_t* ring, u32 timestamp, u8 log_type)
+{
+    LogRollup_t* r = DataRollup_Roll(ring, timestamp);
+
+    if(log_type == LOG_TYPE_OPERATION && r->operations < 0xFFFF) r->operations++;
+    if(log_type == LOG_TYPE_ALARM && r->alarms < 0xFFFF) r->alarms++;
+}
+
+/**
+ * @brief  汇总环需要从记录中重建的起始时间
+ * @note   最新汇总记录之后的时段在复位前只在RAM中累加，需要重建；
+ *         环为空时只重建当前时段，不为已有的全部记录补写汇总
+ */
+static u32 DataRollup_ResumeTime(const RollupRing_t* ring, u32 now)
+{
+    u32 start = now - now % ring->seconds;
+    u32 next;
+    u16 count;
+
+    DataRollup_Oldest(ring, &count);
+    if(count == 0) return start;
+    next = ROLLUP_SLOT(ring, (ring->head + ring->slots - 1) % ring->slots)->period_start + ring->seconds;
+    return (next < start) ? next : start;
+}
+
+/**
+ * @brief  初始化汇总模块
+ * @param  now: 当前时间戳
+ * @note   复位前未写入的时段（当前时段及复位时尚未结束的时段）只在RAM中，
+ *         这里用游标从记录中按时间顺序重放，已结束的时段照常写入汇总环，当前时段留在RAM中继续累加；
+ *         需在记录环恢复之后调用
+ */
+void DataRollup_Init(u32 now)
+{
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u32 from[ROLLUP_PERIODS];
+    u32 start = 0xFFFFFFFF;
+    u8 i;
+
+    for(i = 0; i < ROLLUP_PERIODS; i++)
+    {
+        DataRollup_RingInit(&rollup_ring[i]);
+        from[i] = DataRollup_ResumeTime(&rollup_ring[i], now);
+        if(from[i] < start) start = from[i];
+    }
+
+    DataLogger_CursorOpen(&cursor, start, now, 0, LOG_CURSOR_FORWARD);
+    while((rec = DataLogger_CursorNext(&cursor)) != 0)
+    {
+        for(i = 0; i < ROLLUP_PERIODS; i++)
+        {
+            if(rec->sensor.timestamp < from[i]) continue;
+            if(rec->sensor.log_type == LOG_TYPE_SENSOR)
+                DataRollup_RingSample(&rollup_ring[i], rec->sensor.timestamp, rec->sensor.temperature,
+                                      rec->sensor.humidity, rec->sensor.light);
+            else if(rec->sensor.log_type == LOG_TYPE_OPERATION || rec->sensor.log_type == LOG_TYPE_ALARM)
+                DataRollup_RingEvent(&rollup_ring[i], rec->sensor.timestamp, rec->sensor.log_type);
+        }
+    }
+    DataLogger_CursorClose(&cursor);
+}
+
+/**
+ * @brief  累加一个传感器样本到小时和日汇总
+ */
+void DataRollup_AddSample(u32 timestamp, u8 temp, u8 humi, u8 light)
+{
+    u8 i;
+
+    for(i = 0; i < ROLLUP_PERIODS; i++)
+    {
+        DataRollup_RingSample(&rollup_ring[i], timestamp, temp, humi, light);
+    }
+}
+
+/**
+ * @brief  累加一条操作或报警记录到小时和日汇总
+ */
+void DataRollup_AddEvent(u32 timestamp, u8 log_type)
+{
+    u8 i;
+
+    for(i = 0; i < ROLLUP_PERIODS; i++)
+    {
+        DataRollup_RingEvent(&rollup_ring[i], timestamp, log_type);
+    }
+}
+
+/**
+ * @brief  获取包含timestamp的时段汇总
+ * @param  period: ROLLUP_HOUR/ROLLUP_DAY
+ * @retval 0-成功，1-该时段无数据
+ */
+u8 DataRollup_Get(u8 period, u32 timestamp, LogRollup_t* out)
+{
+    RollupRing_t* ring;
+    const LogRollup_t* rec;
+    u32 start;
+
+    if(period >= ROLLUP_PERIODS) return 1;
+    ring = &rollup_ring[period];
+    start = timestamp - timestamp % ring->seconds;
+
+    if(ring->open_valid && ring->open.period_start == start)
+    {
+        *out = ring->open;
+        return 0;
+    }
+    rec = DataRollup_Find(ring, start);
+    if(rec == 0) return 1;
+    *out = *rec;
+    return 0;
+}
+
+/**
+ * @brief  合并[start, end)内的各时段汇总，例如7个日汇总得到周汇总
+ * @retval 0-成功，1-区间内无数据
+ */
+u8 DataRollup_GetRange(u8 period, u32 start, u32 end, LogRollup_t* out)
+{
+    LogRollup_t r;
+    u32 t, seconds;
+    u8 found = 0;
+
+    if(period >= ROLLUP_PERIODS) return 1;
+    seconds = rollup_ring[period].seconds;
+    DataRollup_Reset(out, start - start % seconds);
+    for(t = out->period_start; t < end; t += seconds)
+    {
+        if(DataRollup_Get(period, t, &r) == 0)
+        {
+            DataRollup_Merge(out, &r);
+            found = 1;
+        }
+    }
+    return found ? 0 : 1;
+}
+
+/**
+ * @brief  将src累加到dst
+ */
+void DataRollup_Merge(LogRollup_t* dst, const LogRollup_t* src)
+{
+    dst->temp_sum += src->temp_sum;
+    dst->humi_sum += src->humi_sum;
+    dst->light_sum += src->light_sum;
+    dst->operations = (dst->operations + src->operations > 0xFFFF) ? 0xFFFF : dst->operations + src->operations;
+    dst->alarms = (dst->alarms + src->alarms > 0xFFFF) ? 0xFFFF : dst->alarms + src->alarms;
+    if(src->samples > 0)
+    {
+        dst->samples += src->samples;
+        if(src->temp_min < dst->temp_min) dst->temp_min = src->temp_min;
+        if(src->temp_max > dst->temp_max) dst->temp_max = src->temp_max;
+        if(src->humi_min < dst->humi_min) dst->humi_min = src->humi_min;
+        if(src->humi_max > dst->humi_max) dst->humi_max = src->humi_max;
+        if(src->light_min < dst->light_min) dst->light_min = src->light_min;
+        if(src->light_max > dst->light_max) dst->light_max = src->light_max;
+    }
+}
+
+/**
+ * @brief  清空汇总区
+ */
+void DataRollup_EraseAll(void)
+{
+    u16 page;
+    u8 i;
+
+    DataLogger_Acquire();
+    FLASH_Unlock();
+    for(page = 0; page < ROLLUP_HOUR_PAGES + ROLLUP_DAY_PAGES; page++)
+    {
+        FLASH_ErasePage(ROLLUP_START_ADDR + (u32)page * FLASH_PAGE_SIZE);
+    }
+    FLASH_Lock();
+    DataLogger_Release();
+    for(i = 0; i < ROLLUP_PERIODS; i++)
+    {
+        rollup_ring[i].head = 0;
+        rollup_ring[i].open_valid = 0;
+    }
+}
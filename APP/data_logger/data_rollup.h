@@ -0,0 +1,49 @@
+#ifndef __DATA_ROLLUP_H__
+#define __DATA_ROLLUP_H__
+
+#include "stm32f10x.h"
+
+// 汇总存储区：配置区(0x0806F000)之前的8KB，小时汇总和日汇总各占两页，环形写入
+#define ROLLUP_START_ADDR   0x0806D000
+#define ROLLUP_HOUR_PAGES   2           // 小时汇总页数（保留64~128小时）
+#define ROLLUP_DAY_PAGES    2           // 日汇总页数（保留64~128天）
+
+// 汇总时段
+#define ROLLUP_HOUR         0
+#define ROLLUP_DAY          1
+#define ROLLUP_PERIODS      2
+
+#define ROLLUP_COMMIT       0x5AA5      // 记录完整标志
+
+#define ROLLUP_HOUR_SECONDS 3600
+#define ROLLUP_DAY_SECONDS  86400
+
+// 时段汇总记录（32字节），时段结束时写入Flash，当前时段保存在RAM中
+typedef struct
+{
+    u32 period_start;   // 时段起始时间戳（整点/零点）
+    u32 samples;        // 传感器样本数
+    u32 temp_sum;       // 温度累加值
+    u32 humi_sum;       // 湿度累加值
+    u32 light_sum;      // 光照累加值
+    u16 operations;     // 操作记录数
+    u16 alarms;         // 报警记录数
+    u8  temp_min;       // 最低温度
+    u8  temp_max;       // 最高温度
+    u8  humi_min;       // 最低湿度
+    u8  humi_max;       // 最高湿度
+    u8  light_min;      // 最低光照
+    u8  light_max;      // 最高光照
+    u16 commit;         // ROLLUP_COMMIT，最后写入，标志记录完整
+} __attribute__((packed)) LogRollup_t;
+
+// 函数声明
+void DataRollup_Init(u32 now);                                      // 恢复各汇总环，从记录重建未写入的时段
+void DataRollup_AddSample(u32 timestamp, u8 temp, u8 humi, u8 light); // 累加传感器样本
+void DataRollup_AddEvent(u32 timestamp, u8 log_type);               // 累加操作/报警记录
+u8 DataRollup_Get(u8 period, u32 timestamp, LogRollup_t* out);      // 获取包含timestamp的时段汇总
+u8 DataRollup_GetRange(u8 period, u32 start, u32 end, LogRollup_t* out); // 合并[start, end)内各时段
+void DataRollup_Merge(LogRollup_t* dst, const LogRollup_t* src);    // 合并两个汇总
+void DataRollup_EraseAll(void);                                     // 清空汇总区
+
+#endif /* __DATA_ROLLUP_H__ */
@@ -0,0 +1,95 @@
+#include "log_export.h"
+#include "data_logger.h"
+#include "usart3.h"
+#include "hc05.h"
+#include "crc16.h"
+#include "stdio.h"
+#include "string.h"
+
+static u8 export_active = 0;
+static u32 export_pos;                  // 下一帧的起始记录位置
+static u32 export_frames;               // 本次导出已发送的数据帧数
+static u8 export_frame[LOG_EXPORT_FRAME_MAX];
+
+/**
+ * @brief  组帧并写入USART3发送缓冲区
+ * @note   调用前需确认USART3_TX_Free()不小于帧长，整帧一次写入，不会与其他输出交错
+ */
+static void LogExport_SendFrame(u8 type, u32 pos, const u8* payload, u8 len)
+{
+    u16 crc;
+    u16 n = LOG_EXPORT_HEADER_LEN;
+
+    export_frame[0] = LOG_EXPORT_SYNC1;
+    export_frame[1] = LOG_EXPORT_SYNC2;
+    export_frame[2] = type;
+    export_frame[3] = len;
+    export_frame[4] = pos & 0xFF;
+    export_frame[5] = (pos >> 8) & 0xFF;
+    export_frame[6] = (pos >> 16) & 0xFF;
+    export_frame[7] = (pos >> 24) & 0xFF;
+    if(len > 0) memcpy(&export_frame[n], payload, len);
+    n += len;
+    crc = crc16_ccitt(0xFFFF, &export_frame[2], n - 2);
+    export_frame[n++] = crc & 0xFF;
+    export_frame[n++] = crc >> 8;
+    USART3_Write(export_frame, n);
+}
+
+/**
+ * @brief  从记录位置pos开始导出
+ * @param  pos: 记录位置，0或已被覆盖的位置从最旧记录开始
+ */
+void LogExport_Start(u32 pos)
+{
+    DataLogger_Flush();     // 暂存的记录一并导出
+    export_pos = pos;
+    export_frames = 0;
+    export_active = 1;
+    printf("Log export started at pos 0x%08lX\r\n", pos);
+}
+
+/**
+ * @brief  停止导出，断点为最后发送的位置
+ */
+void LogExport_Stop(void)
+{
+    if(!export_active) return;
+    export_active = 0;
+    printf("Log export stopped at pos 0x%08lX (%lu frames)\r\n", export_pos, export_frames);
+}
+
+u8 LogExport_Active(void)
+{
+    return export_active;
+}
+
+/**
+ * @brief  导出任务：发送缓冲区能容纳整帧时直接从Flash组帧，保持DMA连续发送
+ * @note   读到最新记录后发送结束帧并停止；导出期间新写入的记录也会被导出；
+ *         读取到组帧完成期间占用Flash，掉电写入不会擦除正在读取的页
+ */
+void LogExport_Task(void)
+{
+    const LogRecord_t* data;
+    u16 count;
+
+    // AT事务期间暂停，发送缓冲区排空后HC05任务才会进入AT模式
+    while(export_active && !HC05_AT_Busy() && USART3_TX_Free() >= LOG_EXPORT_FRAME_MAX)
+    {
+        DataLogger_Acquire();
+        count = DataLogger_ReadRaw(&export_pos, &data, LOG_EXPORT_RECORDS);
+        if(count == 0)
+        {
+            DataLogger_Release();
+            LogExport_SendFrame(LOG_EXPORT_END, export_pos, 0, 0);
+            export_active = 0;
+            printf("Log export done at pos 0x%08lX (%lu frames)\r\n", export_pos, export_frames);
+            return;
+        }
+        LogExport_SendFrame(LOG_EXPORT_DATA, export_pos, data->raw_data, count * LOG_RECORD_SIZE);
+        DataLogger_Release();
+        export_pos += count;
+        export_frames++;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef __LOG_EXPORT_H__
+#define __LOG_EXPORT_H__
+
+#include "stm32f10x.h"
+
+// 日志二进制导出：通过USART3（蓝牙）按帧发送Flash中的原始记录槽，可从任意记录位置续传
+//
+// 帧格式（多字节字段为小端）：
+//   0xA5 0x5A | type(1) | len(1) | pos(4) | payload(len) | crc(2)
+//   crc为CRC-16/CCITT-FALSE（多项式0x1021，初值0xFFFF），覆盖type至payload末尾
+// type:
+//   LOG_EXPORT_DATA  payload为len/16个连续的16字节原始记录槽（格式见data_logger.h，
+//                    压缩记录不展开），pos为第一个槽的记录位置LOG_POS(环号, 页序号, 槽号)
+//   LOG_EXPORT_END   无payload，pos为导出结束位置；
+//                    断线后发送"EXPORT <pos>"从最后一个完整帧的pos + len/16处续传
+// 每次导出一个记录环，环号取pos最高字节（0-传感器，1-操作，2-报警），
+// 例如"EXPORT 0x02000000"从最旧的报警记录开始导出
+#define LOG_EXPORT_SYNC1        0xA5
+#define LOG_EXPORT_SYNC2        0x5A
+#define LOG_EXPORT_DATA         0x01
+#define LOG_EXPORT_END          0x02
+
+#define LOG_EXPORT_RECORDS      8       // 每帧记录槽数
+#define LOG_EXPORT_HEADER_LEN   8       // 同步字+type+len+pos
+#define LOG_EXPORT_FRAME_MAX    (LOG_EXPORT_HEADER_LEN + LOG_EXPORT_RECORDS * 16 + 2)
+
+// 函数声明
+void LogExport_Start(u32 pos);          // 从记录位置pos开始导出（0-从最旧记录开始）
+void LogExport_Stop(void);              // 停止导出
+u8 LogExport_Active(void);              // 是否正在导出
+void LogExport_Task(void);              // 周期任务：发送缓冲区有空间时继续发帧
+
+#endif /* __LOG_EXPORT_H__ */
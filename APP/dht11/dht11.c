@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include "stm32f10x.h"  // 添加STM32头文件，解决GPIO定义问题
 
 // 外部全局变量声明
@@ -11,6 +12,16 @@ extern volatile u32 system_time_ms;
 static DHT11_Data_t dht11_data = {0};
 static DHT11_Filter_t dht11_filter = {0};
 
+// 异步采集状态（由TIM6/EXTI15_10中断推进）
+static volatile DHT11_AsyncState_t async_state = DHT11_ASYNC_IDLE;
+static volatile u16 async_edges[DHT11_EDGE_COUNT];  // 下降沿时间戳(us, 相对释放总线时刻)
+static volatile u8 async_edge_count = 0;
+static volatile u8 async_ready = 0;                 // 完成标志
+static volatile DHT11_Status_t async_status = DHT11_OK;
+static u8 async_frame[5];
+static u32 async_last_start = 0;
+static u8 async_started = 0;
+
 // Set DHT11 IO to output mode
 void DHT11_IO_OUT(void)
 {
@@ -131,6 +142,7 @@ u8 DHT11_Init(void)
     // 初始化GPIO
     DHT11_IO_OUT();
     DHT11_DQ_OUT = 1;
+    DHT11_Async_Init();
     delay_ms(100);  // 等待DHT11上电稳定
     
     // 测试传感器连接
@@ -155,6 +167,8 @@ u8 DHT11_Read_Data(u8 *temp, u8 *humi)
     u8 buf[5];
     u8 i;
     
+    if(DHT11_Async_Busy()) return 1; // 异步采集进行中，不能占用总线
+    
     DHT11_Rst();
     if(DHT11_Check() == 0)
     {
@@ -336,78 +350,66 @@ DHT11_Data_t* DHT11_Get_Data_Handle(void)
  * @brief 增强版DHT11数据读取
  * @param data DHT11数据结构体指针
  * @return DHT11_Status_t 读取状态
+ * @note 非阻塞：取上一次异步采集的结果并启动下一次采集，
+ *       失败时不再原地延时重试，由下一次调用自然重试
  */
 DHT11_Status_t DHT11_Read_Data_Enhanced(DHT11_Data_t* data)
 {
     u8 temp_raw, humi_raw;
     float temp_filtered, humi_filtered;
-    u8 result;
-    u8 retry;
+    DHT11_Status_t result;
     u32 current_time = system_time_ms; // 获取当前时间
-    u32 min_interval;
     
-    // 根据模式设置最小读取间隔
-    // 真实传感器需要至少1秒间隔，模拟模式可以更频繁
-    min_interval = 1000; // 真实传感器1秒间隔
-    
-    // 检查读取间隔
-    if(current_time - data->last_read_time < min_interval) {
-        printf("DHT11: 读取间隔太短，需要等待 (模式:%s, 间隔:%dms)\r\n", 
-               "真实", min_interval);
-        return DHT11_ERROR_TIMEOUT;
+    if(!DHT11_Async_Ready()) {
+        DHT11_Async_Start();
+        return DHT11_ERROR_TIMEOUT; // 尚无新数据
     }
     
-    // 多次重试读取
-    for(retry = 0; retry < DHT11_MAX_RETRY; retry++) {
-        result = DHT11_Read_Data(&temp_raw, &humi_raw);
-        
-        if(result == 0) { // 读取成功
-            // 数据验证
-            if(DHT11_Validate_Data(temp_raw, humi_raw)) {
-                // 数据滤波
-                temp_filtered = DHT11_Filter_Data((float)temp_raw, 
-                                                  dht11_filter.temp_buffer, 
-                                                  DHT11_FILTER_SIZE,
-                                                  &dht11_filter.index,
-                                                  &dht11_filter.count);
-                
-                humi_filtered = DHT11_Filter_Data((float)humi_raw, 
-                                                  dht11_filter.humi_buffer, 
-                                                  DHT11_FILTER_SIZE,
-                                                  &dht11_filter.index,
-                                                  &dht11_filter.count);
-                
-                // 应用校准
-                if(data->calibration_enabled) {
-                    temp_filtered += data->temp_offset;
-                    humi_filtered += data->humi_offset;
-                }
-                
-                // 更新数据
-                data->temperature = temp_filtered;
-                data->humidity = humi_filtered;
-                data->status = DHT11_OK;
-                data->retry_count = retry;
-                data->last_read_time = current_time;
-                
-                printf("DHT11: 增强读取成功 - 原始T=%d°C,H=%d%% 滤波后T=%.1f°C,H=%.1f%% (重试%d次,%s)\r\n",
-                       temp_raw, humi_raw, temp_filtered, humi_filtered, retry,
-                       "真实模式");
-                
-                return DHT11_OK;
-            } else {
-                data->status = DHT11_ERROR_INVALID_DATA;
+    result = DHT11_Async_Get_Result(&temp_raw, &humi_raw);
+    DHT11_Async_Start();
+    
+    if(result == DHT11_OK) { // 读取成功
+        // 数据验证
+        if(DHT11_Validate_Data(temp_raw, humi_raw)) {
+            // 数据滤波
+            temp_filtered = DHT11_Filter_Data((float)temp_raw, 
+                                              dht11_filter.temp_buffer, 
+                                              DHT11_FILTER_SIZE,
+                                              &dht11_filter.index,
+                                              &dht11_filter.count);
+            
+            humi_filtered = DHT11_Filter_Data((float)humi_raw, 
+                                              dht11_filter.humi_buffer, 
+                                              DHT11_FILTER_SIZE,
+                                              &dht11_filter.index,
+                                              &dht11_filter.count);
+            
+            // 应用校准
+            if(data->calibration_enabled) {
+                temp_filtered += data->temp_offset;
+                humi_filtered += data->humi_offset;
             }
-        } else {
-            data->status = (retry == DHT11_MAX_RETRY - 1) ? DHT11_ERROR_NO_RESPONSE : DHT11_ERROR_TIMEOUT;
+            
+            // 更新数据
+            data->temperature = temp_filtered;
+            data->humidity = humi_filtered;
+            data->status = DHT11_OK;
+            data->retry_count = 0;
+            data->last_read_time = current_time;
+            
+            printf("DHT11: 增强读取成功 - 原始T=%d°C,H=%d%% 滤波后T=%.1f°C,H=%.1f%%\r\n",
+                   temp_raw, humi_raw, temp_filtered, humi_filtered);
+            
+            return DHT11_OK;
         }
-        
-        delay_ms(500); // 重试间隔
+        data->status = DHT11_ERROR_INVALID_DATA;
+    } else {
+        data->status = result;
     }
     
-    data->retry_count = retry;
-    printf("DHT11: 增强读取失败 - 重试%d次后仍无法获取有效数据 (%s)\r\n", retry,
-           "真实模式");
+    data->error_count++;
+    if(data->retry_count < 0xFF) data->retry_count++;
+    printf("DHT11: 增强读取失败 - 状态%d, 连续失败%d次\r\n", data->status, data->retry_count);
     
     return data->status;
 }
@@ -443,6 +445,13 @@ void DHT11_Update_With_Retry(void)
             printf("DHT11: 传感器无响应\r\n");
             break;
             
+        case DHT11_ERROR_CHECKSUM:
+        case DHT11_ERROR_TRUNCATED:
+        case DHT11_ERROR_TIMING:
+            consecutive_errors++;
+            printf("DHT11: 数据帧错误(%d)\r\n", status);
+            break;
+            
         default:
             consecutive_errors++;
             printf("DHT11: 未知错误\r\n");
@@ -456,3 +465,214 @@ void DHT11_Update_With_Retry(void)
         consecutive_errors = 0;
     }
 }
+
+/* ========================= 异步采集 ========================= */
+/*
+ * 时序: 主机拉低20ms(TIM6单脉冲) -> 释放总线并打开EXTI11下降沿中断，
+ * TIM6重新从0计数作为1us时间基准和整帧超时 -> 每个下降沿记录TIM6计数值
+ * -> 收满42个下降沿或超时后解码，置完成标志。
+ * 相邻下降沿间隔 = 50us低电平 + 高电平宽度，据此区分0/1。
+ */
+
+// 以1MHz从0开始单次计时，到期产生TIM6更新中断
+static void DHT11_Timer_Arm(u16 us)
+{
+    TIM_Cmd(DHT11_TIM, DISABLE);
+    TIM_SetAutoreload(DHT11_TIM, us - 1);
+    TIM_SetCounter(DHT11_TIM, 0);
+    TIM_ClearITPendingBit(DHT11_TIM, TIM_IT_Update);
+    TIM_Cmd(DHT11_TIM, ENABLE);
+}
+
+// 结束一次采集：解码并置完成标志（中断上下文调用）
+static void DHT11_Async_Finish(void)
+{
+    EXTI->IMR &= ~DHT11_EXTI_LINE;
+    TIM_Cmd(DHT11_TIM, DISABLE);
+    async_status = DHT11_Decode_Frame((const u16*)async_edges, async_edge_count, async_frame);
+    async_state = DHT11_ASYNC_IDLE;
+    async_ready = 1;
+}
+
+/**
+ * @brief 配置异步采集用的TIM6单脉冲计时器和PG11下降沿中断
+ */
+void DHT11_Async_Init(void)
+{
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure;
+    EXTI_InitTypeDef EXTI_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+    
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM6, ENABLE);
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
+    
+    // TIM6: 72MHz/72 = 1MHz，单脉冲模式
+    TIM_TimeBaseInitStructure.TIM_Period = DHT11_START_LOW_US - 1;
+    TIM_TimeBaseInitStructure.TIM_Prescaler = 72 - 1;
+    TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(DHT11_TIM, &TIM_TimeBaseInitStructure);
+    TIM_SelectOnePulseMode(DHT11_TIM, TIM_OPMode_Single);
+    TIM_UpdateRequestConfig(DHT11_TIM, TIM_UpdateSource_Regular); // 仅溢出产生更新中断
+    TIM_ClearITPendingBit(DHT11_TIM, TIM_IT_Update);
+    TIM_ITConfig(DHT11_TIM, TIM_IT_Update, ENABLE);
+    
+    // PG11 -> EXTI11 下降沿，平时屏蔽
+    GPIO_EXTILineConfig(GPIO_PortSourceGPIOG, GPIO_PinSource11);
+    EXTI_InitStructure.EXTI_Line = DHT11_EXTI_LINE;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = DISABLE;
+    EXTI_Init(&EXTI_InitStructure);
+    EXTI_ClearITPendingBit(DHT11_EXTI_LINE);
+    
+    // 边沿时间戳精度依赖中断响应，使用最高优先级
+    NVIC_InitStructure.NVIC_IRQChannel = EXTI15_10_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+    
+    NVIC_InitStructure.NVIC_IRQChannel = TIM6_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_Init(&NVIC_InitStructure);
+    
+    async_state = DHT11_ASYNC_IDLE;
+}
+
+/**
+ * @brief 启动一次异步采集
+ * @return 0-已启动 1-正在采集或距上次启动不足DHT11_MIN_INTERVAL_MS
+ */
+u8 DHT11_Async_Start(void)
+{
+    if(async_state != DHT11_ASYNC_IDLE) return 1;
+    if(async_started && system_time_ms - async_last_start < DHT11_MIN_INTERVAL_MS) return 1;
+    
+    async_started = 1;
+    async_last_start = system_time_ms;
+    async_edge_count = 0;
+    
+    DHT11_IO_OUT();
+    DHT11_DQ_OUT = 0; // 起始信号，持续时间由TIM6计时
+    async_state = DHT11_ASYNC_START;
+    DHT11_Timer_Arm(DHT11_START_LOW_US);
+    
+    return 0;
+}
+
+/**
+ * @brief 是否正在采集
+ */
+u8 DHT11_Async_Busy(void)
+{
+    return async_state != DHT11_ASYNC_IDLE;
+}
+
+/**
+ * @brief 完成标志：是否有新的采集结果待取
+ */
+u8 DHT11_Async_Ready(void)
+{
+    return async_ready;
+}
+
+/**
+ * @brief 取出采集结果并清除完成标志
+ * @param temp 温度输出（仅成功时写入）
+ * @param humi 湿度输出（仅成功时写入）
+ * @return 本次采集状态；无新结果时返回DHT11_ERROR_TIMEOUT
+ */
+DHT11_Status_t DHT11_Async_Get_Result(u8 *temp, u8 *humi)
+{
+    if(!async_ready) return DHT11_ERROR_TIMEOUT;
+    
+    async_ready = 0;
+    if(async_status == DHT11_OK) {
+        *humi = async_frame[0];
+        *temp = async_frame[2];
+    }
+    return async_status;
+}
+
+/**
+ * @brief 由下降沿时间戳解码一帧数据
+ * @param edges 下降沿时间戳(us)，edges[0]为传感器应答起始
+ * @param count 时间戳数量
+ * @param buf 5字节输出：湿度整数、湿度小数、温度整数、温度小数、校验和
+ * @return DHT11_OK或具体错误
+ */
+DHT11_Status_t DHT11_Decode_Frame(const u16 *edges, u8 count, u8 *buf)
+{
+    u8 i;
+    u16 width;
+    
+    if(count == 0) return DHT11_ERROR_NO_RESPONSE;
+    if(count < DHT11_EDGE_COUNT) return DHT11_ERROR_TRUNCATED;
+    
+    width = edges[1] - edges[0];
+    if(width < DHT11_ACK_MIN_US || width > DHT11_ACK_MAX_US) return DHT11_ERROR_TIMING;
+    
+    memset(buf, 0, 5);
+    for(i = 0; i < 40; i++)
+    {
+        width = edges[i + 2] - edges[i + 1];
+        if(width < DHT11_BIT_MIN_US || width > DHT11_BIT_MAX_US) return DHT11_ERROR_TIMING;
+        
+        buf[i / 8] <<= 1;
+        if(width > DHT11_BIT_THRESHOLD_US) buf[i / 8] |= 1;
+    }
+    
+    if((u8)(buf[0] + buf[1] + buf[2] + buf[3]) != buf[4]) return DHT11_ERROR_CHECKSUM;
+    
+    return DHT11_OK;
+}
+
+/**
+ * @brief TIM6中断：起始信号结束 / 整帧超时
+ */
+void TIM6_IRQHandler(void)
+{
+    if(TIM_GetITStatus(DHT11_TIM, TIM_IT_Update) != RESET)
+    {
+        TIM_ClearITPendingBit(DHT11_TIM, TIM_IT_Update);
+        
+        if(async_state == DHT11_ASYNC_START)
+        {
+            // 释放总线，开始记录传感器下降沿，TIM6从0重新计时
+            DHT11_DQ_OUT = 1;
+            DHT11_IO_IN();
+            EXTI_ClearITPendingBit(DHT11_EXTI_LINE);
+            EXTI->IMR |= DHT11_EXTI_LINE;
+            async_state = DHT11_ASYNC_CAPTURE;
+            DHT11_Timer_Arm(DHT11_FRAME_TIMEOUT_US);
+        }
+        else if(async_state == DHT11_ASYNC_CAPTURE)
+        {
+            // 超时：传感器无应答或帧不完整
+            DHT11_Async_Finish();
+        }
+    }
+}
+
+/**
+ * @brief EXTI15_10中断：记录PG11下降沿时间戳
+ */
+void EXTI15_10_IRQHandler(void)
+{
+    u16 now = TIM_GetCounter(DHT11_TIM);
+    
+    if(EXTI_GetITStatus(DHT11_EXTI_LINE) != RESET)
+    {
+        EXTI_ClearITPendingBit(DHT11_EXTI_LINE);
+        
+        if(async_state == DHT11_ASYNC_CAPTURE && async_edge_count < DHT11_EDGE_COUNT)
+        {
+            async_edges[async_edge_count++] = now;
+            if(async_edge_count >= DHT11_EDGE_COUNT) {
+                DHT11_Async_Finish();
+            }
+        }
+    }
+}
@@ -22,14 +22,37 @@
 #define DHT11_FILTER_SIZE   5    // 滑动平均滤波器大小
 #define DHT11_MAX_RETRY     3    // 最大重试次数
 
+// DHT11异步采集配置 (EXTI11下降沿 + TIM6 1MHz计时)
+#define DHT11_EXTI_LINE         EXTI_Line11
+#define DHT11_TIM               TIM6
+#define DHT11_START_LOW_US      20000   // 主机起始信号低电平 (≥18ms)
+#define DHT11_FRAME_TIMEOUT_US  10000   // 应答+40位数据约4.3ms，超时视为帧不完整
+#define DHT11_MIN_INTERVAL_MS   1000    // 两次采集最小间隔
+#define DHT11_EDGE_COUNT        42      // 应答下降沿 + 40个数据位下降沿 + 结束下降沿
+#define DHT11_ACK_MIN_US        120     // 应答(80us低+80us高)下降沿间隔范围
+#define DHT11_ACK_MAX_US        220
+#define DHT11_BIT_MIN_US        60      // 数据位(50us低+26~70us高)下降沿间隔范围
+#define DHT11_BIT_MAX_US        160
+#define DHT11_BIT_THRESHOLD_US  100     // 间隔大于该值判为1 (0约78us, 1约120us)
+
 // DHT11状态枚举
 typedef enum {
     DHT11_OK = 0,              // 读取成功
     DHT11_ERROR_TIMEOUT,       // 超时错误
     DHT11_ERROR_NO_RESPONSE,   // 传感器无响应
-    DHT11_ERROR_INVALID_DATA   // 数据无效
+    DHT11_ERROR_INVALID_DATA,  // 数据无效
+    DHT11_ERROR_CHECKSUM,      // 校验和错误
+    DHT11_ERROR_TRUNCATED,     // 帧不完整（下降沿数量不足）
+    DHT11_ERROR_TIMING         // 脉宽超出协议范围
 } DHT11_Status_t;
 
+// DHT11异步采集状态
+typedef enum {
+    DHT11_ASYNC_IDLE = 0,      // 空闲
+    DHT11_ASYNC_START,         // 输出起始低电平
+    DHT11_ASYNC_CAPTURE        // 记录传感器下降沿
+} DHT11_AsyncState_t;
+
 // DHT11滤波器结构体
 typedef struct {
     float temp_buffer[DHT11_FILTER_SIZE];  // 温度历史数据（修正字段名）
@@ -76,4 +99,12 @@ DHT11_Status_t DHT11_Read_Data_Enhanced(DHT11_Data_t* data);
 float DHT11_Filter_Data(float new_data, float* buffer, u8 size, u8* index, u8* count);
 void DHT11_Update_With_Retry(void);
 
+// 异步采集函数（不阻塞主循环）
+void DHT11_Async_Init(void);                            // 配置TIM6/EXTI11
+u8 DHT11_Async_Start(void);                             // 启动一次采集，0-已启动 1-忙或间隔不足
+u8 DHT11_Async_Busy(void);                              // 是否正在采集
+u8 DHT11_Async_Ready(void);                             // 完成标志：有新结果待取
+DHT11_Status_t DHT11_Async_Get_Result(u8 *temp, u8 *humi); // 取结果并清除完成标志
+DHT11_Status_t DHT11_Decode_Frame(const u16 *edges, u8 count, u8 *buf); // 下降沿时间戳解码
+
 #endif
@@ -1,5 +1,6 @@
 #include "fan_pwm.h"
 #include "stdio.h"
+#include "log.h"
 
 static u16 pwm_period = 0;
 
@@ -69,7 +70,7 @@ void Fan_Set_Speed_Percent(u8 percent)
 	
 	TIM_SetCompare1(TIM3, ccr_val);
 	
-	printf("Fan PWM: Speed set to %d%% (CCR=%d)\r\n", percent, ccr_val);
+	LOG_DEBUG(("Fan PWM: Speed set to %d%% (CCR=%d)\r\n", percent, ccr_val));
 }
 
 /*******************************************************************************
@@ -8,10 +8,15 @@
 #include "usart3.h"
 #include "usart.h"
 #include "SysTick.h"
+#include "scheduler.h"
+#include "event_bus.h"
+#include "log.h"
 #include "string.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "greenhouse_display.h"
+#include "../data_logger/log_export.h"
+#include "telemetry.h"
 #include "../fan_pwm/fan_pwm.h"  // 添加PWM头文件
 #include "../ws2812/ws2812.h"    // 添加RGB彩灯头文件
 
@@ -19,6 +24,8 @@ extern volatile u32 system_time_ms;
 
 GreenhouseStatus_t greenhouse_status = {0};
 
+static void Greenhouse_Check_Commands(void);
+
 void Greenhouse_Init(void)
 {
     DHT11_Init();
@@ -28,8 +35,11 @@ void Greenhouse_Init(void)
     KEY_Init();
     HC05_Init();
     RTC_Init();
+    Config_Init();          // 日志分区页数取自配置
     DataLogger_Init();
-    Config_Init();
+    Greenhouse_Check_Commands();
+    Event_Set_Interval(EVT_TOPIC_SENSOR, EVT_SENSOR_INTERVAL);
+    Telemetry_Init();
     RGB_Greenhouse_Init();  // 初始化RGB彩灯系统
     
     greenhouse_status.work_mode = MODE_AUTO;
@@ -66,6 +76,7 @@ void Greenhouse_Init(void)
     greenhouse_status.auto_mode_ratio = 100;
     
     DHT11_Set_Calibration(0.0f, 0.0f);
+    DHT11_Async_Start();    // 预先启动首次采集，首个控制周期即有数据
     
     BEEP_Short();
     printf("Smart Greenhouse System Started!\r\n");
@@ -85,29 +96,42 @@ void Greenhouse_Update_Sensors(void)
     static u8 last_valid_humi = 0;
 
     u8 temp, humi;
-    u8 dht_result;
+    u8 old_temp, old_humi, old_light, old_error;
+    DHT11_Status_t dht_result;
     
-    // 读取DHT11数据
-    dht_result = DHT11_Read_Data(&temp, &humi);
-    if (dht_result == 0) {
-        greenhouse_status.temperature = temp;
-        greenhouse_status.humidity = humi;
-        greenhouse_status.sensor_error &= ~0x01;
-        last_valid_temp = temp;
-        last_valid_humi = humi;
-                         printf("DHT11: Read Success T=%d°C, H=%d%%\r\n", temp, humi);
-    } else {
-        // DHT11 read failed, use last valid data
-        greenhouse_status.sensor_error |= 0x01;
-        greenhouse_status.temperature = last_valid_temp;
-        greenhouse_status.humidity = last_valid_humi;
-        printf("DHT11: Read Failed, Using Last Valid Data T=%d°C, H=%d%%\r\n",
-               greenhouse_status.temperature, greenhouse_status.humidity);
+    old_temp = greenhouse_status.temperature;
+    old_humi = greenhouse_status.humidity;
+    old_light = greenhouse_status.light;
+    old_error = greenhouse_status.sensor_error;
+    
+    // 读取DHT11数据 - 取异步采集完成的帧，未完成时保持上次数据，不阻塞
+    if (DHT11_Async_Ready()) {
+        dht_result = DHT11_Async_Get_Result(&temp, &humi);
+        if (dht_result == DHT11_OK) {
+            greenhouse_status.temperature = temp;
+            greenhouse_status.humidity = humi;
+            greenhouse_status.sensor_error &= ~0x01;
+            last_valid_temp = temp;
+            last_valid_humi = humi;
+            LOG_DEBUG(("DHT11: Read Success T=%d°C, H=%d%%\r\n", temp, humi));
+        } else {
+            // DHT11 read failed, use last valid data
+            greenhouse_status.sensor_error |= 0x01;
+            greenhouse_status.temperature = last_valid_temp;
+            greenhouse_status.humidity = last_valid_humi;
+            LOG_WARN(("DHT11: Read Failed (err=%d), Using Last Valid Data T=%d°C, H=%d%%\r\n",
+                   dht_result, greenhouse_status.temperature, greenhouse_status.humidity));
+        }
     }
+    DHT11_Async_Start(); // 启动下一次采集（忙或间隔不足时自动忽略）
     
     // 读取光照传感器
     greenhouse_status.light = Lsens_Get_Val();
-    printf("Light Sensor: Reading L=%d%%\r\n", greenhouse_status.light);
+    LOG_DEBUG(("Light Sensor: Reading L=%d%%\r\n", greenhouse_status.light));
+    
+    if(greenhouse_status.temperature != old_temp || greenhouse_status.humidity != old_humi ||
+       greenhouse_status.light != old_light || greenhouse_status.sensor_error != old_error)
+        Event_Publish(EVT_TOPIC_SENSOR);
     
     log_counter++;
     if(log_counter >= 5)
@@ -130,9 +154,15 @@ void Greenhouse_Auto_Control(void)
     u8 humi_threshold, humi_hysteresis;
     u8 light_threshold, light_hysteresis;
     u8 fan_speed, current_fan_speed;
+    u8 old_fan, old_pump, old_light, old_speed;
     
     if(greenhouse_status.work_mode != MODE_AUTO) return;
     
+    old_fan = greenhouse_status.fan_status;
+    old_pump = greenhouse_status.pump_status;
+    old_light = greenhouse_status.light_status;
+    old_speed = Fan_Get_Speed_Percent();
+    
     temp_threshold = Config_Get_U8(CONFIG_TEMP_FAN_ON);
     temp_hysteresis = system_config.temp_hysteresis;
     
@@ -165,7 +195,7 @@ void Greenhouse_Auto_Control(void)
     }
     else if(greenhouse_status.temperature < temp_threshold - temp_hysteresis)
     {
-        printf("Temperature below stop threshold, preparing to turn off fan...\r\n");
+        LOG_DEBUG(("Temperature below stop threshold, preparing to turn off fan...\r\n"));
         if(greenhouse_status.fan_status == DEVICE_ON)
         {
             if(greenhouse_status.temperature <= 25) {
@@ -198,7 +228,7 @@ void Greenhouse_Auto_Control(void)
                        greenhouse_status.temperature, current_fan_speed, fan_speed);
             }
         } else {
-             printf("Temperature in hysteresis zone, fan OFF, maintaining current state\r\n");
+             LOG_DEBUG(("Temperature in hysteresis zone, fan OFF, maintaining current state\r\n"));
         }
     }
     
@@ -249,6 +279,10 @@ void Greenhouse_Auto_Control(void)
             DataLogger_WriteOperation(OP_LIGHT_OFF, DEVICE_ON, DEVICE_OFF, 0);
         }
     }
+    
+    if(greenhouse_status.fan_status != old_fan || greenhouse_status.pump_status != old_pump ||
+       greenhouse_status.light_status != old_light || Fan_Get_Speed_Percent() != old_speed)
+        Event_Publish(EVT_TOPIC_DEVICE);
 }
 
 void Greenhouse_Manual_Control(u8 device, u8 action)
@@ -297,6 +331,7 @@ void Greenhouse_Manual_Control(u8 device, u8 action)
             DataLogger_WriteOperation(operation, old_value, action, 1);
             break;
     }
+    Event_Publish(EVT_TOPIC_DEVICE);
     BEEP_Short();
 }
 
@@ -360,6 +395,7 @@ void Greenhouse_Process_Key(u8 key)
             printf("Switch to %s mode\r\n", greenhouse_status.work_mode ? "MANUAL" : "AUTO");
             operation = greenhouse_status.work_mode ? OP_MODE_MANUAL : OP_MODE_AUTO;
             DataLogger_WriteOperation(operation, old_mode, greenhouse_status.work_mode, 1);
+            Event_Publish(EVT_TOPIC_MODE);
             BEEP_Short();
             break;
             
@@ -417,6 +453,7 @@ void Greenhouse_Check_Alarms(void)
 
     if (greenhouse_status.alarm_flags != new_alarm_flags) {
         greenhouse_status.alarm_flags = new_alarm_flags;
+        Event_Publish(EVT_TOPIC_ALARM);
         
         if (new_alarm_flags == ALARM_NONE) {
             BEEP_Set_Alarm(ALARM_TYPE_NONE);
@@ -437,522 +474,756 @@ void Greenhouse_Check_Alarms(void)
         }
 }
 
+// ===== 蓝牙命令表 =====
+// 命令行格式：命令名 [参数]，命令名按整词精确匹配（大写字母和下划线，遇到空格、':'或数字结束），
+// 参数为十进制或0x开头的十六进制数，可直接接在命令名后（如RGB_BRIGHT30）；
+// BT_ARG_TEXT命令的参数不解析，整行交给处理函数（如CONFIG_SET temp_fan_on 28）
+
+#define BT_ARG_NONE         0       // 不带参数
+#define BT_ARG_OPTIONAL     1       // 可选参数，缺省为0
+#define BT_ARG_REQUIRED     2       // 必须带参数
+#define BT_ARG_TEXT         3       // 文本参数，处理函数从bt_text取整行
+
+#define BT_CMD_MANUAL       0x01    // 仅手动模式可用
+
+typedef struct BtCommand BtCommand_t;
+
+struct BtCommand
+{
+    const char* name;                                       // 命令名
+    void (*handler)(const BtCommand_t* cmd, u32 arg);       // 处理函数
+    u32 param;                                              // 传给处理函数的固定参数
+    u8  arg_type;                                           // BT_ARG_xxx
+    u8  flags;                                              // BT_CMD_xxx
+    u32 arg_max;                                            // 参数上限
+};
+
+static char* bt_text;                                       // BT_ARG_TEXT命令的整行（从命令名起）
+
+// 查询系统状态
+static void Greenhouse_Cmd_Status(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== System Status ===\r\n");
+    printf("Temperature: %d°C\r\n", greenhouse_status.temperature);
+    printf("Humidity: %d%%\r\n", greenhouse_status.humidity);
+    printf("Light: %d%%\r\n", greenhouse_status.light);
+    printf("Mode: %s\r\n", greenhouse_status.work_mode ? "Manual" : "Auto");
+    printf("Fan: %s\r\n", greenhouse_status.fan_run_status.status ? "ON" : "OFF");
+    printf("Pump: %s\r\n", greenhouse_status.pump_run_status.status ? "ON" : "OFF");
+    printf("Light: %s\r\n", greenhouse_status.light_run_status.status ? "ON" : "OFF");
+    printf("====================\r\n");
+}
+
+// 切换到自动模式，关闭手动开启的设备
+static void Greenhouse_Cmd_Auto(const BtCommand_t* cmd, u32 arg)
+{
+    // 从手动模式切换到自动模式时，关闭所有手动开启的设备
+    if(greenhouse_status.work_mode == MODE_MANUAL) {
+        printf("Switching from MANUAL to AUTO mode...\r\n");
+        
+        // 关闭风扇
+        if(greenhouse_status.fan_run_status.status == DEVICE_ON) {
+            Fan_Set_Speed_Percent(0);
+            greenhouse_status.fan_run_status.status = DEVICE_OFF;
+            printf("Auto: Fan turned OFF (manual override cleared)\r\n");
+        }
+        
+        // 关闭水泵（流水灯）
+        if(greenhouse_status.pump_run_status.status == DEVICE_ON) {
+            LED_Pump_Set(0);
+            greenhouse_status.pump_run_status.status = DEVICE_OFF;
+            printf("Auto: Pump/Marquee turned OFF (manual override cleared)\r\n");
+        }
+        
+        // 关闭补光灯
+        if(greenhouse_status.light_run_status.status == DEVICE_ON) {
+            LED_Light_Set(0);
+            greenhouse_status.light_run_status.status = DEVICE_OFF;
+            printf("Auto: Light turned OFF (manual override cleared)\r\n");
+        }
+    }
+    
+    greenhouse_status.work_mode = MODE_AUTO;
+    Event_Publish(EVT_TOPIC_MODE);
+    printf("Switched to AUTO mode - System will control devices automatically\r\n");
+}
+
+// 切换到手动模式
+static void Greenhouse_Cmd_Manual(const BtCommand_t* cmd, u32 arg)
+{
+    if(greenhouse_status.work_mode == MODE_AUTO) {
+        printf("Switching from AUTO to MANUAL mode...\r\n");
+        printf("Note: Devices will keep current state until manually controlled\r\n");
+    }
+    
+    greenhouse_status.work_mode = MODE_MANUAL;
+    Event_Publish(EVT_TOPIC_MODE);
+    printf("Switched to MANUAL mode - Use FAN_ON/OFF, PUMP_ON/OFF, LIGHT_ON/OFF commands\r\n");
+}
+
+// FAN_ON/FAN_OFF - 风扇开关（仅手动模式）
+static void Greenhouse_Cmd_Fan(const BtCommand_t* cmd, u32 arg)
+{
+    if(cmd->param == DEVICE_ON) {
+        Fan_Set_Speed_Percent(100); // 100%功率
+        greenhouse_status.fan_status = DEVICE_ON; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.fan_run_status, DEVICE_ON); // 同步运行时状态
+        printf("Fan turned ON (100%% power)\r\n");
+    } else {
+        Fan_Set_Speed_Percent(0);
+        greenhouse_status.fan_status = DEVICE_OFF; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.fan_run_status, DEVICE_OFF); // 同步运行时状态
+        printf("Fan turned OFF\r\n");
+    }
+    Greenhouse_Update_Display(); // 更新TFT显示
+    RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
+}
+
+// PUMP_ON/PUMP_OFF - 水泵开关（仅手动模式）
+static void Greenhouse_Cmd_Pump(const BtCommand_t* cmd, u32 arg)
+{
+    if(cmd->param == DEVICE_ON) {
+        LED_Pump_Set(1);
+        greenhouse_status.pump_status = DEVICE_ON; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.pump_run_status, DEVICE_ON); // 同步运行时状态
+        printf("Pump turned ON\r\n");
+    } else {
+        LED_Pump_Set(0);
+        greenhouse_status.pump_status = DEVICE_OFF; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.pump_run_status, DEVICE_OFF); // 同步运行时状态
+        printf("Pump turned OFF\r\n");
+    }
+    Greenhouse_Update_Display(); // 更新TFT显示
+    RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
+}
+
+// LIGHT_ON/LIGHT_OFF - 补光灯开关（仅手动模式）
+static void Greenhouse_Cmd_Light(const BtCommand_t* cmd, u32 arg)
+{
+    if(cmd->param == DEVICE_ON) {
+        LED_Light_Set(1);
+        greenhouse_status.light_status = DEVICE_ON; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.light_run_status, DEVICE_ON); // 同步运行时状态
+        printf("Light turned ON\r\n");
+    } else {
+        LED_Light_Set(0);
+        greenhouse_status.light_status = DEVICE_OFF; // 修正状态变量
+        Greenhouse_Update_Device_Status(&greenhouse_status.light_run_status, DEVICE_OFF); // 同步运行时状态
+        printf("Light turned OFF\r\n");
+    }
+    Greenhouse_Update_Display(); // 更新TFT显示
+    RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
+}
+
+// 系统统计信息
+static void Greenhouse_Cmd_Stats(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== System Statistics ===\r\n");
+    printf("Run time: %lu seconds\r\n", greenhouse_status.system_run_time);
+    printf("Fan switches: %d\r\n", greenhouse_status.fan_run_status.switch_count);
+    printf("Pump switches: %d\r\n", greenhouse_status.pump_run_status.switch_count);
+    printf("Light switches: %d\r\n", greenhouse_status.light_run_status.switch_count);
+    printf("Debug TX dropped: %lu bytes\r\n", USART1_Get_TX_Dropped());
+    printf("BT RX dropped: %lu lines, TX dropped: %lu bytes\r\n",
+           USART3_Get_Dropped(), USART3_Get_TX_Dropped());
+    printf("========================\r\n");
+}
+
+// 环境趋势
+static void Greenhouse_Cmd_Trend(const BtCommand_t* cmd, u32 arg)
+{
+    // ... (TREND command implementation)
+}
+
+// 传感器状态查询
+static void Greenhouse_Cmd_Sensor_Status(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== DHT11 Sensor Status ===\r\n");
+    printf("Current Mode: Real Sensor Mode\r\n");
+    printf("Note: System will auto-retry if read fails\r\n");
+    printf("===========================\r\n");
+}
+
+// ===== 蓝牙模块命令 =====
+// AT命令由HC05_AT_Task异步执行，处理函数只打印标题并提交请求，结果由回调打印，不阻塞其他任务
+
+// 提交AT请求，队列满时提示稍后重试
+static void Greenhouse_BT_Submit(const char* at, HC05_AT_Callback_t callback)
+{
+    if(HC05_AT_Submit(at, callback) != 0)
+    {
+        printf("HC05 busy, try again later\r\n");
+    }
+}
+
+// 打印查询结果：模块返回的参数行
+static void Greenhouse_BT_Print_Value(u8 result, const char* value)
+{
+    if(result == HC05_AT_OK) {
+        printf("%s\r\n", value[0] ? value : "OK");
+    } else if(result == HC05_AT_ERROR) {
+        printf("Module returned ERROR\r\n");
+    } else {
+        printf("No response from module\r\n");
+    }
+    printf("=============================\r\n");
+}
+
+// 蓝牙名称查询
+static void Greenhouse_Cmd_BT_Name(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== Bluetooth Device Info ===\r\n");
+    printf("Note: Device name is set to 'SBH'\r\n");
+    Greenhouse_BT_Submit("AT+NAME?", Greenhouse_BT_Print_Value);  // 查询当前蓝牙名称
+}
+
+// 蓝牙版本查询
+static void Greenhouse_Cmd_BT_Ver(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 Firmware Version ===\r\n");
+    Greenhouse_BT_Submit("AT+VERSION?", Greenhouse_BT_Print_Value);
+}
+
+// 蓝牙地址查询
+static void Greenhouse_Cmd_BT_Addr(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 MAC Address ===\r\n");
+    Greenhouse_BT_Submit("AT+ADDR?", Greenhouse_BT_Print_Value);
+}
+
+// 蓝牙PIN查询
+static void Greenhouse_Cmd_BT_Pin(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 Pairing PIN ===\r\n");
+    Greenhouse_BT_Submit("AT+PSWD?", Greenhouse_BT_Print_Value);
+}
+
+// 蓝牙波特率查询
+static void Greenhouse_Cmd_BT_Baud(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 UART Baudrate ===\r\n");
+    Greenhouse_BT_Submit("AT+UART?", Greenhouse_BT_Print_Value);
+}
+
+// 蓝牙角色查询结果
+static void Greenhouse_BT_Role_Done(u8 result, const char* value)
+{
+    if(result == HC05_AT_OK && strncmp(value, "+ROLE:", 6) == 0 && value[6] == '0') {
+        printf("Current Role: Slave Mode\r\n");
+    } else if(result == HC05_AT_OK && strncmp(value, "+ROLE:", 6) == 0 && value[6] == '1') {
+        printf("Current Role: Master Mode\r\n");
+    } else {
+        printf("Role Query Failed\r\n");
+    }
+    printf("======================\r\n");
+}
+
+// 蓝牙角色查询
+static void Greenhouse_Cmd_BT_Role(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 Role Mode ===\r\n");
+    Greenhouse_BT_Submit("AT+ROLE?", Greenhouse_BT_Role_Done);
+}
+
+// 蓝牙设备类查询
+static void Greenhouse_Cmd_BT_Class(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 Device Class ===\r\n");
+    Greenhouse_BT_Submit("AT+CLASS?", Greenhouse_BT_Print_Value);
+}
+
+// 蓝牙AT测试结果
+static void Greenhouse_BT_Test_Done(u8 result, const char* value)
+{
+    if(result == HC05_AT_OK) {
+        printf("AT Command Response: OK\r\n");
+    } else {
+        printf("AT Command Response: FAILED\r\n");
+    }
+    printf("====================\r\n");
+}
+
+// 蓝牙AT测试
+static void Greenhouse_Cmd_BT_Test(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 AT Test ===\r\n");
+    Greenhouse_BT_Submit("AT", Greenhouse_BT_Test_Done);
+}
+
+// 蓝牙模块重置结果
+static void Greenhouse_BT_Reset_Done(u8 result, const char* value)
+{
+    if(result == HC05_AT_OK) {
+        printf("Module Reset: SUCCESS\r\n");
+        printf("Wait for module restart...\r\n");
+    } else {
+        printf("Module Reset: FAILED\r\n");
+    }
+    printf("=========================\r\n");
+}
+
+// 蓝牙模块重置
+static void Greenhouse_Cmd_BT_Reset(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== HC05 Module Reset ===\r\n");
+    Greenhouse_BT_Submit("AT+RESET", Greenhouse_BT_Reset_Done);
+}
+
+// HC05诊断测试3结果
+static void Greenhouse_BT_Diag_Done(u8 result, const char* value)
+{
+    if(result == HC05_AT_OK) {
+        printf("  AT Response: PASS\r\n");
+    } else {
+        printf("  AT Response: FAILED\r\n");
+        printf("  Check TXD/RXD connections\r\n");
+    }
+    printf("=== Diagnostics Complete ===\r\n");
+}
+
+// HC05硬件诊断
+static void Greenhouse_Cmd_BT_Diag(const BtCommand_t* cmd, u32 arg)
+{
+    u8 key_low, key_high;
+    
+    // KEY引脚由AT事务占用时不能翻转
+    if(HC05_AT_Busy()) {
+        printf("HC05 busy, try again later\r\n");
+        return;
+    }
+    
+    printf("=== HC05 Hardware Diagnostics ===\r\n");
+    
+    // 测试1：KEY引脚控制测试，回读输出寄存器确认翻转
+    printf("Test 1: KEY Pin Control...\r\n");
+    HC05_KEY = 1;
+    key_high = GPIO_ReadOutputDataBit(HC05_KEY_PORT, HC05_KEY_PIN);
+    HC05_KEY = 0;
+    key_low = GPIO_ReadOutputDataBit(HC05_KEY_PORT, HC05_KEY_PIN);
+    printf("  KEY=1 reads %d, KEY=0 reads %d\r\n", key_high, key_low);
+    printf("  KEY control: %s\r\n", (key_high == 1 && key_low == 0) ? "PASS" : "FAILED");
+    
+    // 测试2：LED状态检测
+    printf("Test 2: LED Status Detection...\r\n");
+    printf("  LED Status: %s\r\n", HC05_LED ? "HIGH" : "LOW");
+    if(HC05_LED == 0) {
+        printf("  WARNING: LED LOW - Check power\r\n");
+    } else {
+        printf("  LED detection: PASS\r\n");
+    }
+    
+    // 测试3：AT命令测试，结果由回调打印
+    printf("Test 3: AT Command Test...\r\n");
+    Greenhouse_BT_Submit("AT", Greenhouse_BT_Diag_Done);
+}
+
+// RGB温度显示
+static void Greenhouse_Cmd_RGB_Temp(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_TEMP_DISPLAY);
+    RGB_Show_Temperature(greenhouse_status.temperature);
+    printf("RGB: Temperature display mode activated (%d°C)\r\n", greenhouse_status.temperature);
+}
+
+// RGB湿度显示
+static void Greenhouse_Cmd_RGB_Humidity(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_HUMIDITY_DISPLAY);
+    RGB_Show_Humidity(greenhouse_status.humidity);
+    printf("RGB: Humidity display mode activated (%d%%)\r\n", greenhouse_status.humidity);
+}
+
+// RGB光照显示
+static void Greenhouse_Cmd_RGB_Light(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_LIGHT_DISPLAY);
+    RGB_Show_Light_Level(greenhouse_status.light);
+    printf("RGB: Light display mode activated (%d%%)\r\n", greenhouse_status.light);
+}
+
+// RGB系统状态显示
+static void Greenhouse_Cmd_RGB_Status(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_STATUS_DISPLAY);
+    RGB_Show_System_Status(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status);
+    printf("RGB: System status display mode activated\r\n");
+}
+
+// 关闭RGB显示
+static void Greenhouse_Cmd_RGB_Off(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_OFF);
+    RGB_LED_Clear();
+    printf("RGB: Display turned off\r\n");
+}
+
+// RGB彩虹动画
+static void Greenhouse_Cmd_RGB_Rainbow(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
+    RGB_Start_Rainbow_Animation();
+    printf("RGB: Rainbow animation started\r\n");
+}
+
+// RGB呼吸动画
+static void Greenhouse_Cmd_RGB_Breathing(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
+    RGB_Start_Breathing_Animation(RGB_COLOR_BLUE);
+    printf("RGB: Breathing animation started\r\n");
+}
+
+// RGB流水动画
+static void Greenhouse_Cmd_RGB_Flow(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
+    RGB_Start_Water_Flow_Animation();
+    printf("RGB: Water flow animation started\r\n");
+}
+
+// RGB心形图案
+static void Greenhouse_Cmd_RGB_Heart(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Heart(RGB_COLOR_RED);
+    printf("RGB: Heart pattern displayed\r\n");
+}
+
+// RGB笑脸图案
+static void Greenhouse_Cmd_RGB_Smiley(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Smiley(RGB_COLOR_YELLOW);
+    printf("RGB: Smiley pattern displayed\r\n");
+}
+
+// RGB对勾图案
+static void Greenhouse_Cmd_RGB_Check(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Check_Mark(RGB_COLOR_GREEN);
+    printf("RGB: Check mark pattern displayed\r\n");
+}
+
+// RGB叉号图案
+static void Greenhouse_Cmd_RGB_Cross(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Cross(RGB_COLOR_RED);
+    printf("RGB: Cross pattern displayed\r\n");
+}
+
+// RGB机器人图案
+static void Greenhouse_Cmd_RGB_Robot(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Robot(RGB_COLOR_GREEN);
+    printf("RGB: Robot pattern displayed\r\n");
+}
+
+// RGB手动状态表情
+static void Greenhouse_Cmd_RGB_Manual_Face(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_PATTERN);
+    RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, 
+                               greenhouse_status.pump_status, 
+                               greenhouse_status.light_status,
+                               Fan_Get_Speed());
+    printf("RGB: Manual status face pattern displayed\r\n");
+}
+
+// RGB纯色显示，颜色取自命令表
+static void Greenhouse_Cmd_RGB_Color(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
+    RGB_Set_All_Color(cmd->param);
+    printf("RGB: %s color displayed\r\n", cmd->name + 4);
+}
+
+// RGB亮度控制 (RGB_BRIGHT 0-100，也可写作RGB_BRIGHT30)
+static void Greenhouse_Cmd_RGB_Bright(const BtCommand_t* cmd, u32 arg)
+{
+    RGB_Set_Brightness((u8)arg);
+    printf("RGB: Brightness set to %d%%\r\n", (int)arg);
+}
+
+// 调度器统计 - 各任务周期/超时/最长执行时间
+static void Greenhouse_Cmd_Sched(const BtCommand_t* cmd, u32 arg)
+{
+    Scheduler_Print_Stats();
+}
+
+// 日志二进制导出 (EXPORT [记录位置])，断线后从最后收到的位置续传
+static void Greenhouse_Cmd_Export(const BtCommand_t* cmd, u32 arg)
+{
+    LogExport_Start(arg);
+}
+
+// 事件总线统计 - 各主题发布/分发次数
+static void Greenhouse_Cmd_Events(const BtCommand_t* cmd, u32 arg)
+{
+    Event_Print_Stats();
+}
+
+// 停止日志导出
+static void Greenhouse_Cmd_Export_Stop(const BtCommand_t* cmd, u32 arg)
+{
+    LogExport_Stop();
+}
+
+// 配置参数命令 - 整行交给配置模块，CONFIG_SAVE把修改追加到Flash配置日志
+static void Greenhouse_Cmd_Config(const BtCommand_t* cmd, u32 arg)
+{
+    Config_Handle_Command(bt_text);
+}
+
+// 帮助命令
+static void Greenhouse_Cmd_Help(const BtCommand_t* cmd, u32 arg)
+{
+    printf("=== Bluetooth Command Help ===\r\n");
+    printf("Basic Commands:\r\n");
+    printf("  STATUS - Query system status\r\n");
+    printf("  AUTO - Switch to auto mode\r\n");
+    printf("  MANUAL - Switch to manual mode\r\n");
+    printf("Device Control:\r\n");
+    printf("  FAN_ON/FAN_OFF - Fan control\r\n");
+    printf("  PUMP_ON/PUMP_OFF - Pump control\r\n");
+    printf("  LIGHT_ON/LIGHT_OFF - Light control\r\n");
+    printf("RGB Display Modes:\r\n");
+    printf("  RGB_TEMP - Temperature visualization\r\n");
+    printf("  RGB_HUMIDITY - Humidity visualization\r\n");
+    printf("  RGB_LIGHT - Light level visualization\r\n");
+    printf("  RGB_STATUS - System status display\r\n");
+    printf("  RGB_OFF - Turn off RGB display\r\n");
+    printf("RGB Animations:\r\n");
+    printf("  RGB_RAINBOW - Rainbow effect\r\n");
+    printf("  RGB_BREATHING - Breathing effect\r\n");
+    printf("  RGB_FLOW - Water flow effect\r\n");
+    printf("RGB Patterns:\r\n");
+    printf("  RGB_HEART - Heart pattern\r\n");
+    printf("  RGB_SMILEY - Smiley face pattern\r\n");
+    printf("  RGB_CHECK - Check mark pattern\r\n");
+    printf("  RGB_CROSS - Cross pattern\r\n");
+    printf("  RGB_ROBOT - Robot pattern\r\n");
+    printf("  RGB_MANUAL_FACE - Device status face\r\n");
+    printf("RGB Colors:\r\n");
+    printf("  RGB_RED/GREEN/BLUE/WHITE/YELLOW/PURPLE/CYAN\r\n");
+    printf("RGB Brightness:\r\n");
+    printf("  RGB_BRIGHT[0-100] - Set brightness (e.g., RGB_BRIGHT30)\r\n");
+    printf("Sensor Control:\r\n");
+    printf("  SENSOR_STATUS - Query sensor status\r\n");
+    printf("Query Commands:\r\n");
+    printf("  STATS - System Statistics\r\n");
+    printf("  TREND - Environment Trend\r\n");
+    printf("  SCHED - Task Scheduler Statistics\r\n");
+    printf("  EVENTS - Event Bus Statistics\r\n");
+    printf("Log Export:\r\n");
+    printf("  EXPORT [pos] - Stream binary log frames, resume from pos (ring in top byte)\r\n");
+    printf("  EXPORT_STOP - Stop log export\r\n");
+    printf("Configuration:\r\n");
+    printf("  CONFIG_GET [name] - Show parameters\r\n");
+    printf("  CONFIG_SET name value - Set a parameter\r\n");
+    printf("  CONFIG_SAVE - Save parameters to flash\r\n");
+    printf("  CONFIG_RESET - Restore and save defaults\r\n");
+    printf("  CONFIG_HELP - Parameter names and ranges\r\n");
+    printf("Binary Telemetry:\r\n");
+    printf("  0x00-delimited COBS frames (GET/SUBSCRIBE/UNSUBSCRIBE), see telemetry.h\r\n");
+    printf("Bluetooth Commands:\r\n");
+    printf("  BT_NAME - Get Device Name\r\n");
+    printf("  BT_VER - Get Firmware Version\r\n");
+    printf("  BT_ADDR - Get MAC Address\r\n");
+    printf("  BT_PIN - Get Pairing PIN\r\n");
+    printf("  BT_BAUD - Get Baudrate\r\n");
+    printf("  BT_ROLE - Get Role Mode\r\n");
+    printf("  BT_CLASS - Get Device Class\r\n");
+    printf("  BT_TEST - Test AT Response\r\n");
+    printf("  BT_RESET - Reset Module\r\n");
+    printf("  BT_DIAG - Hardware Diagnostics\r\n");
+    printf("  HELP - Show This Help\r\n");
+    printf("==============================\r\n");
+}
+
+// 命令表，按命令名字典序（strcmp）排列，用二分查找；新增命令时插入到对应位置
+static const BtCommand_t bt_commands[] =
+{
+    {"AUTO",            Greenhouse_Cmd_Auto,            0,                BT_ARG_NONE,     0,             0},
+    {"BT_ADDR",         Greenhouse_Cmd_BT_Addr,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_BAUD",         Greenhouse_Cmd_BT_Baud,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_CLASS",        Greenhouse_Cmd_BT_Class,        0,                BT_ARG_NONE,     0,             0},
+    {"BT_DIAG",         Greenhouse_Cmd_BT_Diag,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_NAME",         Greenhouse_Cmd_BT_Name,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_PIN",          Greenhouse_Cmd_BT_Pin,          0,                BT_ARG_NONE,     0,             0},
+    {"BT_RESET",        Greenhouse_Cmd_BT_Reset,        0,                BT_ARG_NONE,     0,             0},
+    {"BT_ROLE",         Greenhouse_Cmd_BT_Role,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_TEST",         Greenhouse_Cmd_BT_Test,         0,                BT_ARG_NONE,     0,             0},
+    {"BT_VER",          Greenhouse_Cmd_BT_Ver,          0,                BT_ARG_NONE,     0,             0},
+    {"CONFIG_GET",      Greenhouse_Cmd_Config,          0,                BT_ARG_TEXT,     0,             0},
+    {"CONFIG_HELP",     Greenhouse_Cmd_Config,          0,                BT_ARG_TEXT,     0,             0},
+    {"CONFIG_RESET",    Greenhouse_Cmd_Config,          0,                BT_ARG_TEXT,     0,             0},
+    {"CONFIG_SAVE",     Greenhouse_Cmd_Config,          0,                BT_ARG_TEXT,     0,             0},
+    {"CONFIG_SET",      Greenhouse_Cmd_Config,          0,                BT_ARG_TEXT,     0,             0},
+    {"EVENTS",          Greenhouse_Cmd_Events,          0,                BT_ARG_NONE,     0,             0},
+    {"EXPORT",          Greenhouse_Cmd_Export,          0,                BT_ARG_OPTIONAL, 0,             0xFFFFFFFF},
+    {"EXPORT_STOP",     Greenhouse_Cmd_Export_Stop,     0,                BT_ARG_NONE,     0,             0},
+    {"FAN_OFF",         Greenhouse_Cmd_Fan,             DEVICE_OFF,       BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"FAN_ON",          Greenhouse_Cmd_Fan,             DEVICE_ON,        BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"HELP",            Greenhouse_Cmd_Help,            0,                BT_ARG_NONE,     0,             0},
+    {"LIGHT_OFF",       Greenhouse_Cmd_Light,           DEVICE_OFF,       BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"LIGHT_ON",        Greenhouse_Cmd_Light,           DEVICE_ON,        BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"MANUAL",          Greenhouse_Cmd_Manual,          0,                BT_ARG_NONE,     0,             0},
+    {"PUMP_OFF",        Greenhouse_Cmd_Pump,            DEVICE_OFF,       BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"PUMP_ON",         Greenhouse_Cmd_Pump,            DEVICE_ON,        BT_ARG_NONE,     BT_CMD_MANUAL, 0},
+    {"RGB_BLUE",        Greenhouse_Cmd_RGB_Color,       RGB_COLOR_BLUE,   BT_ARG_NONE,     0,             0},
+    {"RGB_BREATHING",   Greenhouse_Cmd_RGB_Breathing,   0,                BT_ARG_NONE,     0,             0},
+    {"RGB_BRIGHT",      Greenhouse_Cmd_RGB_Bright,      0,                BT_ARG_REQUIRED, 0,             100},
+    {"RGB_CHECK",       Greenhouse_Cmd_RGB_Check,       0,                BT_ARG_NONE,     0,             0},
+    {"RGB_CROSS",       Greenhouse_Cmd_RGB_Cross,       0,                BT_ARG_NONE,     0,             0},
+    {"RGB_CYAN",        Greenhouse_Cmd_RGB_Color,       RGB_COLOR_CYAN,   BT_ARG_NONE,     0,             0},
+    {"RGB_FLOW",        Greenhouse_Cmd_RGB_Flow,        0,                BT_ARG_NONE,     0,             0},
+    {"RGB_GREEN",       Greenhouse_Cmd_RGB_Color,       RGB_COLOR_GREEN,  BT_ARG_NONE,     0,             0},
+    {"RGB_HEART",       Greenhouse_Cmd_RGB_Heart,       0,                BT_ARG_NONE,     0,             0},
+    {"RGB_HUMIDITY",    Greenhouse_Cmd_RGB_Humidity,    0,                BT_ARG_NONE,     0,             0},
+    {"RGB_LIGHT",       Greenhouse_Cmd_RGB_Light,       0,                BT_ARG_NONE,     0,             0},
+    {"RGB_MANUAL_FACE", Greenhouse_Cmd_RGB_Manual_Face, 0,                BT_ARG_NONE,     0,             0},
+    {"RGB_OFF",         Greenhouse_Cmd_RGB_Off,         0,                BT_ARG_NONE,     0,             0},
+    {"RGB_PURPLE",      Greenhouse_Cmd_RGB_Color,       RGB_COLOR_PURPLE, BT_ARG_NONE,     0,             0},
+    {"RGB_RAINBOW",     Greenhouse_Cmd_RGB_Rainbow,     0,                BT_ARG_NONE,     0,             0},
+    {"RGB_RED",         Greenhouse_Cmd_RGB_Color,       RGB_COLOR_RED,    BT_ARG_NONE,     0,             0},
+    {"RGB_ROBOT",       Greenhouse_Cmd_RGB_Robot,       0,                BT_ARG_NONE,     0,             0},
+    {"RGB_SMILEY",      Greenhouse_Cmd_RGB_Smiley,      0,                BT_ARG_NONE,     0,             0},
+    {"RGB_STATUS",      Greenhouse_Cmd_RGB_Status,      0,                BT_ARG_NONE,     0,             0},
+    {"RGB_TEMP",        Greenhouse_Cmd_RGB_Temp,        0,                BT_ARG_NONE,     0,             0},
+    {"RGB_WHITE",       Greenhouse_Cmd_RGB_Color,       RGB_COLOR_WHITE,  BT_ARG_NONE,     0,             0},
+    {"RGB_YELLOW",      Greenhouse_Cmd_RGB_Color,       RGB_COLOR_YELLOW, BT_ARG_NONE,     0,             0},
+    {"SCHED",           Greenhouse_Cmd_Sched,           0,                BT_ARG_NONE,     0,             0},
+    {"SENSOR_STATUS",   Greenhouse_Cmd_Sensor_Status,   0,                BT_ARG_NONE,     0,             0},
+    {"STATS",           Greenhouse_Cmd_Stats,           0,                BT_ARG_NONE,     0,             0},
+    {"STATUS",          Greenhouse_Cmd_Status,          0,                BT_ARG_NONE,     0,             0},
+    {"TREND",           Greenhouse_Cmd_Trend,           0,                BT_ARG_NONE,     0,             0}
+};
+
+#define BT_COMMAND_COUNT    (sizeof(bt_commands) / sizeof(bt_commands[0]))
+
+/**
+ * @brief  检查命令表是否按字典序排列，乱序时二分查找会漏掉命令
+ */
+static void Greenhouse_Check_Commands(void)
+{
+    u8 i;
+
+    for(i = 1; i < BT_COMMAND_COUNT; i++)
+    {
+        if(strcmp(bt_commands[i - 1].name, bt_commands[i].name) >= 0)
+            printf("BT command table out of order at %s\r\n", bt_commands[i].name);
+    }
+}
+
+/**
+ * @brief  按命令名查找命令表
+ * @param  name: 命令名起始地址（不要求以'\0'结尾）
+ * @param  len: 命令名长度
+ * @retval 命令表项，未找到返回0
+ */
+static const BtCommand_t* Greenhouse_Find_Command(const char* name, u8 len)
+{
+    const BtCommand_t* cmd;
+    int lo = 0, hi = BT_COMMAND_COUNT - 1, mid, diff;
+
+    while(lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        cmd = &bt_commands[mid];
+        diff = strncmp(cmd->name, name, len);
+        if(diff == 0) diff = (cmd->name[len] != '\0');  // 表中命令名更长
+        if(diff == 0) return cmd;
+        if(diff < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  执行一条蓝牙命令
+ * @param  cmd: 以'\0'结尾的命令行（不含换行符）
+ */
+static void Greenhouse_Bluetooth_Command(char* cmd)
+{
+    static u16 command_count = 0; // 调试计数器
+    const BtCommand_t* entry;
+    char* p;
+    char* end;
+    u32 arg = 0;
+    u8 len = 0;
+    u8 has_arg;
+    
+    command_count++;
+    
+    LOG_INFO(("[BT_CMD_%d] Received: %s (len=%d)\r\n", 
+           command_count, 
+           cmd, 
+           (int)strlen(cmd)));
+    
+    while(*cmd == ' ') cmd++;
+    while((cmd[len] >= 'A' && cmd[len] <= 'Z') || cmd[len] == '_') len++;
+    entry = (len > 0) ? Greenhouse_Find_Command(cmd, len) : 0;
+    if(entry == 0)
+    {
+        printf("Unknown command\r\n");
+        return;
+    }
+    if(entry->arg_type == BT_ARG_TEXT)
+    {
+        bt_text = cmd;
+        entry->handler(entry, 0);
+        return;
+    }
+    
+    // 解析参数
+    p = cmd + len;
+    while(*p == ' ' || *p == ':') p++;
+    has_arg = (*p != '\0' && *p != '\r');
+    if(has_arg)
+    {
+        arg = strtoul(p, &end, (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) ? 16 : 10);
+        while(*end == ' ' || *end == '\r') end++;
+        if(end == p || *end != '\0' || entry->arg_type == BT_ARG_NONE || arg > entry->arg_max)
+        {
+            printf("Error: Invalid argument for %s\r\n", entry->name);
+            return;
+        }
+    }
+    else if(entry->arg_type == BT_ARG_REQUIRED)
+    {
+        printf("Error: %s needs an argument\r\n", entry->name);
+        return;
+    }
+    
+    if((entry->flags & BT_CMD_MANUAL) && greenhouse_status.work_mode != MODE_MANUAL)
+    {
+        printf("Error: Switch to MANUAL mode first\r\n");
+        return;
+    }
+    
+    entry->handler(entry, arg);
+}
+
+/**
+ * @brief  处理蓝牙命令队列
+ * @note   命令行由USART3中断组帧入队，这里逐条取出执行，
+ *         执行期间到达的命令在队列中等待，不会丢失；以0x00开头的是二进制遥测帧
+ */
 void Greenhouse_Handle_Bluetooth(void)
 {
-     static u16 command_count = 0; // 调试计数器
-     
-     // 调试：显示接收状态检查
-     if(USART3_RX_STA != 0) {
-         printf("[DEBUG] USART3_RX_STA = 0x%04X\r\n", USART3_RX_STA);
-     }
-     
-     if(USART3_RX_STA & 0x8000)
-     {
-         USART3_RX_BUF[USART3_RX_STA & 0X3FFF] = 0;
-         command_count++;
-         
-         printf("[BT_CMD_%d] Received: %s (len=%d)\r\n", 
-                command_count, 
-                USART3_RX_BUF, 
-                USART3_RX_STA & 0X3FFF);
-         
-         // STATUS命令 - 查询系统状态
-         if(strstr((char*)USART3_RX_BUF, "STATUS"))
-         {
-             printf("=== System Status ===\r\n");
-             printf("Temperature: %d°C\r\n", greenhouse_status.temperature);
-             printf("Humidity: %d%%\r\n", greenhouse_status.humidity);
-             printf("Light: %d%%\r\n", greenhouse_status.light);
-             printf("Mode: %s\r\n", greenhouse_status.work_mode ? "Manual" : "Auto");
-             printf("Fan: %s\r\n", greenhouse_status.fan_run_status.status ? "ON" : "OFF");
-             printf("Pump: %s\r\n", greenhouse_status.pump_run_status.status ? "ON" : "OFF");
-             printf("Light: %s\r\n", greenhouse_status.light_run_status.status ? "ON" : "OFF");
-             printf("====================\r\n");
-         }
-         // AUTO模式切换
-         else if(strstr((char*)USART3_RX_BUF, "AUTO"))
-         {
-             // 从手动模式切换到自动模式时，关闭所有手动开启的设备
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 printf("Switching from MANUAL to AUTO mode...\r\n");
-                 
-                 // 关闭风扇
-                 if(greenhouse_status.fan_run_status.status == DEVICE_ON) {
-                     Fan_Set_Speed_Percent(0);
-                     greenhouse_status.fan_run_status.status = DEVICE_OFF;
-                     printf("Auto: Fan turned OFF (manual override cleared)\r\n");
-                 }
-                 
-                 // 关闭水泵（流水灯）
-                 if(greenhouse_status.pump_run_status.status == DEVICE_ON) {
-                     LED_Pump_Set(0);
-                     greenhouse_status.pump_run_status.status = DEVICE_OFF;
-                     printf("Auto: Pump/Marquee turned OFF (manual override cleared)\r\n");
-                 }
-                 
-                 // 关闭补光灯
-                 if(greenhouse_status.light_run_status.status == DEVICE_ON) {
-                     LED_Light_Set(0);
-                     greenhouse_status.light_run_status.status = DEVICE_OFF;
-                     printf("Auto: Light turned OFF (manual override cleared)\r\n");
-                 }
-             }
-             
-             greenhouse_status.work_mode = MODE_AUTO;
-             printf("Switched to AUTO mode - System will control devices automatically\r\n");
-         }
-         // MANUAL模式切换
-         else if(strstr((char*)USART3_RX_BUF, "MANUAL"))
-         {
-             if(greenhouse_status.work_mode == MODE_AUTO) {
-                 printf("Switching from AUTO to MANUAL mode...\r\n");
-                 printf("Note: Devices will keep current state until manually controlled\r\n");
-             }
-             
-             greenhouse_status.work_mode = MODE_MANUAL;
-             printf("Switched to MANUAL mode - Use FAN_ON/OFF, PUMP_ON/OFF, LIGHT_ON/OFF commands\r\n");
-         }
-         // FAN_ON - 风扇开启
-         else if(strstr((char*)USART3_RX_BUF, "FAN_ON"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 Fan_Set_Speed_Percent(100); // 100%功率
-                 greenhouse_status.fan_status = DEVICE_ON; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.fan_run_status, DEVICE_ON); // 同步运行时状态
-                 printf("Fan turned ON (100%% power)\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // FAN_OFF - 风扇关闭
-         else if(strstr((char*)USART3_RX_BUF, "FAN_OFF"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 Fan_Set_Speed_Percent(0);
-                 greenhouse_status.fan_status = DEVICE_OFF; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.fan_run_status, DEVICE_OFF); // 同步运行时状态
-                 printf("Fan turned OFF\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // PUMP_ON - 水泵开启
-         else if(strstr((char*)USART3_RX_BUF, "PUMP_ON"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 LED_Pump_Set(1);
-                 greenhouse_status.pump_status = DEVICE_ON; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.pump_run_status, DEVICE_ON); // 同步运行时状态
-                 printf("Pump turned ON\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // PUMP_OFF - 水泵关闭  
-         else if(strstr((char*)USART3_RX_BUF, "PUMP_OFF"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 LED_Pump_Set(0);
-                 greenhouse_status.pump_status = DEVICE_OFF; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.pump_run_status, DEVICE_OFF); // 同步运行时状态
-                 printf("Pump turned OFF\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // LIGHT_ON - 补光灯开启
-         else if(strstr((char*)USART3_RX_BUF, "LIGHT_ON"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 LED_Light_Set(1);
-                 greenhouse_status.light_status = DEVICE_ON; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.light_run_status, DEVICE_ON); // 同步运行时状态
-                 printf("Light turned ON\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // LIGHT_OFF - 补光灯关闭
-         else if(strstr((char*)USART3_RX_BUF, "LIGHT_OFF"))
-         {
-             if(greenhouse_status.work_mode == MODE_MANUAL) {
-                 LED_Light_Set(0);
-                 greenhouse_status.light_status = DEVICE_OFF; // 修正状态变量
-                 Greenhouse_Update_Device_Status(&greenhouse_status.light_run_status, DEVICE_OFF); // 同步运行时状态
-                 printf("Light turned OFF\r\n");
-                 Greenhouse_Update_Display(); // 更新TFT显示
-                 RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status, Fan_Get_Speed());
-             } else {
-                 printf("Error: Switch to MANUAL mode first\r\n");
-             }
-         }
-         // STATS命令 - 系统统计信息
-         else if(strstr((char*)USART3_RX_BUF, "STATS"))
-         {
-             printf("=== System Statistics ===\r\n");
-             printf("Run time: %lu seconds\r\n", greenhouse_status.system_run_time);
-             printf("Fan switches: %d\r\n", greenhouse_status.fan_run_status.switch_count);
-             printf("Pump switches: %d\r\n", greenhouse_status.pump_run_status.switch_count);
-             printf("Light switches: %d\r\n", greenhouse_status.light_run_status.switch_count);
-             printf("========================\r\n");
-         }
-         // TREND命令 - 环境趋势
-         else if(strstr((char*)USART3_RX_BUF, "TREND"))
-         {
-             // ... (TREND command implementation)
-         }
-         // 传感器状态查询
-         else if(strstr((char*)USART3_RX_BUF, "SENSOR_STATUS"))
-         {
-             printf("=== DHT11 Sensor Status ===\r\n");
-             printf("Current Mode: Real Sensor Mode\r\n");
-             printf("Note: System will auto-retry if read fails\r\n");
-             printf("===========================\r\n");
-         }
-         // 蓝牙名称查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_NAME"))
-         {
-             printf("=== Bluetooth Device Info ===\r\n");
-             printf("Current device name: ");
-             HC05_Get_Name();  // 查询当前蓝牙名称
-             printf("Note: Device name is set to 'SBH'\r\n");
-             printf("=============================\r\n");
-         }
-         // 蓝牙版本查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_VER"))
-         {
-             printf("=== HC05 Firmware Version ===\r\n");
-             HC05_Get_Version();
-             printf("==============================\r\n");
-         }
-         // 蓝牙地址查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_ADDR"))
-         {
-             printf("=== HC05 MAC Address ===\r\n");
-             HC05_Get_Address();
-             printf("========================\r\n");
-         }
-         // 蓝牙PIN查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_PIN"))
-         {
-             printf("=== HC05 Pairing PIN ===\r\n");
-             HC05_Get_Pin();
-             printf("========================\r\n");
-         }
-         // 蓝牙波特率查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_BAUD"))
-         {
-             printf("=== HC05 UART Baudrate ===\r\n");
-             HC05_Get_Baud();
-             printf("==========================\r\n");
-         }
-         // 蓝牙角色查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_ROLE"))
-         {
-             u8 role; // 声明变量在代码块开始处
-             printf("=== HC05 Role Mode ===\r\n");
-             role = HC05_Get_Role();
-             if(role == 0) {
-                 printf("Current Role: Slave Mode\r\n");
-             } else if(role == 1) {
-                 printf("Current Role: Master Mode\r\n");
-             } else {
-                 printf("Role Query Failed\r\n");
-             }
-             printf("======================\r\n");
-         }
-         // 蓝牙设备类查询
-         else if(strstr((char*)USART3_RX_BUF, "BT_CLASS"))
-         {
-             printf("=== HC05 Device Class ===\r\n");
-             HC05_Get_Class();
-             printf("=========================\r\n");
-         }
-         // 蓝牙AT测试
-         else if(strstr((char*)USART3_RX_BUF, "BT_TEST"))
-         {
-             printf("=== HC05 AT Test ===\r\n");
-             if(HC05_Test_AT() == 0) {
-                 printf("AT Command Response: OK\r\n");
-             } else {
-                 printf("AT Command Response: FAILED\r\n");
-             }
-             printf("====================\r\n");
-         }
-         // 蓝牙模块重置
-         else if(strstr((char*)USART3_RX_BUF, "BT_RESET"))
-         {
-             printf("=== HC05 Module Reset ===\r\n");
-             if(HC05_Reset() == 0) {
-                 printf("Module Reset: SUCCESS\r\n");
-                 printf("Wait for module restart...\r\n");
-             } else {
-                 printf("Module Reset: FAILED\r\n");
-             }
-             printf("=========================\r\n");
-         }
-         // HC05硬件诊断
-         else if(strstr((char*)USART3_RX_BUF, "BT_DIAG"))
-         {
-             printf("=== HC05 Hardware Diagnostics ===\r\n");
-             
-             // 测试1：KEY引脚控制测试
-             printf("Test 1: KEY Pin Control...\r\n");
-             HC05_KEY = 0;
-             delay_ms(10);
-             printf("  KEY=0: Normal mode\r\n");
-             
-             HC05_KEY = 1;
-             delay_ms(10);
-             printf("  KEY=1: AT mode\r\n");
-             
-             HC05_KEY = 0;
-             printf("  KEY control: PASS\r\n");
-             
-             // 测试2：LED状态检测
-             printf("Test 2: LED Status Detection...\r\n");
-             printf("  LED Status: %s\r\n", HC05_LED ? "HIGH" : "LOW");
-             if(HC05_LED == 0) {
-                 printf("  WARNING: LED LOW - Check power\r\n");
-             } else {
-                 printf("  LED detection: PASS\r\n");
-             }
-             
-             // 测试3：AT命令测试
-             printf("Test 3: AT Command Test...\r\n");
-             if(HC05_Test_AT() == 0) {
-                 printf("  AT Response: PASS\r\n");
-             } else {
-                 printf("  AT Response: FAILED\r\n");
-                 printf("  Check TXD/RXD connections\r\n");
-             }
-             
-             printf("=== Diagnostics Complete ===\r\n");
-         }
-         // ===== RGB彩灯控制命令 =====
-         
-         // RGB显示模式控制
-         else if(strstr((char*)USART3_RX_BUF, "RGB_TEMP"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_TEMP_DISPLAY);
-             RGB_Show_Temperature(greenhouse_status.temperature);
-             printf("RGB: Temperature display mode activated (%d°C)\r\n", greenhouse_status.temperature);
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_HUMIDITY"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_HUMIDITY_DISPLAY);
-             RGB_Show_Humidity(greenhouse_status.humidity);
-             printf("RGB: Humidity display mode activated (%d%%)\r\n", greenhouse_status.humidity);
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_LIGHT"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_LIGHT_DISPLAY);
-             RGB_Show_Light_Level(greenhouse_status.light);
-             printf("RGB: Light display mode activated (%d%%)\r\n", greenhouse_status.light);
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_STATUS"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_STATUS_DISPLAY);
-             RGB_Show_System_Status(greenhouse_status.fan_status, greenhouse_status.pump_status, greenhouse_status.light_status);
-             printf("RGB: System status display mode activated\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_OFF"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_OFF);
-             RGB_LED_Clear();
-             printf("RGB: Display turned off\r\n");
-         }
-         
-         // RGB动画效果
-         else if(strstr((char*)USART3_RX_BUF, "RGB_RAINBOW"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
-             RGB_Start_Rainbow_Animation();
-             printf("RGB: Rainbow animation started\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_BREATHING"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
-             RGB_Start_Breathing_Animation(RGB_COLOR_BLUE);
-             printf("RGB: Breathing animation started\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_FLOW"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_ANIMATION);
-             RGB_Start_Water_Flow_Animation();
-             printf("RGB: Water flow animation started\r\n");
-         }
-         
-         // RGB图案显示
-         else if(strstr((char*)USART3_RX_BUF, "RGB_HEART"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Heart(RGB_COLOR_RED);
-             printf("RGB: Heart pattern displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_SMILEY"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Smiley(RGB_COLOR_YELLOW);
-             printf("RGB: Smiley pattern displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_CHECK"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Check_Mark(RGB_COLOR_GREEN);
-             printf("RGB: Check mark pattern displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_CROSS"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Cross(RGB_COLOR_RED);
-             printf("RGB: Cross pattern displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_ROBOT"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Robot(RGB_COLOR_GREEN);
-             printf("RGB: Robot pattern displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_MANUAL_FACE"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_PATTERN);
-             RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, 
-                                        greenhouse_status.pump_status, 
-                                        greenhouse_status.light_status,
-                                        Fan_Get_Speed());
-             printf("RGB: Manual status face pattern displayed\r\n");
-         }
-         
-         // RGB纯色显示
-         else if(strstr((char*)USART3_RX_BUF, "RGB_RED"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_RED);
-             printf("RGB: Red color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_GREEN"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_GREEN);
-             printf("RGB: Green color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_BLUE"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_BLUE);
-             printf("RGB: Blue color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_WHITE"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_WHITE);
-             printf("RGB: White color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_YELLOW"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_YELLOW);
-             printf("RGB: Yellow color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_PURPLE"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_PURPLE);
-             printf("RGB: Purple color displayed\r\n");
-         }
-         else if(strstr((char*)USART3_RX_BUF, "RGB_CYAN"))
-         {
-             RGB_Set_Display_Mode(RGB_MODE_SOLID_COLOR);
-             RGB_Set_All_Color(RGB_COLOR_CYAN);
-             printf("RGB: Cyan color displayed\r\n");
-         }
-         
-         // RGB亮度控制 (RGB_BRIGHT + 数字)
-         else if(strstr((char*)USART3_RX_BUF, "RGB_BRIGHT"))
-         {
-             char* bright_str = strstr((char*)USART3_RX_BUF, "RGB_BRIGHT");
-             if(bright_str) {
-                 u8 brightness = atoi(bright_str + 10); // "RGB_BRIGHT"后的数字
-                 if(brightness <= 100) {
-                     RGB_Set_Brightness(brightness);
-                     printf("RGB: Brightness set to %d%%\r\n", brightness);
-                 } else {
-                     printf("RGB: Invalid brightness value (0-100)\r\n");
-                 }
-             }
-         }
-         
-         // 帮助命令
-         else if(strstr((char*)USART3_RX_BUF, "HELP"))
-         {
-             printf("=== Bluetooth Command Help ===\r\n");
-             printf("Basic Commands:\r\n");
-             printf("  STATUS - Query system status\r\n");
-             printf("  AUTO - Switch to auto mode\r\n");
-             printf("  MANUAL - Switch to manual mode\r\n");
-             printf("Device Control:\r\n");
-             printf("  FAN_ON/FAN_OFF - Fan control\r\n");
-             printf("  PUMP_ON/PUMP_OFF - Pump control\r\n");
-             printf("  LIGHT_ON/LIGHT_OFF - Light control\r\n");
-             printf("RGB Display Modes:\r\n");
-             printf("  RGB_TEMP - Temperature visualization\r\n");
-             printf("  RGB_HUMIDITY - Humidity visualization\r\n");
-             printf("  RGB_LIGHT - Light level visualization\r\n");
-             printf("  RGB_STATUS - System status display\r\n");
-             printf("  RGB_OFF - Turn off RGB display\r\n");
-             printf("RGB Animations:\r\n");
-             printf("  RGB_RAINBOW - Rainbow effect\r\n");
-             printf("  RGB_BREATHING - Breathing effect\r\n");
-             printf("  RGB_FLOW - Water flow effect\r\n");
-             printf("RGB Patterns:\r\n");
-             printf("  RGB_HEART - Heart pattern\r\n");
-             printf("  RGB_SMILEY - Smiley face pattern\r\n");
-             printf("  RGB_CHECK - Check mark pattern\r\n");
-             printf("  RGB_CROSS - Cross pattern\r\n");
-             printf("RGB Colors:\r\n");
-             printf("  RGB_RED/GREEN/BLUE/WHITE/YELLOW/PURPLE/CYAN\r\n");
-             printf("RGB Brightness:\r\n");
-             printf("  RGB_BRIGHT[0-100] - Set brightness (e.g., RGB_BRIGHT30)\r\n");
-             printf("Sensor Control:\r\n");
-             printf("  SENSOR_STATUS - Query sensor status\r\n");
-             printf("Calibration Commands:\r\n");
-             printf("  CAL_TEMP:±value - Temperature calibration\r\n");
-             printf("  CAL_HUMI:±value - Humidity calibration\r\n");
-             printf("Query Commands:\r\n");
-             printf("  STATS - System Statistics\r\n");
-             printf("  TREND - Environment Trend\r\n");
-             printf("Bluetooth Commands:\r\n");
-             printf("  BT_NAME - Get Device Name\r\n");
-             printf("  BT_VER - Get Firmware Version\r\n");
-             printf("  BT_ADDR - Get MAC Address\r\n");
-             printf("  BT_PIN - Get Pairing PIN\r\n");
-             printf("  BT_BAUD - Get Baudrate\r\n");
-             printf("  BT_ROLE - Get Role Mode\r\n");
-             printf("  BT_CLASS - Get Device Class\r\n");
-             printf("  BT_TEST - Test AT Response\r\n");
-             printf("  BT_RESET - Reset Module\r\n");
-             printf("  BT_DIAG - Hardware Diagnostics\r\n");
-             printf("  HELP - Show This Help\r\n");
-             printf("==============================\r\n");
-         }
-         else
-         {
-             printf("Unknown command\r\n");
-         }
-         
-         USART3_RX_STA = 0;
-     }
+    char cmd[USART3_LINE_LEN];
+    u16 len;
+    
+    while((len = USART3_Get_Line(cmd, sizeof(cmd))) > 0)
+    {
+        if(cmd[0] == 0x00)
+            Telemetry_Receive((const u8*)cmd + 1, len - 1);
+        else if(HC05_AT_Feed_Line(cmd) == 0)     // AT事务进行中时模块应答不当作命令
+            Greenhouse_Bluetooth_Command(cmd);
+    }
 }
 
 // 添加缺失的函数定义
@@ -965,22 +1236,22 @@ void Greenhouse_Task(void)
 {
     static u8 task_counter = 0;
     
-    printf("Greenhouse_Task: Starting sensor reading\r\n");
+    LOG_DEBUG(("Greenhouse_Task: Starting sensor reading\r\n"));
     
     // 更新传感器数据
     Greenhouse_Update_Sensors();
     
-    printf("Greenhouse_Task: Sensor reading completed\r\n");
+    LOG_DEBUG(("Greenhouse_Task: Sensor reading completed\r\n"));
     
     // 每隔几次任务周期打印一次状态，用于调试
     task_counter++;
     if(task_counter >= 10) {  // 每2秒打印一次状态
         task_counter = 0;
-        printf("System Status: T=%d°C, H=%d%%, L=%d%%, Mode=%s\r\n",
+        LOG_DEBUG(("System Status: T=%d°C, H=%d%%, L=%d%%, Mode=%s\r\n",
                greenhouse_status.temperature,
                greenhouse_status.humidity, 
                greenhouse_status.light,
-               greenhouse_status.work_mode ? "Manual" : "Auto");
+               greenhouse_status.work_mode ? "Manual" : "Auto"));
     }
     
     // 执行自动控制逻辑
@@ -1031,6 +1302,7 @@ void Greenhouse_Update_Device_Status(DeviceRunStatus_t* device, u8 new_status)
         
         device->status = new_status;
         device->switch_count++;
+        Event_Publish(EVT_TOPIC_DEVICE);
     }
 }
  
@@ -35,6 +35,13 @@
 #define ALARM_LOW_LIGHT     0x10
 #define ALARM_SENSOR_ERROR  0x20
 
+// 状态变化通知主题（event_bus），遥测据此推送增量
+#define EVT_TOPIC_SENSOR    0   // 温湿度、光照、传感器错误
+#define EVT_TOPIC_DEVICE    1   // 风扇/水泵/补光灯状态和风扇转速
+#define EVT_TOPIC_ALARM     2   // 报警标志
+#define EVT_TOPIC_MODE      3   // 工作模式
+#define EVT_SENSOR_INTERVAL 1000 // 传感器主题最短分发间隔(ms)
+
 // 阈值设定
 #define TEMP_AUTO_FAN_ON    27  // 温度超过27°C开启风扇
 #define TEMP_HIGH_ALARM     35  // 高温报警
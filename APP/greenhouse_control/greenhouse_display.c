@@ -9,18 +9,213 @@
 #include "greenhouse_control.h"
 #include "../rtc/rtc.h"  // 包含RTC头文件，使用其中定义的RTC_Time_t
 #include <string.h>     // 包含string.h以使用strcat
+#include "log.h"
+
+// ================== 保留模式控件层 ==================
+// 每个控件是一块固定包围盒的文本区域，记录目标内容与屏幕上的已显示内容。
+// 每帧先比较两者，把变化的字符格收集为脏矩形，合并相邻矩形后统一刷新，
+// 因此只有真正变化的字符（例如秒数）会被重绘。
+
+#define DISP_FONT_SIZE      16
+#define DISP_CHAR_W         (DISP_FONT_SIZE / 2)
+#define DISP_MAX_COLS       24      // 单个控件最大字符格数
+#define DISP_MAX_DIRTY      24      // 每帧脏矩形表容量
+
+// 控件编号
+typedef enum {
+    W_DATE = 0, W_TIME,
+    W_MODE_LABEL, W_MODE,
+    W_TEMP_LABEL, W_TEMP,
+    W_HUMI_LABEL, W_HUMI,
+    W_LIGHT_LABEL, W_LIGHT,
+    W_FAN_LABEL, W_FAN,
+    W_PUMP_LABEL, W_PUMP,
+    W_LAMP_LABEL, W_LAMP,
+    W_COUNT
+} DispWidgetId_t;
+
+// 控件：包围盒为 (x, y) 起 cols*DISP_CHAR_W 宽、DISP_FONT_SIZE 高
+typedef struct {
+    u16 x, y;
+    u8  cols;
+    u16 color;                      // 目标前景色
+    u16 shown_color;                // 屏幕上内容的前景色
+    char text[DISP_MAX_COLS + 1];   // 目标内容，不足cols以空格补齐
+    char shown[DISP_MAX_COLS + 1];  // 已显示内容，0表示未知
+} DispWidget_t;
+
+// 脏矩形：一行连续的同色字符格
+typedef struct {
+    u16 x, y;
+    u16 color;
+    u8  len;
+    char text[DISP_MAX_COLS + 1];
+} DispDirty_t;
+
+// 控件布局 {x, y, cols}
+static const u16 disp_layout[W_COUNT][3] = {
+    {10, 30, 23}, {160, 50, 15},
+    {10, 70, 6},  {80, 70, 12},
+    {10, 100, 6}, {80, 100, 12},
+    {10, 130, 6}, {80, 130, 12},
+    {10, 160, 6}, {80, 160, 12},
+    {10, 190, 6}, {80, 190, 12},
+    {10, 220, 6}, {80, 220, 12},
+    {10, 250, 6}, {80, 250, 12},
+};
+
+static DispWidget_t disp_widgets[W_COUNT];
+static DispDirty_t disp_dirty[DISP_MAX_DIRTY];
+static u8 disp_dirty_count = 0;
+static u32 disp_flush_pixels = 0;   // 最近一次更新写入的像素数
+
+// 设置控件内容和颜色（只修改目标状态，不访问LCD）
+static void Widget_Set(u8 id, const char* text, u16 color)
+{
+    DispWidget_t* w = &disp_widgets[id];
+    u8 i;
+    
+    for(i = 0; i < w->cols && text[i] != '\0'; i++) {
+        w->text[i] = text[i];
+    }
+    for(; i < w->cols; i++) {
+        w->text[i] = ' ';
+    }
+    w->text[w->cols] = '\0';
+    w->color = color;
+}
+
+// 把脏矩形表写到LCD并清空
+static void Display_Flush(void)
+{
+    DispDirty_t* d;
+    u8 i;
+    
+    BACK_COLOR = WHITE;
+    for(i = 0; i < disp_dirty_count; i++) {
+        d = &disp_dirty[i];
+        FRONT_COLOR = d->color;
+        LCD_ShowString(d->x, d->y, d->len * DISP_CHAR_W, DISP_FONT_SIZE, DISP_FONT_SIZE, (u8*)d->text);
+        disp_flush_pixels += (u32)d->len * DISP_CHAR_W * DISP_FONT_SIZE;
+    }
+    disp_dirty_count = 0;
+}
+
+// 加入一个脏矩形；与上一个矩形同行同色且首尾相接时直接合并
+static void Dirty_Add(u16 x, u16 y, u16 color, const char* text, u8 len)
+{
+    DispDirty_t* d;
+    
+    if(disp_dirty_count > 0) {
+        d = &disp_dirty[disp_dirty_count - 1];
+        if(d->y == y && d->color == color && d->x + d->len * DISP_CHAR_W == x
+           && d->len + len <= DISP_MAX_COLS) {
+            memcpy(&d->text[d->len], text, len);
+            d->len += len;
+            d->text[d->len] = '\0';
+            return;
+        }
+    }
+    
+    if(disp_dirty_count >= DISP_MAX_DIRTY) {
+        Display_Flush();
+    }
+    d = &disp_dirty[disp_dirty_count++];
+    d->x = x;
+    d->y = y;
+    d->color = color;
+    d->len = len;
+    memcpy(d->text, text, len);
+    d->text[len] = '\0';
+}
+
+// 比较所有控件的目标与已显示内容，收集脏字符格后统一刷新
+static void Display_Compose(void)
+{
+    DispWidget_t* w;
+    u8 id, i, start;
+    
+    disp_flush_pixels = 0;
+    for(id = 0; id < W_COUNT; id++) {
+        w = &disp_widgets[id];
+        
+        // 颜色变化时整个控件重绘
+        if(w->color != w->shown_color) {
+            memset(w->shown, 0, sizeof(w->shown));
+        }
+        
+        i = 0;
+        while(i < w->cols) {
+            if(w->text[i] == w->shown[i]) {
+                i++;
+                continue;
+            }
+            start = i;
+            while(i < w->cols && w->text[i] != w->shown[i]) {
+                i++;
+            }
+            Dirty_Add(w->x + start * DISP_CHAR_W, w->y, w->color, &w->text[start], i - start);
+        }
+        
+        memcpy(w->shown, w->text, sizeof(w->shown));
+        w->shown_color = w->color;
+    }
+    Display_Flush();
+}
+
+/**
+ * @brief  使所有控件的已显示内容失效，下次更新时全部重绘
+ * @note   清屏等绕过控件层直接改写屏幕后调用
+ */
+void Display_Invalidate(void)
+{
+    u8 id;
+    
+    for(id = 0; id < W_COUNT; id++) {
+        disp_widgets[id].x = disp_layout[id][0];
+        disp_widgets[id].y = disp_layout[id][1];
+        disp_widgets[id].cols = disp_layout[id][2];
+        memset(disp_widgets[id].shown, 0, sizeof(disp_widgets[id].shown));
+        if(disp_widgets[id].text[0] == '\0') {
+            Widget_Set(id, "", NORMAL_COLOR);
+        }
+    }
+}
+
+/**
+ * @brief  获取最近一次状态刷新写入LCD的像素数
+ */
+u32 Display_Get_Flush_Pixels(void)
+{
+    return disp_flush_pixels;
+}
 
 // 显示屏初始化
 void Display_Init(void)
 {
+    extern volatile u32 system_time_ms;
+    u32 start, elapsed, pixels;
+    
     TFTLCD_Init();
+    
+    // 全屏清屏即单窗口连续写像素，顺便测量像素流吞吐率
+    start = system_time_ms;
     LCD_Clear(WHITE);
+    elapsed = system_time_ms - start;
+    pixels = (u32)tftlcd_data.width * tftlcd_data.height;
+    if(elapsed > 0) {
+        printf("LCD: %lu pixels streamed in %lums (%lu px/s)\r\n",
+               pixels, elapsed, pixels * 1000 / elapsed);
+    }
+    
+    Display_Invalidate();
 }
 
 // 清屏
 void Display_Clear(void)
 {
     LCD_Clear(WHITE);
+    Display_Invalidate();
 }
 
 // 显示标题
@@ -31,166 +226,96 @@ void Display_Title(void)
     LCD_ShowString(60, 10, 200, 24, 24, (u8*)"Smart Greenhouse");
     
     // 显示初始界面框架
-    FRONT_COLOR = NORMAL_COLOR;
-    LCD_ShowString(10, 70, 100, 16, 16, (u8*)"Mode:");
-    LCD_ShowString(10, 100, 100, 16, 16, (u8*)"Temp:");
-    LCD_ShowString(10, 130, 100, 16, 16, (u8*)"Humi:");
-    LCD_ShowString(10, 160, 100, 16, 16, (u8*)"Light:");
-    LCD_ShowString(10, 190, 100, 16, 16, (u8*)"Fan:");
-    LCD_ShowString(10, 220, 100, 16, 16, (u8*)"Pump:");
-    LCD_ShowString(10, 250, 100, 16, 16, (u8*)"Light:");
+    Widget_Set(W_MODE_LABEL, "Mode:", NORMAL_COLOR);
+    Widget_Set(W_TEMP_LABEL, "Temp:", NORMAL_COLOR);
+    Widget_Set(W_HUMI_LABEL, "Humi:", NORMAL_COLOR);
+    Widget_Set(W_LIGHT_LABEL, "Light:", NORMAL_COLOR);
+    Widget_Set(W_FAN_LABEL, "Fan:", NORMAL_COLOR);
+    Widget_Set(W_PUMP_LABEL, "Pump:", NORMAL_COLOR);
+    Widget_Set(W_LAMP_LABEL, "Light:", NORMAL_COLOR);
     
     // 显示初始值
-    FRONT_COLOR = VALUE_COLOR;
-    LCD_ShowString(80, 70, 100, 16, 16, (u8*)"---");
-    LCD_ShowString(80, 100, 100, 16, 16, (u8*)"--- C");
-    LCD_ShowString(80, 130, 100, 16, 16, (u8*)"---%");
-    LCD_ShowString(80, 160, 100, 16, 16, (u8*)"---%");
-    LCD_ShowString(80, 190, 100, 16, 16, (u8*)"---");
-    LCD_ShowString(80, 220, 100, 16, 16, (u8*)"---");
-    LCD_ShowString(80, 250, 100, 16, 16, (u8*)"---");
+    Widget_Set(W_MODE, "---", VALUE_COLOR);
+    Widget_Set(W_TEMP, "--- C", VALUE_COLOR);
+    Widget_Set(W_HUMI, "---%", VALUE_COLOR);
+    Widget_Set(W_LIGHT, "---%", VALUE_COLOR);
+    Widget_Set(W_FAN, "---", VALUE_COLOR);
+    Widget_Set(W_PUMP, "---", VALUE_COLOR);
+    Widget_Set(W_LAMP, "---", VALUE_COLOR);
+    
+    Display_Compose();
 }
 
-// 显示系统状态 - 高性能版本
+// 显示系统状态：更新各控件目标内容，只重绘变化的字符
 void Display_System_Status(GreenhouseStatus_t* status)
 {
     char buf[50];
     u8 current_fan_speed;  // 变量声明移到函数开始，符合C89标准
-    static u8 last_temp = 255, last_humi = 255, last_light = 255;  // 缓存上次数值
-    static u8 last_fan_status = 255, last_pump_status = 255, last_light_status = 255;
-    static u8 last_work_mode = 255, last_fan_speed = 255;
+    static u8 last_temp = 255;
+    static u8 last_fan_status = 255, last_fan_speed = 255;
     static u32 last_alarm_flags = 0xFFFFFFFF;
     static u8 first_display = 1;  // 首次显示标志
-    static u8 fan_update_counter = 0;  // 风扇强制更新计数器
     char alarm_msg[50];
     
-    BACK_COLOR = WHITE;
-    
     // 调试信息：显示接收到的数据
     if(first_display) {
-        printf("Display: First display status - T:%d, H:%d, L:%d, Mode:%d\r\n", 
-               status->temperature, status->humidity, status->light, status->work_mode);
+        LOG_INFO(("Display: First display status - T:%d, H:%d, L:%d, Mode:%d\r\n", 
+               status->temperature, status->humidity, status->light, status->work_mode));
+        first_display = 0;
     }
     
-    // 智能刷新：只更新变化的内容，减少不必要的重绘
-    
-    // 时间总是更新（每500ms更新一次，快速响应）
-    LCD_Fill(160, 50, 280, 66, WHITE);
-    FRONT_COLOR = NORMAL_COLOR;
+    // 日期和时间
     RTC_Format_Time(&current_time, buf);
-    LCD_ShowString(160, 50, 120, 16, 16, (u8*)buf);
-    
-    LCD_Fill(10, 30, 200, 46, WHITE);
+    Widget_Set(W_TIME, buf, NORMAL_COLOR);
     RTC_Format_Date(&current_time, buf);
-    LCD_ShowString(10, 30, 200, 16, 16, (u8*)buf);
-    
-    // 工作模式 - 只在变化时更新或首次显示
-    if(last_work_mode != status->work_mode || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 70, 100, 16, 16, (u8*)"Mode:");
-        LCD_Fill(80, 70, 180, 86, WHITE);
-        FRONT_COLOR = VALUE_COLOR;
-        sprintf(buf, "%s", status->work_mode == MODE_AUTO ? "AUTO" : "MANUAL");
-        LCD_ShowString(80, 70, 100, 16, 16, (u8*)buf);
-        last_work_mode = status->work_mode;
-    }
+    Widget_Set(W_DATE, buf, NORMAL_COLOR);
     
-    // 温度 - 只在变化时更新或首次显示
-    if(last_temp != status->temperature || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 100, 100, 16, 16, (u8*)"Temp:");
-        LCD_Fill(80, 100, 180, 116, WHITE);
-        FRONT_COLOR = VALUE_COLOR;
-        sprintf(buf, "%3d C", status->temperature);
-        LCD_ShowString(80, 100, 100, 16, 16, (u8*)buf);
+    // 工作模式
+    Widget_Set(W_MODE, status->work_mode == MODE_AUTO ? "AUTO" : "MANUAL", VALUE_COLOR);
+    
+    // 温度
+    sprintf(buf, "%3d C", status->temperature);
+    Widget_Set(W_TEMP, buf, VALUE_COLOR);
+    if(last_temp != status->temperature) {
+        LOG_DEBUG(("Temperature display updated: %d C\r\n", status->temperature));
         last_temp = status->temperature;
-        printf("Temperature display updated: %d C\r\n", status->temperature);
     }
     
-    // 湿度 - 只在变化时更新或首次显示
-    if(last_humi != status->humidity || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 130, 100, 16, 16, (u8*)"Humi:");
-        LCD_Fill(80, 130, 180, 146, WHITE);
-        FRONT_COLOR = VALUE_COLOR;
-        sprintf(buf, "%3d%%", status->humidity);
-        LCD_ShowString(80, 130, 100, 16, 16, (u8*)buf);
-        last_humi = status->humidity;
-    }
+    // 湿度
+    sprintf(buf, "%3d%%", status->humidity);
+    Widget_Set(W_HUMI, buf, VALUE_COLOR);
     
-    // 光照 - 只在变化时更新或首次显示
-    if(last_light != status->light || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 160, 100, 16, 16, (u8*)"Light:");
-        LCD_Fill(80, 160, 180, 176, WHITE);
-        FRONT_COLOR = VALUE_COLOR;
-        sprintf(buf, "%3d%%", status->light);
-        LCD_ShowString(80, 160, 100, 16, 16, (u8*)buf);
-        last_light = status->light;
-    }
+    // 光照
+    sprintf(buf, "%3d%%", status->light);
+    Widget_Set(W_LIGHT, buf, VALUE_COLOR);
     
-    // 风扇状态和转速变化检测 - 直接从PWM硬件读取
+    // 风扇状态和转速 - 直接从PWM硬件读取
     current_fan_speed = Fan_Get_Speed_Percent();  // 直接从PWM寄存器读取实际转速
     if(last_fan_status != status->fan_status) {
-        printf("Fan status changed: %d -> %d\r\n", last_fan_status, status->fan_status);
+        LOG_DEBUG(("Fan status changed: %d -> %d\r\n", last_fan_status, status->fan_status));
+        last_fan_status = status->fan_status;
     }
     if(last_fan_speed != current_fan_speed) {
-        printf("Fan speed changed: %d%% -> %d%%\r\n", last_fan_speed, current_fan_speed);
-    }
-    
-    // 风扇强制更新计数器 - 每5次调用强制更新一次
-    fan_update_counter++;
-    
-    // 风扇状态显示 - 强制更新以确保转速及时显示
-    if(last_fan_status != status->fan_status || last_fan_speed != current_fan_speed || first_display || (fan_update_counter >= 5)) {
-        
-        if(fan_update_counter >= 5) {
-            fan_update_counter = 0;  // 重置计数器
-            printf("Fan display: Force update (counter reset)\r\n");
-        }
-        
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 190, 100, 16, 16, (u8*)"Fan:");
-        LCD_Fill(80, 190, 180, 206, WHITE);
-        
-        // 修正逻辑：严格根据fan_status判断ON/OFF
-        if(status->fan_status == DEVICE_OFF) {
-            FRONT_COLOR = NORMAL_COLOR;
-            sprintf(buf, "OFF");
-        } else {
-            FRONT_COLOR = OK_COLOR;
-            sprintf(buf, "ON %3d%%", current_fan_speed);
-        }
-        
-        LCD_ShowString(80, 190, 100, 16, 16, (u8*)buf);
-        
-        printf("Fan display updated: %s (Speed: %d%%)\r\n", buf, current_fan_speed);
-        
-        last_fan_status = status->fan_status;
+        LOG_DEBUG(("Fan speed changed: %d%% -> %d%%\r\n", last_fan_speed, current_fan_speed));
         last_fan_speed = current_fan_speed;
     }
-    
-    // 水泵状态 - 只在变化时更新或首次显示
-    if(last_pump_status != status->pump_status || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 220, 100, 16, 16, (u8*)"Pump:");
-        LCD_Fill(80, 220, 180, 236, WHITE);
-        FRONT_COLOR = status->pump_status ? OK_COLOR : NORMAL_COLOR;
-        sprintf(buf, "%s", status->pump_status ? "ON" : "OFF");
-        LCD_ShowString(80, 220, 100, 16, 16, (u8*)buf);
-        last_pump_status = status->pump_status;
+    // 严格根据fan_status判断ON/OFF
+    if(status->fan_status == DEVICE_OFF) {
+        Widget_Set(W_FAN, "OFF", NORMAL_COLOR);
+    } else {
+        sprintf(buf, "ON %3d%%", current_fan_speed);
+        Widget_Set(W_FAN, buf, OK_COLOR);
     }
     
-    // 补光灯状态 - 只在变化时更新或首次显示
-    if(last_light_status != status->light_status || first_display) {
-        FRONT_COLOR = NORMAL_COLOR;
-        LCD_ShowString(10, 250, 100, 16, 16, (u8*)"Light:");
-        LCD_Fill(80, 250, 180, 266, WHITE);
-        FRONT_COLOR = status->light_status ? OK_COLOR : NORMAL_COLOR;
-        sprintf(buf, "%s", status->light_status ? "ON" : "OFF");
-        LCD_ShowString(80, 250, 100, 16, 16, (u8*)buf);
-        last_light_status = status->light_status;
-    }
+    // 水泵状态
+    Widget_Set(W_PUMP, status->pump_status ? "ON" : "OFF",
+               status->pump_status ? OK_COLOR : NORMAL_COLOR);
+    
+    // 补光灯状态
+    Widget_Set(W_LAMP, status->light_status ? "ON" : "OFF",
+               status->light_status ? OK_COLOR : NORMAL_COLOR);
+    
+    Display_Compose();
     
     // 报警状态 - 只在变化时更新
     if (last_alarm_flags != status->alarm_flags)
@@ -213,11 +338,6 @@ void Display_System_Status(GreenhouseStatus_t* status)
         }
         last_alarm_flags = status->alarm_flags;
     }
-    
-    // 重置首次显示标志
-    if(first_display) {
-        first_display = 0;
-    }
 }
 
 // 显示消息
@@ -30,5 +30,7 @@ void Display_Clear(void);
 void Display_Title(void);
 void Display_System_Status(GreenhouseStatus_t* status);
 void Display_Message(u16 x, u16 y, char* msg, u16 color);
+void Display_Invalidate(void);          // 控件内容失效，下次全部重绘
+u32 Display_Get_Flush_Pixels(void);     // 最近一次刷新写入的像素数
 
 #endif /* __GREENHOUSE_DISPLAY_H__ */
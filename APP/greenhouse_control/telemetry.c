@@ -0,0 +1,281 @@
+#include "telemetry.h"
+#include "greenhouse_control.h"
+#include "usart3.h"
+#include "hc05.h"
+#include "crc16.h"
+#include "event_bus.h"
+#include "../data_logger/log_export.h"
+#include "string.h"
+#include "../fan_pwm/fan_pwm.h"
+
+extern volatile u32 system_time_ms;
+
+static u16 tlm_period = 0;              // 最短推送间隔(ms)，0-未订阅
+static u32 tlm_next;                    // 最早可以再次推送增量的时刻（system_time_ms）
+static u32 tlm_keyframe;                // 下次发送完整快照的时刻
+static u8 tlm_dirty;                    // 有状态变化尚未推送
+static u8 tlm_synced;                   // tlm_last已被APP收到
+static TelemetryStatus_t tlm_last;      // 上次发出的快照，TLM_DELTA相对它计算
+static u8 tlm_frame[TLM_FRAME_MAX];
+
+/**
+ * @brief  生成线路帧：0x00 | COBS(type, len, payload, crc) | 0x00
+ * @param  out: 输出缓冲区，至少TLM_FRAME_MAX字节
+ * @retval 帧长度，payload过长返回0
+ */
+u16 Telemetry_Frame_Encode(u8 type, const u8* payload, u8 len, u8* out)
+{
+    u8 raw[TLM_RAW_MAX];
+    u16 crc, n, i, code_pos;
+    u8 code;
+
+    if(len > TLM_PAYLOAD_MAX) return 0;
+    raw[0] = type;
+    raw[1] = len;
+    if(len > 0) memcpy(&raw[2], payload, len);
+    crc = crc16_ccitt(0xFFFF, raw, len + 2);
+    raw[len + 2] = crc & 0xFF;
+    raw[len + 3] = crc >> 8;
+
+    // COBS：每个0x00替换为到下一个0x00的距离，帧短于254字节时不会出现0xFF分块
+    out[0] = 0x00;
+    code_pos = 1;
+    code = 1;
+    n = 2;
+    for(i = 0; i < len + 4; i++)
+    {
+        if(raw[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = n++;
+            code = 1;
+        }
+        else
+        {
+            out[n++] = raw[i];
+            code++;
+        }
+    }
+    out[code_pos] = code;
+    out[n++] = 0x00;
+    return n;
+}
+
+/**
+ * @brief  解码两个帧界之间的数据并校验
+ * @param  payload: 输出缓冲区，至少TLM_PAYLOAD_MAX字节
+ * @retval 0-成功，1-编码、长度或CRC错误
+ */
+u8 Telemetry_Frame_Decode(const u8* data, u16 size, u8* type, u8* payload, u8* len)
+{
+    u8 raw[TLM_RAW_MAX];
+    u16 i = 0, n = 0, crc;
+    u8 code, k;
+
+    while(i < size)
+    {
+        code = data[i++];
+        if(code == 0) return 1;
+        for(k = 1; k < code; k++)
+        {
+            if(i >= size || n >= TLM_RAW_MAX || data[i] == 0) return 1;
+            raw[n++] = data[i++];
+        }
+        if(code < 0xFF && i < size)
+        {
+            if(n >= TLM_RAW_MAX) return 1;
+            raw[n++] = 0;
+        }
+    }
+
+    if(n < 4 || raw[1] != n - 4) return 1;
+    crc = crc16_ccitt(0xFFFF, raw, n - 2);
+    if((crc & 0xFF) != raw[n - 2] || (crc >> 8) != raw[n - 1]) return 1;
+    *type = raw[0];
+    *len = raw[1];
+    memcpy(payload, &raw[2], raw[1]);
+    return 0;
+}
+
+/**
+ * @brief  编码并写入USART3发送缓冲区
+ * @retval 0-已发送，1-发送缓冲区空间不足、AT事务或日志导出进行中
+ * @note   AT事务期间KEY为高，暂停发送以免帧被模块当作命令；
+ *         日志导出帧含原始0x00字节，导出期间也暂停，APP的COBS解析不会在导出数据中误同步，
+ *         推迟的变化在导出结束后随下一个增量或快照发出
+ */
+static u8 Telemetry_Send(u8 type, const u8* payload, u8 len)
+{
+    u16 n;
+
+    if(HC05_AT_Busy() || LogExport_Active() || USART3_TX_Free() < TLM_FRAME_MAX) return 1;
+    n = Telemetry_Frame_Encode(type, payload, len, tlm_frame);
+    USART3_Write(tlm_frame, n);
+    return 0;
+}
+
+/**
+ * @brief  采集当前状态快照
+ */
+static void Telemetry_Snapshot(TelemetryStatus_t* s)
+{
+    s->run_time = greenhouse_status.system_run_time;
+    s->temperature = greenhouse_status.temperature;
+    s->humidity = greenhouse_status.humidity;
+    s->light = greenhouse_status.light;
+    s->work_mode = greenhouse_status.work_mode;
+    s->fan_status = greenhouse_status.fan_status;
+    s->fan_speed = Fan_Get_Speed_Percent();
+    s->pump_status = greenhouse_status.pump_status;
+    s->light_status = greenhouse_status.light_status;
+    s->alarm_flags = greenhouse_status.alarm_flags;
+    s->sensor_error = greenhouse_status.sensor_error;
+    s->fan_switches = greenhouse_status.fan_run_status.switch_count;
+    s->pump_switches = greenhouse_status.pump_run_status.switch_count;
+    s->light_switches = greenhouse_status.light_run_status.switch_count;
+    s->alarm_count = greenhouse_status.alarm_count;
+}
+
+/**
+ * @brief  发送完整快照，成功后作为增量的基准
+ */
+static void Telemetry_Send_Status(void)
+{
+    TelemetryStatus_t s;
+
+    Telemetry_Snapshot(&s);
+    if(Telemetry_Send(TLM_STATUS, (const u8*)&s, sizeof(s)) == 0)
+    {
+        tlm_last = s;
+        tlm_synced = 1;
+        tlm_dirty = 0;
+        tlm_keyframe = system_time_ms + (u32)tlm_period * TLM_KEYFRAME_PERIODS;
+    }
+}
+
+/**
+ * @brief  发送相对上次快照的增量，没有变化时不发送
+ * @note   发送缓冲区满时保留tlm_dirty，下次推送的增量包含这次的变化
+ */
+static void Telemetry_Send_Delta(void)
+{
+    TelemetryStatus_t s;
+    u8 payload[4 + sizeof(TelemetryStatus_t)];
+    const u8* cur = (const u8*)&s;
+    const u8* old = (const u8*)&tlm_last;
+    u32 mask = 0;
+    u8 i, n = 4;
+
+    Telemetry_Snapshot(&s);
+    for(i = 0; i < sizeof(s); i++)
+    {
+        if(cur[i] != old[i])
+        {
+            mask |= (u32)1 << i;
+            payload[n++] = cur[i];
+        }
+    }
+    if(mask == 0)
+    {
+        tlm_dirty = 0;
+        return;
+    }
+
+    payload[0] = mask & 0xFF;
+    payload[1] = (mask >> 8) & 0xFF;
+    payload[2] = (mask >> 16) & 0xFF;
+    payload[3] = mask >> 24;
+    if(Telemetry_Send(TLM_DELTA, payload, n) == 0)
+    {
+        tlm_last = s;
+        tlm_dirty = 0;
+        tlm_next = system_time_ms + tlm_period;
+    }
+}
+
+/**
+ * @brief  处理收到的一帧
+ * @param  data: 两个帧界之间的COBS数据
+ */
+void Telemetry_Receive(const u8* data, u16 size)
+{
+    u8 payload[TLM_PAYLOAD_MAX];
+    u8 ack[2];
+    u8 type, len;
+    u16 period;
+
+    if(Telemetry_Frame_Decode(data, size, &type, payload, &len) != 0) return;
+
+    ack[0] = type;
+    ack[1] = 0;
+    switch(type)
+    {
+        case TLM_GET:
+            Telemetry_Send_Status();
+            break;
+
+        case TLM_SUBSCRIBE:
+            period = (len >= 2) ? (payload[0] | ((u16)payload[1] << 8)) : 0;
+            if(period < TLM_PERIOD_MIN)
+            {
+                ack[1] = 1;
+                Telemetry_Send(TLM_ACK, ack, 2);
+                break;
+            }
+            tlm_period = period;
+            tlm_next = system_time_ms + period;
+            tlm_keyframe = system_time_ms;
+            Telemetry_Send(TLM_ACK, ack, 2);
+            tlm_synced = 0;
+            Telemetry_Send_Status();
+            break;
+
+        case TLM_UNSUBSCRIBE:
+            tlm_period = 0;
+            Telemetry_Send(TLM_ACK, ack, 2);
+            break;
+
+        default:
+            ack[1] = 1;
+            Telemetry_Send(TLM_ACK, ack, 2);
+            break;
+    }
+}
+
+u8 Telemetry_Subscribed(void)
+{
+    return tlm_period != 0;
+}
+
+/**
+ * @brief  状态变化通知：间隔已满足时立即推送增量，否则留给Telemetry_Task
+ */
+static void Telemetry_On_Event(u32 topics)
+{
+    if(tlm_period == 0) return;
+    tlm_dirty = 1;
+    if(tlm_synced && (s32)(system_time_ms - tlm_next) >= 0) Telemetry_Send_Delta();
+}
+
+/**
+ * @brief  订阅温室状态变化通知
+ */
+void Telemetry_Init(void)
+{
+    Event_Subscribe(Telemetry_On_Event, 0xFFFFFFFF);
+}
+
+/**
+ * @brief  遥测周期任务
+ * @note   推送由状态变化通知触发，这里补发因间隔限制或发送缓冲区满而推迟的增量，
+ *         并在没有变化时按TLM_KEYFRAME_PERIODS个间隔发一次完整快照
+ */
+void Telemetry_Task(void)
+{
+    if(tlm_period == 0) return;
+
+    if(!tlm_synced || (s32)(system_time_ms - tlm_keyframe) >= 0)
+        Telemetry_Send_Status();
+    else if(tlm_dirty && (s32)(system_time_ms - tlm_next) >= 0)
+        Telemetry_Send_Delta();
+}
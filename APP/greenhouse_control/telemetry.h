@@ -0,0 +1,72 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "stm32f10x.h"
+
+// 二进制遥测：通过USART3（蓝牙）与手机APP交换紧凑的状态帧，与文本命令并存
+//
+// 帧格式（多字节字段为小端）：
+//   原始帧  type(1) | len(1) | payload(len) | crc(2)
+//           crc为CRC-16/CCITT-FALSE，覆盖type至payload末尾（与日志导出帧相同）
+//   线路上  0x00 | COBS(原始帧) | 0x00
+//           COBS编码后帧内不含0x00，两端的0x00为帧界，收发双方都发送前后两个0x00，
+//           与文本行混在同一串口上时可以随时重新同步
+//   日志导出（EXPORT，见log_export.h）期间设备不发送遥测帧：导出帧的payload含原始0x00，
+//           APP在收到LOG_EXPORT_END或发送EXPORT_STOP之前按导出帧解析，之后再按COBS帧解析；
+//           导出期间推迟的变化在导出结束后随下一个增量或快照发出
+// 设备 -> APP：
+//   TLM_STATUS       payload为TelemetryStatus_t完整快照
+//   TLM_DELTA        payload为mask(4) + 变化的字节：mask第i位为1表示快照第i个字节有变化，
+//                    变化的字节按i从小到大排列，APP在上一个快照上逐字节更新
+//   TLM_ACK          payload为请求type(1) + 结果(1, 0-成功)
+// APP -> 设备：
+//   TLM_GET          无payload，回复一个TLM_STATUS
+//   TLM_SUBSCRIBE    payload为最短推送间隔period_ms(2)，先回复TLM_ACK和TLM_STATUS，
+//                    之后状态变化时（event_bus通知）发TLM_DELTA，两次增量至少间隔period_ms，
+//                    间隔内的变化合并到下一个增量；每TLM_KEYFRAME_PERIODS个间隔发一次TLM_STATUS
+//   TLM_UNSUBSCRIBE  无payload，停止推送，回复TLM_ACK
+#define TLM_STATUS              0x01
+#define TLM_DELTA               0x02
+#define TLM_ACK                 0x03
+#define TLM_GET                 0x10
+#define TLM_SUBSCRIBE           0x11
+#define TLM_UNSUBSCRIBE         0x12
+
+#define TLM_PAYLOAD_MAX         32      // payload最大长度
+#define TLM_RAW_MAX             (TLM_PAYLOAD_MAX + 4)           // 原始帧最大长度
+#define TLM_FRAME_MAX           (TLM_RAW_MAX + 1 + 2)           // COBS开销1字节（帧短于254字节）+ 两个帧界
+#define TLM_PERIOD_MIN          100     // 推送间隔下限(ms)
+#define TLM_KEYFRAME_PERIODS    50      // 每隔多少个推送间隔发一次完整快照，丢帧后APP据此重新同步
+
+// 状态快照，字段顺序即TLM_DELTA中的字节序号，只能在末尾追加字段
+typedef struct
+{
+    u32 run_time;           // 系统运行时间（秒）
+    u8  temperature;        // 温度
+    u8  humidity;           // 湿度
+    u8  light;              // 光照强度
+    u8  work_mode;          // 工作模式
+    u8  fan_status;         // 风扇状态
+    u8  fan_speed;          // 风扇转速百分比
+    u8  pump_status;        // 水泵状态
+    u8  light_status;       // 补光灯状态
+    u8  alarm_flags;        // 报警标志
+    u8  sensor_error;       // 传感器错误标志
+    u16 fan_switches;       // 风扇开关次数
+    u16 pump_switches;      // 水泵开关次数
+    u16 light_switches;     // 补光灯开关次数
+    u16 alarm_count;        // 报警次数
+} __attribute__((packed)) TelemetryStatus_t;
+
+// 帧编解码，不依赖硬件，APP端和上位机测试可直接复用
+u16 Telemetry_Frame_Encode(u8 type, const u8* payload, u8 len, u8* out);   // 生成带帧界的线路帧，返回长度
+u8 Telemetry_Frame_Decode(const u8* data, u16 size, u8* type,
+                          u8* payload, u8* len);                        // 解码帧界之间的数据，0-成功
+
+// 函数声明
+void Telemetry_Init(void);                          // 订阅温室状态变化通知
+void Telemetry_Receive(const u8* data, u16 size);  // 处理收到的一帧（帧界之间的数据）
+void Telemetry_Task(void);                          // 周期任务：补发推迟的增量和定期快照
+u8 Telemetry_Subscribed(void);                      // 是否正在推送
+
+#endif /* __TELEMETRY_H__ */
@@ -9,6 +9,194 @@
 #include "stm32f10x_rcc.h"
 #include "stm32f10x_usart.h"
 
+extern volatile u32 system_time_ms;
+
+// AT transaction states
+#define HC05_AT_IDLE		0	// Nothing in progress
+#define HC05_AT_SETTLE		1	// KEY raised, waiting HC05_AT_KEY_SETTLE before sending
+#define HC05_AT_SENDING		2	// Command queued, waiting for the transmit ring to drain
+#define HC05_AT_WAITING		3	// Waiting for OK/ERROR
+
+typedef struct
+{
+	char cmd[HC05_AT_CMD_LEN];
+	HC05_AT_Callback_t callback;
+} HC05_AT_Request_t;
+
+static HC05_AT_Request_t hc05_at_queue[HC05_AT_QUEUE_LEN];
+static u8 hc05_at_head = 0;					// Next free slot
+static u8 hc05_at_tail = 0;					// Request in progress or next to start
+static u8 hc05_at_state = HC05_AT_IDLE;
+static u8 hc05_at_attempts;					// Attempts left for the current request
+static u32 hc05_at_deadline;				// End of the current wait (system_time_ms)
+static char hc05_at_value[USART3_LINE_LEN];	// Last "+XXX:" line of the current answer
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Submit
+* Description    : Queue an AT command, the callback reports the result
+* Input          : cmd - AT command without CR/LF
+*                  callback - completion callback, may be NULL
+* Return         : 0-Queued 1-Queue full or command too long
+*******************************************************************************/
+u8 HC05_AT_Submit(const char* cmd, HC05_AT_Callback_t callback)
+{
+	HC05_AT_Request_t* req;
+	
+	if((u8)(hc05_at_head - hc05_at_tail) >= HC05_AT_QUEUE_LEN) return 1;
+	if(strlen(cmd) >= HC05_AT_CMD_LEN) return 1;
+	
+	req = &hc05_at_queue[hc05_at_head & (HC05_AT_QUEUE_LEN - 1)];
+	strcpy(req->cmd, cmd);
+	req->callback = callback;
+	hc05_at_head++;
+	return 0;
+}
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Busy
+* Description    : Check for queued or running AT requests
+* Input          : None
+* Return         : 1-Busy 0-Idle
+*******************************************************************************/
+u8 HC05_AT_Busy(void)
+{
+	return hc05_at_head != hc05_at_tail;
+}
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Finish
+* Description    : Leave AT mode, retire the current request and report it
+* Input          : result - HC05_AT_OK/HC05_AT_ERROR/HC05_AT_NO_REPLY
+* Return         : None
+*******************************************************************************/
+static void HC05_AT_Finish(u8 result)
+{
+	HC05_AT_Callback_t callback;
+	
+	HC05_KEY = 0; // Exit AT mode
+	callback = hc05_at_queue[hc05_at_tail & (HC05_AT_QUEUE_LEN - 1)].callback;
+	hc05_at_tail++;
+	hc05_at_state = HC05_AT_IDLE;
+	if(callback) callback(result, hc05_at_value); // Slot already free, callback may submit
+}
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Feed_Line
+* Description    : Match a received line against the request in progress
+* Input          : line - received line without CR/LF
+* Return         : 1-Line was part of the AT answer 0-Not for the AT engine
+*******************************************************************************/
+u8 HC05_AT_Feed_Line(const char* line)
+{
+	if(hc05_at_state != HC05_AT_SENDING && hc05_at_state != HC05_AT_WAITING) return 0;
+	
+	if(strncmp(line, "OK", 2) == 0)
+	{
+		HC05_AT_Finish(HC05_AT_OK);
+		return 1;
+	}
+	if(strncmp(line, "ERROR", 5) == 0)
+	{
+		HC05_AT_Finish(HC05_AT_ERROR);
+		return 1;
+	}
+	if(line[0] == '+')
+	{
+		strncpy(hc05_at_value, line, sizeof(hc05_at_value) - 1);
+		hc05_at_value[sizeof(hc05_at_value) - 1] = 0;
+		return 1;
+	}
+	return 0;
+}
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Task
+* Description    : Drive the AT transaction state machine, call every few ms
+* Input          : None
+* Return         : None
+*******************************************************************************/
+void HC05_AT_Task(void)
+{
+	u32 now = system_time_ms;
+	
+	switch(hc05_at_state)
+	{
+		case HC05_AT_IDLE:
+			// Start only on an empty ring so that no queued data is sent in AT mode
+			if(!HC05_AT_Busy() || USART3_TX_Free() != USART3_TX_RING_LEN) break;
+			hc05_at_attempts = HC05_AT_RETRIES;
+			hc05_at_value[0] = 0;
+			HC05_KEY = 1; // Enter AT mode
+			hc05_at_deadline = now + HC05_AT_KEY_SETTLE;
+			hc05_at_state = HC05_AT_SETTLE;
+			break;
+		
+		case HC05_AT_SETTLE:
+			if((s32)(now - hc05_at_deadline) < 0) break;
+			u3_printf("%s\r\n", hc05_at_queue[hc05_at_tail & (HC05_AT_QUEUE_LEN - 1)].cmd);
+			hc05_at_state = HC05_AT_SENDING;
+			break;
+		
+		case HC05_AT_SENDING:
+			// The answer timeout starts once the command has left the ring
+			if(USART3_TX_Free() != USART3_TX_RING_LEN) break;
+			hc05_at_deadline = now + HC05_AT_TIMEOUT;
+			hc05_at_state = HC05_AT_WAITING;
+			break;
+		
+		case HC05_AT_WAITING:
+			if((s32)(now - hc05_at_deadline) < 0) break;
+			if(--hc05_at_attempts == 0)
+			{
+				HC05_AT_Finish(HC05_AT_NO_REPLY);
+				break;
+			}
+			hc05_at_value[0] = 0;
+			hc05_at_deadline = now + HC05_AT_KEY_SETTLE; // Resend, KEY stays high
+			hc05_at_state = HC05_AT_SETTLE;
+			break;
+	}
+}
+
+static volatile u8 hc05_run_done;
+static u8 hc05_run_result;
+static char hc05_run_value[USART3_LINE_LEN];
+
+/*******************************************************************************
+* Function Name  : HC05_Run_Done
+* Description    : Completion callback used by HC05_AT_Run
+* Input          : result - transaction result, value - answer line
+* Return         : None
+*******************************************************************************/
+static void HC05_Run_Done(u8 result, const char* value)
+{
+	hc05_run_result = result;
+	strcpy(hc05_run_value, value);
+	hc05_run_done = 1;
+}
+
+/*******************************************************************************
+* Function Name  : HC05_AT_Run
+* Description    : Run one AT request to completion (boot time only, before the
+*                  scheduler owns the USART3 line queue)
+* Input          : cmd - AT command without CR/LF
+* Return         : HC05_AT_OK/HC05_AT_ERROR/HC05_AT_NO_REPLY, answer in hc05_run_value
+*******************************************************************************/
+static u8 HC05_AT_Run(const char* cmd)
+{
+	char line[USART3_LINE_LEN];
+	
+	hc05_run_value[0] = 0;
+	if(HC05_AT_Submit(cmd, HC05_Run_Done) != 0) return HC05_AT_NO_REPLY;
+	hc05_run_done = 0;
+	while(!hc05_run_done)
+	{
+		if(USART3_Get_Line(line, sizeof(line)) > 0) HC05_AT_Feed_Line(line);
+		HC05_AT_Task();
+	}
+	return hc05_run_result;
+}
+
 /*******************************************************************************
 * Function Name  : HC05_Init
 * Description    : HC05 Bluetooth module initialization
@@ -99,40 +287,9 @@ u8 HC05_Init(void)
 *******************************************************************************/
 u8 HC05_Get_Role(void)
 {
-	u8* p;
-	u8 retry = 10;
-	u8 temp, t;
-	
-	while(retry--)
-	{
-		HC05_KEY = 1; // Enter AT mode
-		delay_ms(10);
-		u3_printf("AT+ROLE?\r\n"); // Send AT+ROLE? command
-		
-		for(t = 0; t < 20; t++) // Wait up to 200ms for HC05 module response
-		{
-			delay_ms(10);
-			if(USART3_RX_STA&0X8000) break; // Received data
-		}
-		
-		HC05_KEY = 0; // Exit AT mode
-		
-		if(USART3_RX_STA&0X8000) // Received response
-		{
-			temp = USART3_RX_STA&0X7FFF; // Get data length
-			USART3_RX_BUF[temp] = 0; // Add string terminator
-			p = (u8*)strstr((const char*)USART3_RX_BUF, "+ROLE:");
-			if(p)
-			{
-				p += 6; // Offset to after ':'
-				temp = (*p) - '0'; // Get digit
-				USART3_RX_STA = 0; // Clear
-				return temp;
-			}
-		}
-		USART3_RX_STA = 0; // Clear
-	}
-	return 0xFF; // Get failed
+	if(HC05_AT_Run("AT+ROLE?") != HC05_AT_OK) return 0xFF; // Get failed
+	if(strncmp(hc05_run_value, "+ROLE:", 6) != 0) return 0xFF;
+	return hc05_run_value[6] - '0'; // Digit after ':'
 }
 
 /*******************************************************************************
@@ -296,35 +453,7 @@ u8 HC05_Set_Name(char* name)
 *******************************************************************************/
 u8 HC05_Set_Cmd(u8* atstr)
 {
-	u8 retry = 5;
-	u8 temp, t;
-	
-	while(retry--)
-	{
-		HC05_KEY = 1; // Enter AT mode
-		delay_ms(10);
-		u3_printf("%s\r\n", atstr); // Send AT command
-		HC05_KEY = 0; // Exit AT mode
-		
-		for(t = 0; t < 20; t++) // Wait up to 200ms for HC05 module response
-		{
-			delay_ms(10);
-			if(USART3_RX_STA&0X8000) break; // Received data
-		}
-		
-		if(USART3_RX_STA&0X8000) // Received response
-		{
-			temp = USART3_RX_STA&0X7FFF; // Get data length
-			USART3_RX_BUF[temp] = 0; // Add string terminator
-			if(strstr((const char*)USART3_RX_BUF, "OK"))
-			{
-				USART3_RX_STA = 0;
-				return 0;
-			}
-		}
-		USART3_RX_STA = 0; // Clear
-	}
-	return 1; // Set failed
+	return HC05_AT_Run((const char*)atstr) == HC05_AT_OK ? 0 : 1;
 }
 
 /*******************************************************************************
@@ -335,27 +464,12 @@ u8 HC05_Set_Cmd(u8* atstr)
 *******************************************************************************/
 void HC05_CFG_CMD(u8* atstr)
 {
-	u8 temp, t;
-	
-	HC05_KEY = 1; // Enter configuration mode
-	delay_ms(10);
-	u3_printf("%s\r\n", atstr);
-	
-	for(t = 0; t < 50; t++) // Wait up to 500ms for HC05 module response
-	{
-		delay_ms(10);
-		if(USART3_RX_STA&0X8000) break; // Received data
-	}
-	
-	HC05_KEY = 0; // Exit configuration mode
+	u8 result;
 	
-	if(USART3_RX_STA&0X8000) // Received data
-	{
-		temp = USART3_RX_STA&0X7FFF; // Get data length
-		USART3_RX_BUF[temp] = 0; // Add string terminator
-		printf("%s\r\n", USART3_RX_BUF); // Send to serial port
-	}
-	USART3_RX_STA = 0;
+	result = HC05_AT_Run((const char*)atstr);
+	if(hc05_run_value[0]) printf("%s\r\n", hc05_run_value); // Send to serial port
+	if(result == HC05_AT_OK) printf("OK\r\n");
+	else if(result == HC05_AT_ERROR) printf("ERROR\r\n");
 }
 
 /*******************************************************************************
@@ -363,17 +477,11 @@ void HC05_CFG_CMD(u8* atstr)
 * Description    : Send data through HC05
 * Input          : data - data to send
 *                  len - data length
-* Return         : None
+* Return         : bytes queued, less than len if the transmit ring is full
 *******************************************************************************/
-void HC05_Send_Data(u8* data, u16 len)
+u16 HC05_Send_Data(u8* data, u16 len)
 {
-    u16 i;
-    
-    for(i = 0; i < len; i++)
-    {
-        while(USART_GetFlagStatus(USART3, USART_FLAG_TC) == RESET);
-        USART_SendData(USART3, data[i]);
-    }
+    return USART3_Write(data, len);
 }
 
 /*******************************************************************************
@@ -384,18 +492,12 @@ void HC05_Send_Data(u8* data, u16 len)
 *******************************************************************************/
 void HC05_Process_Data(void)
 {
-    u16 len;
+    char line[USART3_LINE_LEN];
     
-    if(USART3_RX_STA & 0x8000)  // Received data
+    while(USART3_Get_Line(line, sizeof(line)) > 0)  // Received data
     {
-        len = USART3_RX_STA & 0x3FFF;  // Get data length
-        USART3_RX_BUF[len] = 0;       // Add string terminator
-        
         // Echo received data to serial port for debugging
-        printf("HC05 received: %s\r\n", USART3_RX_BUF);
-        
-        // Clear receive flag
-        USART3_RX_STA = 0;
+        printf("HC05 received: %s\r\n", line);
     }
 } 
 
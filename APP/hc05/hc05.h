@@ -21,7 +21,36 @@
 #define HC05_SLAVE_MODE		0	// Slave mode
 #define HC05_MASTER_MODE	1	// Master mode
 
+// Asynchronous AT transactions: requests are queued and run one at a time by HC05_AT_Task.
+// A transaction raises KEY, waits HC05_AT_KEY_SETTLE, sends the command once the transmit
+// ring has drained, then waits HC05_AT_TIMEOUT for OK/ERROR (resending up to HC05_AT_RETRIES
+// times) and drops KEY. Response lines are handed over by the USART3 line consumer through
+// HC05_AT_Feed_Line. Other USART3 writers hold off while HC05_AT_Busy() so that their bytes
+// never reach the module in AT mode. Nothing here calls delay_ms.
+#define HC05_AT_QUEUE_LEN	4	// Pending requests, must be a power of two
+#define HC05_AT_CMD_LEN		24	// Maximum AT command length including terminator
+#define HC05_AT_KEY_SETTLE	10	// ms between KEY high and sending the command
+#define HC05_AT_TIMEOUT		200	// ms to wait for OK/ERROR after the command has left
+#define HC05_AT_RETRIES		5	// Attempts per request
+
+// Transaction results passed to the completion callback
+#define HC05_AT_OK			0	// Module answered OK
+#define HC05_AT_ERROR		1	// Module answered ERROR
+#define HC05_AT_NO_REPLY	2	// No answer after HC05_AT_RETRIES attempts
+
+// Completion callback, called from HC05_AT_Task after KEY has dropped.
+// value is the last "+XXX:..." line of the answer, "" if there was none.
+// The callback may submit the next request.
+typedef void (*HC05_AT_Callback_t)(u8 result, const char* value);
+
+u8 HC05_AT_Submit(const char* cmd, HC05_AT_Callback_t callback);	// Queue a request, 0-queued 1-full/too long
+void HC05_AT_Task(void);						// Periodic task: drive the transaction state machine
+u8 HC05_AT_Feed_Line(const char* line);			// Offer a received line, 1-consumed as an AT answer
+u8 HC05_AT_Busy(void);							// Requests queued or in progress
+
 // Function declarations
+// The functions below wait for the answer and are meant for HC05_Init only;
+// after the scheduler starts use HC05_AT_Submit
 u8 HC05_Init(void);
 u8 HC05_Get_Role(void);
 u8 HC05_Set_Role(u8 role);
@@ -39,7 +68,7 @@ u8 HC05_Set_Class(u32 class_code);
 void HC05_Get_Class(void);
 u8 HC05_Set_Cmd(u8* atstr);
 void HC05_CFG_CMD(u8* atstr);
-void HC05_Send_Data(u8* data, u16 len);
+u16 HC05_Send_Data(u8* data, u16 len);
 void HC05_Process_Data(void);
 
 #endif
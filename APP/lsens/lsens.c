@@ -1,31 +1,83 @@
 ﻿#include "lsens.h"
 #include "SysTick.h"
 
+// DMA circular buffer filled continuously by ADC3
+static volatile u16 lsens_buf[LSENS_BUF_LEN];
+// Sum of each buffer half, refreshed by the DMA half/full transfer interrupt.
+// Their total is the running sum over the last LSENS_BUF_LEN samples.
+static volatile u32 lsens_half_sum[2];
+
+// Sum one half of the buffer
+static u32 Lsens_Sum_Half(u16 start)
+{
+    u32 sum = 0;
+    u16 i;
+    
+    for(i = start; i < start + LSENS_BUF_LEN / 2; i++)
+    {
+        sum += lsens_buf[i];
+    }
+    return sum;
+}
+
 // Initialize light sensor
 void Lsens_Init(void)
 {
     GPIO_InitTypeDef GPIO_InitStructure;
     ADC_InitTypeDef ADC_InitStructure;
+    DMA_InitTypeDef DMA_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+    u16 timeout;
     
-    // Enable GPIO and ADC clock
+    // Enable GPIO, ADC and DMA clock
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOF | RCC_APB2Periph_ADC3, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA2, ENABLE);
+    RCC_ADCCLKConfig(RCC_PCLK2_Div6); // ADC clock 72M/6=12MHz (must not exceed 14MHz)
     
     // Configure PF8 as analog input
     GPIO_InitStructure.GPIO_Pin = GPIO_Pin_8;
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
     GPIO_Init(GPIOF, &GPIO_InitStructure);
     
+    // Configure DMA2 Channel5: ADC3->DR to circular buffer
+    DMA_DeInit(LSENS_DMA_CH);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&ADC3->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (u32)lsens_buf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = LSENS_BUF_LEN;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(LSENS_DMA_CH, &DMA_InitStructure);
+    DMA_ITConfig(LSENS_DMA_CH, DMA_IT_HT | DMA_IT_TC, ENABLE);
+    
+    NVIC_InitStructure.NVIC_IRQChannel = DMA2_Channel4_5_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+    
+    DMA_Cmd(LSENS_DMA_CH, ENABLE);
+    
     ADC_DeInit(ADC3);
     
-    // Configure ADC3
+    // Configure ADC3: continuous conversion, results moved by DMA
     ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
-    ADC_InitStructure.ADC_ScanConvMode = DISABLE;
-    ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+    ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+    ADC_InitStructure.ADC_ContinuousConvMode = ENABLE;
     ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_None;
     ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
     ADC_InitStructure.ADC_NbrOfChannel = 1;
     ADC_Init(ADC3, &ADC_InitStructure);
     
+    // Channel is configured once, 239.5 cycles sampling (about 21us per sample)
+    ADC_RegularChannelConfig(ADC3, LSENS_ADC_CH, 1, ADC_SampleTime_239Cycles5);
+    ADC_DMACmd(ADC3, ENABLE);
+    
     // Enable ADC3
     ADC_Cmd(ADC3, ENABLE);
     
@@ -34,33 +86,56 @@ void Lsens_Init(void)
     while(ADC_GetResetCalibrationStatus(ADC3));
     ADC_StartCalibration(ADC3);
     while(ADC_GetCalibrationStatus(ADC3));
+    
+    ADC_SoftwareStartConvCmd(ADC3, ENABLE);
+    
+    // Wait for the first full buffer (about 5.4ms) so the first reading is valid
+    for(timeout = 0; timeout < 20 && lsens_half_sum[1] == 0; timeout++)
+    {
+        delay_ms(1);
+    }
 }
 
-// Get ADC value
+// DMA2 Channel5 interrupt: one buffer half has been refilled
+void DMA2_Channel4_5_IRQHandler(void)
+{
+    if(DMA_GetITStatus(DMA2_IT_HT5) != RESET)
+    {
+        DMA_ClearITPendingBit(DMA2_IT_HT5);
+        lsens_half_sum[0] = Lsens_Sum_Half(0);
+    }
+    if(DMA_GetITStatus(DMA2_IT_TC5) != RESET)
+    {
+        DMA_ClearITPendingBit(DMA2_IT_TC5);
+        lsens_half_sum[1] = Lsens_Sum_Half(LSENS_BUF_LEN / 2);
+    }
+}
+
+// Get latest single ADC sample
 u16 Lsens_Get_Adc(void)
 {
-    // Set specified ADC regular group channel, one sequence, sampling time
-    ADC_RegularChannelConfig(ADC3, ADC_Channel_6, 1, ADC_SampleTime_239Cycles5);
+    u16 pos = LSENS_BUF_LEN - DMA_GetCurrDataCounter(LSENS_DMA_CH); // Next slot DMA will write
     
-    ADC_SoftwareStartConvCmd(ADC3, ENABLE);
-    while(!ADC_GetFlagStatus(ADC3, ADC_FLAG_EOC));
-    
-    return ADC_GetConversionValue(ADC3);
+    return lsens_buf[(pos + LSENS_BUF_LEN - 1) % LSENS_BUF_LEN];
+}
+
+// Get oversampled, decimated ADC value (16-bit, 0 ~ LSENS_RAW_MAX)
+u16 Lsens_Get_Raw(void)
+{
+    return (u16)((lsens_half_sum[0] + lsens_half_sum[1]) >> LSENS_OVERSAMPLE_SHIFT);
+}
+
+// Convert oversampled value to light percent
+// 光敏电阻：光照越强，电阻越小，ADC值越小
+// 反转逻辑：ADC值越小，光照强度百分比越高
+u8 Lsens_Raw_To_Percent(u16 raw)
+{
+    if(raw >= LSENS_RAW_MAX) return 0;
+    return (u8)(100 - ((u32)raw * 100) / LSENS_RAW_MAX);
 }
 
 // Get light intensity (0-100%)
 u8 Lsens_Get_Val(void)
 {
-    u16 temp_val = 0;
-    u8 i;
-    
-    for(i = 0; i < 10; i++)
-    {
-        temp_val += Lsens_Get_Adc();
-    }
-    temp_val /= 10;
-    
-    // Convert to percentage (光敏电阻：光照越强，电阻越小，ADC值越小)
-    // 反转逻辑：ADC值越小，光照强度百分比越高
-    return (u8)(100 - ((temp_val * 100) / 4095));
+    return Lsens_Raw_To_Percent(Lsens_Get_Raw());
 } 
@@ -9,9 +9,18 @@
 #define LSENS_GPIO      GPIOF
 #define LSENS_PIN       GPIO_Pin_8
 
+// ADC3 continuous conversion + DMA2 Channel5 circular buffer
+#define LSENS_DMA_CH            DMA2_Channel5
+#define LSENS_BUF_LEN           256     // Samples in the circular buffer (4^4 oversampling)
+#define LSENS_OVERSAMPLE_SHIFT  4       // Sum of 256 12-bit samples >> 4 = 16-bit result
+#define LSENS_RAW_MAX           (4095UL << LSENS_OVERSAMPLE_SHIFT) // Full scale of oversampled value
+
 // Light sensor function declarations
 void Lsens_Init(void);          // Initialize light sensor
 u8 Lsens_Get_Val(void);         // Get light sensor value (0-100)
+u16 Lsens_Get_Raw(void);        // Get oversampled 16-bit ADC value
+u16 Lsens_Get_Adc(void);        // Get latest single ADC sample
+u8 Lsens_Raw_To_Percent(u16 raw); // Convert oversampled value to light percent
 u16 Get_ADC3(u8 ch);            // Get ADC conversion value
 
 #endif
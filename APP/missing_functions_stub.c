@@ -1,6 +1,7 @@
 /**
  * @file missing_functions_stub.c
- * @brief C89 Compatible implementation of RTC, Data Logger and Config modules
+ * @brief C89 Compatible implementation of the RTC module
+ * @note  配置模块（含Flash配置日志）由APP/config/config.c实现
  * @version 1.0
  * @date 2024-12-19
  */
@@ -10,85 +11,8 @@
 #include "stdio.h"
 #include "string.h"
 
-/* ========================= Type Definitions ========================= */
-
-typedef struct {
-    u16 year;   /* 年 */
-    u8 month;   /* 月 */
-    u8 date;    /* 日 */
-    u8 hour;    /* 时 */
-    u8 min;     /* 分 */
-    u8 sec;     /* 秒 */
-    u8 week;    /* 星期 */
-} RTC_Time_t;
-
-typedef struct {
-    u8 enable;          /* 是否启用 */
-    u8 hour;            /* 触发小时 */
-    u8 min;             /* 触发分钟 */
-    u8 repeat_type;     /* 重复类型：0-一次性，1-每天，2-每周 */
-    u8 week_mask;       /* 星期掩码 */
-    void (*callback)(void); /* 回调函数 */
-} RTC_Timer_t;
-
-typedef struct {
-    u32 timestamp;      /* 时间戳 */
-    u8  log_type;       /* 记录类型 */
-    u8  temperature;    /* 温度 */
-    u8  humidity;       /* 湿度 */
-    u8  light;          /* 光照 */
-    u8  fan_status;     /* 风扇状态 */
-    u8  pump_status;    /* 水泵状态 */
-    u8  light_status;   /* 补光灯状态 */
-    u8  work_mode;      /* 工作模式 */
-    u8  alarm_flags;    /* 报警标志 */
-    u8  reserved[3];    /* 保留字段 */
-} SensorLogRecord_t;
-
-typedef struct {
-    u32 magic;              /* 配置有效标志 */
-    u8  version;            /* 配置版本号 */
-    
-    /* 温度控制参数 */
-    u8  temp_fan_on;        /* 风扇开启温度阈值 */
-    u8  temp_high_alarm;    /* 高温报警阈值 */
-    u8  temp_low_alarm;     /* 低温报警阈值 */
-    u8  temp_hysteresis;    /* 温度控制滞回 */
-    
-    /* 湿度控制参数 */
-    u8  humi_pump_on;       /* 水泵开启湿度阈值 */
-    u8  humi_high_alarm;    /* 高湿度报警阈值 */
-    u8  humi_low_alarm;     /* 低湿度报警阈值 */
-    u8  humi_hysteresis;    /* 湿度控制滞回 */
-    
-    /* 光照控制参数 */
-    u8  light_auto_on;      /* 补光灯开启光照阈值 */
-    u8  light_low_alarm;    /* 光照不足报警阈值 */
-    u8  light_hysteresis;   /* 光照控制滞回 */
-    
-    /* 系统参数 */
-    u8  sensor_interval;    /* 传感器读取间隔（秒） */
-    u8  log_interval;       /* 数据记录间隔（秒） */
-    
-    /* 保留字段 */
-    u8  reserved[16];
-    
-    u32 checksum;           /* 校验和 */
-} SystemConfig_t;
-
-typedef enum {
-    CONFIG_TEMP_FAN_ON = 0,
-    CONFIG_TEMP_HIGH_ALARM,
-    CONFIG_TEMP_LOW_ALARM,
-    CONFIG_HUMI_PUMP_ON,
-    CONFIG_HUMI_HIGH_ALARM,
-    CONFIG_HUMI_LOW_ALARM,
-    CONFIG_LIGHT_AUTO_ON,
-    CONFIG_LIGHT_LOW_ALARM,
-    CONFIG_SENSOR_INTERVAL,
-    CONFIG_LOG_INTERVAL,
-    CONFIG_ITEM_COUNT
-} ConfigItem_t;
+/* 类型取自模块头文件，不在此重复定义 */
+#include "rtc/rtc.h"
 
 /* ========================= Forward Declarations ========================= */
 void RTC_Get_Week(RTC_Time_t* time);
@@ -107,29 +31,6 @@ static u8 timer_count = 0;
 /* 月份天数表 */
 static const u8 month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
-
-
-/* 全局配置 - C89兼容的初始化 */
-SystemConfig_t system_config = {
-    0x5A5A5A5A,     /* magic */
-    0x01,           /* version */
-    27,             /* temp_fan_on 调整到27度 */
-    35,             /* temp_high_alarm */
-    15,             /* temp_low_alarm */
-    1,              /* temp_hysteresis 减少到1度 */
-    30,             /* humi_pump_on */
-    80,             /* humi_high_alarm */
-    20,             /* humi_low_alarm */
-    5,              /* humi_hysteresis */
-    30,             /* light_auto_on */
-    20,             /* light_low_alarm */
-    10,             /* light_hysteresis */
-    2,              /* sensor_interval */
-    10,             /* log_interval */
-    {0},            /* reserved */
-    0               /* checksum */
-};
-
 /* ========================= RTC Module Implementation ========================= */
 
 /**
@@ -340,86 +241,3 @@ void RTC_Timer_Check(void) {
         }
     }
 }
-
-/* ========================= Config Module Implementation ========================= */
-
-/**
- * @brief 配置系统初始化
- */
-u8 Config_Init(void) {
-    printf("Config: Initializing configuration system...\r\n");
-    
-    printf("Config: Default settings loaded\r\n");
-    printf("  Temperature: Fan ON at %d°C, Alarms at %d°C/%d°C\r\n",
-           system_config.temp_fan_on, system_config.temp_high_alarm, system_config.temp_low_alarm);
-    printf("  Humidity: Pump ON at %d%%, Alarms at %d%%/%d%%\r\n",
-           system_config.humi_pump_on, system_config.humi_high_alarm, system_config.humi_low_alarm);
-    printf("  Light: Auto ON at %d%%, Alarm at %d%%\r\n",
-           system_config.light_auto_on, system_config.light_low_alarm);
-    printf("  Intervals: Sensor %ds, Log %ds\r\n",
-           system_config.sensor_interval, system_config.log_interval);
-    
-    return 0;
-}
-
-/**
- * @brief 获取8位配置参数
- */
-u8 Config_Get_U8(ConfigItem_t item) {
-    switch(item) {
-        case CONFIG_TEMP_FAN_ON:     return system_config.temp_fan_on;
-        case CONFIG_TEMP_HIGH_ALARM: return system_config.temp_high_alarm;
-        case CONFIG_TEMP_LOW_ALARM:  return system_config.temp_low_alarm;
-        case CONFIG_HUMI_PUMP_ON:    return system_config.humi_pump_on;
-        case CONFIG_HUMI_HIGH_ALARM: return system_config.humi_high_alarm;
-        case CONFIG_HUMI_LOW_ALARM:  return system_config.humi_low_alarm;
-        case CONFIG_LIGHT_AUTO_ON:   return system_config.light_auto_on;
-        case CONFIG_LIGHT_LOW_ALARM: return system_config.light_low_alarm;
-        case CONFIG_SENSOR_INTERVAL: return system_config.sensor_interval;
-        case CONFIG_LOG_INTERVAL:    return system_config.log_interval;
-        default: return 0;
-    }
-}
-
-/**
- * @brief 处理蓝牙配置命令
- */
-void Config_Handle_Command(char* cmd) {
-    if (!cmd) return;
-    
-    printf("Config: Processing command: %s\r\n", cmd);
-    
-    if (strncmp(cmd, "CONFIG_GET", 10) == 0) {
-        printf("=== Current Configuration ===\r\n");
-        printf("Temperature Control:\r\n");
-        printf("  Fan ON: %d°C, High Alarm: %d°C, Low Alarm: %d°C\r\n",
-               system_config.temp_fan_on, system_config.temp_high_alarm, system_config.temp_low_alarm);
-        printf("Humidity Control:\r\n");
-        printf("  Pump ON: %d%%, High Alarm: %d%%, Low Alarm: %d%%\r\n",
-               system_config.humi_pump_on, system_config.humi_high_alarm, system_config.humi_low_alarm);
-        printf("Light Control:\r\n");
-        printf("  Auto ON: %d%%, Low Alarm: %d%%\r\n",
-               system_config.light_auto_on, system_config.light_low_alarm);
-        printf("System:\r\n");
-        printf("  Sensor Interval: %ds, Log Interval: %ds\r\n",
-               system_config.sensor_interval, system_config.log_interval);
-        printf("============================\r\n");
-    }
-    else if (strncmp(cmd, "CONFIG_RESET", 12) == 0) {
-        /* 恢复默认配置 */
-        system_config.temp_fan_on = 30;
-        system_config.temp_high_alarm = 35;
-        system_config.temp_low_alarm = 15;
-        system_config.humi_pump_on = 30;
-        system_config.humi_high_alarm = 80;
-        system_config.humi_low_alarm = 20;
-        system_config.light_auto_on = 30;
-        system_config.light_low_alarm = 20;
-        system_config.sensor_interval = 2;
-        system_config.log_interval = 10;
-        printf("Config: Reset to default values\r\n");
-    }
-    else {
-        printf("Config: Unknown command. Available: CONFIG_GET, CONFIG_RESET\r\n");
-    }
-}
@@ -10,6 +10,20 @@ u16 FRONT_COLOR=BLACK;	//������ɫ
 u16 BACK_COLOR=WHITE;  //����ɫ 
 
 _tftlcd_data tftlcd_data; 
+
+//每像素只需一次LCD_DATA写入的控制器，像素数组可直接用DMA搬运
+#if defined(TFTLCD_HX8357D)||defined(TFTLCD_R61509V)||defined(TFTLCD_R61509V3)||defined(TFTLCD_ILI9325)\
+  ||defined(TFTLCD_ILI9486)||defined(TFTLCD_SSD1963)||defined(TFTLCD_NT35510)||defined(TFTLCD_ILI9481)\
+  ||defined(TFTLCD_R61509VE)||defined(TFTLCD_SSD1963N)||defined(TFTLCD_ILI9806)
+#define LCD_ONE_WRITE_PER_PIXEL
+#endif
+
+#if LCD_USE_DMA&&defined(LCD_ONE_WRITE_PER_PIXEL)
+#define LCD_PIXEL_DMA
+#define LCD_DMA_CH		DMA1_Channel6
+#define LCD_DMA_FLAG_TC	DMA1_FLAG_TC6
+static u8 lcd_dma_ready=0;
+#endif
   
 
 //д�Ĵ�������
@@ -3834,24 +3848,72 @@ void LCD_Fill(u16 xState,u16 yState,u16 xEnd,u16 yEnd,u16 color)
 	}	
 } 
 
-//��ָ�����������ָ����ɫ��			 
-//(sx,sy),(ex,ey):�����ζԽ�����,�����СΪ:(ex-sx+1)*(ey-sy+1)   
-//color:Ҫ������ɫ
+#ifdef LCD_PIXEL_DMA
+//DMA存储器到存储器方式把像素数组写入LCD_DATA，等待完成后返回
+static void LCD_DMA_Stream(const u16 *color,u32 num)
+{
+	DMA_InitTypeDef DMA_InitStructure;
+	u16 len;
+
+	if(!lcd_dma_ready)
+	{
+		RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+		DMA_DeInit(LCD_DMA_CH);
+		DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)color;
+		DMA_InitStructure.DMA_MemoryBaseAddr = (u32)&TFTLCD->LCD_DATA;
+		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+		DMA_InitStructure.DMA_BufferSize = 1;
+		DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Enable;
+		DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+		DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+		DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+		DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+		DMA_InitStructure.DMA_M2M = DMA_M2M_Enable;
+		DMA_Init(LCD_DMA_CH, &DMA_InitStructure);
+		lcd_dma_ready=1;
+	}
+	while(num)
+	{
+		len=(num>0xFFFF)?0xFFFF:num;	//单次传输最多65535个
+		DMA_Cmd(LCD_DMA_CH, DISABLE);
+		LCD_DMA_CH->CPAR=(u32)color;
+		DMA_SetCurrDataCounter(LCD_DMA_CH, len);
+		DMA_ClearFlag(LCD_DMA_FLAG_TC);
+		DMA_Cmd(LCD_DMA_CH, ENABLE);
+		while(DMA_GetFlagStatus(LCD_DMA_FLAG_TC)==RESET);
+		color+=len;
+		num-=len;
+	}
+	DMA_Cmd(LCD_DMA_CH, DISABLE);
+}
+#endif
+
+//向当前窗口连续写入num个像素
+//color:像素数组(RGB565)
+void LCD_Write_Pixels(const u16 *color,u32 num)
+{
+#ifdef LCD_PIXEL_DMA
+	LCD_DMA_Stream(color,num);
+#else
+	while(num--)
+	{
+		LCD_WriteData_Color(*color++);
+	}
+#endif
+}
+
+//在指定区域内填充指定颜色块
+//(sx,sy),(ex,ey):填充矩形对角坐标,区域大小为:(ex-sx+1)*(ey-sy+1)
+//color:要填充的颜色数组，按行存放
 void LCD_Color_Fill(u16 sx,u16 sy,u16 ex,u16 ey,u16 *color)
 {  
-	u16 height,width;
-	u16 i,j;
-	width=ex-sx+1; 			//�õ����Ŀ���
-	height=ey-sy+1;			//�߶�
-	
-	for(i=0;i<height;i++)
-	{
-		for(j=0;j<width;j++)
-		{
-			LCD_Set_Window(sx+j, sy+i,ex, ey);
-			LCD_WriteData_Color(color[i*width+j]);
-		}
-	}		  
+	u32 num;
+
+	if((sx>ex)||(sy>ey))return;
+	num=(u32)(ex-sx+1)*(ey-sy+1);
+	LCD_Set_Window(sx,sy,ex,ey);
+	LCD_Write_Pixels(color,num);
 }
 //����
 //x,y:����
@@ -4021,7 +4083,8 @@ void LCD_Draw_Circle(u16 x0,u16 y0,u8 r)
 //num:Ҫ��ʾ���ַ�:" "--->"~"
 //size:�����С 12/16/24
 //mode:���ӷ�ʽ(1)���Ƿǵ��ӷ�ʽ(0)
-void LCD_ShowChar(u16 x,u16 y,u8 num,u8 size,u8 mode)
+// 逐点绘制字符，支持叠加方式和屏幕边缘裁剪
+static void LCD_ShowChar_Pixel(u16 x,u16 y,u8 num,u8 size,u8 mode)
 {  							  
     u8 temp,t1,t;
 	u16 y0=y;
@@ -4049,7 +4112,65 @@ void LCD_ShowChar(u16 x,u16 y,u8 num,u8 size,u8 mode)
 			}
 		}  	 
 	}  	    	   	 	  
-}   
+}
+
+// 取字符点阵，字模按列存放，每列size个点、(size+7)/8字节，高位在上
+// 不支持的字号或字符返回0
+static const u8* LCD_Get_Glyph(u8 num,u8 size)
+{
+	if(num<' '||num>'~')return 0;
+	num=num-' ';
+	if(size==12)return ascii_1206[num];
+	else if(size==16)return ascii_1608[num];
+	else if(size==24)return ascii_2412[num];
+	return 0;
+}
+
+// 在一个窗口内按扫描行顺序输出n个相邻字符（非叠加方式）
+// 调用者保证字符全部位于屏幕内且字号有效
+static void LCD_Blit_Glyphs(u16 x,u16 y,const u8 *p,u8 n,u8 size)
+{
+	u16 fg=FRONT_COLOR,bg=BACK_COLOR;
+	u8 w=size/2;
+	u8 bpc=(size+7)/8;					//每列字节数
+	u8 row,col,k,idx,mask;
+	const u8 *glyph;
+
+	LCD_Set_Window(x,y,x+n*w-1,y+size-1);
+	for(row=0;row<size;row++)
+	{
+		idx=row>>3;
+		mask=0x80>>(row&7);
+		for(k=0;k<n;k++)
+		{
+			glyph=LCD_Get_Glyph(p[k],size)+idx;
+			for(col=0;col<w;col++)
+			{
+				LCD_WriteData_Color((*glyph&mask)?fg:bg);
+				glyph+=bpc;
+			}
+		}
+	}
+}
+
+//在指定位置显示一个字符
+//x,y:起始坐标
+//num:要显示的字符:" "--->"~"
+//size:字体大小 12/16/24
+//mode:叠加方式(1)还是非叠加方式(0)
+//非叠加且完整位于屏幕内时整格一次开窗输出，否则逐点绘制
+void LCD_ShowChar(u16 x,u16 y,u8 num,u8 size,u8 mode)
+{
+	if(mode==0&&LCD_Get_Glyph(num,size)!=0
+	   &&x+size/2<=tftlcd_data.width&&y+size<=tftlcd_data.height)
+	{
+		LCD_Blit_Glyphs(x,y,&num,1,size);
+	}
+	else
+	{
+		LCD_ShowChar_Pixel(x,y,num,size,mode);
+	}
+}
 //m^n����
 //����ֵ:m^n�η�.
 u32 LCD_Pow(u8 m,u8 n)
@@ -4118,18 +4239,31 @@ void LCD_ShowxNum(u16 x,u16 y,u32 num,u8 len,u8 size,u8 mode)
 //width,height:�����С  
 //size:�����С
 //*p:�ַ�����ʼ��ַ		  
+//同一行内连续的字符合并为一个窗口输出
 void LCD_ShowString(u16 x,u16 y,u16 width,u16 height,u8 size,u8 *p)
 {         
-	u8 x0=x;
+	u16 x0=x;
+	u8 w=size/2;
+	u8 n,k;
 	width+=x;
 	height+=y;
     while((*p<='~')&&(*p>=' '))//�ж��ǲ��ǷǷ��ַ�!
     {       
         if(x>=width){x=x0;y+=size;}
         if(y>=height)break;//�˳�
-        LCD_ShowChar(x,y,*p,size,0);
-        x+=size/2;
-        p++;
+        // 统计本行可连续输出的字符数
+        for(n=0;n<255&&(p[n]<='~')&&(p[n]>=' ')&&x+n*w<width;n++);
+        if(LCD_Get_Glyph(*p,size)!=0
+           &&x+n*w<=tftlcd_data.width&&y+size<=tftlcd_data.height)
+        {
+            LCD_Blit_Glyphs(x,y,p,n,size);
+        }
+        else
+        {
+            for(k=0;k<n;k++)LCD_ShowChar_Pixel(x+k*w,y,p[k],size,0);
+        }
+        x+=n*w;
+        p+=n;
     }  
 }
 
@@ -4231,34 +4365,28 @@ void LCD_ShowFontHZ(u16 x, u16 y, u8 *cn)
 }	
 #endif
 
+//显示图片
+//x,y:起始坐标  wide,high:图片尺寸
+//pic:图片数据，每像素2字节，低字节在前
+//整幅图片开一次窗口连续写入；数据半字对齐时按u16数组输出（可走DMA）
 void LCD_ShowPicture(u16 x, u16 y, u16 wide, u16 high,u8 *pic)
 {
-	u16 i,j;
-	u16 temp = 0;
-	long tmp=0,num=0;
+	u32 i,num;
+	u16 temp;
+
 	LCD_Set_Window(x, y, x+wide-1, y+high-1);
-	num = wide * high*2 ;
-	//����1�������ʾ�ٶȣ�̫����ܵ���ͼ����ʾ��ȫ
-//	do
-//	{  
-//		temp = pic[tmp + 1];
-//		temp = temp << 8;
-//		temp = temp | pic[tmp];
-//		LCD_WriteData_Color(temp);//�����ʾ
-//		tmp += 2;
-//	}
-//	while(tmp < num);
-	
-	//����2������Ч����LCD��ʾ�ٶȹ��쵼����ʾ��ȫ����
-	for(i=0;i<high;i++)
+	num = (u32)wide * high;
+	if(((u32)pic & 1) == 0)
 	{
-		for(j=0;j<wide;j++)
-		{
-			temp = pic[tmp + 1];
-			temp = temp << 8;
-			temp = temp | pic[tmp];
-			LCD_DrawFRONT_COLOR(x+j,y+i,temp);
-			tmp += 2;
-		}
-	}	
+		LCD_Write_Pixels((const u16 *)pic, num);
+		return;
+	}
+	for(i=0;i<num;i++)
+	{
+		temp = pic[1];
+		temp = temp << 8;
+		temp = temp | pic[0];
+		LCD_WriteData_Color(temp);
+		pic += 2;
+	}
 }
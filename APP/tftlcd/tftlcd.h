@@ -40,6 +40,10 @@
 //#define TFTLCD_ILI9806
 
 
+//像素流DMA开关：1=LCD_Color_Fill/LCD_ShowPicture经DMA1通道6(存储器到存储器)写LCD_DATA
+//仅对每像素一次数据写入的控制器生效，HX8357DN等分两次写入的控制器仍由CPU写入
+#define LCD_USE_DMA	0
+
 #define TFTLCD_DIR	0	//0������  1������  Ĭ������
 
 #define	LCD_LED PBout(0) //LCD����  PB0
@@ -47,8 +51,8 @@
 //TFTLCD��ַ�ṹ��
 typedef struct
 {
-	u16 LCD_CMD;
-	u16 LCD_DATA;
+	vu16 LCD_CMD;
+	vu16 LCD_DATA;
 }TFTLCD_TypeDef;
 
 
@@ -147,6 +151,7 @@ void LCD_Display_Dir(u8 dir);//������Ļ��ʾ����
 void LCD_Clear(u16 Color);//����
 void LCD_Fill(u16 xState,u16 yState,u16 xEnd,u16 yEnd,u16 color);//��䵥ɫ
 void LCD_Color_Fill(u16 sx,u16 sy,u16 ex,u16 ey,u16 *color);//��ָ�����������ָ����ɫ��
+void LCD_Write_Pixels(const u16 *color,u32 num);//向当前窗口连续写入像素
 void LCD_DrawPoint(u16 x,u16 y);//����
 void LCD_DrawFRONT_COLOR(u16 x,u16 y,u16 color);//ָ����ɫ����
 u16 LCD_ReadPoint(u16 x,u16 y);//����
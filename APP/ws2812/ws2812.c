@@ -4,6 +4,22 @@
 
 u8 g_rgb_databuf[3][RGB_LED_XWIDTH][RGB_LED_YHIGH];//RGB
 
+// 待发送的GRB帧
+static u8 rgb_frame[RGB_FRAME_BYTES];
+
+#if RGB_USE_DMA
+// DMA波形表：每位一个BRR写入值，0码在T0H处拉低，1码写0保持高电平至T1H
+static u16 rgb_dma_buf[RGB_DMA_BUF_LEN];
+// UP事件写BSRR置高、CC3事件写BRR拉低所用的常量引脚掩码
+static const u16 rgb_pin_mask = RGB_LED;
+static volatile u8 rgb_dma_busy = 0;
+static RGB_DoneCallback_t rgb_done_callback = 0;
+
+#define RGB_DMA_UP_CH	DMA1_Channel7	// TIM4_UP：每位起始置高
+#define RGB_DMA_T0_CH	DMA1_Channel1	// TIM4_CH1：0码拉低
+#define RGB_DMA_T1_CH	DMA1_Channel5	// TIM4_CH3：1码拉低（帧结束中断）
+#endif
+
 // 全局RGB状态变量
 RGB_GreenhouseStatus_t rgb_greenhouse_status = {
     RGB_MODE_OFF,        // display_mode
@@ -35,6 +51,152 @@ const u8 g_rgb_num_buf[][5]=
 {0x00,0xF8,0xA0,0xA0,0x00},//F
 };
 
+#if RGB_USE_DMA
+// 配置一个DMA1通道：内存到GPIO寄存器，内存半字零扩展写入32位寄存器
+static void RGB_DMA_Channel_Init(DMA_Channel_TypeDef* ch, u32 periph, u32 mem, u32 mem_inc)
+{
+	DMA_InitTypeDef DMA_InitStructure;
+
+	DMA_DeInit(ch);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = periph;
+	DMA_InitStructure.DMA_MemoryBaseAddr = mem;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = RGB_DMA_BUF_LEN;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = mem_inc;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(ch, &DMA_InitStructure);
+}
+
+// TIM4以1.25us为周期运行，不输出到引脚，仅用UP/CC1/CC3事件触发DMA
+static void RGB_DMA_Init(void)
+{
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure;
+	TIM_OCInitTypeDef TIM_OCInitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	TIM_TimeBaseInitStructure.TIM_Period = RGB_TIM_PERIOD - 1;
+	TIM_TimeBaseInitStructure.TIM_Prescaler = 0;
+	TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM4, &TIM_TimeBaseInitStructure);
+	TIM_ARRPreloadConfig(TIM4, DISABLE);
+
+	TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+	TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Disable;
+	TIM_OCInitStructure.TIM_OCPolarity = TIM_OCPolarity_High;
+	TIM_OCInitStructure.TIM_Pulse = RGB_T0H_TICKS;
+	TIM_OC1Init(TIM4, &TIM_OCInitStructure);
+	TIM_OCInitStructure.TIM_Pulse = RGB_T1H_TICKS;
+	TIM_OC3Init(TIM4, &TIM_OCInitStructure);
+
+	RGB_DMA_Channel_Init(RGB_DMA_UP_CH, (u32)&GPIOE->BSRR, (u32)&rgb_pin_mask, DMA_MemoryInc_Disable);
+	RGB_DMA_Channel_Init(RGB_DMA_T0_CH, (u32)&GPIOE->BRR, (u32)rgb_dma_buf, DMA_MemoryInc_Enable);
+	RGB_DMA_Channel_Init(RGB_DMA_T1_CH, (u32)&GPIOE->BRR, (u32)&rgb_pin_mask, DMA_MemoryInc_Disable);
+	DMA_ITConfig(RGB_DMA_T1_CH, DMA_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel5_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	NVIC_InitStructure.NVIC_IRQChannel = TIM4_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+	NVIC_Init(&NVIC_InitStructure);
+}
+
+// 启动一帧发送：周期0为占位（两次BRR写入无影响），其后每个更新事件开始一位
+static void RGB_DMA_Start(void)
+{
+	rgb_dma_busy = 1;
+	GPIO_ResetBits(GPIOE, RGB_LED);
+
+	DMA_Cmd(RGB_DMA_UP_CH, DISABLE);
+	DMA_Cmd(RGB_DMA_T0_CH, DISABLE);
+	DMA_Cmd(RGB_DMA_T1_CH, DISABLE);
+	DMA_SetCurrDataCounter(RGB_DMA_UP_CH, RGB_FRAME_BITS);
+	DMA_SetCurrDataCounter(RGB_DMA_T0_CH, RGB_DMA_BUF_LEN);
+	DMA_SetCurrDataCounter(RGB_DMA_T1_CH, RGB_DMA_BUF_LEN);
+	DMA_ClearFlag(DMA1_FLAG_GL1 | DMA1_FLAG_GL5 | DMA1_FLAG_GL7);
+	DMA_Cmd(RGB_DMA_UP_CH, ENABLE);
+	DMA_Cmd(RGB_DMA_T0_CH, ENABLE);
+	DMA_Cmd(RGB_DMA_T1_CH, ENABLE);
+
+	TIM_SetAutoreload(TIM4, RGB_TIM_PERIOD - 1);
+	TIM_SetCounter(TIM4, 0);
+	TIM_ClearFlag(TIM4, TIM_FLAG_Update | TIM_FLAG_CC1 | TIM_FLAG_CC3);
+	TIM_DMACmd(TIM4, TIM_DMA_Update | TIM_DMA_CC1 | TIM_DMA_CC3, ENABLE);
+	TIM_Cmd(TIM4, ENABLE);
+}
+
+// 停止定时器和DMA请求
+static void RGB_DMA_Stop(void)
+{
+	TIM_Cmd(TIM4, DISABLE);
+	TIM_DMACmd(TIM4, TIM_DMA_Update | TIM_DMA_CC1 | TIM_DMA_CC3, DISABLE);
+	DMA_Cmd(RGB_DMA_UP_CH, DISABLE);
+	DMA_Cmd(RGB_DMA_T0_CH, DISABLE);
+	DMA_Cmd(RGB_DMA_T1_CH, DISABLE);
+}
+
+// 等待上一帧（含锁存）结束，最长约0.85ms；超时则强制停止
+static void RGB_DMA_Wait_Idle(void)
+{
+	u16 timeout;
+
+	for(timeout = 0; timeout < 200 && rgb_dma_busy; timeout++)
+	{
+		delay_us(10);
+	}
+	if(rgb_dma_busy)
+	{
+		TIM_ITConfig(TIM4, TIM_IT_Update, DISABLE);
+		RGB_DMA_Stop();
+		GPIO_ResetBits(GPIOE, RGB_LED);
+		rgb_dma_busy = 0;
+	}
+}
+
+// DMA1通道5传输完成：最后一位的T1H拉低已写入，转入锁存计时
+void DMA1_Channel5_IRQHandler(void)
+{
+	if(DMA_GetITStatus(DMA1_IT_TC5) != RESET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_TC5);
+		RGB_DMA_Stop();
+
+		// 复用TIM4单次计时RGB_RESET_US低电平
+		TIM_SetAutoreload(TIM4, RGB_RESET_US * 72 - 1);
+		TIM_SetCounter(TIM4, 0);
+		TIM_ClearITPendingBit(TIM4, TIM_IT_Update);
+		TIM_ITConfig(TIM4, TIM_IT_Update, ENABLE);
+		TIM_Cmd(TIM4, ENABLE);
+	}
+}
+
+// TIM4更新中断：锁存时间到，帧发送完成
+void TIM4_IRQHandler(void)
+{
+	if(TIM_GetITStatus(TIM4, TIM_IT_Update) != RESET)
+	{
+		TIM_ClearITPendingBit(TIM4, TIM_IT_Update);
+		TIM_Cmd(TIM4, DISABLE);
+		TIM_ITConfig(TIM4, TIM_IT_Update, DISABLE);
+		rgb_dma_busy = 0;
+		if(rgb_done_callback) rgb_done_callback();
+	}
+}
+#endif
+
 void RGB_LED_Init(void)
 {
 	GPIO_InitTypeDef  GPIO_InitStructure;
@@ -44,7 +206,12 @@ void RGB_LED_Init(void)
 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP; 		 
 	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;		
 	GPIO_Init(GPIOE, &GPIO_InitStructure);					
+#if RGB_USE_DMA
+	GPIO_ResetBits(GPIOE,GPIO_Pin_6);
+	RGB_DMA_Init();
+#else
 	GPIO_SetBits(GPIOE,GPIO_Pin_6);		
+#endif
 	
 	RGB_LED_Clear();
 }
@@ -87,9 +254,14 @@ void RGB_LED_Write1(void)
 
 void RGB_LED_Reset(void)
 {
+#if RGB_USE_DMA
+	// DMA方式在帧末自动保持低电平锁存，这里只需等待完成
+	RGB_DMA_Wait_Idle();
+#else
 	RGB_LED_LOW;
-	delay_us(80);
+	delay_us(RGB_RESET_US);
 	RGB_LED_HIGH;
+#endif
 }
 
 void RGB_LED_Write_Byte(uint8_t byte)
@@ -117,45 +289,138 @@ void RGB_LED_Write_24Bits(uint8_t green,uint8_t red,uint8_t blue)
 	RGB_LED_Write_Byte(blue);
 }
 
+/**
+ * @brief  把GRB字节流编码为DMA波形表
+ * @param  grb: GRB字节流，每字节高位先发
+ * @param  len: 字节数
+ * @param  pin: 数据引脚掩码（写入BRR即拉低）
+ * @param  out: 输出表，长度len*8+1；out[0]为启动周期占位，
+ *              out[1+n]为第n位在T0H处写入BRR的值：0码为pin，1码为0
+ * @note   纯函数，不访问硬件
+ */
+void RGB_Encode_Frame(const u8* grb, u16 len, u16 pin, u16* out)
+{
+	u16 i;
+	u8 bit, byte;
 
-//������ɫ�趨��������ɫ�Դ�����
-void RGB_LED_Red(void)
+	*out++ = pin;
+	for(i = 0; i < len; i++)
+	{
+		byte = grb[i];
+		for(bit = 0; bit < 8; bit++)
+		{
+			*out++ = (byte & 0x80) ? 0 : pin;
+			byte <<= 1;
+		}
+	}
+}
+
+/**
+ * @brief  按亮度把g_rgb_databuf整理为GRB字节流（逐行扫描）
+ * @param  grb: 输出缓冲区，长度RGB_FRAME_BYTES
+ * @param  brightness: 亮度百分比(0-100)
+ */
+void RGB_Build_Frame(u8* grb, u8 brightness)
 {
-	uint8_t i;
-	//LEDȫ�ʵ�
-	for(i=0;i<25;i++)
+	u8 i, j;
+
+	for(i = 0; i < RGB_LED_YHIGH; i++)
 	{
-		RGB_LED_Write_24Bits(0,0xff, 0);
+		for(j = 0; j < RGB_LED_XWIDTH; j++)
+		{
+			*grb++ = (g_rgb_databuf[1][j][i] * brightness) / 100;   // green
+			*grb++ = (g_rgb_databuf[0][j][i] * brightness) / 100;   // red
+			*grb++ = (g_rgb_databuf[2][j][i] * brightness) / 100;   // blue
+		}
 	}
 }
 
-void RGB_LED_Green(void)
+/**
+ * @brief  发送一帧GRB数据（RGB_FRAME_BYTES字节）
+ * @note   DMA方式：等待上一帧结束后编码并启动传输，立即返回；
+ *         软件方式：关中断发送整帧（约0.75ms）后锁存
+ */
+void RGB_LED_Send_Frame(const u8* grb)
 {
-	uint8_t i;
+#if RGB_USE_DMA
+	RGB_DMA_Wait_Idle();
+	RGB_Encode_Frame(grb, RGB_FRAME_BYTES, RGB_LED, rgb_dma_buf);
+	RGB_DMA_Start();
+#else
+	u16 i;
 
-	for(i=0;i<25;i++)
+	// 中断会破坏__nop()时序，发送期间关中断
+	__disable_irq();
+	for(i = 0; i < RGB_FRAME_BYTES; i++)
 	{
-		RGB_LED_Write_24Bits(0xff, 0, 0);
+		RGB_LED_Write_Byte(grb[i]);
 	}
+	__enable_irq();
+	RGB_LED_Reset();
+#endif
 }
 
-void RGB_LED_Blue(void)
+/**
+ * @brief  DMA发送是否进行中（软件方式恒为0）
+ */
+u8 RGB_LED_Busy(void)
 {
-	uint8_t i;
+#if RGB_USE_DMA
+	return rgb_dma_busy;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief  设置帧发送完成回调（仅DMA方式，在TIM4中断中调用）
+ */
+void RGB_LED_Set_Done_Callback(RGB_DoneCallback_t cb)
+{
+#if RGB_USE_DMA
+	rgb_done_callback = cb;
+#else
+	(void)cb;
+#endif
+}
+
+// 以固定GRB值填充整帧并发送
+static void RGB_LED_Fill_Raw(u8 green, u8 red, u8 blue)
+{
+	u8 i;
 
-	for(i=0;i<25;i++)
+	for(i = 0; i < RGB_LED_COUNT; i++)
 	{
-		RGB_LED_Write_24Bits(0, 0, 0xff);
+		rgb_frame[i * 3] = green;
+		rgb_frame[i * 3 + 1] = red;
+		rgb_frame[i * 3 + 2] = blue;
 	}
+	RGB_LED_Send_Frame(rgb_frame);
+}
+
+
+//������ɫ�趨��������ɫ�Դ�����
+void RGB_LED_Red(void)
+{
+	RGB_LED_Fill_Raw(0, 0xff, 0);
+}
+
+void RGB_LED_Green(void)
+{
+	RGB_LED_Fill_Raw(0xff, 0, 0);
+}
+
+void RGB_LED_Blue(void)
+{
+	RGB_LED_Fill_Raw(0, 0, 0xff);
 }
 
 void RGB_LED_Clear(void)
 {
-	u8 i;
-	for(i=0;i<25;i++)
-		RGB_LED_Write_24Bits(0,0,0);
-	RGB_LED_Reset();
+	RGB_LED_Fill_Raw(0, 0, 0);
+#if RGB_USE_DMA==0
 	delay_ms(10);
+#endif
 }
 
 /**
@@ -179,9 +444,6 @@ void RGB_Clear_Buffer(void)
 //color��RGB��ɫ
 void RGB_DrawDotColor(u8 x,u8 y,u8 status,u32 color)
 {
-	u8 i=0;
-	u8 j=0;
-	
 	RGB_LED_Clear();
 	if(status)
 	{
@@ -196,11 +458,8 @@ void RGB_DrawDotColor(u8 x,u8 y,u8 status,u32 color)
 		g_rgb_databuf[2][x][y]=0x00;
 	}
 		
-	for(i=0;i<RGB_LED_YHIGH;i++)
-	{
-		for(j=0;j<RGB_LED_XWIDTH;j++)
-			RGB_LED_Write_24Bits(g_rgb_databuf[1][j][i], g_rgb_databuf[0][j][i], g_rgb_databuf[2][j][i]);
-	}
+	RGB_Build_Frame(rgb_frame, 100);
+	RGB_LED_Send_Frame(rgb_frame);
 }
 
 void RGB_DrawLine_Color(u16 x1, u16 y1, u16 x2, u16 y2,u32 color)
@@ -358,18 +617,8 @@ void RGB_Set_Pixel(u8 x, u8 y, u32 color)
  */
 void RGB_LED_Update(void)
 {
-    u8 i, j;
-    u8 red, green, blue;
-    
-    for(i = 0; i < RGB_LED_YHIGH; i++) {
-        for(j = 0; j < RGB_LED_XWIDTH; j++) {
-            red = (g_rgb_databuf[0][j][i] * rgb_greenhouse_status.brightness) / 100;
-            green = (g_rgb_databuf[1][j][i] * rgb_greenhouse_status.brightness) / 100;
-            blue = (g_rgb_databuf[2][j][i] * rgb_greenhouse_status.brightness) / 100;
-            
-            RGB_LED_Write_24Bits(green, red, blue);
-        }
-    }
+    RGB_Build_Frame(rgb_frame, rgb_greenhouse_status.brightness);
+    RGB_LED_Send_Frame(rgb_frame);
 }
 
 /**
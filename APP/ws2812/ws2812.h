@@ -8,10 +8,29 @@
 #define	RGB_LED_HIGH	(GPIO_SetBits(GPIOE,RGB_LED))
 #define RGB_LED_LOW		(GPIO_ResetBits(GPIOE,RGB_LED))
 
+// 输出方式选择：0=__nop()软件时序，1=TIM4触发DMA写GPIO的硬件时序
+// PE6不是任何定时器的输出通道，因此DMA方式由TIM4的更新/CC1/CC3事件
+// 分别触发DMA1通道7/1/5写GPIOE的BSRR/BRR，在PE6上合成WS2812波形
+#define RGB_USE_DMA		1
+
 // RGB LED矩阵尺寸
 #define RGB_LED_XWIDTH	5
 #define RGB_LED_YHIGH	5
 #define RGB_LED_COUNT   (RGB_LED_XWIDTH * RGB_LED_YHIGH)
+#define RGB_FRAME_BYTES (RGB_LED_COUNT * 3)     // 一帧GRB字节数
+#define RGB_FRAME_BITS  (RGB_FRAME_BYTES * 8)   // 一帧位数
+
+// WS2812位时序（TIM4计数时钟72MHz）
+#define RGB_TIM_PERIOD  90      // 1.25us一位
+#define RGB_T0H_TICKS   25      // 0码高电平0.35us后拉低
+#define RGB_T1H_TICKS   56      // 1码高电平0.78us后拉低
+#define RGB_RESET_US    80      // 帧锁存低电平时间
+
+// DMA方式下每位对应一个BRR写入值，首项为启动周期占位
+#define RGB_DMA_BUF_LEN (RGB_FRAME_BITS + 1)
+
+// 帧发送完成（含锁存时间）回调，在中断中执行
+typedef void (*RGB_DoneCallback_t)(void);
 
 // RGB颜色定义 (GRB格式)
 #define RGB_COLOR_RED		0x00FF00
@@ -63,6 +82,11 @@ void RGB_LED_Write_24Bits(uint8_t green, uint8_t red, uint8_t blue);
 void RGB_LED_Clear(void);
 void RGB_Clear_Buffer(void);
 void RGB_LED_Update(void);
+void RGB_Build_Frame(u8* grb, u8 brightness);                   // 按亮度把g_rgb_databuf整理为GRB字节流
+void RGB_Encode_Frame(const u8* grb, u16 len, u16 pin, u16* out); // 把GRB字节流编码为DMA波形表（纯函数）
+void RGB_LED_Send_Frame(const u8* grb);                         // 发送一帧GRB数据
+u8 RGB_LED_Busy(void);                                          // DMA发送是否进行中
+void RGB_LED_Set_Done_Callback(RGB_DoneCallback_t cb);          // 设置帧完成回调
 
 // RGB矩阵控制函数
 void RGB_DrawDotColor(u8 x, u8 y, u8 status, u32 color);
@@ -13,6 +13,11 @@ void SysTick_Init(u8 SYSCLK)
 	SysTick_CLKSourceConfig(SysTick_CLKSource_HCLK_Div8);	//选择外部时钟  HCLK/8
 	fac_us=SYSCLK/8;								//为系统时钟的1/8  
 	fac_ms=(u16)fac_us*1000;						//非ucos下,代表每个ms需要的systick时钟数   
+#if SYSTEM_SUPPORT_OS==0
+	SysTick->LOAD=fac_ms-1;							//1ms节拍,驱动system_time_ms(任务调度时基)
+	SysTick->VAL=0x00;
+	SysTick->CTRL|=SysTick_CTRL_TICKINT_Msk|SysTick_CTRL_ENABLE_Msk;	//开启中断并开始计数
+#endif
 }								    
 
 #if SYSTEM_SUPPORT_OS  							//如果需要支持OS.
@@ -55,39 +60,34 @@ void delay_ms(u16 nms)
 	delay_us((u32)(nms*1000));				//普通方式延时  
 }
 #else //不用ucos时
+//SysTick作为1ms节拍自由运行,延时函数只读取VAL计数差,不再重装LOAD,
+//因此延时期间system_time_ms照常递增
 //延时nus
 //nus为要延时的us数.		    								   
 void delay_us(u32 nus)
 {		
-	u32 temp;	    	 
-	SysTick->LOAD=nus*fac_us; 				//时间加载	  		 
-	SysTick->VAL=0x00;        				//清空计数器
-	SysTick->CTRL|=SysTick_CTRL_ENABLE_Msk ;          //开始倒数	  
-	do
+	u32 ticks;
+	u32 told,tnow,tcnt=0;
+	u32 reload=SysTick->LOAD+1;				//一个节拍的计数值	    	 
+	ticks=nus*fac_us; 						//需要的节拍数	  		 
+	told=SysTick->VAL;        				//刚进入时的计数器值
+	while(1)
 	{
-		temp=SysTick->CTRL;
-	}while((temp&0x01)&&!(temp&(1<<16)));	//等待时间到达   
-	SysTick->CTRL&=~SysTick_CTRL_ENABLE_Msk;       //关闭计数器
-	SysTick->VAL =0X00;       				//清空计数器	 
+		tnow=SysTick->VAL;	
+		if(tnow!=told)
+		{	    
+			if(tnow<told)tcnt+=told-tnow;	//SYSTICK是一个递减的计数器
+			else tcnt+=reload-tnow+told;	    
+			told=tnow;
+			if(tcnt>=ticks)break;			//时间超过/等于要延迟的时间,则退出.
+		}  
+	};
 }
 //延时nms
-//注意nms的范围
-//SysTick->LOAD为24位寄存器,所以,最大延时为:
-//nms<=0xffffff*8*1000/SYSCLK
-//SYSCLK单位为Hz,nms单位为ms
-//对72M条件下,nms<=1864 
+//nms:要延时的ms数
 void delay_ms(u16 nms)
 {	 		  	  
-	u32 temp;		   
-	SysTick->LOAD=(u32)nms*fac_ms;			//时间加载(SysTick->LOAD为24bit)
-	SysTick->VAL =0x00;           			//清空计数器
-	SysTick->CTRL|=SysTick_CTRL_ENABLE_Msk ;          //开始倒数  
-	do
-	{
-		temp=SysTick->CTRL;
-	}while((temp&0x01)&&!(temp&(1<<16)));	//等待时间到达   
-	SysTick->CTRL&=~SysTick_CTRL_ENABLE_Msk;       //关闭计数器
-	SysTick->VAL =0X00;       				//清空计数器	  	    
+	delay_us((u32)nms*1000);
 } 
 #endif
 
@@ -0,0 +1,19 @@
+#include "crc16.h"
+
+/**
+ * @brief  CRC-16/CCITT-FALSE，可分段累加
+ * @param  crc: 初值（0xFFFF）或上一段的结果
+ * @retval 累加后的CRC
+ */
+u16 crc16_ccitt(u16 crc, const u8* data, u16 len)
+{
+    u8 i;
+
+    while(len--)
+    {
+        crc ^= (u16)(*data++) << 8;
+        for(i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
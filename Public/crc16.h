@@ -0,0 +1,9 @@
+#ifndef _crc16_H
+#define _crc16_H
+
+#include "system.h"
+
+// CRC-16/CCITT-FALSE（多项式0x1021），首段传入初值0xFFFF，后续段传入上一段结果即可分段累加
+u16 crc16_ccitt(u16 crc, const u8* data, u16 len);
+
+#endif
@@ -0,0 +1,97 @@
+#include "event_bus.h"
+#include "stdio.h"
+
+// 1ms系统节拍，由SysTick_Handler递增
+extern volatile u32 system_time_ms;
+
+static EventTopic_t event_topics[EVENT_MAX_TOPICS];
+static EventHandler_t event_handlers[EVENT_MAX_SUBSCRIBERS];
+static u32 event_masks[EVENT_MAX_SUBSCRIBERS];
+static u8 event_subscriber_count = 0;
+static u32 event_pending = 0;           // 已发布、等待分发的主题位图
+
+/**
+ * @brief  订阅主题
+ * @param  handler: 回调函数，在Event_Task中调用
+ * @param  topics: 主题位图（bit n对应主题n）
+ * @retval 0-成功，1-订阅者已满
+ */
+u8 Event_Subscribe(EventHandler_t handler, u32 topics)
+{
+    if(handler == 0 || event_subscriber_count >= EVENT_MAX_SUBSCRIBERS) return 1;
+
+    event_handlers[event_subscriber_count] = handler;
+    event_masks[event_subscriber_count] = topics;
+    event_subscriber_count++;
+    return 0;
+}
+
+/**
+ * @brief  设置主题最短分发间隔，用于限制变化频繁的主题
+ */
+void Event_Set_Interval(u8 topic, u16 min_interval_ms)
+{
+    if(topic >= EVENT_MAX_TOPICS) return;
+    event_topics[topic].min_interval_ms = min_interval_ms;
+}
+
+/**
+ * @brief  发布主题变化
+ * @note   只置位等待标志，不调用订阅者，发布者不受订阅者执行时间影响
+ */
+void Event_Publish(u8 topic)
+{
+    if(topic >= EVENT_MAX_TOPICS) return;
+    event_pending |= (u32)1 << topic;
+    event_topics[topic].publish_count++;
+}
+
+/**
+ * @brief  分发到期的主题，同一轮到期的主题合并为一次回调
+ */
+void Event_Task(void)
+{
+    EventTopic_t* t;
+    u32 now = system_time_ms;
+    u32 due = 0;
+    u8 i;
+
+    if(event_pending == 0) return;
+
+    for(i = 0; i < EVENT_MAX_TOPICS; i++)
+    {
+        if(!(event_pending & ((u32)1 << i))) continue;
+        t = &event_topics[i];
+        if(t->min_interval_ms != 0 && t->dispatch_count != 0 &&
+           now - t->last_dispatch < t->min_interval_ms) continue;
+        t->last_dispatch = now;
+        t->dispatch_count++;
+        due |= (u32)1 << i;
+    }
+    if(due == 0) return;
+    event_pending &= ~due;
+
+    for(i = 0; i < event_subscriber_count; i++)
+    {
+        if(event_masks[i] & due) event_handlers[i](event_masks[i] & due);
+    }
+}
+
+/**
+ * @brief  打印各主题发布/分发次数
+ */
+void Event_Print_Stats(void)
+{
+    const EventTopic_t* t;
+    u8 i;
+
+    printf("=== Event Statistics ===\r\n");
+    printf("%-6s %6s %10s %10s\r\n", "Topic", "MinInt", "Published", "Dispatched");
+    for(i = 0; i < EVENT_MAX_TOPICS; i++)
+    {
+        t = &event_topics[i];
+        if(t->publish_count == 0 && t->min_interval_ms == 0) continue;
+        printf("%-6d %6d %10lu %10lu\r\n", i, t->min_interval_ms, t->publish_count, t->dispatch_count);
+    }
+    printf("========================\r\n");
+}
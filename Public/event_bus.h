@@ -0,0 +1,30 @@
+#ifndef _event_bus_H
+#define _event_bus_H
+
+#include "system.h"
+
+// 状态变化通知：发布者只标记主题有变化，Event_Task统一分发给订阅者
+// 同一主题在分发前的多次发布合并为一次；每个主题可设最短分发间隔，间隔内的发布推迟到间隔结束
+#define EVENT_MAX_TOPICS        8       // 最大主题数
+#define EVENT_MAX_SUBSCRIBERS   4       // 最大订阅者数
+
+// 订阅者回调，topics为本次分发的主题位图（已按订阅掩码过滤）
+typedef void (*EventHandler_t)(u32 topics);
+
+// 主题统计
+typedef struct
+{
+    u16 min_interval_ms;        // 最短分发间隔，0-每轮立即分发
+    u32 last_dispatch;          // 上次分发时刻（system_time_ms）
+    u32 publish_count;          // 发布次数
+    u32 dispatch_count;         // 分发次数，与发布次数之差为合并掉的发布
+} EventTopic_t;
+
+// 事件总线接口
+u8 Event_Subscribe(EventHandler_t handler, u32 topics);    // 订阅主题位图，0-成功
+void Event_Set_Interval(u8 topic, u16 min_interval_ms);     // 设置主题最短分发间隔
+void Event_Publish(u8 topic);                               // 标记主题有变化（不可在中断中调用）
+void Event_Task(void);                                      // 周期任务：分发到期的主题
+void Event_Print_Stats(void);                               // 打印各主题发布/分发次数
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _log_H
+#define _log_H
+
+#include "stdio.h"
+
+// 调试日志等级，编译期过滤：高于LOG_LEVEL的日志语句被预处理为空，不占代码也不耗时
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL           LOG_LEVEL_INFO
+#endif
+
+// 用法：LOG_INFO(("Fan: %d%%\r\n", speed));
+// 参数带双括号，兼容不支持可变参数宏的C89编译器
+// 输出经printf进入USART1发送环形缓冲区，由DMA发送，不阻塞调用者
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(args)     printf args
+#else
+#define LOG_ERROR(args)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(args)      printf args
+#else
+#define LOG_WARN(args)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(args)      printf args
+#else
+#define LOG_INFO(args)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(args)     printf args
+#else
+#define LOG_DEBUG(args)
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+#include "scheduler.h"
+#include "stdio.h"
+#include "string.h"
+
+// 1ms系统节拍，由SysTick_Handler递增
+extern volatile u32 system_time_ms;
+
+static SchedTask_t sched_tasks[SCHED_MAX_TASKS];
+static u8 sched_task_count = 0;
+
+// 判断时刻t是否已到达（兼容32位计数回绕）
+#define SCHED_TIME_REACHED(now, t)  ((s32)((u32)(now) - (u32)(t)) >= 0)
+
+/**
+ * @brief  初始化调度器，清空任务表
+ */
+void Scheduler_Init(void)
+{
+    memset(sched_tasks, 0, sizeof(sched_tasks));
+    sched_task_count = 0;
+}
+
+/**
+ * @brief  注册周期任务
+ * @param  name: 任务名称
+ * @param  func: 任务函数
+ * @param  period_ms: 执行周期(ms)，不能为0
+ * @param  deadline_ms: 完成期限(ms)，0或大于周期时取周期
+ * @param  offset_ms: 首次释放相对当前时刻的偏移，用于错开同周期任务
+ * @retval 任务ID，失败返回SCHED_INVALID_ID
+ * @note   任务表顺序即优先级，先注册的任务在同一轮中先执行
+ */
+u8 Scheduler_Add_Task(const char* name, SchedTaskFunc_t func,
+                      u32 period_ms, u32 deadline_ms, u32 offset_ms)
+{
+    SchedTask_t* task;
+
+    if(func == 0 || period_ms == 0 || sched_task_count >= SCHED_MAX_TASKS) {
+        printf("Scheduler: Failed to add task %s\r\n", name ? name : "?");
+        return SCHED_INVALID_ID;
+    }
+
+    task = &sched_tasks[sched_task_count];
+    memset(task, 0, sizeof(SchedTask_t));
+    task->name = name;
+    task->func = func;
+    task->period_ms = period_ms;
+    task->deadline_ms = (deadline_ms == 0 || deadline_ms > period_ms) ? period_ms : deadline_ms;
+    task->next_release = system_time_ms + offset_ms;
+    task->enabled = 1;
+
+    return sched_task_count++;
+}
+
+/**
+ * @brief  使能/禁止任务
+ * @note   重新使能时从当前时刻开始计算释放时间
+ */
+void Scheduler_Set_Enable(u8 id, u8 enable)
+{
+    if(id >= sched_task_count) return;
+
+    if(enable && !sched_tasks[id].enabled) {
+        sched_tasks[id].next_release = system_time_ms;
+    }
+    sched_tasks[id].enabled = enable ? 1 : 0;
+}
+
+/**
+ * @brief  执行一轮调度：按优先级顺序运行所有已到期任务
+ * @retval 本轮执行的任务数量
+ * @note   释放时刻按固定周期推进，不受其他任务执行时间影响；
+ *         若错过多个周期则只补执行一次，并计入skip_count
+ */
+u8 Scheduler_Run_Once(void)
+{
+    SchedTask_t* task;
+    u32 release, start, finish, elapsed, periods;
+    u8 i;
+    u8 ran = 0;
+
+    for(i = 0; i < sched_task_count; i++)
+    {
+        task = &sched_tasks[i];
+        if(!task->enabled) continue;
+
+        start = system_time_ms;
+        if(!SCHED_TIME_REACHED(start, task->next_release)) continue;
+
+        release = task->next_release;
+        task->func();
+        finish = system_time_ms;
+
+        task->run_count++;
+        if(finish - start > task->max_exec_ms) task->max_exec_ms = finish - start;
+        if(start - release > task->max_latency_ms) task->max_latency_ms = start - release;
+
+        elapsed = finish - release;
+        if(elapsed > task->deadline_ms) task->overrun_count++;
+
+        task->next_release = release + task->period_ms;
+        if(SCHED_TIME_REACHED(finish, task->next_release)) {
+            periods = elapsed / task->period_ms;
+            task->skip_count += periods - 1;
+            task->next_release = release + periods * task->period_ms;
+        }
+        ran++;
+    }
+
+    return ran;
+}
+
+/**
+ * @brief  调度主循环，无到期任务时WFI休眠至下一次中断（SysTick为1ms）
+ */
+void Scheduler_Run(void)
+{
+    while(1)
+    {
+        if(Scheduler_Run_Once() == 0) {
+            __WFI();
+        }
+    }
+}
+
+/**
+ * @brief  获取任务控制块
+ */
+const SchedTask_t* Scheduler_Get_Task(u8 id)
+{
+    if(id >= sched_task_count) return 0;
+    return &sched_tasks[id];
+}
+
+/**
+ * @brief  获取已注册任务数
+ */
+u8 Scheduler_Get_Task_Count(void)
+{
+    return sched_task_count;
+}
+
+/**
+ * @brief  清零所有任务的运行统计
+ */
+void Scheduler_Reset_Stats(void)
+{
+    u8 i;
+
+    for(i = 0; i < sched_task_count; i++)
+    {
+        sched_tasks[i].run_count = 0;
+        sched_tasks[i].overrun_count = 0;
+        sched_tasks[i].skip_count = 0;
+        sched_tasks[i].max_exec_ms = 0;
+        sched_tasks[i].max_latency_ms = 0;
+    }
+}
+
+/**
+ * @brief  打印任务运行统计
+ */
+void Scheduler_Print_Stats(void)
+{
+    const SchedTask_t* task;
+    u8 i;
+
+    printf("=== Scheduler Statistics (t=%lums) ===\r\n", system_time_ms);
+    printf("%-12s %6s %6s %8s %6s %6s %6s %6s\r\n",
+           "Task", "Period", "Dline", "Runs", "Ovrun", "Skip", "MaxEx", "MaxLat");
+    for(i = 0; i < sched_task_count; i++)
+    {
+        task = &sched_tasks[i];
+        printf("%-12s %6lu %6lu %8lu %6lu %6lu %6lu %6lu\r\n",
+               task->name, task->period_ms, task->deadline_ms, task->run_count,
+               task->overrun_count, task->skip_count,
+               task->max_exec_ms, task->max_latency_ms);
+    }
+    printf("======================================\r\n");
+}
@@ -0,0 +1,44 @@
+#ifndef _scheduler_H
+#define _scheduler_H
+
+#include "system.h"
+
+// 协作式调度器配置
+#define SCHED_MAX_TASKS     16      // 最大任务数
+#define SCHED_INVALID_ID    0xFF    // 无效任务ID
+
+// 任务函数类型
+typedef void (*SchedTaskFunc_t)(void);
+
+// 任务控制块
+typedef struct
+{
+    const char* name;           // 任务名称（用于统计输出）
+    SchedTaskFunc_t func;       // 任务函数
+    u32 period_ms;              // 执行周期
+    u32 deadline_ms;            // 相对释放时刻的完成期限
+    u32 next_release;           // 下次释放时刻（system_time_ms）
+    u8  enabled;                // 是否使能
+
+    // 运行统计
+    u32 run_count;              // 执行次数
+    u32 overrun_count;          // 超过期限完成的次数
+    u32 skip_count;             // 因严重超时而跳过的释放次数
+    u32 max_exec_ms;            // 最长单次执行时间
+    u32 max_latency_ms;         // 最大释放延迟（释放到开始执行）
+} SchedTask_t;
+
+// 调度器接口
+void Scheduler_Init(void);                                  // 初始化任务表
+u8 Scheduler_Add_Task(const char* name, SchedTaskFunc_t func,
+                      u32 period_ms, u32 deadline_ms,
+                      u32 offset_ms);                       // 注册周期任务，返回任务ID
+void Scheduler_Set_Enable(u8 id, u8 enable);                // 使能/禁止任务
+u8 Scheduler_Run_Once(void);                                // 执行一轮到期任务，返回执行数量
+void Scheduler_Run(void);                                   // 调度主循环（不返回）
+const SchedTask_t* Scheduler_Get_Task(u8 id);               // 获取任务控制块（只读）
+u8 Scheduler_Get_Task_Count(void);                          // 获取已注册任务数
+void Scheduler_Reset_Stats(void);                           // 清零运行统计
+void Scheduler_Print_Stats(void);                           // 打印任务运行统计
+
+#endif
@@ -19,15 +19,88 @@ void _sys_exit(int x)
 { 
 	x = x; 
 } 
+
+//USART1发送环形缓冲区，由DMA1通道4(USART1_TX)发送
+//写入端推进head，DMA完成中断推进tail
+#define USART1_TX_DMA_CH	DMA1_Channel4
+static u8 usart1_tx_ring[USART1_TX_RING_LEN];
+static volatile u16 usart1_tx_head=0;		//下一个写入位置(自由计数)
+static volatile u16 usart1_tx_tail=0;		//下一个发送位置(自由计数)
+static volatile u16 usart1_tx_chunk=0;		//当前DMA传输字节数，0表示空闲
+static volatile u32 usart1_tx_dropped=0;	//缓冲区满丢弃的字节数
+static u8 usart1_tx_ready=0;				//DMA已初始化
+
+//若空闲且有数据，启动一段连续数据的DMA发送
+//调用时DMA中断不能打断(在中断中或已关中断)
+static void USART1_TX_Kick(void)
+{
+	u16 pending,start,len;
+	
+	if(usart1_tx_chunk!=0)return;
+	pending=usart1_tx_head-usart1_tx_tail;
+	if(pending==0)return;
+	
+	start=usart1_tx_tail%USART1_TX_RING_LEN;
+	len=USART1_TX_RING_LEN-start;		//到缓冲区末尾为止，剩余部分下次发送
+	if(len>pending)len=pending;
+	
+	usart1_tx_chunk=len;
+	USART_ClearFlag(USART1,USART_FLAG_TC);
+	DMA_Cmd(USART1_TX_DMA_CH,DISABLE);
+	USART1_TX_DMA_CH->CMAR=(u32)&usart1_tx_ring[start];
+	DMA_SetCurrDataCounter(USART1_TX_DMA_CH,len);
+	DMA_Cmd(USART1_TX_DMA_CH,ENABLE);
+}
+
+//DMA1通道4中断：一段数据已交给USART1
+void DMA1_Channel4_IRQHandler(void)
+{
+	if(DMA_GetITStatus(DMA1_IT_TC4)!=RESET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_TC4);
+		usart1_tx_tail+=usart1_tx_chunk;
+		usart1_tx_chunk=0;
+		USART1_TX_Kick();
+	}
+}
+
 //重定义fputc函数 
+//字符写入发送环形缓冲区后立即返回，缓冲区满时丢弃并计数，不阻塞
+//可在中断中调用
 int fputc(int ch, FILE *f)
 { 	
-	while((USART1->SR&0X40)==0);//循环发送,直到发送完毕   
-	USART1->DR = (u8) ch;      
+	u32 primask;
+	
+	if(!usart1_tx_ready)
+	{
+		while((USART1->SR&0X40)==0);//DMA未初始化前循环发送,直到发送完毕   
+		USART1->DR = (u8) ch;      
+		return ch;
+	}
+	
+	primask=__get_PRIMASK();
+	__disable_irq();
+	if((u16)(usart1_tx_head-usart1_tx_tail)<USART1_TX_RING_LEN)
+	{
+		usart1_tx_ring[usart1_tx_head%USART1_TX_RING_LEN]=(u8)ch;
+		usart1_tx_head++;
+		USART1_TX_Kick();
+	}
+	else
+	{
+		usart1_tx_dropped++;
+	}
+	__set_PRIMASK(primask);
 	return ch;
 }
 #endif
 
+//获取因发送缓冲区满而丢弃的字节数
+u32 USART1_Get_TX_Dropped(void)
+{
+	return usart1_tx_dropped;
+}
+
 //串口1中断服务程序
 //注意,读取USARTx->SR能避免莫名其妙的错误   	
 u8 USART1_RX_BUF[USART1_REC_LEN];     //接收缓冲,最大USART_REC_LEN个字节.
@@ -79,6 +152,7 @@ void USART1_Init(u32 bound)
 	GPIO_InitTypeDef GPIO_InitStructure;
 	USART_InitTypeDef USART_InitStructure;
 	NVIC_InitTypeDef NVIC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
 	 
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1|RCC_APB2Periph_GPIOA, ENABLE);	//使能USART1，GPIOA时钟
  
@@ -111,6 +185,33 @@ void USART1_Init(u32 bound)
 	USART_Init(USART1, &USART_InitStructure); //初始化串口1
 	USART_ITConfig(USART1, USART_IT_RXNE, ENABLE);//开启串口接受中断
 	USART_Cmd(USART1, ENABLE);                    //使能串口1 
+
+	//DMA1通道4：发送环形缓冲区->USART1->DR，每次传输时设置地址和长度
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+	DMA_DeInit(USART1_TX_DMA_CH);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&USART1->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (u32)usart1_tx_ring;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(USART1_TX_DMA_CH, &DMA_InitStructure);
+	DMA_ITConfig(USART1_TX_DMA_CH, DMA_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel4_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority=3;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	while((USART1->SR&0X40)==0);	//等待初始化前的阻塞输出发完
+	USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+	usart1_tx_ready = 1;
 }
 
 // USART3相关函数在usart3.c中定义
@@ -6,6 +6,7 @@
 
 // USART1配置
 #define USART1_REC_LEN  		200  	//定义最大接收字节数 200
+#define USART1_TX_RING_LEN		2048	//printf发送环形缓冲区大小，必须为2的幂
 
 extern u8  USART1_RX_BUF[USART1_REC_LEN]; //接收缓冲,最大USART_REC_LEN个字节.末字节为换行符 
 extern u16 USART1_RX_STA;         		//接收状态标记
@@ -14,8 +15,9 @@ extern u16 USART1_RX_STA;         		//接收状态标记
 
 // 函数声明
 void USART1_Init(u32 bound);					// 串口1初始化
+u32 USART1_Get_TX_Dropped(void);				// 发送缓冲区满丢弃的字节数
 void USART3_Init(u32 bound);					// 串口3初始化 
-void u3_printf(char* fmt,...);					// 串口3打印函数
+u16 u3_printf(char* fmt,...);					// 串口3打印函数（DMA发送，返回入队字节数）
 
 #endif
 
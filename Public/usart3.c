@@ -3,49 +3,242 @@
 #include "stdio.h"	 	 
 #include "string.h"
 
-// USART3 interrupt service routine
-// Note: reading USARTx->SR can avoid unknown errors   	
-u8 USART3_RX_BUF[USART3_REC_LEN];     // receive buffer, max USART_REC_LEN bytes
-// receive status
-// bit15: receive complete flag
-// bit14: received 0x0d
-// bit13~0: number of valid bytes received
-u16 USART3_RX_STA=0;       // receive status flag
+// Line queue written by USART3_IRQHandler (producer) and read by USART3_Get_Line (consumer).
+// Each side only writes its own index, so no locking is needed.
+static char usart3_lines[USART3_LINE_QUEUE][USART3_LINE_LEN];
+static u8 usart3_line_len[USART3_LINE_QUEUE];
+static volatile u8 usart3_line_head = 0;   // next slot to fill, written by ISR only
+static volatile u8 usart3_line_tail = 0;   // next slot to read, written by consumer only
+static u8 usart3_rx_pos = 0;               // bytes in the line being received (ISR only)
+static u8 usart3_rx_discard = 0;           // current line will be dropped (ISR only)
+static u8 usart3_rx_state = 0;             // USART3_RX_xxx (ISR only)
+static volatile u32 usart3_rx_dropped = 0;
+
+// Receive framing states
+#define USART3_RX_TEXT		0	// text line ending in '\n'
+#define USART3_RX_BINARY	1	// 0x00-delimited binary frame
+#define USART3_RX_SKIP		2	// dropped binary frame: swallow it up to and including its closing 0x00
+
+// Format buffer for u3_printf, separate from the receive queue
+static u8 USART3_TX_BUF[USART3_MAX_SEND_LEN];
+
+// Transmit ring drained by DMA1 Channel2 (USART3_TX).
+// The writer advances head; the DMA completion interrupt advances tail.
+#define USART3_TX_DMA_CH	DMA1_Channel2
+static u8 usart3_tx_ring[USART3_TX_RING_LEN];
+static volatile u16 usart3_tx_head = 0;		// next byte to write (free running)
+static volatile u16 usart3_tx_tail = 0;		// next byte to send (free running)
+static volatile u16 usart3_tx_chunk = 0;	// bytes in the running DMA transfer, 0 = idle
+static u32 usart3_tx_queued = 0;
+static u32 usart3_tx_dropped = 0;
 
+// USART3 interrupt service routine
+// Note: reading SR then DR also clears the overrun flag
 void USART3_IRQHandler(void)                	// USART3 interrupt service routine
 {
 	u8 Res;
+	u8 slot;
+	u16 sr;
 #if SYSTEM_SUPPORT_OS 		// if SYSTEM_SUPPORT_OS is true, need to support OS.
 	OSIntEnter();    
 #endif
-	if(USART3->SR & USART_IT_RXNE)  // receive interrupt (received data must end with 0x0d 0x0a)
+	sr = USART3->SR;
+	if(sr & (USART_FLAG_RXNE | USART_FLAG_ORE))
 	{
-		Res =USART3->DR;			// read received data
+		Res = USART3->DR;			// read received data
+		slot = usart3_line_head % USART3_LINE_QUEUE;
 		
-		if((USART3_RX_STA&0x8000)==0)// receive not complete
+		if(usart3_rx_state == USART3_RX_SKIP)
+		{
+			// usart3_rx_pos marks frame data seen, so a repeated opening 0x00 does not end the skip
+			if(Res != 0x00) usart3_rx_pos = 1;
+			else if(usart3_rx_pos > 0)
+			{
+				usart3_rx_state = USART3_RX_TEXT;
+				usart3_rx_pos = 0;
+				usart3_rx_discard = 0;
+			}
+		}
+		else
 		{
-			if(USART3_RX_STA&0x4000)// received 0x0d
+			if(Res == 0x00 && !(usart3_rx_state == USART3_RX_BINARY && usart3_rx_pos > 1))
 			{
-				if(Res!=0x0a)USART3_RX_STA=0;// receive error, restart
-				else USART3_RX_STA|=0x8000;	// receive complete
+				// opening delimiter (repeated ones restart the frame): the line is stored as 0x00 + frame
+				// a partial text line cut off by it is lost, count it like any other dropped line
+				if(usart3_rx_state == USART3_RX_TEXT && (usart3_rx_pos > 0 || usart3_rx_discard))
+					usart3_rx_dropped++;
+				usart3_rx_state = USART3_RX_BINARY;
+				usart3_rx_pos = 0;
+				usart3_rx_discard = 0;
 			}
-			else // haven't received 0X0D yet
-			{	
-				if(Res==0x0d)USART3_RX_STA|=0x4000;
+			if(sr & USART_FLAG_ORE) usart3_rx_discard = 1;	// a byte was lost, line is corrupt
+			
+			if(Res == 0x0d && usart3_rx_state == USART3_RX_TEXT)
+			{
+				// ignored, lines end with 0x0a
+			}
+			else if(usart3_rx_state == USART3_RX_BINARY ? (Res == 0x00 && usart3_rx_pos > 1) : (Res == 0x0a))
+			{
+				if(usart3_rx_discard) usart3_rx_dropped++;
+				else if(usart3_rx_pos > 0)
+				{
+					usart3_line_len[slot] = usart3_rx_pos;
+					usart3_line_head++;		// publish the line
+				}
+				usart3_rx_pos = 0;
+				usart3_rx_discard = 0;
+				usart3_rx_state = USART3_RX_TEXT;
+			}
+			else if(usart3_rx_state == USART3_RX_BINARY &&
+			        (usart3_rx_discard || (u8)(usart3_line_head - usart3_line_tail) >= USART3_LINE_QUEUE
+			         || usart3_rx_pos >= USART3_LINE_LEN - 1))
+			{
+				// corrupt frame, queue full or frame too long: skip to its closing 0x00 so that
+				// neither the rest of the frame nor the text after it is taken for a new frame
+				usart3_rx_dropped++;
+				usart3_rx_state = USART3_RX_SKIP;
+				usart3_rx_pos = (Res != 0x00) ? 1 : 0;
+			}
+			else if(!usart3_rx_discard)
+			{
+				// queue full or line too long: drop the whole line, resync on the next '\n' or 0x00
+				if((u8)(usart3_line_head - usart3_line_tail) >= USART3_LINE_QUEUE
+				   || usart3_rx_pos >= USART3_LINE_LEN - 1)
+				{
+					usart3_rx_discard = 1;
+				}
 				else
 				{
-					USART3_RX_BUF[USART3_RX_STA&0X3FFF]=Res ;
-					USART3_RX_STA++;
-					if(USART3_RX_STA>(USART3_REC_LEN-1))USART3_RX_STA=0;// receive data error, restart  
-				}		 
+					usart3_lines[slot][usart3_rx_pos++] = Res;
+				}
 			}
-		}   		 
+		}
 	} 
 #if SYSTEM_SUPPORT_OS 	// if SYSTEM_SUPPORT_OS is true, need to support OS.
 	OSIntExit();  											 
 #endif
 } 
 
+// Number of complete lines waiting in the queue
+u8 USART3_Line_Available(void)
+{
+	return (u8)(usart3_line_head - usart3_line_tail);
+}
+
+// Pop the oldest line into buf (NUL terminated, truncated to size-1)
+// return: line length, 0 if the queue is empty
+u16 USART3_Get_Line(char* buf, u16 size)
+{
+	u8 slot;
+	u16 len;
+	
+	if(usart3_line_tail == usart3_line_head || size == 0) return 0;
+	
+	slot = usart3_line_tail % USART3_LINE_QUEUE;
+	len = usart3_line_len[slot];
+	if(len > size - 1) len = size - 1;
+	memcpy(buf, usart3_lines[slot], len);
+	buf[len] = 0;
+	usart3_line_tail++;		// release the slot to the ISR
+	return len;
+}
+
+// Discard all queued lines
+void USART3_Flush_Lines(void)
+{
+	usart3_line_tail = usart3_line_head;
+}
+
+// Number of lines dropped since power on
+u32 USART3_Get_Dropped(void)
+{
+	return usart3_rx_dropped;
+}
+
+// Start a DMA transfer of the contiguous block at tail, if idle and data is waiting
+// Called with the DMA interrupt unable to run (from the ISR itself or with IRQs masked)
+static void USART3_TX_Kick(void)
+{
+	u16 pending, start, len;
+	
+	if(usart3_tx_chunk != 0) return;
+	pending = usart3_tx_head - usart3_tx_tail;
+	if(pending == 0) return;
+	
+	start = usart3_tx_tail % USART3_TX_RING_LEN;
+	len = USART3_TX_RING_LEN - start;		// stop at the end of the ring, the rest goes next time
+	if(len > pending) len = pending;
+	
+	usart3_tx_chunk = len;
+	USART_ClearFlag(USART3, USART_FLAG_TC);	// DMA writes DR without the SR read, clear TC by hand
+	DMA_Cmd(USART3_TX_DMA_CH, DISABLE);
+	USART3_TX_DMA_CH->CMAR = (u32)&usart3_tx_ring[start];
+	DMA_SetCurrDataCounter(USART3_TX_DMA_CH, len);
+	DMA_Cmd(USART3_TX_DMA_CH, ENABLE);
+}
+
+// DMA1 Channel2 interrupt: one block has been handed to USART3
+void DMA1_Channel2_IRQHandler(void)
+{
+	if(DMA_GetITStatus(DMA1_IT_TC2) != RESET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_TC2);
+		usart3_tx_tail += usart3_tx_chunk;
+		usart3_tx_chunk = 0;
+		USART3_TX_Kick();
+	}
+}
+
+// Queue raw bytes for transmission, never blocks
+// return: bytes accepted; fewer than len means the ring was full (back-pressure)
+u16 USART3_Write(const u8* data, u16 len)
+{
+	u16 free_len, i;
+	
+	free_len = USART3_TX_RING_LEN - (u16)(usart3_tx_head - usart3_tx_tail);
+	if(len > free_len)
+	{
+		usart3_tx_dropped += len - free_len;
+		len = free_len;
+	}
+	for(i = 0; i < len; i++)
+	{
+		usart3_tx_ring[(usart3_tx_head + i) % USART3_TX_RING_LEN] = data[i];
+	}
+	usart3_tx_head += len;
+	usart3_tx_queued += len;
+	
+	__disable_irq();
+	USART3_TX_Kick();
+	__enable_irq();
+	return len;
+}
+
+// Free space in the transmit ring
+u16 USART3_TX_Free(void)
+{
+	return USART3_TX_RING_LEN - (u16)(usart3_tx_head - usart3_tx_tail);
+}
+
+// Block until the ring is empty and the last stop bit has been sent
+void USART3_TX_Wait_Done(void)
+{
+	while(usart3_tx_head != usart3_tx_tail);
+	while(USART_GetFlagStatus(USART3, USART_FLAG_TC) == RESET);
+}
+
+// Total bytes accepted for transmission since power on
+u32 USART3_Get_TX_Queued(void)
+{
+	return usart3_tx_queued;
+}
+
+// Total bytes rejected because the ring was full
+u32 USART3_Get_TX_Dropped(void)
+{
+	return usart3_tx_dropped;
+}
+
 // Initialize IO and USART3
 // bound: baud rate
 void USART3_Init(u32 bound){
@@ -53,6 +246,7 @@ void USART3_Init(u32 bound){
 	GPIO_InitTypeDef GPIO_InitStructure;
 	USART_InitTypeDef USART_InitStructure;
 	NVIC_InitTypeDef NVIC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
 	 
 	RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART3, ENABLE);	// Enable USART3, GPIOB clock
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
@@ -75,6 +269,29 @@ void USART3_Init(u32 bound){
 	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;			// IRQ channel enable
 	NVIC_Init(&NVIC_InitStructure);	// initialize VIC register according to specified parameters
 
+	// DMA1 Channel2: transmit ring -> USART3->DR, address and length set per transfer
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+	DMA_DeInit(USART3_TX_DMA_CH);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&USART3->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (u32)usart3_tx_ring;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(USART3_TX_DMA_CH, &DMA_InitStructure);
+	DMA_ITConfig(USART3_TX_DMA_CH, DMA_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority=3;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
 	// USART initialization settings
 	USART_InitStructure.USART_BaudRate = bound;// serial baud rate
 	USART_InitStructure.USART_WordLength = USART_WordLength_8b;// word length is 8-bit data format
@@ -85,23 +302,22 @@ void USART3_Init(u32 bound){
 
 	USART_Init(USART3, &USART_InitStructure); // initialize serial port
 	USART_ITConfig(USART3, USART_IT_RXNE, ENABLE);// enable serial receive interrupt
+	USART_DMACmd(USART3, USART_DMAReq_Tx, ENABLE);// transmit through DMA
 	USART_Cmd(USART3, ENABLE);                    // enable USART3
 
 }
 
 // USART3, printf function
 // ensure that the data sent at one time does not exceed USART3_MAX_SEND_LEN bytes
-void u3_printf(char* fmt,...)  
+// The text is queued to the transmit ring and sent by DMA; only formatting costs CPU time
+// return: bytes queued, less than the formatted length if the ring was full
+u16 u3_printf(char* fmt,...)  
 {  
-	u16 i,j; 
+	u16 i; 
 	va_list ap; 
 	va_start(ap,fmt);
-	vsprintf((char*)USART3_RX_BUF,fmt,ap);
+	vsprintf((char*)USART3_TX_BUF,fmt,ap);
 	va_end(ap);
-	i=strlen((const char*)USART3_RX_BUF);		// length of data to be sent this time
-	for(j=0;j<i;j++)							// loop to send data
-	{
-		while(USART_GetFlagStatus(USART3,USART_FLAG_TC)==RESET); // loop send until transmission complete  
-		USART_SendData(USART3,USART3_RX_BUF[j]); 
-	} 
+	i=strlen((const char*)USART3_TX_BUF);		// length of data to be sent this time
+	return USART3_Write(USART3_TX_BUF,i);
 }
@@ -3,14 +3,27 @@
 
 #include "system.h"
 
-#define USART3_REC_LEN      200  // Define maximum receive bytes 200
-#define USART3_MAX_SEND_LEN 200	 // Maximum send buffer bytes
+#define USART3_MAX_SEND_LEN 200	 // Maximum bytes formatted by one u3_printf call
+#define USART3_TX_RING_LEN  512  // Transmit ring size, must be a power of two
 #define EN_USART3_RX 			1		// Enable (1), Disable (0) USART3 receive
 
-extern u8  USART3_RX_BUF[USART3_REC_LEN]; // Receive buffer, max USART3_REC_LEN bytes, last byte is newline
-extern u16 USART3_RX_STA;         		// Receive status flag
+// Receive line queue: the ISR frames bytes into lines (terminated by '\n', '\r' ignored)
+// and pushes them into a single-producer/single-consumer ring of line slots.
+// A line may also be a binary frame sent as 0x00 <bytes> 0x00 (no 0x00 inside, e.g. COBS);
+// it is queued as 0x00 followed by the frame bytes, and '\r'/'\n' inside it are data
+#define USART3_LINE_LEN     64   // Maximum line length including terminator
+#define USART3_LINE_QUEUE   8    // Number of queued lines, must be a power of two
 
 void USART3_Init(u32 bound);
-void u3_printf(char* fmt,...);
+u16 u3_printf(char* fmt,...);                 // Queue formatted text, returns bytes queued
+u16 USART3_Write(const u8* data, u16 len);   // Queue raw bytes, returns bytes queued
+u16 USART3_TX_Free(void);                    // Free space in the transmit ring
+void USART3_TX_Wait_Done(void);              // Block until every queued byte has left the wire
+u32 USART3_Get_TX_Queued(void);              // Total bytes accepted for transmission
+u32 USART3_Get_TX_Dropped(void);             // Bytes rejected because the ring was full
+u8 USART3_Line_Available(void);              // Number of complete lines waiting
+u16 USART3_Get_Line(char* buf, u16 size);     // Pop one line, returns length (0 = none)
+void USART3_Flush_Lines(void);               // Discard all queued lines
+u32 USART3_Get_Dropped(void);                // Lines dropped (queue full, too long or overrun)
 
 #endif
@@ -2,14 +2,19 @@
 #include "system.h"
 #include "SysTick.h"
 #include "usart3.h"
+#include "../APP/hc05/hc05.h"
 #include "tftlcd.h"
 #include "dht11.h"
 #include "../APP/greenhouse_control/greenhouse_control.h"
 #include "../APP/greenhouse_control/greenhouse_display.h"
 #include "../APP/data_logger/data_logger.h"
+#include "../APP/data_logger/log_export.h"
+#include "../APP/greenhouse_control/telemetry.h"
+#include "event_bus.h"
 #include "../APP/led/led.h"
 #include "../APP/key/key.h"
 #include "../APP/ws2812/ws2812.h"  // 添加RGB彩灯支持
+#include "scheduler.h"
 #include "stm32f10x_gpio.h"
 #include "usart.h"
 
@@ -66,18 +71,90 @@ void Peripheral_Init(void)
 	RGB_LED_Clear();
 }
 
+/**
+ * @brief  按键扫描任务 - 10ms
+ */
+static void Key_Task(void)
+{
+	u8 key;
+	
+	key = KEY_Scan(0);
+	if(key) {
+		Greenhouse_Process_Key(key);
+	}
+}
+
+/**
+ * @brief  RTC时间更新任务 - 1s
+ */
+static void RTC_Task(void)
+{
+	RTC_Process_Interrupt();  // 更新时间，模拟1秒时钟
+}
+
+/**
+ * @brief  RGB彩灯常规显示任务 - 1s
+ */
+static void RGB_Task(void)
+{
+	if(greenhouse_status.work_mode == MODE_AUTO) {
+		// 自动模式下，显示机器人头像
+		RGB_Show_Robot(RGB_COLOR_GREEN);
+	} else {
+		// 手动模式下，显示状态人脸，并实时反映风扇速度
+		RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, 
+							   greenhouse_status.pump_status, 
+							   greenhouse_status.light_status,
+							   Fan_Get_Speed());
+	}
+}
+
+/**
+ * @brief  温室控制主任务 - 500ms
+ */
+static void Main_Task(void)
+{
+	Greenhouse_Task();          // 温室控制主任务
+	Greenhouse_Update_Display(); // 更新显示
+}
+
+/**
+ * @brief  系统状态LED闪烁任务 - 150ms
+ */
+static void System_LED_Task(void)
+{
+	LED_System_Toggle();
+}
+
+/**
+ * @brief  注册周期任务
+ * @note   注册顺序即优先级：实时性要求高的任务在前；
+ *         偏移量用于错开同时到期的慢任务
+ */
+static void Task_Register(void)
+{
+	Scheduler_Init();
+	// 参数: 名称, 任务函数, 周期(ms), 完成期限(ms), 首次释放偏移(ms)
+	Scheduler_Add_Task("BEEP",       BEEP_Task,                    5,    5,      0);
+	Scheduler_Add_Task("Bluetooth",  Greenhouse_Handle_Bluetooth,  5,    50,     1);
+	Scheduler_Add_Task("HC05",       HC05_AT_Task,                 5,    10,     3);
+	Scheduler_Add_Task("Key",        Key_Task,                     10,   30,     2);
+	Scheduler_Add_Task("Marquee",    LED_Marquee_Update,           200,  50,     3);
+	Scheduler_Add_Task("SysLED",     System_LED_Task,              150,  50,     4);
+	Scheduler_Add_Task("Export",     LogExport_Task,               10,   10,     6);
+	Scheduler_Add_Task("Events",     Event_Task,                   10,   10,     7);
+	Scheduler_Add_Task("Telemetry",  Telemetry_Task,               10,   10,     8);
+	Scheduler_Add_Task("RTC",        RTC_Task,                     1000, 100,    5);
+	Scheduler_Add_Task("Greenhouse", Main_Task,                    500,  500,    7);
+	Scheduler_Add_Task("Logger",     DataLogger_Task,              1000, 200,    9);
+	Scheduler_Add_Task("RGB",        RGB_Task,                     1000, 200,  250);
+}
+
 /**
  * @brief  主函数
  */
 int main(void)
 {	
-	u8 key;
-	u16 task_counter = 0;
-	u16 led_counter = 0;
-	u16 rtc_counter = 0;
-	u16 rgb_counter = 0;           // RGB更新计数器
-	u16 rgb_mode_counter = 0;      // RGB模式切换计数器
-	
 	// 系统初始化
 	System_Clock_Init();
 	Peripheral_Init();
@@ -153,73 +230,7 @@ int main(void)
 	
 	printf("System started, running...\r\n\r\n");
 	
-	// 主循环
-	
-	while(1)
-	{
-		task_counter++;
-		led_counter++;
-		rtc_counter++;
-		rgb_counter++;
-		rgb_mode_counter++;
-		
-		// 按键处理
-		key = KEY_Scan(0);
-		if(key) {
-			Greenhouse_Process_Key(key);
-		}
-		
-		// RTC时间更新 - 每200次循环调用一次 (约1秒)
-		if(rtc_counter >= 200) {
-			rtc_counter = 0;
-			RTC_Process_Interrupt();  // 更新时间，模拟1秒时钟
-		}
-		
-		// RGB彩灯处理 - 每2次循环更新一次 (约10ms)
-		if(rgb_counter >= 2) {
-			rgb_counter = 0;
-
-			// 每秒更新一次常规显示
-			if(rgb_mode_counter >= 200) { // 200 * 5ms = 1s
-				rgb_mode_counter = 0;
-				
-				if(greenhouse_status.work_mode == MODE_AUTO) {
-					// 自动模式下，显示机器人头像
-					RGB_Show_Robot(RGB_COLOR_GREEN);
-				} else {
-					// 手动模式下，显示状态人脸，并实时反映风扇速度
-					RGB_Show_Manual_Status_Face(greenhouse_status.fan_status, 
-										   greenhouse_status.pump_status, 
-										   greenhouse_status.light_status,
-										   Fan_Get_Speed());
-				}
-			}
-		}
-		
-		// 任务调度 - 每50次循环执行一次 (约500ms)
-		if(task_counter >= 50)
-		{
-			task_counter = 0;
-			printf("Main task executing: counter=%d\r\n", task_counter);
-			
-			Greenhouse_Task();          // 温室控制主任务
-			Greenhouse_Update_Display(); // 更新显示
-		}
-		
-		// 系统状态LED闪烁 - 每30次循环切换一次
-		if (led_counter >= 30) { 
-			led_counter = 0;
-			LED_System_Toggle();
-		}
-		
-		// 实时任务
-		BEEP_Task();                // 处理蜂鸣器任务
-		LED_Marquee_Update();       // 更新跑马灯状态
-		
-		// 处理蓝牙命令 - 实时处理
-		Greenhouse_Handle_Bluetooth();
-		
-		// 循环延时5ms - 提高响应速度
-		delay_ms(5);
-	}
+	// 主循环 - 由调度器按system_time_ms节拍驱动各任务，空闲时休眠
+	Task_Register();
+	Scheduler_Run();
 }
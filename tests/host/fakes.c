@@ -0,0 +1,32 @@
+/**
+ * @file   fakes.c
+ * @brief  被测模块依赖、但测试不关心的外部函数（弱符号，链接了真实模块时以真实模块为准）
+ */
+#include "host.h"
+#include "fakes.h"
+
+u8 fake_config[CONFIG_ITEM_COUNT];          // 0-使用各模块的默认值
+u8 fake_at_busy = 0;
+
+__attribute__((weak)) u8 Config_Get_U8(ConfigItem_t item)
+{
+    return (item < CONFIG_ITEM_COUNT) ? fake_config[item] : 0;
+}
+
+__attribute__((weak)) u8 HC05_AT_Busy(void)
+{
+    return fake_at_busy;
+}
+
+__attribute__((weak)) u8 RTC_Is_Leap_Year(u16 year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+__attribute__((weak)) u8 RTC_Get_Month_Days(u16 year, u8 month)
+{
+    static const u8 days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    if(month < 1 || month > 12) return 0;
+    return (month == 2 && RTC_Is_Leap_Year(year)) ? 29 : days[month - 1];
+}
@@ -0,0 +1,9 @@
+#ifndef _fakes_H
+#define _fakes_H
+
+#include "config.h"
+
+extern u8 fake_config[CONFIG_ITEM_COUNT];   // Config_Get_U8的返回值
+extern u8 fake_at_busy;                     // HC05_AT_Busy的返回值
+
+#endif
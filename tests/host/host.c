@@ -0,0 +1,365 @@
+#define _GNU_SOURCE
+#include "host.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+unsigned long host_checks = 0;
+unsigned long host_failures = 0;
+
+volatile u32 system_time_ms = 0;
+
+u32 host_flash_steps = 0;
+u32 host_flash_programs = 0;
+u32 host_flash_erases = 0;
+u32 host_flash_misuse = 0;
+jmp_buf host_power_lost;
+u8 host_power_lost_in_erase = 0;
+
+static u32 host_primask = 0;
+static u32 host_nvic[8];
+static host_hook_t host_wfi_hook = 0;
+static u8 host_flash_locked = 1;
+static u32 host_cut_step = 0;
+static u32 host_fail_step = 0;
+static u32 host_rand_state = 1;
+
+#define HOST_FSMC_PAGE  0x6C000000
+
+static host_bus_write_t host_bus_write = 0;
+static host_bus_read_t host_bus_read = 0;
+static uintptr_t host_bus_addr;
+static u8 host_bus_store;
+
+/* ========================= 存储器映射 ========================= */
+
+static void host_map(uintptr_t addr, size_t len)
+{
+    void* p = mmap((void*)addr, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(p != (void*)addr)
+    {
+        fprintf(stderr, "host: cannot map 0x%08lx (build with -no-pie)\n", (unsigned long)addr);
+        exit(2);
+    }
+}
+
+__attribute__((constructor))
+static void host_init(void)
+{
+    host_map(HOST_FLASH_BASE, HOST_FLASH_SIZE);        // Flash
+    host_map(0x40000000, 0x30000);                      // APB1/APB2/AHB外设
+    host_map(0x42000000, 0x600000);                     // 外设位带别名区
+    host_map(HOST_FSMC_PAGE, 0x1000);                   // FSMC Bank1.sector4（LCD）
+    host_map(0xA0000000, 0x1000);                       // FSMC寄存器
+    host_map(0xE000E000, 0x1000);                       // 内核外设（NVIC/SCB/SysTick）
+    memset((void*)HOST_FLASH_BASE, 0xFF, HOST_FLASH_SIZE);
+
+    // 固件的printf输出默认丢弃，HOST_VERBOSE=1时保留
+    if(getenv("HOST_VERBOSE") == 0) freopen("/dev/null", "w", stdout);
+}
+
+/* ========================= 断言 ========================= */
+
+void host_fail(const char* file, int line, const char* expr)
+{
+    host_failures++;
+    if(host_failures <= 20) fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+}
+
+void host_fail_eq(const char* file, int line, const char* a, const char* b, long long va, long long vb)
+{
+    host_failures++;
+    if(host_failures <= 20)
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", file, line, a, b, va, vb);
+}
+
+int host_report(const char* name)
+{
+    fprintf(stderr, "%-20s %lu checks, %lu failed\n", name, host_checks, host_failures);
+    return host_failures ? 1 : 0;
+}
+
+/* ========================= 时钟与中断 ========================= */
+
+void host_set_rtc(u32 seconds)
+{
+    RTC->CNTH = seconds >> 16;
+    RTC->CNTL = seconds & 0xFFFF;
+}
+
+void host_set_wfi_hook(host_hook_t hook)
+{
+    host_wfi_hook = hook;
+}
+
+void host_wfi(void)
+{
+    if(host_wfi_hook) host_wfi_hook();
+    else system_time_ms++;
+}
+
+void delay_ms(u16 nms)
+{
+    system_time_ms += nms;
+}
+
+void delay_us(u32 nus)
+{
+    (void)nus;
+}
+
+void host_disable_irq(void)         { host_primask = 1; }
+void host_enable_irq(void)          { host_primask = 0; }
+uint32_t host_get_primask(void)     { return host_primask; }
+void host_set_primask(uint32_t pm)  { host_primask = pm & 1; }
+u8 host_irq_masked(void)            { return host_primask != 0; }
+
+void host_nvic_enable(int irq)
+{
+    if(irq >= 0) host_nvic[irq >> 5] |= 1u << (irq & 31);
+}
+
+void host_nvic_disable(int irq)
+{
+    if(irq >= 0) host_nvic[irq >> 5] &= ~(1u << (irq & 31));
+}
+
+u8 host_nvic_enabled(int irq)
+{
+    return (host_nvic[irq >> 5] >> (irq & 31)) & 1;
+}
+
+void host_system_reset(void)
+{
+    fprintf(stderr, "host: NVIC_SystemReset\n");
+    exit(3);
+}
+
+/* ========================= Flash模型 ========================= */
+
+static u32 host_rand(void)
+{
+    host_rand_state ^= host_rand_state << 13;
+    host_rand_state ^= host_rand_state >> 17;
+    host_rand_state ^= host_rand_state << 5;
+    return host_rand_state;
+}
+
+void host_flash_reset(void)
+{
+    memset((void*)HOST_FLASH_BASE, 0xFF, HOST_FLASH_SIZE);
+    host_flash_steps = 0;
+    host_flash_programs = 0;
+    host_flash_erases = 0;
+    host_flash_misuse = 0;
+    host_flash_locked = 1;
+    host_cut_step = 0;
+    host_fail_step = 0;
+}
+
+void host_power_cut_at(u32 step)
+{
+    host_cut_step = step;
+}
+
+void host_flash_fail_at(u32 step)
+{
+    host_fail_step = step;
+}
+
+u8 host_flash_unlocked(void)
+{
+    return !host_flash_locked;
+}
+
+/**
+ * @brief  开始一步编程/擦除
+ * @retval 1-按计划返回编程错误
+ * @note   到达掉电步时由调用方写入中途状态后调用host_power_fail
+ */
+static u8 host_flash_step(void)
+{
+    host_flash_steps++;
+    if(host_fail_step != 0 && host_flash_steps == host_fail_step) return 1;
+    return 0;
+}
+
+static u8 host_flash_cut_now(void)
+{
+    return host_cut_step != 0 && host_flash_steps == host_cut_step;
+}
+
+static void host_power_fail(void)
+{
+    host_cut_step = 0;
+    host_fail_step = 0;
+    host_flash_locked = 1;
+    host_primask = 0;
+    longjmp(host_power_lost, 1);
+}
+
+static u8 host_flash_addr_ok(u32 addr, u32 align)
+{
+    return addr >= HOST_FLASH_BASE && addr < HOST_FLASH_BASE + HOST_FLASH_SIZE && (addr % align) == 0;
+}
+
+void FLASH_Unlock(void)
+{
+    host_flash_locked = 0;
+}
+
+void FLASH_Lock(void)
+{
+    host_flash_locked = 1;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data)
+{
+    volatile u16* cell = (volatile u16*)(uintptr_t)Address;
+
+    if(host_flash_locked || !host_flash_addr_ok(Address, 2))
+    {
+        host_flash_misuse++;
+        return FLASH_ERROR_WRP;
+    }
+    if(*cell != 0xFFFF && Data != 0x0000)
+    {
+        host_flash_misuse++;
+        return FLASH_ERROR_PG;
+    }
+    host_flash_programs++;
+    if(host_flash_step()) return FLASH_ERROR_PG;
+    if(host_flash_cut_now())
+    {
+        // 编程中途掉电：部分应清零的位仍为1
+        host_rand_state = host_flash_steps * 2654435761u | 1;
+        *cell = Data | (u16)(host_rand() & ~Data);
+        host_power_lost_in_erase = 0;
+        host_power_fail();
+    }
+    *cell = Data;
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+    FLASH_Status status;
+
+    // 与StdPeriph库相同，先写低半字再写高半字
+    status = FLASH_ProgramHalfWord(Address, Data & 0xFFFF);
+    if(status == FLASH_COMPLETE)
+        status = FLASH_ProgramHalfWord(Address + 2, Data >> 16);
+    return status;
+}
+
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address)
+{
+    u32 base = Page_Address & ~(u32)(HOST_FLASH_PAGE - 1);
+    volatile u32* word = (volatile u32*)(uintptr_t)base;
+    u32 mask;
+    u16 i;
+    u8 level;
+
+    if(host_flash_locked || !host_flash_addr_ok(Page_Address, 1))
+    {
+        host_flash_misuse++;
+        return FLASH_ERROR_WRP;
+    }
+    host_flash_erases++;
+    if(host_flash_step()) return FLASH_ERROR_PG;
+    if(host_flash_cut_now())
+    {
+        // 擦除中途掉电：各位只会由0变1，结果介于原内容和全1之间，按掉电早晚变1的位占1/8到3/4
+        host_rand_state = host_flash_steps * 2654435761u | 1;
+        level = host_rand() % 4;
+        for(i = 0; i < HOST_FLASH_PAGE / 4; i++)
+        {
+            mask = host_rand();
+            if(level <= 1) mask &= host_rand();
+            if(level == 0) mask &= host_rand();
+            if(level == 3) mask |= host_rand();
+            word[i] |= mask;
+        }
+        host_power_lost_in_erase = 1;
+        host_power_fail();
+    }
+    memset((void*)(uintptr_t)base, 0xFF, HOST_FLASH_PAGE);
+    return FLASH_COMPLETE;
+}
+
+/* ========================= DMA与串口 ========================= */
+
+u32 host_dma_drain(DMA_Channel_TypeDef* ch, u8 channel, void (*irq)(void), u8* out, u32 size)
+{
+    u32 total = 0, n;
+    u32 tc = (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << ((channel - 1) * 4);
+
+    while((ch->CCR & DMA_CCR1_EN) && ch->CNDTR > 0)
+    {
+        n = ch->CNDTR;
+        if(out != 0 && total + n <= size) memcpy(out + total, (const void*)(uintptr_t)ch->CMAR, n);
+        total += n;
+        ch->CNDTR = 0;
+        DMA1->ISR |= tc;
+        irq();
+        DMA1->ISR &= ~tc;
+    }
+    return total;
+}
+
+void host_usart_rx(USART_TypeDef* usart, u8 byte, u8 overrun, void (*irq)(void))
+{
+    // SR的清零位按普通存储器保存，USART_ClearFlag写入的~flag会留下其他标志，ORE按本次参数设置
+    usart->DR = byte;
+    usart->SR = (usart->SR & ~USART_FLAG_ORE) | USART_FLAG_RXNE | (overrun ? USART_FLAG_ORE : 0);
+    irq();
+    usart->SR &= ~(USART_FLAG_RXNE | USART_FLAG_ORE);
+}
+
+/* ========================= FSMC总线 ========================= */
+
+// 访问FSMC页时缺页：打开该页，按回调准备读出的值，单步执行这条指令后再关闭并把写入交给回调
+
+static void host_bus_fault(int sig, siginfo_t* info, void* ctx)
+{
+    ucontext_t* uc = (ucontext_t*)ctx;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+
+    (void)sig;
+    if((addr & ~(uintptr_t)0xFFF) != HOST_FSMC_PAGE || host_bus_write == 0) abort();
+    host_bus_addr = addr & ~(uintptr_t)1;
+    host_bus_store = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+    mprotect((void*)HOST_FSMC_PAGE, 0x1000, PROT_READ | PROT_WRITE);
+    if(!host_bus_store && host_bus_read != 0)
+        *(volatile u16*)host_bus_addr = host_bus_read((u32)host_bus_addr);
+    uc->uc_mcontext.gregs[REG_EFL] |= 0x100;             // TF
+}
+
+static void host_bus_step(int sig, siginfo_t* info, void* ctx)
+{
+    ucontext_t* uc = (ucontext_t*)ctx;
+
+    (void)sig;
+    (void)info;
+    if(host_bus_store) host_bus_write((u32)host_bus_addr, *(volatile u16*)host_bus_addr);
+    mprotect((void*)HOST_FSMC_PAGE, 0x1000, PROT_NONE);
+    uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+}
+
+void host_fsmc_trap(host_bus_write_t write, host_bus_read_t read)
+{
+    struct sigaction sa;
+
+    host_bus_write = write;
+    host_bus_read = read;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO;
+    sa.sa_sigaction = host_bus_fault;
+    sigaction(SIGSEGV, &sa, 0);
+    sa.sa_sigaction = host_bus_step;
+    sigaction(SIGTRAP, &sa, 0);
+    mprotect((void*)HOST_FSMC_PAGE, 0x1000, write ? PROT_NONE : PROT_READ | PROT_WRITE);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file   host.h
+ * @brief  固件模块的主机测试环境（gcc，x86-64 Linux）
+ * @note   把STM32F103的存储器映射（Flash、外设、位带、FSMC、内核外设）映射为同地址的内存，
+ *         固件源文件和StdPeriph库不作修改直接编译；Flash由host.c中的模型实现，
+ *         可在任意一步编程/擦除中途掉电；时钟、DMA传输和串口接收由测试驱动
+ */
+#ifndef _host_H
+#define _host_H
+
+#include "stm32f10x.h"
+#include <setjmp.h>
+#include <stdio.h>
+
+// 断言：失败时打印位置并计数，不中止测试
+#define CHECK(cond) \
+    do { host_checks++; if(!(cond)) host_fail(__FILE__, __LINE__, #cond); } while(0)
+#define CHECK_EQ(a, b) \
+    do { long long _a = (long long)(a), _b = (long long)(b); host_checks++; \
+         if(_a != _b) host_fail_eq(__FILE__, __LINE__, #a, #b, _a, _b); } while(0)
+
+extern unsigned long host_checks;
+extern unsigned long host_failures;
+void host_fail(const char* file, int line, const char* expr);
+void host_fail_eq(const char* file, int line, const char* a, const char* b, long long va, long long vb);
+int host_report(const char* name);                  // 打印结果，返回进程退出码
+
+// 时钟：system_time_ms由测试推进，RTC计数器即RTC寄存器
+extern volatile u32 system_time_ms;
+void host_set_rtc(u32 seconds);
+typedef void (*host_hook_t)(void);
+void host_set_wfi_hook(host_hook_t hook);           // __WFI时调用，默认system_time_ms加1
+
+// 中断
+u8 host_irq_masked(void);                           // PRIMASK是否置位
+u8 host_nvic_enabled(int irq);
+
+// Flash模型：只能把1编程为0（写0x0000除外，非空半字编程返回FLASH_ERROR_PG），按2KB页擦除
+#define HOST_FLASH_BASE     0x08000000
+#define HOST_FLASH_SIZE     0x80000
+#define HOST_FLASH_PAGE     2048
+extern u32 host_flash_steps;                        // 已执行的编程/擦除步数（半字编程和页擦除各一步）
+extern u32 host_flash_programs;                     // 其中的半字编程次数
+extern u32 host_flash_erases;                       // 其中的页擦除次数
+extern u32 host_flash_misuse;                       // 未解锁、地址非法或向非空半字编程的次数
+extern jmp_buf host_power_lost;                     // 掉电时longjmp到这里
+extern u8 host_power_lost_in_erase;                 // 最近一次掉电发生在页擦除中途
+void host_flash_reset(void);                        // 整片擦除，计数清零，取消掉电和故障
+void host_power_cut_at(u32 step);                   // 第step步执行到一半时掉电（0-取消）
+void host_flash_fail_at(u32 step);                  // 第step步返回FLASH_ERROR_PG且不写入（0-取消）
+u8 host_flash_unlocked(void);
+
+// DMA：完成通道上正在进行的传输（存储器到外设），数据写入out，置位TC并调用中断处理函数，
+// 直到通道空闲；返回传输的字节数
+u32 host_dma_drain(DMA_Channel_TypeDef* ch, u8 channel, void (*irq)(void), u8* out, u32 size);
+
+// 串口接收一个字节：置位RXNE（overrun时同时置位ORE）后调用中断处理函数
+void host_usart_rx(USART_TypeDef* usart, u8 byte, u8 overrun, void (*irq)(void));
+
+// FSMC总线：打开后对0x6C000000页的每次访问都交给回调（用于LCD面板模型）
+typedef void (*host_bus_write_t)(u32 addr, u16 data);
+typedef u16 (*host_bus_read_t)(u32 addr);
+void host_fsmc_trap(host_bus_write_t write, host_bus_read_t read);
+
+#endif
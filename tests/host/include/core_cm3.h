@@ -0,0 +1,137 @@
+/**
+ * @file   core_cm3.h
+ * @brief  主机测试用的Cortex-M3内核层，替代Libraries/CMSIS/core_cm3.h
+ * @note   寄存器结构和地址与CMSIS V1.30一致（host.c把这些地址映射为内存），
+ *         内核指令改为调用host.c中的模拟实现：开关中断记录在PRIMASK，__WFI推进模拟时钟
+ */
+#ifndef __CM3_CORE_H__
+#define __CM3_CORE_H__
+
+#include <stdint.h>
+
+#define __CM3_CMSIS_VERSION_MAIN  (0x01)
+#define __CM3_CMSIS_VERSION_SUB   (0x30)
+#define __CORTEX_M                (0x03)
+
+#ifdef __cplusplus
+  #define     __I     volatile
+#else
+  #define     __I     volatile const
+#endif
+#define     __O     volatile
+#define     __IO    volatile
+
+#define __ASM            __asm
+#define __INLINE         inline
+
+typedef struct
+{
+  __IO uint32_t ISER[8];
+       uint32_t RESERVED0[24];
+  __IO uint32_t ICER[8];
+       uint32_t RSERVED1[24];
+  __IO uint32_t ISPR[8];
+       uint32_t RESERVED2[24];
+  __IO uint32_t ICPR[8];
+       uint32_t RESERVED3[24];
+  __IO uint32_t IABR[8];
+       uint32_t RESERVED4[56];
+  __IO uint8_t  IP[240];
+       uint32_t RESERVED5[644];
+  __O  uint32_t STIR;
+}  NVIC_Type;
+
+typedef struct
+{
+  __I  uint32_t CPUID;
+  __IO uint32_t ICSR;
+  __IO uint32_t VTOR;
+  __IO uint32_t AIRCR;
+  __IO uint32_t SCR;
+  __IO uint32_t CCR;
+  __IO uint8_t  SHP[12];
+  __IO uint32_t SHCSR;
+  __IO uint32_t CFSR;
+  __IO uint32_t HFSR;
+  __IO uint32_t DFSR;
+  __IO uint32_t MMFAR;
+  __IO uint32_t BFAR;
+  __IO uint32_t AFSR;
+  __I  uint32_t PFR[2];
+  __I  uint32_t DFR;
+  __I  uint32_t ADR;
+  __I  uint32_t MMFR[4];
+  __I  uint32_t ISAR[5];
+} SCB_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+  __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Pos         16
+#define SysTick_CTRL_COUNTFLAG_Msk         (1ul << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_CLKSOURCE_Pos          2
+#define SysTick_CTRL_CLKSOURCE_Msk         (1ul << SysTick_CTRL_CLKSOURCE_Pos)
+#define SysTick_CTRL_TICKINT_Pos            1
+#define SysTick_CTRL_TICKINT_Msk           (1ul << SysTick_CTRL_TICKINT_Pos)
+#define SysTick_CTRL_ENABLE_Pos             0
+#define SysTick_CTRL_ENABLE_Msk            (1ul << SysTick_CTRL_ENABLE_Pos)
+#define SysTick_LOAD_RELOAD_Pos             0
+#define SysTick_LOAD_RELOAD_Msk            (0xFFFFFFul << SysTick_LOAD_RELOAD_Pos)
+
+#define SCS_BASE            (0xE000E000)
+#define SysTick_BASE        (SCS_BASE +  0x0010)
+#define NVIC_BASE           (SCS_BASE +  0x0100)
+#define SCB_BASE            (SCS_BASE +  0x0D00)
+
+#define SCB                 ((SCB_Type *)           SCB_BASE)
+#define SysTick             ((SysTick_Type *)       SysTick_BASE)
+#define NVIC                ((NVIC_Type *)          NVIC_BASE)
+
+// 模拟实现见host.c
+void host_disable_irq(void);
+void host_enable_irq(void);
+uint32_t host_get_primask(void);
+void host_set_primask(uint32_t primask);
+void host_wfi(void);
+void host_nvic_enable(int irq);
+void host_nvic_disable(int irq);
+void host_system_reset(void);
+
+static __INLINE void __enable_irq(void)              { host_enable_irq(); }
+static __INLINE void __disable_irq(void)             { host_disable_irq(); }
+static __INLINE uint32_t __get_PRIMASK(void)         { return host_get_primask(); }
+static __INLINE void __set_PRIMASK(uint32_t priMask) { host_set_primask(priMask); }
+static __INLINE void __NOP(void)                     { }
+static __INLINE void __nop(void)                     { }    // ARMCC内建函数
+static __INLINE void __WFI(void)                     { host_wfi(); }
+static __INLINE void __WFE(void)                     { host_wfi(); }
+static __INLINE void __SEV(void)                     { }
+static __INLINE void __ISB(void)                     { }
+static __INLINE void __DSB(void)                     { }
+static __INLINE void __DMB(void)                     { }
+
+static __INLINE void NVIC_EnableIRQ(IRQn_Type IRQn)  { host_nvic_enable(IRQn); }
+static __INLINE void NVIC_DisableIRQ(IRQn_Type IRQn) { host_nvic_disable(IRQn); }
+
+static __INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+  if(IRQn >= 0) NVIC->IP[(uint32_t)IRQn] = ((priority << (8 - __NVIC_PRIO_BITS)) & 0xff);
+}
+
+static __INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+  if(ticks > SysTick_LOAD_RELOAD_Msk) return 1;
+  SysTick->LOAD = (ticks & SysTick_LOAD_RELOAD_Msk) - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+  return 0;
+}
+
+static __INLINE void NVIC_SystemReset(void)          { host_system_reset(); }
+
+#endif /* __CM3_CORE_H__ */
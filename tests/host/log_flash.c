@@ -0,0 +1,123 @@
+#include "host.h"
+#include "fakes.h"
+#include "log_flash.h"
+#include <string.h>
+
+#define SLOT(page, slot)    ((const LogRecord_t*)(FLASH_START_ADDR + (u32)(page) * FLASH_PAGE_SIZE + (slot) * LOG_RECORD_SIZE))
+#define HEADER(page)        ((const LogPageHeader_t*)SLOT(page, 0))
+
+void log_flash_layout(u16 first[LOG_RING_COUNT], u16 count[LOG_RING_COUNT])
+{
+    u8 op = fake_config[CONFIG_LOG_OPERATION_PAGES];
+    u8 alarm = fake_config[CONFIG_LOG_ALARM_PAGES];
+
+    if(op < LOG_RING_MIN_PAGES || op > LOG_RING_MAX_PAGES) op = DEFAULT_LOG_OPERATION_PAGES;
+    if(alarm < LOG_RING_MIN_PAGES || alarm > LOG_RING_MAX_PAGES) alarm = DEFAULT_LOG_ALARM_PAGES;
+    count[LOG_RING_SENSOR] = LOG_PAGE_COUNT - op - alarm;
+    count[LOG_RING_OPERATION] = op;
+    count[LOG_RING_ALARM] = alarm;
+    first[LOG_RING_SENSOR] = 0;
+    first[LOG_RING_OPERATION] = count[LOG_RING_SENSOR];
+    first[LOG_RING_ALARM] = count[LOG_RING_SENSOR] + op;
+}
+
+u8 log_flash_commit(const LogRecord_t* rec)
+{
+    u8 crc = 0, i, b;
+
+    for(i = 0; i < LOG_RECORD_SIZE - 1; i++)
+    {
+        crc ^= rec->raw_data[i];
+        for(b = 0; b < 8; b++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return (crc == 0xFF) ? 0xFE : crc;
+}
+
+u32 log_flash_slots(u8 ring, LogFlashSlot_t* out, u32 max)
+{
+    u16 first[LOG_RING_COUNT], count[LOG_RING_COUNT];
+    u16 pages[LOG_PAGE_COUNT], n = 0, i, j, t, newest = 0, slot;
+    const LogRecord_t* rec;
+    u32 total = 0;
+
+    log_flash_layout(first, count);
+    for(i = first[ring]; i < first[ring] + count[ring]; i++)
+    {
+        if(HEADER(i)->magic != LOG_PAGE_MAGIC || HEADER(i)->ring != ring) continue;
+        if(n == 0 || (s16)(HEADER(i)->seq - newest) > 0) newest = HEADER(i)->seq;
+        pages[n++] = i;
+    }
+    // 按序号从旧到新排序（以最新页为基准比较，序号回绕也成立）
+    for(i = 1; i < n; i++)
+    {
+        for(j = i; j > 0 && (s16)(HEADER(pages[j])->seq - newest) < (s16)(HEADER(pages[j - 1])->seq - newest); j--)
+        {
+            t = pages[j];
+            pages[j] = pages[j - 1];
+            pages[j - 1] = t;
+        }
+    }
+
+    for(i = 0; i < n; i++)
+    {
+        for(slot = LOG_HEADER_SLOTS; slot < LOG_SLOTS_PER_PAGE; slot++)
+        {
+            rec = SLOT(pages[i], slot);
+            if(rec->raw_data[LOG_RECORD_SIZE - 1] != log_flash_commit(rec)) continue;
+            if(total < max)
+            {
+                out[total].pos = LOG_POS(ring, HEADER(pages[i])->seq, slot);
+                out[total].rec = *rec;
+            }
+            total++;
+        }
+    }
+    return total;
+}
+
+u32 log_flash_expand(const LogFlashSlot_t* slots, u32 n, SensorLogRecord_t* out, u32 max)
+{
+    const SensorPackRecord_t* p;
+    SensorLogRecord_t s;
+    u32 i, total = 0;
+    u16 d;
+    u8 k;
+
+    for(i = 0; i < n; i++)
+    {
+        if(slots[i].rec.pack.log_type != LOG_TYPE_SENSOR_PACK)
+        {
+            if(total < max) out[total] = slots[i].rec.sensor;
+            total++;
+            continue;
+        }
+        p = &slots[i].rec.pack;
+        memset(&s, 0, sizeof(s));
+        s.timestamp = p->timestamp;
+        s.log_type = LOG_TYPE_SENSOR;
+        s.temperature = p->temperature;
+        s.humidity = p->humi_fan & 0x7F;
+        s.fan_status = p->humi_fan >> 7;
+        s.light = p->light_pump & 0x7F;
+        s.pump_status = p->light_pump >> 7;
+        s.alarm_flags = p->flags & 0x3F;
+        s.light_status = (p->flags >> 6) & 1;
+        s.work_mode = p->flags >> 7;
+        for(k = 0; k < LOG_PACK_SAMPLES; k++)
+        {
+            if(k > 0)
+            {
+                d = p->delta[k - 1];
+                if(d == 0xFFFF) break;
+                s.timestamp += (d & 0x0F) + 1;
+                s.temperature += (s8)(((d >> 4) & 0x07) ^ 0x04) - 4;
+                s.humidity += (s8)(((d >> 7) & 0x0F) ^ 0x08) - 8;
+                s.light += (s8)(((d >> 11) & 0x1F) ^ 0x10) - 16;
+            }
+            if(total < max) out[total] = s;
+            total++;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file   log_flash.h
+ * @brief  不经过data_logger.c、直接按页头和记录格式读出Flash中各记录环的内容，作为测试的参照
+ */
+#ifndef _log_flash_H
+#define _log_flash_H
+
+#include "data_logger.h"
+
+typedef struct
+{
+    u32 pos;                    // LOG_POS(环号, 页序号, 槽号)
+    LogRecord_t rec;
+} LogFlashSlot_t;
+
+void log_flash_layout(u16 first[LOG_RING_COUNT], u16 count[LOG_RING_COUNT]);   // 按fake_config划分各环
+u8 log_flash_commit(const LogRecord_t* rec);                                    // 记录的提交字节
+u32 log_flash_slots(u8 ring, LogFlashSlot_t* out, u32 max);                      // 按页序号顺序列出环内已提交的记录槽
+u32 log_flash_expand(const LogFlashSlot_t* slots, u32 n, SensorLogRecord_t* out, u32 max); // 展开压缩记录
+
+#endif
@@ -0,0 +1,503 @@
+/**
+ * @file   test_config.c
+ * @brief  配置日志：回放、旧格式迁移、擦除次数，以及一段跨越整理的保存中在每一个编程/擦除步掉电后
+ *         重启，参数为掉电前已完成的保存加上正在进行的保存中按参数顺序的前若干项（整理则全有或全无），
+ *         之后可以继续保存
+ * @note   直接包含config.c以读取日志页和写入位置；重启时静态变量按启动代码恢复初值，
+ *         system_config之外的参数全部来自Flash
+ */
+#include "host.h"
+#include "fakes.h"
+#include "../../APP/config/config.c"
+#include <stdlib.h>
+
+#define REPLAY_SAVES    4000
+#define W_SAVES         10
+#define W_RESET         6           // W中这一次保存是恢复默认配置
+#define W_STEPS_MAX     256
+#define ERASE_TRIALS    1024        // 擦除中途掉电的结果是随机的，擦除步多试几次（残缺旧页头伪造较新seq的概率很小）
+
+typedef struct
+{
+    u8 count;
+    u8 item[4];
+    u16 value[4];
+} Save_t;
+
+static int flash_owners;                                // DataLogger_Acquire未释放的次数
+static u8 snapshot[HOST_FLASH_SIZE];
+static Save_t w[W_SAVES];
+static u16 expected[W_SAVES + 1][CONFIG_ITEM_COUNT];    // W中每次保存完成后的参数
+static u32 bad_boot, bad_resume;
+
+void DataLogger_Acquire(void)
+{
+    flash_owners++;
+}
+
+void DataLogger_Release(void)
+{
+    flash_owners--;
+}
+
+/**
+ * @brief  重启：静态变量恢复初值（.bss清零），Config_Init从Flash恢复参数
+ */
+static void reboot(void)
+{
+    config_page = CONFIG_NO_PAGE;
+    config_seq = 0;
+    config_write_pos = 0;
+    memset(config_saved, 0, sizeof(config_saved));
+    memset(&system_config, 0, sizeof(system_config));
+    flash_owners = 0;
+    Config_Init();
+}
+
+static void values(u16* v)
+{
+    u8 i;
+
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++) v[i] = Config_Get_U16((ConfigItem_t)i);
+}
+
+static u8 same(const u16* a, const u16* b)
+{
+    return memcmp(a, b, CONFIG_ITEM_COUNT * sizeof(u16)) == 0;
+}
+
+/**
+ * @brief  参数的一个合法取值（按Config_Set_U8/U16实际的范围检查），与当前值不同
+ */
+static u16 random_value(u8 item)
+{
+    u16 current = Config_Get_U16((ConfigItem_t)item);
+    u16 lo, hi, v;
+
+    if(item == CONFIG_AUTO_LIGHT_TIME) { lo = 0; hi = 1440; }
+    else { lo = config_items[item].min_value; hi = config_items[item].max_value; }
+    if(lo == hi) return current;
+    do v = lo + rand() % (hi - lo + 1); while(v == current);
+    return v;
+}
+
+/**
+ * @brief  随机选count个不同的参数修改为新值
+ */
+static void random_save(Save_t* s, u8 count)
+{
+    u8 i, j, item;
+
+    s->count = 0;
+    for(i = 0; i < count; i++)
+    {
+        do
+        {
+            item = rand() % CONFIG_ITEM_COUNT;
+            for(j = 0; j < s->count && s->item[j] != item; j++);
+        } while(j < s->count);
+        s->item[s->count] = item;
+        s->value[s->count++] = random_value(item);
+    }
+}
+
+static void run(const Save_t* s)
+{
+    u8 i;
+
+    for(i = 0; i < s->count; i++) CHECK_EQ(Config_Set_U16((ConfigItem_t)s->item[i], s->value[i]), 0);
+    CHECK_EQ(Config_Save(), 0);
+}
+
+/**
+ * @brief  首次上电：没有日志时写入默认配置，只擦除一次；再次上电回放得到同样的参数
+ */
+static void test_first_boot(void)
+{
+    u16 def[CONFIG_ITEM_COUNT], got[CONFIG_ITEM_COUNT];
+
+    Config_Set_Defaults();
+    values(def);
+    CHECK_EQ(def[CONFIG_TEMP_FAN_ON], DEFAULT_TEMP_FAN_ON);
+    CHECK_EQ(def[CONFIG_AUTO_LIGHT_TIME], DEFAULT_AUTO_LIGHT_TIME);
+
+    host_flash_reset();
+    reboot();
+    values(got);
+    CHECK(same(got, def));
+    CHECK_EQ(config_seq, 1);
+    CHECK_EQ(config_write_pos, CONFIG_HEADER_SIZE + CONFIG_ITEM_COUNT * CONFIG_ENTRY_SIZE);
+    CHECK_EQ(host_flash_steps, 1 + 2 * CONFIG_ITEM_COUNT + 4);
+    CHECK_EQ(flash_owners, 0);
+    CHECK(!host_flash_unlocked());
+
+    host_flash_steps = 0;
+    reboot();
+    values(got);
+    CHECK(same(got, def));
+    CHECK_EQ(config_seq, 1);
+    CHECK_EQ(host_flash_steps, 0);                  // 已有日志时上电不写Flash
+
+    // 没有变化的保存不写入；超出范围的设置被拒绝
+    CHECK_EQ(Config_Save(), 0);
+    CHECK_EQ(Config_Set_U8(CONFIG_TEMP_FAN_ON, config_items[CONFIG_TEMP_FAN_ON].max_value + 1), 1);
+    CHECK_EQ(Config_Set_U16(CONFIG_AUTO_LIGHT_TIME, 1441), 1);
+    CHECK_EQ(Config_Save(), 0);
+    CHECK_EQ(host_flash_steps, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  旧格式整页配置上电时迁移到日志，旧页在下次整理前保留；旧格式没有的记录配额取默认值，
+ *         保留字段清零；校验和不符时使用默认配置
+ */
+static void test_legacy(void)
+{
+    SystemConfig_t legacy;
+    u16 got[CONFIG_ITEM_COUNT], def[CONFIG_ITEM_COUNT];
+
+    Config_Set_Defaults();
+    values(def);
+    legacy = system_config;
+    legacy.temp_fan_on = 41;
+    legacy.led_brightness = 7;
+    legacy.auto_light_time = 600;
+    legacy.log_operation_pages = 0;                 // 旧格式这两个字节是清零的保留字段
+    legacy.log_alarm_pages = 0;
+    memset(legacy.reserved, 0x5A, sizeof(legacy.reserved));
+    legacy.checksum = Config_Calculate_Checksum(&legacy);
+
+    host_flash_reset();
+    memcpy((void*)CONFIG_FLASH_ADDR, &legacy, sizeof(legacy));
+    reboot();
+    values(got);
+    CHECK_EQ(got[CONFIG_TEMP_FAN_ON], 41);
+    CHECK_EQ(got[CONFIG_LED_BRIGHTNESS], 7);
+    CHECK_EQ(got[CONFIG_AUTO_LIGHT_TIME], 600);
+    CHECK_EQ(got[CONFIG_LOG_OPERATION_PAGES], DEFAULT_LOG_OPERATION_PAGES);
+    CHECK_EQ(got[CONFIG_LOG_ALARM_PAGES], DEFAULT_LOG_ALARM_PAGES);
+    CHECK_EQ(system_config.reserved[0], 0);
+    CHECK_EQ(config_page, 1);
+    CHECK(memcmp((void*)CONFIG_FLASH_ADDR, &legacy, sizeof(legacy)) == 0);
+    reboot();
+    values(got);
+    CHECK_EQ(got[CONFIG_TEMP_FAN_ON], 41);
+    CHECK_EQ(got[CONFIG_AUTO_LIGHT_TIME], 600);
+    CHECK_EQ(got[CONFIG_LOG_OPERATION_PAGES], DEFAULT_LOG_OPERATION_PAGES);    // 迁移写入日志的也是默认配额
+    CHECK_EQ(got[CONFIG_LOG_ALARM_PAGES], DEFAULT_LOG_ALARM_PAGES);
+
+    legacy.checksum++;
+    host_flash_reset();
+    memcpy((void*)CONFIG_FLASH_ADDR, &legacy, sizeof(legacy));
+    reboot();
+    values(got);
+    CHECK(same(got, def));
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  随机修改并保存，定期重启比较回放结果；每次保存只追加有变化的参数，
+ *         一页写满才擦除另一页（原实现每次保存都擦除一页）
+ */
+static void test_replay(void)
+{
+    Save_t s;
+    u16 want[CONFIG_ITEM_COUNT], got[CONFIG_ITEM_COUNT];
+    u32 i, steps, entries = 0, erases = 0, bad_steps = 0, bad_replay = 0;
+    u16 seq;
+
+    host_flash_reset();
+    reboot();
+    for(i = 0; i < REPLAY_SAVES; i++)
+    {
+        random_save(&s, 1 + rand() % 3);
+        seq = config_seq;
+        steps = host_flash_steps;
+        run(&s);
+        steps = host_flash_steps - steps;
+        if(config_seq != seq)
+        {
+            CHECK_EQ((u16)(config_seq - seq), 1);
+            erases++;
+            if(steps > 2 * s.count + 1 + 2 * CONFIG_ITEM_COUNT + 4) bad_steps++;
+        }
+        else
+        {
+            if(steps != 2 * s.count) bad_steps++;
+            entries += s.count;
+        }
+
+        values(want);
+        if(i % 37 == 0 || config_seq != seq)
+        {
+            reboot();
+            values(got);
+            if(!same(got, want)) bad_replay++;
+        }
+        CHECK_EQ(flash_owners, 0);
+    }
+    CHECK_EQ(bad_steps, 0);
+    CHECK_EQ(bad_replay, 0);
+    CHECK(erases > 0);
+    CHECK(erases <= entries / (CONFIG_PAGE_ENTRIES - CONFIG_ITEM_COUNT - 3) + 1);
+    CHECK_EQ(host_flash_misuse, 0);
+    printf("replay: %u saves, %lu entries, %lu erases (%.1f per 1000 saves, was 1000)\n", REPLAY_SAVES,
+           (unsigned long)entries, (unsigned long)erases, erases * 1000.0 / REPLAY_SAVES);
+
+    // 编程失败：本次保存返回错误，失败的槽位跳过，下次保存重写该参数
+    random_save(&s, 2);
+    host_flash_fail_at(host_flash_steps + 3);
+    for(i = 0; i < s.count; i++) Config_Set_U16((ConfigItem_t)s.item[i], s.value[i]);
+    CHECK_EQ(Config_Save(), 1);
+    host_flash_fail_at(0);
+    CHECK_EQ(flash_owners, 0);
+    CHECK(!host_flash_unlocked());
+    values(want);
+    CHECK_EQ(Config_Save(), 0);
+    reboot();
+    values(got);
+    CHECK(same(got, want));
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  掉电重启后的参数：前d次保存完整，第d+1次保存中有变化的参数按顺序只有前若干项生效
+ */
+static u8 state_ok(const u16* got, u32 d)
+{
+    const u16* old = expected[d];
+    const u16* new = expected[d < W_SAVES ? d + 1 : d];
+    u8 i, prefix = 1;
+
+    for(i = 0; i < CONFIG_ITEM_COUNT; i++)
+    {
+        if(old[i] == new[i])
+        {
+            if(got[i] != old[i]) return 0;
+        }
+        else if(got[i] == new[i])
+        {
+            if(!prefix) return 0;
+        }
+        else if(got[i] == old[i])
+        {
+            prefix = 0;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief  掉电重启后继续修改两个参数并保存，再重启应完整回放
+ */
+static u8 check_resume(void)
+{
+    Save_t s;
+    u16 want[CONFIG_ITEM_COUNT], got[CONFIG_ITEM_COUNT];
+    u32 misuse = host_flash_misuse;
+
+    random_save(&s, 2);
+    run(&s);
+    values(want);
+    reboot();
+    values(got);
+    return same(got, want) && host_flash_misuse == misuse && flash_owners == 0;
+}
+
+static void run_w(u32 i)
+{
+    if(i == W_RESET)
+    {
+        CHECK_EQ(Config_Reset(), 0);
+        return;
+    }
+    run(&w[i]);
+}
+
+/**
+ * @brief  W中第k步编程/擦除到一半时掉电，重启后检查
+ * @param  seed: 加到步数上，改变中途掉电时留下的随机内容
+ * @retval 1-第k步是页擦除
+ */
+static u8 cut_at(u32 k, u32 seed)
+{
+    u16 got[CONFIG_ITEM_COUNT];
+    volatile u32 i, done = 0;
+    u8 in_erase;
+
+    memcpy((void*)HOST_FLASH_BASE, snapshot, HOST_FLASH_SIZE);
+    reboot();
+    host_flash_steps += seed;
+    host_power_cut_at(host_flash_steps + k);
+    if(setjmp(host_power_lost) == 0)
+    {
+        for(i = 0; i < W_SAVES; i++)
+        {
+            run_w(i);
+            done = i + 1;
+        }
+    }
+    host_power_cut_at(0);
+    in_erase = host_power_lost_in_erase;
+
+    reboot();
+    values(got);
+    if(!state_ok(got, done) || flash_owners != 0) bad_boot++;
+    if(!check_resume()) bad_resume++;
+    return in_erase;
+}
+
+/**
+ * @brief  每一步掉电：两页都写过日志、当前页只剩几个空槽，W中的保存要整理到另一页（擦除旧日志页）；
+ *         干跑记下每次保存后的参数，再从同一Flash内容出发在W的每一步掉电
+ */
+static void test_power_loss(void)
+{
+    static u8 erase_step[W_STEPS_MAX + 1];
+    Save_t s;
+    u32 i, k, t, base, total, cuts = 0, erase_cuts = 0;
+    u16 seq;
+
+    host_flash_reset();
+    reboot();
+    while(config_seq < 2 || config_write_pos + 10 * CONFIG_ENTRY_SIZE <= CONFIG_PAGE_SIZE)
+    {
+        random_save(&s, 1);
+        run(&s);
+    }
+    memcpy(snapshot, (void*)HOST_FLASH_BASE, HOST_FLASH_SIZE);
+
+    for(i = 0; i < W_SAVES; i++) w[i].count = 0;
+    reboot();
+    values(expected[0]);
+    seq = config_seq;
+    base = host_flash_steps;
+    for(i = 0; i < W_SAVES; i++)
+    {
+        if(i != W_RESET) random_save(&w[i], 1 + rand() % 4);
+        run_w(i);
+        values(expected[i + 1]);
+    }
+    total = host_flash_steps - base;
+    CHECK_EQ((u16)(config_seq - seq), 1);               // W中整理了一次
+    CHECK(config_write_pos > CONFIG_HEADER_SIZE + CONFIG_ITEM_COUNT * CONFIG_ENTRY_SIZE);  // 之后又追加了
+    CHECK(!same(expected[W_RESET], expected[W_RESET + 1]));
+    CHECK(total > 2 * CONFIG_ITEM_COUNT && total <= W_STEPS_MAX);
+    CHECK_EQ(host_flash_misuse, 0);
+
+    for(k = 1; k <= total && k <= W_STEPS_MAX; k++)
+    {
+        erase_step[k] = cut_at(k, 0);
+        cuts++;
+    }
+    for(k = 1; k <= total && k <= W_STEPS_MAX; k++)
+    {
+        if(!erase_step[k]) continue;
+        for(t = 1; t < ERASE_TRIALS; t++) cut_at(k, t * 7919);
+        erase_cuts++;
+    }
+    CHECK_EQ(cuts, total);
+    CHECK_EQ(erase_cuts, 1);
+    CHECK_EQ(bad_boot, 0);
+    CHECK_EQ(bad_resume, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+    printf("power: %lu steps, %lu erase steps x %u\n", (unsigned long)total,
+           (unsigned long)erase_cuts, ERASE_TRIALS);
+}
+
+/**
+ * @brief  首次上电和迁移旧格式时写第一个日志页中途掉电：重启后重新写入，参数不变
+ */
+static void test_power_loss_init(void)
+{
+    SystemConfig_t legacy;
+    u16 want[CONFIG_ITEM_COUNT], got[CONFIG_ITEM_COUNT];
+    u32 k, steps, bad = 0;
+    u8 pass;
+
+    for(pass = 0; pass < 2; pass++)
+    {
+        Config_Set_Defaults();
+        legacy = system_config;
+        legacy.humi_pump_on = 33;
+        legacy.checksum = Config_Calculate_Checksum(&legacy);
+        if(pass == 1) system_config = legacy;
+        values(want);
+
+        steps = 1 + 2 * CONFIG_ITEM_COUNT + 4;
+        for(k = 1; k <= steps; k++)
+        {
+            host_flash_reset();
+            if(pass == 1) memcpy((void*)CONFIG_FLASH_ADDR, &legacy, sizeof(legacy));
+            host_power_cut_at(k);
+            if(setjmp(host_power_lost) == 0) reboot();
+            host_power_cut_at(0);
+            reboot();
+            values(got);
+            if(!same(got, want) || config_page == CONFIG_NO_PAGE || flash_owners != 0) bad++;
+            if(!check_resume()) bad++;
+        }
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  蓝牙配置命令：CONFIG_SET只改RAM，CONFIG_SAVE后重启仍然有效，CONFIG_RESET恢复并保存默认值
+ */
+static void test_commands(void)
+{
+    char line[64];
+    u16 def[CONFIG_ITEM_COUNT];
+
+    Config_Set_Defaults();
+    values(def);
+    host_flash_reset();
+    reboot();
+
+    strcpy(line, "CONFIG_SET temp_fan_on 28");
+    Config_Handle_Command(line);
+    strcpy(line, "CONFIG_SET auto_light_time 900");
+    Config_Handle_Command(line);
+    CHECK_EQ(Config_Get_U8(CONFIG_TEMP_FAN_ON), 28);
+    reboot();
+    CHECK_EQ(Config_Get_U8(CONFIG_TEMP_FAN_ON), DEFAULT_TEMP_FAN_ON);
+
+    strcpy(line, "CONFIG_SET temp_fan_on 28");
+    Config_Handle_Command(line);
+    strcpy(line, "CONFIG_SET auto_light_time 900");
+    Config_Handle_Command(line);
+    strcpy(line, "CONFIG_SAVE");
+    Config_Handle_Command(line);
+    reboot();
+    CHECK_EQ(Config_Get_U8(CONFIG_TEMP_FAN_ON), 28);
+    CHECK_EQ(Config_Get_U16(CONFIG_AUTO_LIGHT_TIME), 900);
+
+    strcpy(line, "CONFIG_SET temp_fan_on 99");             // 超出范围
+    Config_Handle_Command(line);
+    CHECK_EQ(Config_Get_U8(CONFIG_TEMP_FAN_ON), 28);
+
+    strcpy(line, "CONFIG_RESET");
+    Config_Handle_Command(line);
+    reboot();
+    CHECK_EQ(Config_Get_U8(CONFIG_TEMP_FAN_ON), DEFAULT_TEMP_FAN_ON);
+    CHECK_EQ(Config_Get_U16(CONFIG_AUTO_LIGHT_TIME), DEFAULT_AUTO_LIGHT_TIME);
+    CHECK_EQ(flash_owners, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+int main(void)
+{
+    srand(25);
+    test_first_boot();
+    test_legacy();
+    test_commands();
+    test_replay();
+    test_power_loss();
+    test_power_loss_init();
+    return host_report("config");
+}
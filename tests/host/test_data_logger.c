@@ -0,0 +1,1041 @@
+/**
+ * @file   test_data_logger.c
+ * @brief  Flash数据记录器：启动恢复的统计与逐条扫描一致（含各环回绕）；
+ *         按时间范围查询与暴力筛选结果一致；长期写入下各页擦除次数均衡；
+ *         压缩记录的增量边界、往返还原和实际压缩率；写合并减少的编程/擦除次数，报警和掉电时立即写入，
+ *         掉电写入跨页时不擦除；
+ *         传感器环多次回绕后报警和操作记录全部保留；
+ *         打印记录和日统计在满日志上的栈峰值与条数无关，小于原records[100]/records[20]缓冲区的实现
+ * @note   直接包含data_logger.c以测试其中的静态函数；Flash内容由log_flash.c独立读出作为参照
+ */
+#include "host.h"
+#include "fakes.h"
+#include "log_flash.h"
+#include <stdarg.h>
+
+// 被测文件的打印经过这里：测量栈峰值时不格式化，只计被测函数自身的栈
+static u8 log_printf_quiet;
+
+static int log_printf(const char* fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if(log_printf_quiet) return 0;
+    va_start(ap, fmt);
+    n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+#define printf log_printf
+#include "../../APP/data_logger/data_logger.c"
+#undef printf
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#define SLOTS_MAX       (LOG_PAGE_COUNT * LOG_SLOTS_PER_PAGE)
+#define SAMPLES_MAX     (SLOTS_MAX * LOG_PACK_SAMPLES)
+
+static LogFlashSlot_t slots[SLOTS_MAX];
+static SensorLogRecord_t samples[SAMPLES_MAX];
+static u32 now;
+
+// 各环的全部记录按时间合并：时间相同时环号小的在前，同一环内保持写入顺序
+typedef struct
+{
+    LogRecord_t rec;
+    u8 ring;
+    u32 index;
+} Merged_t;
+
+static Merged_t merged[SAMPLES_MAX];
+static u32 merged_count;
+static LogRecord_t results[1024];
+
+static void advance(u32 seconds)
+{
+    now += seconds;
+    host_set_rtc(now);
+    system_time_ms += seconds * 1000;
+}
+
+/**
+ * @brief  清空Flash，按fake_config划分各环后启动
+ */
+static void fresh(void)
+{
+    host_flash_reset();
+    now = 1750000000;
+    host_set_rtc(now);
+    DataLogger_Init();
+}
+
+/**
+ * @brief  模拟运行：样本缓慢变化（大多可压缩，jumpy时常有突变），穿插操作和报警记录
+ */
+static void workload(u32 count, u32 op_every, u32 alarm_every, u8 jumpy)
+{
+    static int temp = 25, humi = 50, light = 60;
+    static u8 fan = 0;
+    u32 i;
+
+    for(i = 0; i < count; i++)
+    {
+        advance(1 + rand() % 12);
+        temp += rand() % 3 - 1;
+        humi += rand() % 5 - 2;
+        light += rand() % 9 - 4;
+        if(jumpy && rand() % 3 == 0) light += rand() % 61 - 30;
+        if(temp < 5) temp = 5;
+        if(temp > 45) temp = 45;
+        if(humi < 10) humi = 10;
+        if(humi > 95) humi = 95;
+        if(light < 0) light = 0;
+        if(light > 100) light = 100;
+        if(rand() % 101 == 0) fan = !fan;
+        DataLogger_WriteSensorData(temp, humi, light, fan, 0, 0, 1, 0);
+        if(op_every != 0 && i % op_every == 0) DataLogger_WriteOperation(fan ? OP_FAN_ON : OP_FAN_OFF, !fan, fan, 1);
+        if(alarm_every != 0 && i % alarm_every == 0) DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 1, light, 20);
+    }
+}
+
+/**
+ * @brief  逐条扫描Flash得到各类记录数和最旧/最新时间戳
+ */
+static void scan_counts(DataLoggerInfo_t* info)
+{
+    u32 n, i, k;
+    u8 r;
+
+    memset(info, 0, sizeof(*info));
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        n = log_flash_slots(r, slots, SLOTS_MAX);
+        if(n == 0) continue;
+        k = log_flash_expand(slots, n, samples, SAMPLES_MAX);
+        for(i = 0; i < k; i++)
+        {
+            switch(samples[i].log_type)
+            {
+                case LOG_TYPE_SENSOR:    info->sensor_records++;    break;
+                case LOG_TYPE_OPERATION: info->operation_records++; break;
+                case LOG_TYPE_ALARM:     info->alarm_records++;     break;
+            }
+        }
+        if(info->oldest_timestamp == 0 || samples[0].timestamp < info->oldest_timestamp)
+            info->oldest_timestamp = samples[0].timestamp;
+        if(samples[k - 1].timestamp > info->newest_timestamp)
+            info->newest_timestamp = samples[k - 1].timestamp;
+    }
+    info->total_records = info->sensor_records + info->operation_records + info->alarm_records;
+}
+
+static void check_info(const DataLoggerInfo_t* a, const DataLoggerInfo_t* b)
+{
+    CHECK_EQ(a->total_records, b->total_records);
+    CHECK_EQ(a->sensor_records, b->sensor_records);
+    CHECK_EQ(a->operation_records, b->operation_records);
+    CHECK_EQ(a->alarm_records, b->alarm_records);
+    CHECK_EQ(a->oldest_timestamp, b->oldest_timestamp);
+    CHECK_EQ(a->newest_timestamp, b->newest_timestamp);
+}
+
+/**
+ * @brief  启动恢复：各环多次回绕过程中反复重启，恢复的统计与运行时累计的统计、
+ *         逐条扫描Flash的结果都一致，写入位置不变
+ */
+static void test_boot(void)
+{
+    DataLoggerInfo_t run, boot, scan;
+    u8 round;
+
+    srand(11);
+    fresh();
+    for(round = 0; round < 16; round++)
+    {
+        workload(2500, 9, 37, 1);
+        DataLogger_Flush();
+        DataLogger_GetInfo(&run);
+        DataLogger_Init();
+        DataLogger_GetInfo(&boot);
+        scan_counts(&scan);
+        check_info(&boot, &run);
+        check_info(&boot, &scan);
+        CHECK_EQ(boot.current_page, run.current_page);
+        CHECK_EQ(boot.current_offset, run.current_offset);
+    }
+    // 各环都已回绕
+    CHECK(LOG_PAGE_HEADER(log_rings[LOG_RING_SENSOR].current_page)->seq > 2 * log_rings[LOG_RING_SENSOR].page_count);
+    CHECK(LOG_PAGE_HEADER(log_rings[LOG_RING_OPERATION].current_page)->seq > log_rings[LOG_RING_OPERATION].page_count);
+    CHECK(LOG_PAGE_HEADER(log_rings[LOG_RING_ALARM].current_page)->seq > log_rings[LOG_RING_ALARM].page_count);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  已封页只读页头：把非写入页的记录槽改坏后重启，统计不变，说明启动不逐条扫描这些页
+ */
+static void test_boot_reads_headers(void)
+{
+    DataLoggerInfo_t before, after;
+    LogRing_t* ring = &log_rings[LOG_RING_SENSOR];
+    u16 page, slot, n = 0;
+
+    DataLogger_GetInfo(&before);
+    for(page = ring->first_page; page < ring->first_page + ring->page_count; page++)
+    {
+        if(page == ring->current_page || LOG_PAGE_HEADER(page)->sealed != LOG_PAGE_SEALED) continue;
+        for(slot = LOG_HEADER_SLOTS; slot < LOG_SLOTS_PER_PAGE; slot++)
+            ((LogRecord_t*)LOG_SLOT_ADDR(page, slot))->raw_data[LOG_RECORD_SIZE - 1] ^= 0x5A;
+        n++;
+    }
+    CHECK(n >= ring->page_count - 2);
+    DataLogger_Init();
+    DataLogger_GetInfo(&after);
+    check_info(&after, &before);
+}
+
+static int merged_cmp(const void* a, const void* b)
+{
+    const Merged_t* x = (const Merged_t*)a;
+    const Merged_t* y = (const Merged_t*)b;
+
+    if(x->rec.sensor.timestamp != y->rec.sensor.timestamp)
+        return x->rec.sensor.timestamp < y->rec.sensor.timestamp ? -1 : 1;
+    if(x->ring != y->ring) return x->ring - y->ring;
+    return x->index < y->index ? -1 : 1;
+}
+
+static void build_merged(void)
+{
+    u32 n, k, i;
+    u8 r;
+
+    merged_count = 0;
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        n = log_flash_slots(r, slots, SLOTS_MAX);
+        k = log_flash_expand(slots, n, samples, SAMPLES_MAX);
+        for(i = 0; i < k; i++)
+        {
+            memcpy(merged[merged_count].rec.raw_data, &samples[i], LOG_RECORD_SIZE);
+            merged[merged_count].ring = r;
+            merged[merged_count].index = i;
+            merged_count++;
+        }
+    }
+    qsort(merged, merged_count, sizeof(Merged_t), merged_cmp);
+}
+
+static u8 type_match(const LogRecord_t* rec, u8 log_type)
+{
+    return log_type == 0 || rec->sensor.log_type == log_type;
+}
+
+/**
+ * @brief  随机时间窗口（含早于最旧、晚于最新和空窗口）和类型过滤：
+ *         DataLogger_Query从新到旧、游标从旧到新的结果都与对合并记录的暴力筛选一致
+ */
+static void test_query(void)
+{
+    static const u8 types[4] = {0, LOG_TYPE_SENSOR, LOG_TYPE_OPERATION, LOG_TYPE_ALARM};
+    LogQuery_t q;
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u32 lo, hi, span, i, k, expect, bad = 0, q_total = 0;
+    u16 n;
+    int j;
+
+    srand(12);
+    fresh();
+    workload(30000, 9, 37, 1);
+    DataLogger_Flush();
+    build_merged();
+    CHECK(merged_count > 8000);
+    lo = merged[0].rec.sensor.timestamp;
+    hi = merged[merged_count - 1].rec.sensor.timestamp;
+
+    for(i = 0; i < 600; i++)
+    {
+        span = (i % 3 == 0) ? rand() % 200 : rand() % ((hi - lo) / 4);
+        q.start_time = lo - 500 + rand() % (hi - lo + 1000);
+        q.end_time = (i % 50 == 0) ? q.start_time - 1 : q.start_time + span;
+        q.log_type = types[rand() % 4];
+        q.max_records = 1 + rand() % 1024;
+
+        // 从新到旧，取前max_records条
+        n = DataLogger_Query(&q, results, sizeof(results) / sizeof(results[0]));
+        expect = 0;
+        for(j = merged_count - 1; j >= 0 && expect < q.max_records; j--)
+        {
+            const LogRecord_t* m = &merged[j].rec;
+            if(m->sensor.timestamp < q.start_time || m->sensor.timestamp > q.end_time) continue;
+            if(!type_match(m, q.log_type)) continue;
+            if(expect >= n || memcmp(&results[expect], m, LOG_RECORD_SIZE) != 0) bad++;
+            expect++;
+        }
+        if(n != expect) bad++;
+        q_total += n;
+
+        // 从旧到新全部遍历
+        DataLogger_CursorOpen(&cursor, q.start_time, q.end_time, q.log_type, LOG_CURSOR_FORWARD);
+        for(k = 0; k < merged_count; k++)
+        {
+            const LogRecord_t* m = &merged[k].rec;
+            if(m->sensor.timestamp < q.start_time || m->sensor.timestamp > q.end_time) continue;
+            if(!type_match(m, q.log_type)) continue;
+            rec = DataLogger_CursorNext(&cursor);
+            if(rec == 0 || memcmp(rec, m, LOG_RECORD_SIZE) != 0) bad++;
+        }
+        if(DataLogger_CursorNext(&cursor) != 0) bad++;
+        DataLogger_CursorClose(&cursor);
+    }
+    CHECK_EQ(bad, 0);
+    CHECK(q_total > 10000);
+    CHECK_EQ(log_busy, 0);
+}
+
+/**
+ * @brief  长期写入（传感器环回绕数十次，样本不可压缩）：每个环内各页擦除次数相差不超过1，
+ *         擦除次数重启后保持；跨回绕从旧到新遍历与逐条扫描一致。HOST_VERBOSE=1时打印各页擦除次数
+ */
+static void test_wear(void)
+{
+    DataLoggerInfo_t info;
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    u32 counts[LOG_PAGE_COUNT];
+    u32 i, lo, hi, wraps, bad = 0;
+    u16 page;
+    u8 r;
+
+    srand(14);
+    fresh();
+    for(i = 0; i < 40 * 25 * (LOG_SLOTS_PER_PAGE - LOG_HEADER_SLOTS); i++)
+    {
+        advance(60);
+        // 光照来回跳变，每个样本单独占一条记录
+        DataLogger_WriteSensorData(25, 50, (i & 1) ? 90 : 10, 0, 0, 0, 1, 0);
+        if(rand() % 7 == 0) DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+        if(rand() % 11 == 0) DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 1, 10, 20);
+    }
+    DataLogger_Flush();
+
+    for(page = 0; page < LOG_PAGE_COUNT; page++) counts[page] = DataLogger_GetEraseCount(page);
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        LogRing_t* ring = &log_rings[r];
+
+        lo = 0xFFFFFFFF;
+        hi = 0;
+        printf("ring %u erase:", r);
+        for(page = ring->first_page; page < ring->first_page + ring->page_count; page++)
+        {
+            if(counts[page] < lo) lo = counts[page];
+            if(counts[page] > hi) hi = counts[page];
+            printf(" %lu", (unsigned long)counts[page]);
+        }
+        printf("\n");
+        wraps = LOG_PAGE_HEADER(ring->current_page)->seq / ring->page_count;
+        CHECK(hi - lo <= 1);
+        CHECK(wraps >= 10);
+        CHECK(lo + 1 >= wraps);
+        CHECK(hi <= wraps + 1);
+    }
+    CHECK(counts[log_rings[LOG_RING_SENSOR].first_page] >= 39);
+
+    // 重启后擦除次数不变，统计与扫描一致
+    DataLogger_Init();
+    for(page = 0; page < LOG_PAGE_COUNT; page++)
+        if(DataLogger_GetEraseCount(page) != counts[page]) bad++;
+    CHECK_EQ(bad, 0);
+    build_merged();
+    DataLogger_GetInfo(&info);
+    CHECK_EQ(info.total_records, merged_count);
+    CHECK_EQ(info.oldest_timestamp, merged[0].rec.sensor.timestamp);
+    CHECK_EQ(info.newest_timestamp, merged[merged_count - 1].rec.sensor.timestamp);
+
+    DataLogger_CursorOpen(&cursor, 0, 0xFFFFFFFF, 0, LOG_CURSOR_FORWARD);
+    for(i = 0; i < merged_count; i++)
+    {
+        rec = DataLogger_CursorNext(&cursor);
+        if(rec == 0 || memcmp(rec, &merged[i].rec, LOG_RECORD_SIZE) != 0) bad++;
+    }
+    CHECK(DataLogger_CursorNext(&cursor) == 0);
+    DataLogger_CursorClose(&cursor);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+static void make_sample(SensorLogRecord_t* s, u32 ts, u8 temp, u8 humi, u8 light)
+{
+    memset(s, 0, sizeof(*s));
+    s->timestamp = ts;
+    s->log_type = LOG_TYPE_SENSOR;
+    s->temperature = temp;
+    s->humidity = humi;
+    s->light = light;
+    s->fan_status = 1;
+    s->work_mode = 1;
+}
+
+// 以base开始一条压缩记录，再追加s，返回是否追加成功
+static u8 pack_pair(const SensorLogRecord_t* base, const SensorLogRecord_t* s)
+{
+    LogRecord_t rec;
+
+    DataLogger_PackStart(&rec, base);
+    return DataLogger_PackAppend(&rec.pack, s);
+}
+
+/**
+ * @brief  压缩格式边界：各增量范围端点内外、状态变化、记录已满、增量编码为0xFFFF、
+ *         不能压缩的首样本
+ */
+static void test_pack_bounds(void)
+{
+    SensorLogRecord_t base, s;
+    LogRecord_t rec;
+    u8 i;
+
+    make_sample(&base, 1000, 20, 50, 60);
+    CHECK(DataLogger_PackStart(&rec, &base));
+
+    make_sample(&s, 1001, 20, 50, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1016, 20, 50, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1017, 20, 50, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1000, 20, 50, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 999, 20, 50, 60);   CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 16, 50, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 15, 50, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 23, 50, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 24, 50, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 42, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 41, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 57, 60);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 58, 60);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 44);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 43);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 75);  CHECK(pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 76);  CHECK(!pack_pair(&base, &s));
+
+    // 增量全为最大/-1时编码为0xFFFF，与未使用标志冲突
+    make_sample(&s, 1016, 19, 49, 59);  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1015, 19, 49, 59);  CHECK(pack_pair(&base, &s));
+
+    // 设备状态、工作模式、报警标志变化
+    make_sample(&s, 1001, 20, 50, 60);  s.fan_status = 0;   CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 60);  s.pump_status = 1;  CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 60);  s.light_status = 1; CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 60);  s.work_mode = 0;    CHECK(!pack_pair(&base, &s));
+    make_sample(&s, 1001, 20, 50, 60);  s.alarm_flags = 1;  CHECK(!pack_pair(&base, &s));
+
+    // 记录已满
+    DataLogger_PackStart(&rec, &base);
+    for(i = 1; i < LOG_PACK_SAMPLES; i++)
+    {
+        make_sample(&s, 1000 + i, 20, 50, 60);
+        CHECK(DataLogger_PackAppend(&rec.pack, &s));
+    }
+    make_sample(&s, 1000 + i, 20, 50, 60);
+    CHECK(!DataLogger_PackAppend(&rec.pack, &s));
+    CHECK_EQ(DataLogger_PackCount(&rec.pack), LOG_PACK_SAMPLES);
+
+    // 首样本超出压缩格式
+    make_sample(&s, 1000, 20, 128, 60);  CHECK(!DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 50, 128);  CHECK(!DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 127, 127); CHECK(DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 50, 60);   s.alarm_flags = 0x40;  CHECK(!DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 50, 60);   s.alarm_flags = 0x3F;  CHECK(DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 50, 60);   s.fan_status = 2;      CHECK(!DataLogger_PackStart(&rec, &s));
+    make_sample(&s, 1000, 20, 50, 60);   s.work_mode = 2;       CHECK(!DataLogger_PackStart(&rec, &s));
+}
+
+/**
+ * @brief  随机样本序列：追加成功与否和按格式计算的结果一致，展开后逐字节还原
+ */
+static void test_pack_roundtrip(void)
+{
+    SensorLogRecord_t in[LOG_PACK_SAMPLES], out[LOG_PACK_SAMPLES], s;
+    LogRecord_t rec;
+    s32 dt, dtemp, dhumi, dlight;
+    u32 i, bad = 0, appended = 0;
+    u8 n = 0, fits;
+
+    srand(15);
+    for(i = 0; i < 200000; i++)
+    {
+        if(i % 5 == 0)
+        {
+            make_sample(&in[0], rand(), rand() % 256, rand() % 128, rand() % 128);
+            in[0].fan_status = rand() & 1;
+            in[0].pump_status = rand() & 1;
+            in[0].light_status = rand() & 1;
+            in[0].work_mode = rand() & 1;
+            in[0].alarm_flags = rand() & 0x3F;
+            DataLogger_PackStart(&rec, &in[0]);
+            n = 1;
+        }
+        dt = rand() % 20 - 2;
+        dtemp = rand() % 10 - 5;
+        dhumi = rand() % 20 - 10;
+        dlight = rand() % 36 - 18;
+        s = in[n - 1];
+        s.timestamp += dt;
+        s.temperature += dtemp;
+        s.humidity += dhumi;
+        s.light += dlight;
+        if(rand() % 20 == 0) s.pump_status ^= 1;
+        dtemp = (s32)s.temperature - in[n - 1].temperature;
+        dhumi = (s32)s.humidity - in[n - 1].humidity;
+        dlight = (s32)s.light - in[n - 1].light;
+        fits = n < LOG_PACK_SAMPLES && s.pump_status == in[0].pump_status &&
+               dt >= 1 && dt <= 16 && dtemp >= -4 && dtemp <= 3 && dhumi >= -8 && dhumi <= 7 &&
+               dlight >= -16 && dlight <= 15 && !(dt == 16 && dtemp == -1 && dhumi == -1 && dlight == -1);
+        if(DataLogger_PackAppend(&rec.pack, &s) != fits) bad++;
+        if(fits)
+        {
+            in[n++] = s;
+            appended++;
+        }
+        if(DataLogger_PackUnpack(&rec.pack, out) != n || memcmp(out, in, n * sizeof(SensorLogRecord_t)) != 0) bad++;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK(appended > 10000);
+}
+
+/**
+ * @brief  实际运行轨迹（5秒一个样本，温湿度光照缓慢变化，偶有设备切换）经写入接口存入Flash，
+ *         游标读回与写入的样本完全一致，压缩率大于3（HOST_VERBOSE=1时打印）
+ */
+static void test_pack_trace(void)
+{
+    static SensorLogRecord_t trace[8000];
+    LogCursor_t cursor;
+    const LogRecord_t* rec;
+    int temp = 24, humi = 60, light = 40;
+    u8 fan = 0;
+    u32 i, n, bad = 0;
+
+    srand(16);
+    fresh();
+    for(i = 0; i < 8000; i++)
+    {
+        advance(5);
+        if(rand() % 4 == 0) temp += rand() % 3 - 1;
+        if(rand() % 2 == 0) humi += rand() % 3 - 1;
+        light += rand() % 5 - 2;
+        if(temp < 5) temp = 5;
+        if(humi < 20) humi = 20;
+        if(humi > 95) humi = 95;
+        if(light < 0) light = 0;
+        if(light > 100) light = 100;
+        if(rand() % 300 == 0) fan = !fan;
+        make_sample(&trace[i], now, temp, humi, light);
+        trace[i].fan_status = fan;
+        DataLogger_WriteSensorData(temp, humi, light, fan, 0, 0, 1, 0);
+    }
+    DataLogger_Flush();
+
+    DataLogger_CursorOpen(&cursor, 0, 0xFFFFFFFF, LOG_TYPE_SENSOR, LOG_CURSOR_FORWARD);
+    for(i = 0; i < 8000; i++)
+    {
+        rec = DataLogger_CursorNext(&cursor);
+        if(rec == 0 || memcmp(rec, &trace[i], LOG_RECORD_SIZE) != 0) bad++;
+    }
+    CHECK(DataLogger_CursorNext(&cursor) == 0);
+    DataLogger_CursorClose(&cursor);
+    CHECK_EQ(bad, 0);
+
+    n = log_flash_slots(LOG_RING_SENSOR, slots, SLOTS_MAX);
+    printf("pack: %u samples in %lu records, ratio %.2f\n", 8000, (unsigned long)n, 8000.0 / n);
+    CHECK(n * 3 < 8000);
+}
+
+/**
+ * @brief  按固定轨迹写入3000条传感器记录，穿插操作和报警记录，传感器环不回绕
+ * @param  staged: 0-每条记录写入后立即写入Flash（暂存区不合并记录，即暂存前的写入方式）
+ */
+static void staging_run(u8 staged, DataLoggerInfo_t* info)
+{
+    int temp = 24, humi = 60, light = 40;
+    u32 i;
+
+    // 记录区先写满旧数据（页头无效），每打开一页都要擦除
+    srand(13);
+    host_flash_reset();
+    memset((void*)FLASH_START_ADDR, 0, LOG_PAGE_COUNT * FLASH_PAGE_SIZE);
+    now = 1750000000;
+    host_set_rtc(now);
+    DataLogger_Init();
+    for(i = 0; i < 3000; i++)
+    {
+        advance(5);
+        if(rand() % 4 == 0) temp += rand() % 3 - 1;
+        if(rand() % 2 == 0) humi += rand() % 3 - 1;
+        light += rand() % 5 - 2;
+        if(temp < 5) temp = 5;
+        if(humi < 20) humi = 20;
+        if(humi > 95) humi = 95;
+        if(light < 0) light = 0;
+        if(light > 100) light = 100;
+        DataLogger_WriteSensorData(temp, humi, light, 0, 0, 0, 1, 0);
+        if(!staged) DataLogger_Flush();
+        if(i % 20 == 0)
+        {
+            DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+            if(!staged) DataLogger_Flush();
+        }
+        if(i % 500 == 0) DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 1, light, 20);
+    }
+    DataLogger_Flush();
+    scan_counts(info);
+}
+
+/**
+ * @brief  写合并：同一组记录在暂存合并下的半字编程和页擦除次数都明显少于逐条写入，
+ *         Flash中的记录相同（HOST_VERBOSE=1时打印两种方式的次数）
+ */
+static void test_staging(void)
+{
+    DataLoggerInfo_t direct, staged;
+    u32 programs, erases;
+
+    staging_run(0, &direct);
+    programs = host_flash_programs;
+    erases = host_flash_erases;
+    staging_run(1, &staged);
+    check_info(&staged, &direct);
+    CHECK_EQ(staged.sensor_records, 3000);
+    CHECK_EQ(staged.alarm_records, 6);
+    printf("staging: %lu/%lu half-word programs, %lu/%lu page erases (staged/direct)\n",
+           (unsigned long)host_flash_programs, (unsigned long)programs,
+           (unsigned long)host_flash_erases, (unsigned long)erases);
+    CHECK(host_flash_programs * 2 < programs);
+    CHECK(host_flash_erases * 2 < erases);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  报警记录和掉电中断立即写入暂存记录；Flash被占用时掉电中断只置位请求，
+ *         由最外层释放完成
+ */
+static void test_forced_flush(void)
+{
+    DataLoggerInfo_t info;
+    u32 programs;
+
+    fresh();
+    programs = host_flash_programs;     // 启动时预擦除空环的第一页（写入擦除计数）
+    advance(5);
+    DataLogger_WriteSensorData(25, 50, 60, 0, 0, 0, 1, 0);
+    DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+    CHECK_EQ(log_stage_count, 2);
+    CHECK_EQ(host_flash_programs, programs);
+
+    // 报警记录连同之前暂存的记录一起写入
+    advance(5);
+    DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 1, 10, 20);
+    CHECK_EQ(log_stage_count, 0);
+    CHECK(host_flash_programs > 0);
+    scan_counts(&info);
+    CHECK_EQ(info.total_records, 3);
+
+    // 掉电中断
+    advance(5);
+    DataLogger_WriteSensorData(25, 50, 60, 0, 0, 0, 1, 0);
+    programs = host_flash_programs;
+    EXTI->PR = EXTI_Line16;
+    PVD_IRQHandler();
+    CHECK_EQ(log_stage_count, 0);
+    CHECK(host_flash_programs > programs);
+    scan_counts(&info);
+    CHECK_EQ(info.sensor_records, 2);
+
+    // 占用期间（如游标持有记录区指针）掉电：释放时写入
+    advance(5);
+    DataLogger_WriteOperation(OP_FAN_OFF, 1, 0, 1);
+    programs = host_flash_programs;
+    DataLogger_Acquire();
+    EXTI->PR = EXTI_Line16;
+    PVD_IRQHandler();
+    CHECK_EQ(log_stage_count, 1);
+    CHECK_EQ(host_flash_programs, programs);
+    DataLogger_Release();
+    CHECK_EQ(log_stage_count, 0);
+    CHECK(host_flash_programs > programs);
+    scan_counts(&info);
+    CHECK_EQ(info.operation_records, 2);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  掉电中断写入跨页时只编程不擦除：写入页写满后打开已预擦除的下一页；
+ *         下一页未就绪（这里直接写脏）时放弃跨页的记录，之前的记录照常写入；
+ *         回到正常写入后擦除脏页并恢复预擦除
+ */
+static void test_pvd_no_erase(void)
+{
+    LogRing_t* ring = &log_rings[LOG_RING_OPERATION];
+    DataLoggerInfo_t info, scan;
+    u32 erases, ops;
+    u16 next;
+    u8 i;
+
+    // 操作环先回绕：正常写入跨页后要擦除最旧页
+    fresh();
+    while(LOG_PAGE_HEADER(ring->current_page)->seq < ring->page_count ||
+          ring->current_offset != LOG_SLOTS_PER_PAGE - 2)
+    {
+        advance(1);
+        DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+        DataLogger_Flush();
+    }
+    next = DataLogger_RingPage(ring, ring->current_page, 1);
+    CHECK(ring->next_ready);
+    CHECK(DataLogger_PageBlank(next));
+
+    // 5条记录跨过页尾：2条写入当前页，3条写入预擦除的下一页
+    scan_counts(&info);
+    ops = info.operation_records;
+    erases = host_flash_erases;
+    for(i = 0; i < 5; i++)
+    {
+        advance(1);
+        DataLogger_WriteOperation(OP_FAN_OFF, 1, i, 1);
+    }
+    EXTI->PR = EXTI_Line16;
+    PVD_IRQHandler();
+    CHECK_EQ(log_stage_count, 0);
+    CHECK_EQ(host_flash_erases, erases);
+    CHECK_EQ(ring->current_page, next);
+    CHECK(!ring->next_ready);
+    scan_counts(&info);
+    CHECK_EQ(info.operation_records, ops + 5);
+
+    // 正常写入后恢复预擦除
+    advance(1);
+    DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+    DataLogger_Flush();
+    CHECK(ring->next_ready);
+
+    // 下一页不是空页：掉电中断不擦除，跨页的3条记录放弃
+    while(ring->current_offset != LOG_SLOTS_PER_PAGE - 2)
+    {
+        advance(1);
+        DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+        DataLogger_Flush();
+    }
+    next = DataLogger_RingPage(ring, ring->current_page, 1);
+    *(volatile u32*)LOG_PAGE_ADDR(next) = 0x12345678;      // 页头里的半截内容
+    scan_counts(&info);
+    ops = info.operation_records;
+    erases = host_flash_erases;
+    for(i = 0; i < 5; i++)
+    {
+        advance(1);
+        DataLogger_WriteOperation(OP_FAN_OFF, 1, i, 1);
+    }
+    DataLogger_Acquire();
+    EXTI->PR = EXTI_Line16;
+    PVD_IRQHandler();
+    CHECK_EQ(log_stage_count, 5);
+    DataLogger_Release();           // 推迟到释放时的写入同样不擦除
+    CHECK_EQ(log_stage_count, 0);
+    CHECK_EQ(host_flash_erases, erases);
+    scan_counts(&info);
+    CHECK_EQ(info.operation_records, ops + 2);
+    DataLogger_GetInfo(&info);
+    CHECK_EQ(info.operation_records, ops + 2);
+
+    // 正常写入时擦除脏页后开页
+    advance(1);
+    DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1);
+    DataLogger_Flush();
+    CHECK(host_flash_erases > erases);
+    CHECK_EQ(ring->current_page, next);
+    CHECK_EQ(ring->current_offset, LOG_HEADER_SLOTS + 1);
+    CHECK(ring->next_ready);
+    scan_counts(&info);
+    DataLogger_GetInfo(&scan);
+    check_info(&scan, &info);
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+/**
+ * @brief  传感器环回绕十次，其间稀少的报警和操作记录全部保留，按类型查询只访问对应的环
+ *         （查询期间传感器环设为不可访问）；修改各环页数后重启，统计与Flash一致并可继续写入
+ */
+static void test_retention(void)
+{
+    static LogRecord_t alarms[400], ops[400];
+    LogQuery_t q;
+    DataLoggerInfo_t info, scan;
+    LogRing_t* sensor = &log_rings[LOG_RING_SENSOR];
+    u32 i, n, k, n_alarm = 0, n_op = 0, bad = 0, guard;
+    u16 got;
+
+    srand(20);
+    fresh();
+    for(i = 0; i < (10 * 25 + 1) * LOG_RECORDS_PER_PAGE; i++)
+    {
+        advance(5);
+        DataLogger_WriteSensorData(25, 50, (i & 1) ? 90 : 10, 0, 0, 0, 1, 0);
+        if(i % 150 == 75)
+        {
+            memset(&alarms[n_alarm], 0, sizeof(LogRecord_t));
+            alarms[n_alarm].alarm.timestamp = now;
+            alarms[n_alarm].alarm.log_type = LOG_TYPE_ALARM;
+            alarms[n_alarm].alarm.alarm_type = ALARM_LOW_LIGHT_LOG;
+            alarms[n_alarm].alarm.alarm_level = 3;
+            alarms[n_alarm].alarm.trigger_value = n_alarm;
+            alarms[n_alarm].alarm.threshold = 20;
+            DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 3, n_alarm, 20);
+            n_alarm++;
+        }
+        if(i % 90 == 0)
+        {
+            memset(&ops[n_op], 0, sizeof(LogRecord_t));
+            ops[n_op].operation.timestamp = now;
+            ops[n_op].operation.log_type = LOG_TYPE_OPERATION;
+            ops[n_op].operation.operation = OP_PUMP_ON;
+            ops[n_op].operation.old_value = n_op & 1;
+            ops[n_op].operation.new_value = n_op;
+            ops[n_op].operation.trigger_mode = 2;
+            DataLogger_WriteOperation(OP_PUMP_ON, n_op & 1, n_op, 2);
+            n_op++;
+        }
+    }
+    DataLogger_Flush();
+    CHECK(LOG_PAGE_HEADER(sensor->current_page)->seq >= 10 * sensor->page_count);
+    CHECK(n_alarm > 200 && n_op > 300);
+
+    // Flash中的报警环和操作环恰为全部提交的记录
+    n = log_flash_slots(LOG_RING_ALARM, slots, SLOTS_MAX);
+    CHECK_EQ(n, n_alarm);
+    for(k = 0; k < n && k < n_alarm; k++)
+        if(memcmp(&slots[k].rec, &alarms[k], LOG_RECORD_SIZE - 1) != 0) bad++;
+    n = log_flash_slots(LOG_RING_OPERATION, slots, SLOTS_MAX);
+    CHECK_EQ(n, n_op);
+    for(k = 0; k < n && k < n_op; k++)
+        if(memcmp(&slots[k].rec, &ops[k], LOG_RECORD_SIZE - 1) != 0) bad++;
+    DataLogger_GetInfo(&info);
+    CHECK_EQ(info.alarm_records, n_alarm);
+    CHECK_EQ(info.operation_records, n_op);
+
+    // 按类型查询时传感器环不可访问
+    guard = (sensor->page_count * FLASH_PAGE_SIZE) & ~0xFFFu;
+    CHECK(mprotect((void*)LOG_PAGE_ADDR(sensor->first_page), guard, PROT_NONE) == 0);
+    q.start_time = 0;
+    q.end_time = 0xFFFFFFFF;
+    q.log_type = LOG_TYPE_ALARM;
+    q.max_records = 1024;
+    got = DataLogger_Query(&q, results, 1024);
+    CHECK_EQ(got, n_alarm);
+    for(k = 0; k < got && k < n_alarm; k++)
+        if(memcmp(&results[k], &alarms[n_alarm - 1 - k], LOG_RECORD_SIZE - 1) != 0) bad++;
+    q.log_type = LOG_TYPE_OPERATION;
+    got = DataLogger_Query(&q, results, 1024);
+    CHECK_EQ(got, n_op);
+    for(k = 0; k < got && k < n_op; k++)
+        if(memcmp(&results[k], &ops[n_op - 1 - k], LOG_RECORD_SIZE - 1) != 0) bad++;
+    mprotect((void*)LOG_PAGE_ADDR(sensor->first_page), guard, PROT_READ | PROT_WRITE);
+    CHECK_EQ(bad, 0);
+
+    // 修改各环页数：划分之外和序号不连续的页被回收，统计与Flash一致，继续写入正常
+    fake_config[CONFIG_LOG_OPERATION_PAGES] = 6;
+    fake_config[CONFIG_LOG_ALARM_PAGES] = 5;
+    DataLogger_Init();
+    CHECK_EQ(sensor->page_count, LOG_PAGE_COUNT - 11);
+    DataLogger_GetInfo(&info);
+    scan_counts(&scan);
+    check_info(&info, &scan);
+    workload(5000, 20, 40, 1);
+    DataLogger_Flush();
+    DataLogger_GetInfo(&info);
+    scan_counts(&scan);
+    check_info(&info, &scan);
+    DataLogger_Init();
+    DataLogger_GetInfo(&scan);
+    check_info(&info, &scan);
+    CHECK_EQ(host_flash_misuse, 0);
+    fake_config[CONFIG_LOG_OPERATION_PAGES] = 0;
+    fake_config[CONFIG_LOG_ALARM_PAGES] = 0;
+}
+
+/* ===== 栈峰值：在涂色的独立栈上运行被测函数，从栈底找第一个被改写的字节 ===== */
+
+#define STACK_SIZE      (64 * 1024)
+#define STACK_PAINT     0xA5
+
+static u8 stack_area[STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t stack_main, stack_probe;
+static void (*stack_fn)(void);
+
+static void stack_entry(void)
+{
+    stack_fn();
+}
+
+/**
+ * @brief  在涂色的栈上运行fn，返回其使用的栈字节数（含stack_entry本身的帧）
+ */
+static u32 stack_peak(void (*fn)(void))
+{
+    u32 i;
+
+    memset(stack_area, STACK_PAINT, sizeof(stack_area));
+    stack_fn = fn;
+    getcontext(&stack_probe);
+    stack_probe.uc_stack.ss_sp = stack_area;
+    stack_probe.uc_stack.ss_size = sizeof(stack_area);
+    stack_probe.uc_link = &stack_main;
+    makecontext(&stack_probe, stack_entry, 0);
+    swapcontext(&stack_main, &stack_probe);
+    for(i = 0; i < sizeof(stack_area) && stack_area[i] == STACK_PAINT; i++);
+    return sizeof(stack_area) - i;
+}
+
+static u32 stack_day;
+static u16 stack_count;
+static u8 stack_avg[3];
+static u16 stack_ops;
+
+/**
+ * @brief  原日统计：查询当天的最多100条记录到栈上的缓冲区再求平均
+ */
+static void old_daily_stats(void)
+{
+    LogQuery_t query;
+    LogRecord_t records[100];
+    u32 temp_sum = 0, humi_sum = 0, light_sum = 0;
+    u16 found, sensor_count = 0, i;
+
+    query.start_time = stack_day;
+    query.end_time = stack_day + 86400;
+    query.log_type = 0;
+    query.max_records = 100;
+    found = DataLogger_Query(&query, records, 100);
+    stack_ops = 0;
+    for(i = 0; i < found; i++)
+    {
+        if(records[i].sensor.log_type == LOG_TYPE_SENSOR)
+        {
+            temp_sum += records[i].sensor.temperature;
+            humi_sum += records[i].sensor.humidity;
+            light_sum += records[i].sensor.light;
+            sensor_count++;
+        }
+        else if(records[i].operation.log_type == LOG_TYPE_OPERATION)
+        {
+            stack_ops++;
+        }
+    }
+    stack_avg[0] = sensor_count ? temp_sum / sensor_count : 0;
+    stack_avg[1] = sensor_count ? humi_sum / sensor_count : 0;
+    stack_avg[2] = sensor_count ? light_sum / sensor_count : 0;
+}
+
+/**
+ * @brief  原打印记录：最多20条查询到栈上的缓冲区再逐条打印
+ */
+static void old_print_records(void)
+{
+    LogQuery_t query;
+    LogRecord_t records[20];
+    RTC_Time_t time;
+    u16 found, i;
+
+    log_printf("--- Last %d Records ---\r\n", stack_count);
+    query.start_time = 0;
+    query.end_time = 0xFFFFFFFF;
+    query.log_type = 0;
+    query.max_records = stack_count > 20 ? 20 : stack_count;
+    found = DataLogger_Query(&query, records, 20);
+    for(i = 0; i < found; i++)
+    {
+        DataLogger_ToTime(records[i].sensor.timestamp, &time);
+        log_printf("[%04d-%02d-%02d %02d:%02d:%02d] ",
+               time.year, time.month, time.date, time.hour, time.min, time.sec);
+        log_printf("Sensor: T=%dC H=%d%% L=%d%% F=%d P=%d Li=%d M=%d A=0x%02X\r\n",
+               records[i].sensor.temperature, records[i].sensor.humidity,
+               records[i].sensor.light, records[i].sensor.fan_status,
+               records[i].sensor.pump_status, records[i].sensor.light_status,
+               records[i].sensor.work_mode, records[i].sensor.alarm_flags);
+    }
+    log_printf("==================\r\n");
+}
+
+static void new_daily_stats(void)
+{
+    DataLogger_GetDailyStats(stack_day, &stack_avg[0], &stack_avg[1], &stack_avg[2], &stack_ops);
+}
+
+static void new_print_records(void)
+{
+    DataLogger_PrintRecords(stack_count);
+}
+
+/**
+ * @brief  满日志（传感器环已回绕）上的栈峰值（不含printf）：打印20条和打印全部记录相同，
+ *         日统计读汇总和扫描当天记录都小于原实现，差值至少为原缓冲区大小减去游标
+ */
+static void test_stack(void)
+{
+    DataLoggerInfo_t info;
+    u32 print_20, print_all, old_print, daily_rollup, daily_scan, old_daily;
+
+    srand(17);
+    fresh();
+    workload(LOG_PAGE_COUNT * LOG_RECORDS_PER_PAGE * 3, 20, 500, 1);
+    DataLogger_Flush();
+    DataLogger_GetInfo(&info);
+    CHECK(LOG_PAGE_HEADER(log_rings[LOG_RING_SENSOR].current_page)->seq >= log_rings[LOG_RING_SENSOR].page_count);
+    stack_day = now - now % 86400;
+
+    log_printf_quiet = 1;
+    stack_count = 20;
+    print_20 = stack_peak(new_print_records);
+    stack_count = 0xFFFF;
+    print_all = stack_peak(new_print_records);
+    stack_count = 20;
+    old_print = stack_peak(old_print_records);
+    daily_rollup = stack_peak(new_daily_stats);
+    DataRollup_EraseAll();
+    daily_scan = stack_peak(new_daily_stats);
+    CHECK(stack_ops > 0);
+    old_daily = stack_peak(old_daily_stats);
+    log_printf_quiet = 0;
+
+    CHECK(print_20 > 0 && print_20 < STACK_SIZE);
+    CHECK_EQ(print_all, print_20);
+    CHECK(print_20 + 20 * sizeof(LogRecord_t) - sizeof(LogCursor_t) <= old_print);
+    CHECK(daily_rollup < old_daily);
+    CHECK(daily_scan + 100 * sizeof(LogRecord_t) - sizeof(LogCursor_t) <= old_daily);
+    CHECK(daily_scan < 1024);
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "data_logger stack: print %lu/%lu (all %lu records) vs old %lu, "
+                "daily rollup %lu scan %lu vs old records[100] %lu bytes\n",
+                (unsigned long)print_20, (unsigned long)print_all,
+                (unsigned long)(info.sensor_records + info.operation_records + info.alarm_records),
+                (unsigned long)old_print, (unsigned long)daily_rollup, (unsigned long)daily_scan,
+                (unsigned long)old_daily);
+}
+
+int main(void)
+{
+    test_boot();
+    test_boot_reads_headers();
+    test_query();
+    test_wear();
+    test_pack_bounds();
+    test_pack_roundtrip();
+    test_pack_trace();
+    test_staging();
+    test_forced_flush();
+    test_pvd_no_erase();
+    test_retention();
+    test_stack();
+    return host_report("data_logger");
+}
@@ -0,0 +1,209 @@
+/**
+ * @file   test_dht11.c
+ * @brief  DHT11下降沿解码：由协议时序合成下降沿时间戳，检查正常帧、校验和错、应答和数据位
+ *         脉宽越界、帧不完整；并经TIM6/EXTI15_10中断处理函数走一遍异步采集
+ */
+#include "host.h"
+#include "dht11.h"
+#include <string.h>
+
+#define WIDTH_0     78          // 50us低 + 28us高
+#define WIDTH_1     120         // 50us低 + 70us高
+#define WIDTH_ACK   160         // 80us低 + 80us高
+
+void TIM6_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+
+/**
+ * @brief  5字节数据 -> 42个下降沿时间戳，起点为t0
+ */
+static void make_edges(u16* edges, u16 t0, const u8* data)
+{
+    u8 i;
+
+    edges[0] = t0;
+    edges[1] = t0 + WIDTH_ACK;
+    for(i = 0; i < 40; i++)
+    {
+        u8 bit = (data[i / 8] >> (7 - i % 8)) & 1;
+        edges[i + 2] = edges[i + 1] + (bit ? WIDTH_1 : WIDTH_0);
+    }
+}
+
+static void make_frame(u8* data, u8 humi, u8 temp)
+{
+    data[0] = humi;
+    data[1] = 0;
+    data[2] = temp;
+    data[3] = 7;
+    data[4] = (u8)(data[0] + data[1] + data[2] + data[3]);
+}
+
+// 把第i个数据位的宽度改为width，之后的下降沿整体平移
+static void set_bit_width(u16* edges, u8 i, u16 width)
+{
+    u16 delta = width - (edges[i + 2] - edges[i + 1]);
+    u8 k;
+
+    for(k = i + 2; k < DHT11_EDGE_COUNT; k++) edges[k] += delta;
+}
+
+static void test_decode(void)
+{
+    u16 edges[DHT11_EDGE_COUNT];
+    u8 data[5], buf[5];
+    u32 v;
+
+    make_frame(data, 55, 24);
+    make_edges(edges, 10, data);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+    CHECK(memcmp(buf, data, 5) == 0);
+
+    // 全部位值都能还原
+    for(v = 0; v < 256; v++)
+    {
+        make_frame(data, v, 255 - v);
+        make_edges(edges, 10, data);
+        if(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf) != DHT11_OK || memcmp(buf, data, 5) != 0) break;
+    }
+    CHECK_EQ(v, 256);
+
+    // 16位计时器回绕不影响间隔
+    make_frame(data, 60, 30);
+    make_edges(edges, 0xFF00, data);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+    CHECK(memcmp(buf, data, 5) == 0);
+}
+
+static void test_errors(void)
+{
+    u16 edges[DHT11_EDGE_COUNT];
+    u8 data[5], buf[5];
+
+    make_frame(data, 55, 24);
+    data[4]++;
+    make_edges(edges, 10, data);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_ERROR_CHECKSUM);
+
+    make_frame(data, 55, 24);
+    CHECK_EQ(DHT11_Decode_Frame(edges, 0, buf), DHT11_ERROR_NO_RESPONSE);
+    make_edges(edges, 10, data);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT - 1, buf), DHT11_ERROR_TRUNCATED);
+    CHECK_EQ(DHT11_Decode_Frame(edges, 1, buf), DHT11_ERROR_TRUNCATED);
+
+    // 应答间隔越界
+    edges[0] = edges[1] - (DHT11_ACK_MIN_US - 1);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_ERROR_TIMING);
+    edges[0] = edges[1] - (DHT11_ACK_MAX_US + 1);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_ERROR_TIMING);
+    edges[0] = edges[1] - DHT11_ACK_MIN_US;
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+    edges[0] = edges[1] - DHT11_ACK_MAX_US;
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+
+    // 数据位间隔越界：第一位和最后一位
+    make_edges(edges, 10, data);
+    set_bit_width(edges, 0, DHT11_BIT_MIN_US - 1);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_ERROR_TIMING);
+    make_edges(edges, 10, data);
+    set_bit_width(edges, 39, DHT11_BIT_MAX_US + 1);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_ERROR_TIMING);
+}
+
+/**
+ * @brief  0/1判决门限：间隔等于门限判0，大于门限判1；范围端点本身有效
+ */
+static void test_threshold(void)
+{
+    u16 edges[DHT11_EDGE_COUNT];
+    u8 data[5] = {0, 0, 0, 0, 0}, buf[5];
+
+    make_edges(edges, 10, data);
+    set_bit_width(edges, 7, DHT11_BIT_THRESHOLD_US);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+    CHECK_EQ(buf[0], 0);
+
+    // 第7位(data[0]最低位)和第39位(校验和最低位)都判为1，校验和仍然成立
+    set_bit_width(edges, 7, DHT11_BIT_THRESHOLD_US + 1);
+    set_bit_width(edges, 39, DHT11_BIT_MAX_US);
+    set_bit_width(edges, 8, DHT11_BIT_MIN_US);
+    CHECK_EQ(DHT11_Decode_Frame(edges, DHT11_EDGE_COUNT, buf), DHT11_OK);
+    CHECK_EQ(buf[0], 1);
+    CHECK_EQ(buf[1], 0);
+    CHECK_EQ(buf[4], 1);
+}
+
+static void tim6_update(void)
+{
+    DHT11_TIM->SR |= TIM_IT_Update;
+    TIM6_IRQHandler();
+}
+
+static void exti_edge(u16 t)
+{
+    DHT11_TIM->CNT = t;
+    EXTI->PR = DHT11_EXTI_LINE;
+    EXTI15_10_IRQHandler();
+}
+
+/**
+ * @brief  异步采集：起始信号到期后打开下降沿中断，收满42个下降沿解码；
+ *         下降沿不足时由整帧超时结束，两次启动之间至少间隔DHT11_MIN_INTERVAL_MS
+ */
+static void test_async(void)
+{
+    u16 edges[DHT11_EDGE_COUNT];
+    u8 data[5], i, temp = 0, humi = 0;
+
+    system_time_ms = 5000;
+    DHT11_Async_Init();
+    CHECK(!DHT11_Async_Busy());
+    CHECK_EQ(DHT11_Async_Get_Result(&temp, &humi), DHT11_ERROR_TIMEOUT);
+
+    CHECK_EQ(DHT11_Async_Start(), 0);
+    CHECK(DHT11_Async_Busy());
+    CHECK_EQ(DHT11_TIM->ARR, DHT11_START_LOW_US - 1);
+    CHECK_EQ(EXTI->IMR & DHT11_EXTI_LINE, 0);
+    exti_edge(5);                                   // 起始信号期间的下降沿不记录
+    tim6_update();
+    CHECK(EXTI->IMR & DHT11_EXTI_LINE);
+    CHECK_EQ(DHT11_TIM->ARR, DHT11_FRAME_TIMEOUT_US - 1);
+
+    make_frame(data, 62, 27);
+    make_edges(edges, 30, data);
+    for(i = 0; i < DHT11_EDGE_COUNT; i++) exti_edge(edges[i]);
+    CHECK(!DHT11_Async_Busy());
+    CHECK(DHT11_Async_Ready());
+    CHECK_EQ(EXTI->IMR & DHT11_EXTI_LINE, 0);
+    CHECK_EQ(DHT11_Async_Get_Result(&temp, &humi), DHT11_OK);
+    CHECK_EQ(temp, 27);
+    CHECK_EQ(humi, 62);
+    CHECK(!DHT11_Async_Ready());
+
+    // 间隔不足时拒绝启动
+    system_time_ms += DHT11_MIN_INTERVAL_MS - 1;
+    CHECK_EQ(DHT11_Async_Start(), 1);
+    system_time_ms += 1;
+    CHECK_EQ(DHT11_Async_Start(), 0);
+    CHECK_EQ(DHT11_Async_Start(), 1);
+
+    // 只收到一部分下降沿就超时
+    tim6_update();
+    for(i = 0; i < 10; i++) exti_edge(edges[i]);
+    CHECK(DHT11_Async_Busy());
+    tim6_update();
+    CHECK(!DHT11_Async_Busy());
+    temp = humi = 0;
+    CHECK_EQ(DHT11_Async_Get_Result(&temp, &humi), DHT11_ERROR_TRUNCATED);
+    CHECK_EQ(temp, 0);
+    CHECK_EQ(humi, 0);
+}
+
+int main(void)
+{
+    test_decode();
+    test_errors();
+    test_threshold();
+    test_async();
+    return host_report("dht11");
+}
@@ -0,0 +1,230 @@
+/**
+ * @file   test_display.c
+ * @brief  状态界面的保留模式控件层：连续渲染状态帧到FSMC面板模型，每帧只写入变化的字符格
+ *         （秒数跳变、分钟进位、温度变化、变色控件整体重绘），内容不变时不写像素；
+ *         增量更新后的画面与全部重绘的画面逐像素一致；HOST_VERBOSE=1时打印每次更新的像素数
+ */
+#include "host.h"
+#include "greenhouse_display.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PANEL_W     320
+#define PANEL_H     480
+#define CELL_W      8
+#define CELL_H      16
+
+// ===== 被测模块依赖的外部函数 =====
+
+RTC_Time_t current_time = {2025, 7, 11, 12, 34, 56, 5};
+static u8 fan_speed;
+
+u8 Fan_Get_Speed_Percent(void) { return fan_speed; }
+
+void RTC_Format_Time(RTC_Time_t* time, char* str)
+{
+    sprintf(str, "%02d:%02d:%02d", time->hour, time->min, time->sec);
+}
+
+void RTC_Format_Date(RTC_Time_t* time, char* str)
+{
+    sprintf(str, "%04d-%02d-%02d", time->year, time->month, time->date);
+}
+
+// ===== 面板模型：0x2A/0x2B开窗，0x2C后每像素高低字节两次写入，记录本帧写过的像素 =====
+
+typedef struct
+{
+    u16 fb[PANEL_H][PANEL_W];
+    u8 written[PANEL_H][PANEL_W];
+    u16 sc, ec, sp, ep;
+    u16 x, y;
+    u8 cmd;
+    u8 arg_n;
+    u8 args[4];
+    u8 byte_n;
+    u8 hi;
+    u32 pixels;
+} Panel_t;
+
+static Panel_t panel;
+static u8 expect[PANEL_H][PANEL_W];
+
+static void panel_write(u32 addr, u16 v)
+{
+    Panel_t* p = &panel;
+    u16 s, e;
+
+    if(addr == (u32)&TFTLCD->LCD_CMD)
+    {
+        p->cmd = (u8)v;
+        p->arg_n = 0;
+        p->byte_n = 0;
+        if(v == 0x2C)
+        {
+            p->x = p->sc;
+            p->y = p->sp;
+        }
+        return;
+    }
+    if(p->cmd == 0x2A || p->cmd == 0x2B)
+    {
+        if(p->arg_n < 4) p->args[p->arg_n++] = (u8)v;
+        if(p->arg_n == 4)
+        {
+            s = (p->args[0] << 8) | p->args[1];
+            e = (p->args[2] << 8) | p->args[3];
+            if(p->cmd == 0x2A) { p->sc = s; p->ec = e; }
+            else { p->sp = s; p->ep = e; }
+        }
+    }
+    else if(p->cmd == 0x2C)
+    {
+        if(p->byte_n == 0)
+        {
+            p->hi = (u8)v;
+            p->byte_n = 1;
+            return;
+        }
+        p->byte_n = 0;
+        p->pixels++;
+        if(p->x < PANEL_W && p->y < PANEL_H)
+        {
+            p->fb[p->y][p->x] = (p->hi << 8) | (v & 0xFF);
+            p->written[p->y][p->x] = 1;
+        }
+        if(++p->x > p->ec)
+        {
+            p->x = p->sc;
+            if(++p->y > p->ep) p->y = p->sp;
+        }
+    }
+}
+
+static u16 panel_read(u32 addr)
+{
+    (void)addr;
+    return 0;
+}
+
+// ===== 帧与期望写入区域 =====
+
+static GreenhouseStatus_t status;
+
+/**
+ * @brief  期望本帧写入控件(x, y)中从第col格起的n个字符格
+ */
+static void expect_cells(u16 x, u16 y, u8 col, u8 n)
+{
+    u16 i, j;
+
+    for(j = 0; j < CELL_H; j++)
+        for(i = 0; i < n * CELL_W; i++) expect[y + j][x + col * CELL_W + i] = 1;
+}
+
+/**
+ * @brief  渲染一帧，返回写入的像素数；写入范围与期望的字符格逐像素比较
+ */
+static u32 frame(const char* name)
+{
+    u32 bad = 0, i;
+
+    memset(panel.written, 0, sizeof(panel.written));
+    panel.pixels = 0;
+    Display_System_Status(&status);
+    for(i = 0; i < PANEL_W * PANEL_H; i++)
+        if((&panel.written[0][0])[i] != (&expect[0][0])[i]) bad++;
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(Display_Get_Flush_Pixels(), panel.pixels);
+    if(getenv("HOST_VERBOSE")) fprintf(stderr, "display: %-22s %5lu pixels\n", name, (unsigned long)panel.pixels);
+    memset(expect, 0, sizeof(expect));
+    return panel.pixels;
+}
+
+/**
+ * @brief  连续状态帧：只重绘变化的字符格，结果与全部重绘一致
+ */
+static void test_updates(void)
+{
+    static u16 snapshot[PANEL_H][PANEL_W];
+    u32 full;
+
+    status.temperature = 25;
+    status.humidity = 60;
+    status.light = 40;
+    status.work_mode = MODE_AUTO;
+    status.fan_status = DEVICE_OFF;
+    status.alarm_flags = ALARM_NONE;
+
+    // 首帧：标题之后的全部控件和报警区
+    Display_Invalidate();
+    Display_Title();
+    memset(expect, 0, sizeof(expect));
+    memset(panel.written, 0, sizeof(panel.written));
+    panel.pixels = 0;
+    Display_System_Status(&status);
+    full = Display_Get_Flush_Pixels();
+    CHECK(full > 0);
+
+    // 内容不变：不写像素
+    CHECK_EQ(frame("unchanged"), 0);
+
+    // 秒数跳变：时间控件"12:34:56"只有第8格
+    current_time.sec = 57;
+    expect_cells(160, 50, 7, 1);
+    CHECK_EQ(frame("seconds tick"), CELL_W * CELL_H);
+
+    // 分钟进位 12:34:59 -> 12:35:00：第5、7、8格，冒号不重绘
+    current_time.sec = 59;
+    expect_cells(160, 50, 7, 1);
+    frame("seconds tick");
+    current_time.min = 35;
+    current_time.sec = 0;
+    expect_cells(160, 50, 4, 1);
+    expect_cells(160, 50, 6, 2);
+    CHECK_EQ(frame("minute carry"), 3 * CELL_W * CELL_H);
+
+    // 温度 " 25 C" -> " 26 C"
+    status.temperature = 26;
+    expect_cells(80, 100, 2, 1);
+    CHECK_EQ(frame("temperature"), CELL_W * CELL_H);
+
+    // 温度 " 26 C" -> "101 C"：三位数字都变
+    status.temperature = 101;
+    expect_cells(80, 100, 0, 3);
+    CHECK_EQ(frame("temperature 3 digits"), 3 * CELL_W * CELL_H);
+
+    // 风扇开启：颜色改变，整个控件重绘
+    status.fan_status = DEVICE_ON;
+    fan_speed = 45;
+    expect_cells(80, 190, 0, 12);
+    CHECK_EQ(frame("fan colour change"), 12 * CELL_W * CELL_H);
+
+    // 风扇转速 45% -> 50%：同色，只有两个数字格
+    fan_speed = 50;
+    expect_cells(80, 190, 4, 2);
+    CHECK_EQ(frame("fan speed"), 2 * CELL_W * CELL_H);
+
+    // 增量更新后的画面与失效后全部重绘的画面一致
+    memcpy(snapshot, panel.fb, sizeof(snapshot));
+    Display_Invalidate();
+    panel.pixels = 0;
+    Display_System_Status(&status);
+    CHECK(memcmp(snapshot, panel.fb, sizeof(snapshot)) == 0);
+    CHECK_EQ(Display_Get_Flush_Pixels(), panel.pixels);
+    CHECK_EQ(panel.pixels, (23 + 15 + 7 * 6 + 7 * 12) * CELL_W * CELL_H);   // 全部控件的字符格
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "display: full redraw %lu pixels, seconds tick %u pixels\n",
+                (unsigned long)Display_Get_Flush_Pixels(), CELL_W * CELL_H);
+}
+
+int main(void)
+{
+    host_fsmc_trap(panel_write, panel_read);
+    LCD_Display_Dir(0);
+    CHECK_EQ(tftlcd_data.width, PANEL_W);
+    CHECK_EQ(tftlcd_data.height, PANEL_H);
+
+    test_updates();
+    return host_report("display");
+}
@@ -0,0 +1,588 @@
+/**
+ * @file   test_greenhouse.c
+ * @brief  蓝牙命令表：命令表有序，HELP列出的每条命令都能按完整命令名查到，执行到对应的设备函数；
+ *         前缀、加长和小写的命令名不被误认；参数的格式、上限、缺省和手动模式检查；
+ *         与原strstr逐条匹配比较查找耗时；稳定运行时主任务无调试输出，与原printf路径比较每周期的
+ *         串口阻塞时间（HOST_VERBOSE=1时打印）
+ */
+#include "host.h"
+#include "fakes.h"
+#include "../../APP/greenhouse_control/greenhouse_control.c"
+#include <stdarg.h>
+#include <time.h>
+
+void USART3_IRQHandler(void);
+
+// ===== 被测模块依赖的外部函数：设备操作记录到calls =====
+
+static char calls[512];
+
+static void note(const char* fmt, ...)
+{
+    u32 n = strlen(calls);
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(calls + n, sizeof(calls) - n, fmt, ap);
+    va_end(ap);
+    strncat(calls, " ", sizeof(calls) - strlen(calls) - 1);
+}
+
+SystemConfig_t system_config;
+
+u8 DHT11_Init(void) { return 0; }
+void Lsens_Init(void) {}
+void LED_Init(void) {}
+void BEEP_Init(void) {}
+void KEY_Init(void) {}
+u8 HC05_Init(void) { return 0; }
+u8 RTC_Init(void) { return 0; }
+u8 Config_Init(void) { return 0; }
+u8 DataLogger_Init(void) { return 0; }
+void Telemetry_Init(void) {}
+void RGB_Greenhouse_Init(void) {}
+void DHT11_Set_Calibration(float temp_offset, float humi_offset) {}
+u8 DHT11_Async_Start(void) { return 0; }
+u8 DHT11_Async_Ready(void) { return 0; }
+DHT11_Status_t DHT11_Async_Get_Result(u8* temp, u8* humi) { return DHT11_OK; }
+u8 Lsens_Get_Val(void) { return 50; }
+void BEEP_Short(void) {}
+void BEEP_Set_Alarm(AlarmType_t alarm_type) {}
+u8 DataLogger_WriteSensorData(u8 temp, u8 humi, u8 light, u8 fan, u8 pump, u8 light_dev, u8 mode, u8 alarms) { return 0; }
+u8 DataLogger_WriteOperation(u8 operation, u8 old_val, u8 new_val, u8 trigger) { return 0; }
+u8 DataLogger_WriteAlarm(u8 alarm_type, u8 level, u8 trigger_val, u8 threshold) { return 0; }
+void Display_System_Status(GreenhouseStatus_t* status) {}
+u32 USART1_Get_TX_Dropped(void) { return 0; }
+u8 Fan_Get_Speed(void) { return 0; }
+u8 Fan_Get_Speed_Percent(void) { return 0; }
+void Fan_Set_Speed(u8 speed) { note("Fan_Set_Speed(%u)", speed); }
+void Fan_Set_Speed_Percent(u8 percent) { note("Fan_Set_Speed_Percent(%u)", percent); }
+void LED_Pump_Set(u8 state) { note("LED_Pump_Set(%u)", state); }
+void LED_Light_Set(u8 state) { note("LED_Light_Set(%u)", state); }
+void LED_Alarm_Set(u8 state) { note("LED_Alarm_Set(%u)", state); }
+void Event_Set_Interval(u8 topic, u16 min_interval_ms) {}
+void Event_Publish(u8 topic) { note("Event_Publish(%u)", topic); }
+void Event_Print_Stats(void) { note("Event_Print_Stats"); }
+void Scheduler_Print_Stats(void) { note("Scheduler_Print_Stats"); }
+void LogExport_Start(u32 pos) { note("LogExport_Start(0x%X)", pos); }
+void LogExport_Stop(void) { note("LogExport_Stop"); }
+void Telemetry_Receive(const u8* data, u16 size) { note("Telemetry_Receive(%u)", size); }
+void Config_Handle_Command(char* cmd) { note("Config_Handle_Command(%s)", cmd); }
+u8 HC05_AT_Feed_Line(const char* line) { return 0; }
+u8 HC05_AT_Submit(const char* cmd, HC05_AT_Callback_t callback) { note("HC05_AT_Submit(%s)", cmd); return 0; }
+void RGB_Set_Display_Mode(RGB_DisplayMode_t mode) { note("RGB_Set_Display_Mode(%u)", mode); }
+void RGB_Set_Brightness(u8 brightness) { note("RGB_Set_Brightness(%u)", brightness); }
+void RGB_Set_All_Color(u32 color) { note("RGB_Set_All_Color(0x%06X)", color); }
+void RGB_LED_Clear(void) { note("RGB_LED_Clear"); }
+void RGB_Show_Temperature(u8 temperature) { note("RGB_Show_Temperature"); }
+void RGB_Show_Humidity(u8 humidity) { note("RGB_Show_Humidity"); }
+void RGB_Show_Light_Level(u8 light_level) { note("RGB_Show_Light_Level"); }
+void RGB_Show_System_Status(u8 fan_status, u8 pump_status, u8 light_status) { note("RGB_Show_System_Status"); }
+void RGB_Start_Rainbow_Animation(void) { note("RGB_Start_Rainbow_Animation"); }
+void RGB_Start_Breathing_Animation(u32 color) { note("RGB_Start_Breathing_Animation"); }
+void RGB_Start_Water_Flow_Animation(void) { note("RGB_Start_Water_Flow_Animation"); }
+void RGB_Show_Heart(u32 color) { note("RGB_Show_Heart"); }
+void RGB_Show_Smiley(u32 color) { note("RGB_Show_Smiley"); }
+void RGB_Show_Check_Mark(u32 color) { note("RGB_Show_Check_Mark"); }
+void RGB_Show_Cross(u32 color) { note("RGB_Show_Cross"); }
+void RGB_Show_Robot(u32 color) { note("RGB_Show_Robot"); }
+void RGB_Show_Manual_Status_Face(u8 fan_status, u8 pump_status, u8 light_status, u8 fan_speed)
+{
+    note("RGB_Show_Manual_Status_Face");
+}
+
+// ===== 执行命令并取得输出 =====
+
+static char out[8192];
+
+// 执行一行命令，固件的printf输出存入out，设备操作存入calls
+static void run(const char* line)
+{
+    char buf[USART3_LINE_LEN];
+    FILE* saved = stdout;
+    FILE* f;
+    u32 n;
+
+    calls[0] = '\0';
+    strncpy(buf, line, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    f = tmpfile();
+    stdout = f;
+    Greenhouse_Bluetooth_Command(buf);
+    fflush(f);
+    stdout = saved;
+    rewind(f);
+    n = fread(out, 1, sizeof(out) - 1, f);
+    out[n] = '\0';
+    fclose(f);
+    if(getenv("HOST_VERBOSE")) printf("%s", out);
+}
+
+static u8 failed(void)
+{
+    return strstr(out, "Unknown command") != 0 || strstr(out, "Error") != 0;
+}
+
+// ===== HELP列出的命令 =====
+
+#define MAX_DOC     80
+
+static char doc[MAX_DOC][24];
+static u8 doc_count;
+
+/**
+ * @brief  从HELP输出中取出命令名：每行"  "之后到" - "或行尾的部分，按'/'拆开，
+ *         "RGB_RED/GREEN"这样的简写补上第一个命令名的前缀，去掉"[0-100]"、" [pos]"这类参数说明
+ */
+static void parse_help(void)
+{
+    char* line;
+    char* save;
+    char* tok;
+    char* tsave;
+    char prefix[24];
+    u32 k;
+
+    run("HELP");
+    doc_count = 0;
+    for(line = strtok_r(out, "\r\n", &save); line != 0; line = strtok_r(0, "\r\n", &save))
+    {
+        if(strncmp(line, "  ", 2) != 0 || line[2] < 'A' || line[2] > 'Z') continue;
+        line += 2;
+        if(strstr(line, " - ")) *strstr(line, " - ") = '\0';
+        line[strspn(line, "ABCDEFGHIJKLMNOPQRSTUVWXYZ_/")] = '\0';
+        prefix[0] = '\0';
+        for(tok = strtok_r(line, "/", &tsave); tok != 0; tok = strtok_r(0, "/", &tsave))
+        {
+            if(doc_count >= MAX_DOC) break;
+            if(prefix[0] == '\0')
+            {
+                k = strchr(tok, '_') ? (u32)(strchr(tok, '_') - tok + 1) : 0;
+                memcpy(prefix, tok, k);
+                prefix[k] = '\0';
+                strcpy(doc[doc_count++], tok);
+            }
+            else if(strchr(tok, '_') == 0) snprintf(doc[doc_count++], sizeof(doc[0]), "%s%s", prefix, tok);
+            else strcpy(doc[doc_count++], tok);
+        }
+    }
+}
+
+static u8 documented(const char* name)
+{
+    u8 i;
+
+    for(i = 0; i < doc_count; i++)
+        if(strcmp(doc[i], name) == 0) return 1;
+    return 0;
+}
+
+/**
+ * @brief  命令表按字典序排列；HELP列出的命令和命令表一一对应，每条都能按完整命令名查到
+ */
+static void test_table(void)
+{
+    const BtCommand_t* entry;
+    u32 i, unsorted = 0, missing = 0, undocumented = 0;
+
+    for(i = 1; i < BT_COMMAND_COUNT; i++)
+        if(strcmp(bt_commands[i - 1].name, bt_commands[i].name) >= 0) unsorted++;
+    CHECK_EQ(unsorted, 0);
+
+    parse_help();
+    CHECK_EQ(doc_count, BT_COMMAND_COUNT);
+    for(i = 0; i < doc_count; i++)
+    {
+        entry = Greenhouse_Find_Command(doc[i], strlen(doc[i]));
+        if(entry == 0 || strcmp(entry->name, doc[i]) != 0)
+        {
+            fprintf(stderr, "documented but not found: %s\n", doc[i]);
+            missing++;
+        }
+    }
+    for(i = 0; i < BT_COMMAND_COUNT; i++)
+    {
+        if(!documented(bt_commands[i].name))
+        {
+            fprintf(stderr, "not in HELP: %s\n", bt_commands[i].name);
+            undocumented++;
+        }
+    }
+    CHECK_EQ(missing, 0);
+    CHECK_EQ(undocumented, 0);
+
+    // 命令名不以'\0'结尾：只比较前len个字符
+    entry = Greenhouse_Find_Command("STATUS_XYZ", 6);
+    CHECK(entry != 0 && strcmp(entry->name, "STATUS") == 0);
+    entry = Greenhouse_Find_Command("RGB_BRIGHT30", 10);
+    CHECK(entry != 0 && strcmp(entry->name, "RGB_BRIGHT") == 0);
+}
+
+/**
+ * @brief  完整命令名匹配：前缀、加长、小写和包含其他命令名的命令都不被误认
+ */
+static void test_exact(void)
+{
+    static const char* const unknown[] =
+    {
+        "STAT", "STATUSX", "status", "Status", "FAN", "FAN_O", "FAN_ONN", "RGB", "RGB_", "RGB_REDX",
+        "BT", "BT_", "XHELP", "HELPME", "EXPORTSTOP", "_", "", "   ", "123", "A", "ZZZ"
+    };
+    static const struct { const char* line; const char* name; } exact[] =
+    {
+        {"STATUS", "STATUS"}, {"STATS", "STATS"}, {"SENSOR_STATUS", "SENSOR_STATUS"},
+        {"RGB_STATUS", "RGB_STATUS"}, {"EXPORT", "EXPORT"}, {"EXPORT_STOP", "EXPORT_STOP"},
+        {"RGB_LIGHT", "RGB_LIGHT"}, {"LIGHT_ON", "LIGHT_ON"}, {"RGB_BRIGHT", "RGB_BRIGHT"}
+    };
+    const BtCommand_t* entry;
+    u32 i;
+
+    for(i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++)
+    {
+        CHECK(Greenhouse_Find_Command(unknown[i], strlen(unknown[i])) == 0);
+        run(unknown[i]);
+        CHECK(strstr(out, "Unknown command") != 0);
+        CHECK_EQ(calls[0], '\0');
+    }
+    for(i = 0; i < sizeof(exact) / sizeof(exact[0]); i++)
+    {
+        entry = Greenhouse_Find_Command(exact[i].line, strlen(exact[i].line));
+        CHECK(entry != 0 && strcmp(entry->name, exact[i].name) == 0);
+    }
+}
+
+/**
+ * @brief  每条命令执行到对应的处理函数（手动模式下），查询类命令检查输出的标题
+ */
+static void test_dispatch(void)
+{
+    static const struct { const char* line; const char* expect; } cases[] =
+    {
+        {"MANUAL",          "Event_Publish(3)"},
+        {"STATUS",          "=== System Status ==="},
+        {"STATS",           "=== System Statistics ==="},
+        {"SENSOR_STATUS",   "=== DHT11 Sensor Status ==="},
+        {"TREND",           ""},
+        {"SCHED",           "Scheduler_Print_Stats"},
+        {"EVENTS",          "Event_Print_Stats"},
+        {"HELP",            "=== Bluetooth Command Help ==="},
+        {"FAN_ON",          "Fan_Set_Speed_Percent(100)"},
+        {"FAN_OFF",         "Fan_Set_Speed_Percent(0)"},
+        {"PUMP_ON",         "LED_Pump_Set(1)"},
+        {"PUMP_OFF",        "LED_Pump_Set(0)"},
+        {"LIGHT_ON",        "LED_Light_Set(1)"},
+        {"LIGHT_OFF",       "LED_Light_Set(0)"},
+        {"RGB_TEMP",        "RGB_Show_Temperature"},
+        {"RGB_HUMIDITY",    "RGB_Show_Humidity"},
+        {"RGB_LIGHT",       "RGB_Show_Light_Level"},
+        {"RGB_STATUS",      "RGB_Show_System_Status"},
+        {"RGB_OFF",         "RGB_LED_Clear"},
+        {"RGB_RAINBOW",     "RGB_Start_Rainbow_Animation"},
+        {"RGB_BREATHING",   "RGB_Start_Breathing_Animation"},
+        {"RGB_FLOW",        "RGB_Start_Water_Flow_Animation"},
+        {"RGB_HEART",       "RGB_Show_Heart"},
+        {"RGB_SMILEY",      "RGB_Show_Smiley"},
+        {"RGB_CHECK",       "RGB_Show_Check_Mark"},
+        {"RGB_CROSS",       "RGB_Show_Cross"},
+        {"RGB_ROBOT",       "RGB_Show_Robot"},
+        {"RGB_MANUAL_FACE", "RGB_Show_Manual_Status_Face"},
+        {"RGB_RED",         "RGB_Set_All_Color(0x00FF00)"},
+        {"RGB_GREEN",       "RGB_Set_All_Color(0xFF0000)"},
+        {"RGB_BLUE",        "RGB_Set_All_Color(0x0000FF)"},
+        {"RGB_WHITE",       "RGB_Set_All_Color(0xFFFFFF)"},
+        {"RGB_YELLOW",      "RGB_Set_All_Color(0xFFFF00)"},
+        {"RGB_PURPLE",      "RGB_Set_All_Color(0x00FFFF)"},
+        {"RGB_CYAN",        "RGB_Set_All_Color(0xFF00FF)"},
+        {"RGB_BRIGHT 30",   "RGB_Set_Brightness(30)"},
+        {"EXPORT",          "LogExport_Start(0x0)"},
+        {"EXPORT_STOP",     "LogExport_Stop"},
+        {"CONFIG_GET",      "Config_Handle_Command(CONFIG_GET)"},
+        {"CONFIG_GET temp", "Config_Handle_Command(CONFIG_GET temp)"},
+        {"CONFIG_SET temp_fan_on 28", "Config_Handle_Command(CONFIG_SET temp_fan_on 28)"},
+        {"CONFIG_SAVE",     "Config_Handle_Command(CONFIG_SAVE)"},
+        {"CONFIG_RESET",    "Config_Handle_Command(CONFIG_RESET)"},
+        {"CONFIG_HELP",     "Config_Handle_Command(CONFIG_HELP)"},
+        {"BT_NAME",         "HC05_AT_Submit(AT+NAME?)"},
+        {"BT_VER",          "HC05_AT_Submit(AT+VERSION?)"},
+        {"BT_ADDR",         "HC05_AT_Submit(AT+ADDR?)"},
+        {"BT_PIN",          "HC05_AT_Submit(AT+PSWD?)"},
+        {"BT_BAUD",         "HC05_AT_Submit(AT+UART?)"},
+        {"BT_ROLE",         "HC05_AT_Submit(AT+ROLE?)"},
+        {"BT_CLASS",        "HC05_AT_Submit(AT+CLASS?)"},
+        {"BT_TEST",         "HC05_AT_Submit(AT)"},
+        {"BT_RESET",        "HC05_AT_Submit(AT+RESET)"},
+        {"BT_DIAG",         "HC05_AT_Submit(AT)"},
+        {"AUTO",            "Event_Publish(3)"}
+    };
+    u32 i, j, untested = 0;
+
+    // 每条文档命令都有用例
+    for(i = 0; i < doc_count; i++)
+    {
+        for(j = 0; j < sizeof(cases) / sizeof(cases[0]); j++)
+            if(strncmp(cases[j].line, doc[i], strlen(doc[i])) == 0 &&
+               (cases[j].line[strlen(doc[i])] == '\0' || cases[j].line[strlen(doc[i])] == ' ')) break;
+        if(j == sizeof(cases) / sizeof(cases[0]))
+        {
+            fprintf(stderr, "no dispatch case for %s\n", doc[i]);
+            untested++;
+        }
+    }
+    CHECK_EQ(untested, 0);
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        run(cases[i].line);
+        CHECK(!failed());
+        if(strstr(calls, cases[i].expect) == 0 && strstr(out, cases[i].expect) == 0)
+        {
+            fprintf(stderr, "%s: expected %s, got calls \"%s\"\n", cases[i].line, cases[i].expect, calls);
+            CHECK(0);
+        }
+    }
+    CHECK_EQ(greenhouse_status.work_mode, MODE_AUTO);
+}
+
+/**
+ * @brief  参数：紧跟命令名、空格或':'分隔、十进制或0x十六进制；超出上限、格式错误、
+ *         缺少必需参数和给无参数命令加参数都报错且不执行；手动命令在自动模式下被拒绝
+ */
+static void test_args(void)
+{
+    static const struct { const char* line; const char* expect; } ok[] =
+    {
+        {"RGB_BRIGHT30",            "RGB_Set_Brightness(30)"},
+        {"RGB_BRIGHT 0x1E",         "RGB_Set_Brightness(30)"},
+        {"RGB_BRIGHT:100",          "RGB_Set_Brightness(100)"},
+        {"RGB_BRIGHT0",             "RGB_Set_Brightness(0)"},
+        {"  RGB_BRIGHT 7  ",        "RGB_Set_Brightness(7)"},
+        {"RGB_BRIGHT 55\r",         "RGB_Set_Brightness(55)"},
+        {"EXPORT 0x01000005",       "LogExport_Start(0x1000005)"},
+        {"EXPORT 4294967295",       "LogExport_Start(0xFFFFFFFF)"},
+        {"STATUS ",                 "=== System Status ==="}
+    };
+    static const char* const bad[] =
+    {
+        "RGB_BRIGHT101", "RGB_BRIGHT 0x65", "RGB_BRIGHT", "RGB_BRIGHT ", "RGB_BRIGHT 3x",
+        "RGB_BRIGHT 30 40", "RGB_BRIGHT -1", "RGB_BRIGHTx", "STATUS 1", "FAN_ON 1", "HELP me",
+        "EXPORT 0xZZ"
+    };
+    static const char* const manual_only[] =
+    {
+        "FAN_ON", "FAN_OFF", "PUMP_ON", "PUMP_OFF", "LIGHT_ON", "LIGHT_OFF"
+    };
+    u32 i;
+
+    for(i = 0; i < sizeof(ok) / sizeof(ok[0]); i++)
+    {
+        run(ok[i].line);
+        CHECK(!failed());
+        if(strstr(calls, ok[i].expect) == 0 && strstr(out, ok[i].expect) == 0)
+        {
+            fprintf(stderr, "%s: expected %s, got calls \"%s\"\n", ok[i].line, ok[i].expect, calls);
+            CHECK(0);
+        }
+    }
+    for(i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        run(bad[i]);
+        CHECK(failed());
+        CHECK_EQ(calls[0], '\0');
+    }
+    run("RGB_BRIGHT");
+    CHECK(strstr(out, "Error: RGB_BRIGHT needs an argument") != 0);
+    run("RGB_BRIGHT101");
+    CHECK(strstr(out, "Error: Invalid argument for RGB_BRIGHT") != 0);
+
+    greenhouse_status.work_mode = MODE_AUTO;
+    for(i = 0; i < sizeof(manual_only) / sizeof(manual_only[0]); i++)
+    {
+        run(manual_only[i]);
+        CHECK(strstr(out, "Error: Switch to MANUAL mode first") != 0);
+        CHECK_EQ(calls[0], '\0');
+    }
+    run("MANUAL");
+    run("FAN_ON");
+    CHECK(strstr(calls, "Fan_Set_Speed_Percent(100)") != 0);
+    run("AUTO");
+    CHECK(strstr(calls, "Fan_Set_Speed_Percent(0)") != 0);
+}
+
+/**
+ * @brief  串口接收路径：USART3中断组帧的命令行经Greenhouse_Handle_Bluetooth逐条执行，
+ *         0x00开头的二进制帧交给遥测模块
+ */
+static void test_uart_path(void)
+{
+    static const u8 frame[] = {0x00, 0x05, 0x01, 0x00};
+    const char* s = "RGB_BRIGHT 40\r\nEXPORT_STOP\r\n";
+    FILE* saved = stdout;
+    u32 i;
+
+    calls[0] = '\0';
+    for(; *s; s++) host_usart_rx(USART3, *s, 0, USART3_IRQHandler);
+    for(i = 0; i < sizeof(frame); i++) host_usart_rx(USART3, frame[i], 0, USART3_IRQHandler);
+    stdout = fopen("/dev/null", "w");
+    Greenhouse_Handle_Bluetooth();
+    fclose(stdout);
+    stdout = saved;
+    CHECK(strcmp(calls, "RGB_Set_Brightness(40) LogExport_Stop Telemetry_Receive(2) ") == 0);
+}
+
+// ===== 原实现：按固定顺序对整行strstr =====
+
+static const char* const chain[] =
+{
+    "STATUS", "AUTO", "MANUAL", "FAN_ON", "FAN_OFF", "PUMP_ON", "PUMP_OFF", "LIGHT_ON", "LIGHT_OFF",
+    "STATS", "TREND", "SENSOR_STATUS", "BT_NAME", "BT_VER", "BT_ADDR", "BT_PIN", "BT_BAUD", "BT_ROLE",
+    "BT_CLASS", "BT_TEST", "BT_RESET", "BT_DIAG", "RGB_TEMP", "RGB_HUMIDITY", "RGB_LIGHT", "RGB_STATUS",
+    "RGB_OFF", "RGB_RAINBOW", "RGB_BREATHING", "RGB_FLOW", "RGB_HEART", "RGB_SMILEY", "RGB_CHECK",
+    "RGB_CROSS", "RGB_ROBOT", "RGB_MANUAL_FACE", "RGB_RED", "RGB_GREEN", "RGB_BLUE", "RGB_WHITE",
+    "RGB_YELLOW", "RGB_PURPLE", "RGB_CYAN", "RGB_BRIGHT", "HELP"
+};
+
+static int chain_find(const char* line)
+{
+    u32 i;
+
+    for(i = 0; i < sizeof(chain) / sizeof(chain[0]); i++)
+        if(strstr(line, chain[i])) return i;
+    return -1;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief  查找耗时：全部文档命令各查找多次，与原strstr链比较；原实现把SENSOR_STATUS、
+ *         RGB_STATUS当作STATUS，新实现按完整命令名区分
+ */
+static void test_timing(void)
+{
+    enum { ROUNDS = 20000 };
+    volatile u32 sink = 0;
+    double t0, t_find, t_chain;
+    u32 r, i, misrouted = 0;
+    int k;
+
+    for(i = 0; i < doc_count; i++)
+    {
+        k = chain_find(doc[i]);
+        if(k >= 0 && strcmp(chain[k], doc[i]) != 0) misrouted++;
+    }
+    CHECK(chain_find("SENSOR_STATUS") == 0);    // 参考实现确实有误认
+    CHECK(strcmp(Greenhouse_Find_Command("SENSOR_STATUS", 13)->name, "SENSOR_STATUS") == 0);
+
+    t0 = now_ns();
+    for(r = 0; r < ROUNDS; r++)
+        for(i = 0; i < doc_count; i++) sink += (Greenhouse_Find_Command(doc[i], strlen(doc[i])) != 0);
+    t_find = (now_ns() - t0) / ((double)ROUNDS * doc_count);
+    t0 = now_ns();
+    for(r = 0; r < ROUNDS; r++)
+        for(i = 0; i < doc_count; i++) sink += chain_find(doc[i]);
+    t_chain = (now_ns() - t0) / ((double)ROUNDS * doc_count);
+
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "lookup: binary search %.1f ns, strstr chain %.1f ns per command; "
+                "chain misroutes %u of %u documented commands\n", t_find, t_chain, misrouted, doc_count);
+    (void)sink;
+}
+
+/**
+ * @brief  原Greenhouse_Task：每次调用无条件打印两行跟踪、光照读数和温度低于停止阈值的提示（本测试的温度），
+ *         每10次打印一行状态
+ */
+static void old_task(void)
+{
+    static u8 task_counter = 0;
+
+    printf("Greenhouse_Task: Starting sensor reading\r\n");
+    Greenhouse_Update_Sensors();
+    printf("Light Sensor: Reading L=%d%%\r\n", greenhouse_status.light);
+    printf("Greenhouse_Task: Sensor reading completed\r\n");
+    task_counter++;
+    if(task_counter >= 10) {
+        task_counter = 0;
+        printf("System Status: T=%d°C, H=%d%%, L=%d%%, Mode=%s\r\n",
+               greenhouse_status.temperature,
+               greenhouse_status.humidity,
+               greenhouse_status.light,
+               greenhouse_status.work_mode ? "Manual" : "Auto");
+    }
+    if(greenhouse_status.work_mode == MODE_AUTO) {
+        printf("Temperature below stop threshold, preparing to turn off fan...\r\n");
+        Greenhouse_Auto_Control();
+    }
+    Greenhouse_Check_Alarms();
+    greenhouse_status.system_run_time++;
+}
+
+/**
+ * @brief  运行task多次，返回每次调用的printf输出字节数，ns为每次调用的主机耗时
+ */
+static double task_output(void (*task)(void), u32 rounds, double* ns)
+{
+    FILE* saved = stdout;
+    char* buf = 0;
+    size_t size = 0;
+    double t0;
+    u32 i;
+
+    stdout = open_memstream(&buf, &size);
+    t0 = now_ns();
+    for(i = 0; i < rounds; i++) task();
+    *ns = (now_ns() - t0) / rounds;
+    fclose(stdout);
+    stdout = saved;
+    free(buf);
+    return (double)size / rounds;
+}
+
+/**
+ * @brief  主循环耗时：温湿度光照在阈值以内稳定运行时Greenhouse_Task不再输出调试信息；
+ *         原实现每次调用的输出在115200波特率下逐字节等待发送，折算为阻塞时间比较（HOST_VERBOSE=1时打印）
+ */
+static void test_loop_time(void)
+{
+    enum { ROUNDS = 1000 };
+    const double us_per_byte = 10 * 1e6 / 115200;    // 8N1每字节10位
+    double bytes_new, bytes_old, ns_new, ns_old;
+
+    fake_config[CONFIG_TEMP_FAN_ON] = DEFAULT_TEMP_FAN_ON;
+    fake_config[CONFIG_HUMI_PUMP_ON] = DEFAULT_HUMI_PUMP_ON;
+    fake_config[CONFIG_LIGHT_AUTO_ON] = DEFAULT_LIGHT_AUTO_ON;
+    system_config.temp_hysteresis = 2;
+    system_config.humi_hysteresis = 5;
+    system_config.light_hysteresis = 10;
+    greenhouse_status.work_mode = MODE_AUTO;
+    greenhouse_status.temperature = 24;
+    greenhouse_status.humidity = 50;
+    task_output(Greenhouse_Task, 50, &ns_new);      // 预热：报警和设备状态在此稳定
+    bytes_new = task_output(Greenhouse_Task, ROUNDS, &ns_new);
+    bytes_old = task_output(old_task, ROUNDS, &ns_old);
+
+    CHECK(bytes_new == 0);
+    CHECK(bytes_old > 100);
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "loop: Greenhouse_Task %.0f bytes %.2f us per call; old printf path %.1f bytes "
+                "%.2f us per call + %.2f ms blocked on USART1 (%.1f%% of the 200 ms period)\n",
+                bytes_new, ns_new / 1000, bytes_old, ns_old / 1000, bytes_old * us_per_byte / 1000,
+                bytes_old * us_per_byte / 2000);
+}
+
+int main(void)
+{
+    test_table();
+    test_exact();
+    test_dispatch();
+    test_args();
+    test_uart_path();
+    test_timing();
+    test_loop_time();
+    return host_report("greenhouse");
+}
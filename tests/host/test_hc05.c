@@ -0,0 +1,359 @@
+/**
+ * @file   test_hc05.c
+ * @brief  HC05 AT事务引擎：按毫秒驱动主循环，USART3发送环的输出交给HC05模型，模型按可配置的
+ *         延迟、错误和不应答把回复逐字节送回USART3接收中断；检查回调结果和顺序、重发次数、
+ *         KEY时序（KEY为高时线上只有AT命令）、超时，以及HC05_AT_Task从不阻塞主循环
+ */
+#include "host.h"
+#include "hc05.h"
+#include "usart3.h"
+#include <stdlib.h>
+#include <string.h>
+
+void USART3_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+
+// ===== HC05模型 =====
+
+#define REPLY_OK        0       // 回复参数行（查询命令）和OK
+#define REPLY_ERROR     1       // 回复ERROR:(0)
+#define REPLY_NONE      2       // 不回复
+
+typedef struct
+{
+    u8 mode;                    // REPLY_xxx
+    u16 latency;                // 收到命令到开始回复的毫秒数
+    u8 ignore;                  // 前几次收到的命令不回复
+    u32 key_rise;               // KEY上升沿时刻
+    u8 key;                     // 上一毫秒的KEY电平
+    char rx[64];                // 正在接收的命令
+    u8 rx_n;
+    char reply[64];             // 待发送的回复
+    u32 reply_at;               // 开始发送回复的时刻，0-无
+    u32 commands;               // 收到的AT命令数
+    u32 early;                  // KEY上升后不到HC05_AT_KEY_SETTLE就收到的字节
+    u32 leaked;                 // KEY为高时收到的非AT命令字节
+    u32 data;                   // KEY为低时收到的透传字节
+    char last_cmd[32];
+} Hc05Model_t;
+
+static Hc05Model_t hc;
+
+static void model_reset(u8 mode, u16 latency)
+{
+    memset(&hc, 0, sizeof(hc));
+    hc.mode = mode;
+    hc.latency = latency;
+}
+
+// AT模式下收到一个完整命令，按配置准备回复
+static void model_command(const char* cmd)
+{
+    const char* q;
+
+    hc.commands++;
+    strncpy(hc.last_cmd, cmd, sizeof(hc.last_cmd) - 1);
+    if(strncmp(cmd, "AT", 2) != 0) hc.leaked += strlen(cmd) + 2;
+    if(hc.ignore > 0)
+    {
+        hc.ignore--;
+        return;
+    }
+    switch(hc.mode)
+    {
+        case REPLY_OK:
+            // 查询命令"AT+XXX?"回复"+XXX:value"再回复OK
+            q = strchr(cmd, '?');
+            if(q != 0 && strncmp(cmd, "AT+", 3) == 0)
+                snprintf(hc.reply, sizeof(hc.reply), "+%.*s:SBH\r\nOK\r\n", (int)(q - cmd - 3), cmd + 3);
+            else
+                strcpy(hc.reply, "OK\r\n");
+            break;
+        case REPLY_ERROR:
+            strcpy(hc.reply, "ERROR:(0)\r\n");
+            break;
+        default:
+            return;
+    }
+    hc.reply_at = system_time_ms + hc.latency;
+}
+
+// 模型每毫秒运行一次：取走发送环的字节，到时间后送出回复
+static void model_tick(void)
+{
+    u8 buf[USART3_TX_RING_LEN];
+    u32 n, i;
+    const char* p;
+
+    if(HC05_KEY && !hc.key) hc.key_rise = system_time_ms;
+    hc.key = HC05_KEY;
+
+    n = host_dma_drain(DMA1_Channel2, 2, DMA1_Channel2_IRQHandler, buf, sizeof(buf));
+    for(i = 0; i < n; i++)
+    {
+        if(!hc.key)
+        {
+            hc.data++;
+            continue;
+        }
+        if(system_time_ms - hc.key_rise < HC05_AT_KEY_SETTLE) hc.early++;
+        if(buf[i] == '\n')
+        {
+            hc.rx[hc.rx_n] = '\0';
+            if(hc.rx_n > 0 && hc.rx[hc.rx_n - 1] == '\r') hc.rx[hc.rx_n - 1] = '\0';
+            model_command(hc.rx);
+            hc.rx_n = 0;
+        }
+        else if(hc.rx_n < sizeof(hc.rx) - 1) hc.rx[hc.rx_n++] = buf[i];
+    }
+
+    if(hc.reply_at != 0 && (s32)(system_time_ms - hc.reply_at) >= 0)
+    {
+        for(p = hc.reply; *p; p++) host_usart_rx(USART3, *p, 0, USART3_IRQHandler);
+        hc.reply_at = 0;
+    }
+}
+
+// ===== 主循环和回调 =====
+
+typedef struct
+{
+    u8 result;
+    char value[USART3_LINE_LEN];
+    u32 time;
+    u8 tag;
+} Done_t;
+
+static Done_t done[32];
+static u32 done_count;
+static u32 other_lines;             // 不属于AT应答、交给命令处理的行
+static u32 blocked;                 // HC05_AT_Task调用期间时间前进的次数
+
+static void record(u8 tag, u8 result, const char* value)
+{
+    if(done_count >= sizeof(done) / sizeof(done[0])) return;
+    done[done_count].result = result;
+    strncpy(done[done_count].value, value, sizeof(done[0].value) - 1);
+    done[done_count].time = system_time_ms;
+    done[done_count].tag = tag;
+    done_count++;
+}
+
+static void done_a(u8 result, const char* value) { record('A', result, value); }
+static void done_b(u8 result, const char* value) { record('B', result, value); }
+
+// 回调中提交下一个请求
+static void done_chain(u8 result, const char* value)
+{
+    record('C', result, value);
+    CHECK_EQ(HC05_AT_Submit("AT+VERSION?", done_b), 0);
+}
+
+// 主循环：每毫秒模型收发一次，取出接收行交给AT引擎或命令处理，运行AT任务
+static void run_ms(u32 ms)
+{
+    char line[USART3_LINE_LEN];
+    u32 t, before;
+
+    for(t = 0; t < ms; t++)
+    {
+        system_time_ms++;
+        model_tick();
+        while(USART3_Get_Line(line, sizeof(line)) > 0)
+            if(HC05_AT_Feed_Line(line) == 0) other_lines++;
+        before = system_time_ms;
+        HC05_AT_Task();
+        if(system_time_ms != before) blocked++;
+    }
+}
+
+// 运行到引擎空闲，最多limit毫秒，返回所用时间
+static u32 run_until_idle(u32 limit)
+{
+    u32 t0 = system_time_ms;
+
+    while(HC05_AT_Busy() && system_time_ms - t0 < limit) run_ms(1);
+    run_ms(2);
+    return system_time_ms - t0;
+}
+
+static void reset_results(void)
+{
+    done_count = 0;
+    other_lines = 0;
+}
+
+/**
+ * @brief  查询命令：各种回复延迟下回调得到OK和参数行，KEY先拉高、稳定后才发命令，完成后拉低
+ */
+static void test_query(void)
+{
+    static const char* const cmds[] = {"AT+NAME?", "AT+VERSION?", "AT+ADDR?", "AT+PSWD?", "AT+ROLE?"};
+    char expect[32];
+    u32 i, elapsed, t0, slow = 0;
+    u16 latency;
+
+    srand(24);
+    for(i = 0; i < 200; i++)
+    {
+        latency = rand() % (HC05_AT_TIMEOUT - 20);
+        model_reset(REPLY_OK, latency);
+        reset_results();
+        t0 = system_time_ms;
+        CHECK_EQ(HC05_AT_Submit(cmds[i % 5], done_a), 0);
+        CHECK(HC05_AT_Busy());
+        elapsed = run_until_idle(5000);
+        CHECK_EQ(done_count, 1);
+        CHECK_EQ(done[0].result, HC05_AT_OK);
+        snprintf(expect, sizeof(expect), "+%.*s:SBH", (int)strlen(cmds[i % 5]) - 4, cmds[i % 5] + 3);
+        CHECK(strcmp(done[0].value, expect) == 0);
+        CHECK_EQ(hc.commands, 1);
+        CHECK(strcmp(hc.last_cmd, cmds[i % 5]) == 0);
+        if(done[0].time - t0 > latency + HC05_AT_KEY_SETTLE + 5) slow++;
+        CHECK_EQ(HC05_KEY, 0);
+        CHECK(elapsed < 5000);
+    }
+    CHECK_EQ(slow, 0);
+    CHECK_EQ(hc.early, 0);
+    CHECK_EQ(hc.leaked, 0);
+    CHECK_EQ(other_lines, 0);
+    CHECK_EQ(blocked, 0);
+
+    // 设置命令只回复OK，参数为空
+    model_reset(REPLY_OK, 30);
+    reset_results();
+    HC05_AT_Submit("AT+NAME=SBH", done_a);
+    run_until_idle(5000);
+    CHECK_EQ(done_count, 1);
+    CHECK_EQ(done[0].result, HC05_AT_OK);
+    CHECK_EQ(done[0].value[0], '\0');
+}
+
+/**
+ * @brief  ERROR回复、不应答和前几次不应答：不应答时重发HC05_AT_RETRIES次后报HC05_AT_NO_REPLY，
+ *         每次等待HC05_AT_TIMEOUT；第三次才应答时结果为OK
+ */
+static void test_errors(void)
+{
+    u32 t0, elapsed;
+
+    model_reset(REPLY_ERROR, 50);
+    reset_results();
+    HC05_AT_Submit("AT+PSWD=1234", done_a);
+    run_until_idle(5000);
+    CHECK_EQ(done_count, 1);
+    CHECK_EQ(done[0].result, HC05_AT_ERROR);
+    CHECK_EQ(hc.commands, 1);
+
+    model_reset(REPLY_NONE, 0);
+    reset_results();
+    t0 = system_time_ms;
+    HC05_AT_Submit("AT", done_a);
+    elapsed = run_until_idle(10000);
+    CHECK_EQ(done_count, 1);
+    CHECK_EQ(done[0].result, HC05_AT_NO_REPLY);
+    CHECK_EQ(hc.commands, HC05_AT_RETRIES);
+    CHECK(done[0].time - t0 >= HC05_AT_RETRIES * (HC05_AT_KEY_SETTLE + HC05_AT_TIMEOUT));
+    CHECK(done[0].time - t0 <= HC05_AT_RETRIES * (HC05_AT_KEY_SETTLE + HC05_AT_TIMEOUT + 5));
+    CHECK(elapsed < 10000);
+    CHECK_EQ(HC05_KEY, 0);
+
+    model_reset(REPLY_OK, 20);
+    hc.ignore = 2;
+    reset_results();
+    HC05_AT_Submit("AT+ROLE?", done_a);
+    run_until_idle(10000);
+    CHECK_EQ(done_count, 1);
+    CHECK_EQ(done[0].result, HC05_AT_OK);
+    CHECK(strcmp(done[0].value, "+ROLE:SBH") == 0);
+    CHECK_EQ(hc.commands, 3);
+    CHECK_EQ(hc.early, 0);
+    CHECK_EQ(blocked, 0);
+}
+
+/**
+ * @brief  队列：按提交顺序逐个执行，满时拒绝，超长命令拒绝，回调中可以提交下一个请求
+ */
+static void test_queue(void)
+{
+    char longcmd[HC05_AT_CMD_LEN + 1];
+    u8 i;
+
+    model_reset(REPLY_OK, 10);
+    reset_results();
+    for(i = 0; i < HC05_AT_QUEUE_LEN; i++)
+        CHECK_EQ(HC05_AT_Submit((i & 1) ? "AT+ADDR?" : "AT+NAME?", (i & 1) ? done_b : done_a), 0);
+    CHECK_EQ(HC05_AT_Submit("AT", done_a), 1);
+    run_until_idle(5000);
+    CHECK_EQ(done_count, HC05_AT_QUEUE_LEN);
+    for(i = 0; i < done_count; i++)
+    {
+        CHECK_EQ(done[i].tag, (i & 1) ? 'B' : 'A');
+        CHECK(strcmp(done[i].value, (i & 1) ? "+ADDR:SBH" : "+NAME:SBH") == 0);
+    }
+    CHECK_EQ(hc.commands, HC05_AT_QUEUE_LEN);
+
+    memset(longcmd, 'A', sizeof(longcmd) - 1);
+    longcmd[sizeof(longcmd) - 1] = '\0';
+    CHECK_EQ(HC05_AT_Submit(longcmd, done_a), 1);
+    longcmd[HC05_AT_CMD_LEN - 1] = '\0';
+    CHECK_EQ(HC05_AT_Submit(longcmd, done_a), 0);
+    model_reset(REPLY_ERROR, 5);
+    reset_results();
+    run_until_idle(5000);
+    CHECK_EQ(done_count, 1);
+
+    model_reset(REPLY_OK, 10);
+    reset_results();
+    HC05_AT_Submit("AT+NAME?", done_chain);
+    run_until_idle(5000);
+    CHECK_EQ(done_count, 2);
+    CHECK_EQ(done[0].tag, 'C');
+    CHECK_EQ(done[1].tag, 'B');
+    CHECK(strcmp(done[1].value, "+VERSION:SBH") == 0);
+    CHECK_EQ(blocked, 0);
+}
+
+/**
+ * @brief  与其他USART3输出共用发送环：发送环里有数据时不拉高KEY，KEY为高时线上只有AT命令；
+ *         事务期间收到的普通命令行不被当作应答
+ */
+static void test_shared_line(void)
+{
+    const char* s;
+    u32 i;
+
+    model_reset(REPLY_OK, 40);
+    reset_results();
+    u3_printf("STATUS reply line 1\r\nline 2\r\n");
+    HC05_AT_Submit("AT+NAME?", done_a);
+    CHECK_EQ(HC05_KEY, 0);
+    HC05_AT_Task();
+    CHECK_EQ(HC05_KEY, 0);                  // 发送环未空
+    run_ms(5);
+    CHECK(hc.data > 0);
+    for(i = 0; i < 8 && HC05_AT_Busy(); i++)
+    {
+        // 事务期间手机发来的命令
+        for(s = "STATUS\r\n"; *s; s++) host_usart_rx(USART3, *s, 0, USART3_IRQHandler);
+        run_ms(3);
+    }
+    run_until_idle(5000);
+    CHECK_EQ(done_count, 1);
+    CHECK_EQ(done[0].result, HC05_AT_OK);
+    CHECK_EQ(hc.leaked, 0);
+    CHECK_EQ(hc.early, 0);
+    CHECK_EQ(other_lines, i);
+    CHECK(!HC05_AT_Busy());
+    CHECK_EQ(HC05_AT_Feed_Line("OK"), 0);   // 空闲时的OK不是应答
+}
+
+int main(void)
+{
+    HC05_KEY = 0;
+    test_query();
+    test_errors();
+    test_queue();
+    test_shared_line();
+    return host_report("hc05");
+}
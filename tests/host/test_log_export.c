@@ -0,0 +1,212 @@
+/**
+ * @file   test_log_export.c
+ * @brief  日志导出回环：写满一份模拟日志，经LogExport_Task和USART3的DMA发送环导出，
+ *         用tools/log_decode解码，与Flash中各记录环的记录槽逐字节比较；并测试断点续传和坏帧
+ */
+#include "host.h"
+#include "fakes.h"
+#include "log_flash.h"
+#include "log_export.h"
+#include "usart3.h"
+#include "log_decode.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_MAX     (256 * 1024)
+#define SLOTS_MAX       (LOG_PAGE_COUNT * LOG_SLOTS_PER_PAGE)
+
+void DMA1_Channel2_IRQHandler(void);
+
+static u8 capture[CAPTURE_MAX];
+static u32 capture_len;
+static LogFlashSlot_t expected[SLOTS_MAX];
+
+typedef struct
+{
+    LogFlashSlot_t slots[SLOTS_MAX];
+    u32 count;
+    u32 end_pos;
+    u8 ended;
+} Decoded_t;
+
+static Decoded_t decoded;
+
+static void on_frame(void* user, uint8_t type, uint32_t pos, const uint8_t* payload, uint8_t len)
+{
+    Decoded_t* d = (Decoded_t*)user;
+    u8 i;
+
+    if(type == LOG_DECODE_END)
+    {
+        d->ended = 1;
+        d->end_pos = pos;
+        return;
+    }
+    for(i = 0; i < len / LOG_RECORD_SIZE; i++)
+    {
+        if(d->count >= SLOTS_MAX) return;
+        d->slots[d->count].pos = pos + i;
+        memcpy(d->slots[d->count].rec.raw_data, payload + i * LOG_RECORD_SIZE, LOG_RECORD_SIZE);
+        d->count++;
+    }
+}
+
+/**
+ * @brief  运行导出任务并排空发送环，直到导出结束或发出max_frames个数据帧后停止
+ */
+static void run_export(u32 pos, u32 max_frames)
+{
+    u32 frames = 0, n;
+
+    LogExport_Start(pos);
+    while(LogExport_Active())
+    {
+        LogExport_Task();
+        n = host_dma_drain(DMA1_Channel2, 2, DMA1_Channel2_IRQHandler, capture + capture_len, CAPTURE_MAX - capture_len);
+        capture_len += n;
+        frames += n / LOG_EXPORT_FRAME_MAX;
+        if(max_frames != 0 && frames >= max_frames) LogExport_Stop();
+    }
+    capture_len += host_dma_drain(DMA1_Channel2, 2, DMA1_Channel2_IRQHandler, capture + capture_len, CAPTURE_MAX - capture_len);
+}
+
+static void decode(LogDecoder_t* dec)
+{
+    memset(&decoded, 0, sizeof(decoded));
+    LogDecode_Init(dec, on_frame, &decoded);
+    LogDecode_Feed(dec, capture, capture_len);
+}
+
+/**
+ * @brief  写一份模拟日志：缓慢变化的传感器样本（大多可压缩，偶尔状态变化另起一条），
+ *         穿插操作和报警记录；各环都写满一轮以上
+ */
+static void write_log(u32 t0, u32 samples)
+{
+    u32 i, t = t0;
+    int temp = 25, humi = 50, light = 60;
+    u8 fan = 0;
+
+    srand(1);
+    for(i = 0; i < samples; i++)
+    {
+        t += 1 + rand() % 3;
+        host_set_rtc(t);
+        temp += rand() % 3 - 1;
+        humi += rand() % 5 - 2;
+        light += rand() % 9 - 4;
+        if(temp < 10) temp = 10;
+        if(temp > 40) temp = 40;
+        if(humi < 20) humi = 20;
+        if(humi > 90) humi = 90;
+        if(light < 0) light = 0;
+        if(light > 100) light = 100;
+        if(i % 97 == 0) fan = !fan;
+        DataLogger_WriteSensorData(temp, humi, light, fan, 0, 0, 0, 0);
+        if(i % 20 == 0) DataLogger_WriteOperation(fan ? OP_FAN_ON : OP_FAN_OFF, !fan, fan, 0);
+        if(i % 30 == 0) DataLogger_WriteAlarm(ALARM_HIGH_TEMP_LOG, 2, temp, 35);
+        system_time_ms += 1000;
+    }
+    DataLogger_Flush();
+}
+
+static u32 compare(const LogFlashSlot_t* a, u32 na, const LogFlashSlot_t* b, u32 nb)
+{
+    u32 i, bad = 0;
+
+    CHECK_EQ(na, nb);
+    for(i = 0; i < na && i < nb; i++)
+    {
+        if(a[i].pos != b[i].pos || memcmp(a[i].rec.raw_data, b[i].rec.raw_data, LOG_RECORD_SIZE) != 0) bad++;
+    }
+    CHECK_EQ(bad, 0);
+    return bad;
+}
+
+static void test_full_export(void)
+{
+    LogDecoder_t dec;
+    u32 n;
+    u8 r;
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        n = log_flash_slots(r, expected, SLOTS_MAX);
+        CHECK(n > LOG_RECORDS_PER_PAGE);
+
+        capture_len = 0;
+        run_export(LOG_POS(r, 0, 0), 0);
+        decode(&dec);
+        CHECK_EQ(dec.crc_errors, 0);
+        CHECK_EQ(dec.skipped, 0);
+        CHECK(decoded.ended);
+        compare(decoded.slots, decoded.count, expected, n);
+        // 结束位置之后没有记录：从结束位置续传只得到结束帧
+        capture_len = 0;
+        run_export(decoded.end_pos, 0);
+        decode(&dec);
+        CHECK_EQ(decoded.count, 0);
+        CHECK(decoded.ended);
+    }
+}
+
+static void test_resume(void)
+{
+    static LogFlashSlot_t first_part[SLOTS_MAX];
+    LogDecoder_t dec;
+    u32 n, k, resume;
+
+    n = log_flash_slots(LOG_RING_SENSOR, expected, SLOTS_MAX);
+
+    // 传输一部分后断开，从最后一个完整帧之后续传
+    capture_len = 0;
+    run_export(LOG_POS(LOG_RING_SENSOR, 0, 0), 10);
+    decode(&dec);
+    CHECK(!decoded.ended);
+    CHECK(decoded.count > 0 && decoded.count < n);
+    k = decoded.count;
+    memcpy(first_part, decoded.slots, k * sizeof(LogFlashSlot_t));
+    resume = decoded.slots[k - 1].pos + 1;
+
+    capture_len = 0;
+    run_export(resume, 0);
+    decode(&dec);
+    CHECK(decoded.ended);
+    CHECK_EQ(k + decoded.count, n);
+    compare(first_part, k, expected, k);
+    if(k + decoded.count == n) compare(decoded.slots, decoded.count, expected + k, n - k);
+}
+
+static void test_corrupt_frame(void)
+{
+    LogDecoder_t dec;
+    u32 n;
+
+    n = log_flash_slots(LOG_RING_OPERATION, expected, SLOTS_MAX);
+    capture_len = 0;
+    run_export(LOG_POS(LOG_RING_OPERATION, 0, 0), 0);
+
+    // 第3帧的payload中改一个字节：只丢这一帧，其余帧照常解码
+    capture[2 * LOG_EXPORT_FRAME_MAX + LOG_EXPORT_HEADER_LEN + 5] ^= 0x40;
+    decode(&dec);
+    CHECK_EQ(dec.crc_errors, 1);
+    CHECK(decoded.ended);
+    CHECK_EQ(decoded.count, n - LOG_EXPORT_RECORDS);
+    compare(decoded.slots, 2 * LOG_EXPORT_RECORDS, expected, 2 * LOG_EXPORT_RECORDS);
+    compare(decoded.slots + 2 * LOG_EXPORT_RECORDS, decoded.count - 2 * LOG_EXPORT_RECORDS,
+            expected + 3 * LOG_EXPORT_RECORDS, n - 3 * LOG_EXPORT_RECORDS);
+}
+
+int main(void)
+{
+    host_flash_reset();
+    host_set_rtc(1750000000);
+    DataLogger_Init();
+    write_log(1750000000, 16000);
+    CHECK_EQ(host_flash_misuse, 0);
+
+    test_full_export();
+    test_resume();
+    test_corrupt_frame();
+    return host_report("log_export");
+}
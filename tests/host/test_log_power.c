@@ -0,0 +1,424 @@
+/**
+ * @file   test_log_power.c
+ * @brief  Flash数据记录器掉电一致性：一段跨越各环开页、封页和擦除的写入中，在每一个编程/擦除步
+ *         掉电后重启，各环的记录都是已提交记录中连续的一段（无残缺、无乱码），已写入的记录不丢，
+ *         统计与Flash一致，之后可以继续写入；重启恢复本身掉电也同样检查；
+ *         擦除中途掉电后页头已擦净、页内仍有残留位的页在使用前重新擦除
+ * @note   直接包含data_logger.c以读取各环的写入位置；Flash内容由log_flash.c独立读出作为参照
+ */
+#include "host.h"
+#include "fakes.h"
+#include "log_flash.h"
+#include "../../APP/data_logger/data_logger.c"
+#include <stdlib.h>
+
+#define SLOTS_MAX       (LOG_PAGE_COUNT * LOG_SLOTS_PER_PAGE)
+#define SAMPLES_MAX     (SLOTS_MAX * LOG_PACK_SAMPLES)
+#define SUBMIT_MAX      16000
+#define W_ROUNDS        12
+#define W_MAX           (W_ROUNDS * 5)
+#define W_STEPS_MAX     1024
+#define ERASE_TRIALS    64          // 擦除中途掉电的结果是随机的，擦除步多试几次
+
+#define OP_SENSOR       0
+#define OP_OPERATION    1
+#define OP_ALARM        2
+#define OP_FLUSH        3
+
+typedef struct
+{
+    u8 kind;
+    u8 value;
+} Step_t;
+
+// 各环按提交顺序的全部记录（不含提交字节）
+static LogRecord_t submitted[LOG_RING_COUNT][SUBMIT_MAX];
+static u32 submitted_count[LOG_RING_COUNT];
+
+static Step_t w[W_MAX];
+static u32 w_count;
+static u32 dry_steps[W_MAX];                            // 干跑中每个操作完成时的步数
+static u32 dry_newest[W_MAX + 1][LOG_RING_COUNT];       // 每个操作完成后Flash中最新记录的序号
+static u32 dry_oldest[W_MAX + 1][LOG_RING_COUNT];       // 每个操作完成后Flash中最旧记录的序号
+
+static u8 snapshot[HOST_FLASH_SIZE];
+static u8 cut_image[HOST_FLASH_SIZE];
+static u32 snapshot_now, snapshot_submitted[LOG_RING_COUNT];
+static LogFlashSlot_t slots[SLOTS_MAX];
+static SensorLogRecord_t samples[SAMPLES_MAX];
+static u32 now;
+static u32 bad_boot, bad_resume, nested_cuts;
+
+static void advance(u32 seconds)
+{
+    now += seconds;
+    host_set_rtc(now);
+    system_time_ms += seconds * 1000;
+}
+
+static void submit(u8 ring, const LogRecord_t* rec)
+{
+    if(submitted_count[ring] < SUBMIT_MAX) submitted[ring][submitted_count[ring]++] = *rec;
+}
+
+/**
+ * @brief  执行一个操作，同时记下应写入的记录
+ * @note   记录内容只由操作本身决定；传感器样本value为奇数时光照跳变（单独成一条记录），
+ *         为偶数时与value+1的样本相差1，可追加到其后的压缩记录
+ */
+static void run(const Step_t* s)
+{
+    LogRecord_t rec;
+    u8 light;
+
+    memset(&rec, 0, sizeof(rec));
+    switch(s->kind)
+    {
+        case OP_SENSOR:
+            advance(1 + s->value % 3);
+            light = (s->value & 1) ? (s->value * 29) & 0x7F : (((s->value + 1) * 29) & 0x7F) + 1;
+            rec.sensor.timestamp = now;
+            rec.sensor.log_type = LOG_TYPE_SENSOR;
+            rec.sensor.temperature = 20 + s->value % 4;
+            rec.sensor.humidity = 60;
+            rec.sensor.light = light;
+            rec.sensor.work_mode = 1;
+            submit(LOG_RING_SENSOR, &rec);
+            DataLogger_WriteSensorData(rec.sensor.temperature, 60, light, 0, 0, 0, 1, 0);
+            break;
+        case OP_OPERATION:
+            advance(1);
+            rec.operation.timestamp = now;
+            rec.operation.log_type = LOG_TYPE_OPERATION;
+            rec.operation.operation = OP_FAN_ON;
+            rec.operation.old_value = s->value;
+            rec.operation.new_value = s->value + 1;
+            rec.operation.trigger_mode = 1;
+            submit(LOG_RING_OPERATION, &rec);
+            DataLogger_WriteOperation(OP_FAN_ON, s->value, s->value + 1, 1);
+            break;
+        case OP_ALARM:
+            advance(1);
+            rec.alarm.timestamp = now;
+            rec.alarm.log_type = LOG_TYPE_ALARM;
+            rec.alarm.alarm_type = ALARM_LOW_LIGHT_LOG;
+            rec.alarm.alarm_level = 2;
+            rec.alarm.trigger_value = s->value;
+            rec.alarm.threshold = 20;
+            submit(LOG_RING_ALARM, &rec);
+            DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 2, s->value, 20);
+            break;
+        default:
+            DataLogger_Flush();
+            break;
+    }
+}
+
+/**
+ * @brief  读出一个环在Flash中的全部记录，与提交序列比较
+ * @param  oldest/newest: 输出Flash中最旧/最新记录在提交序列中的序号（环为空时均为0xFFFFFFFF）
+ * @retval 1-Flash中的记录恰为提交序列中连续的一段
+ */
+static u8 ring_contents(u8 r, u32* oldest, u32* newest, u32* count)
+{
+    u32 n, k, i, start;
+
+    n = log_flash_slots(r, slots, SLOTS_MAX);
+    k = log_flash_expand(slots, n, samples, SAMPLES_MAX);
+    *count = k;
+    *oldest = *newest = 0xFFFFFFFF;
+    if(k == 0) return 1;
+
+    for(start = 0; start < submitted_count[r]; start++)
+        if(memcmp(&submitted[r][start], &samples[0], LOG_RECORD_SIZE - 1) == 0) break;
+    if(start + k > submitted_count[r]) return 0;
+    for(i = 1; i < k; i++)
+        if(memcmp(&submitted[r][start + i], &samples[i], LOG_RECORD_SIZE - 1) != 0) return 0;
+    *oldest = start;
+    *newest = start + k - 1;
+    return 1;
+}
+
+/**
+ * @brief  重启后的检查：各环连续、统计与Flash一致；durable/oldest为0时不检查对应界限
+ */
+static u8 check_after_boot(const u32* durable, const u32* oldest_bound)
+{
+    DataLoggerInfo_t info;
+    u32 oldest, newest, count, total = 0;
+    u8 r, ok = 1;
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        if(!ring_contents(r, &oldest, &newest, &count)) ok = 0;
+        // 已写入Flash的记录不丢
+        if(durable != 0 && durable[r] != 0xFFFFFFFF && (newest == 0xFFFFFFFF || newest < durable[r])) ok = 0;
+        // 最多失去正在擦除的一页
+        if(oldest_bound != 0 && oldest_bound[r] != 0xFFFFFFFF && oldest > oldest_bound[r]) ok = 0;
+        total += count;
+    }
+    DataLogger_GetInfo(&info);
+    if(info.total_records != total) ok = 0;
+    return ok;
+}
+
+/**
+ * @brief  重启后继续写入：每个环新写的记录紧接在Flash中原有的最新记录之后
+ * @note   掉电时未写入的记录从提交序列中去掉
+ */
+static u8 check_resume(void)
+{
+    static const Step_t more[4] = {{OP_SENSOR, 1}, {OP_OPERATION, 77}, {OP_ALARM, 78}, {OP_FLUSH, 0}};
+    u32 oldest, newest, count;
+    u8 i, r, ok = 1;
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        ring_contents(r, &oldest, &newest, &count);
+        if(newest != 0xFFFFFFFF) submitted_count[r] = newest + 1;
+    }
+    for(i = 0; i < 4; i++) run(&more[i]);
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        if(!ring_contents(r, &oldest, &newest, &count)) ok = 0;
+        if(newest != submitted_count[r] - 1) ok = 0;
+    }
+    return ok;
+}
+
+/**
+ * @brief  恢复到写入W之前的状态：Flash、时间和提交序列
+ */
+static void restore(void)
+{
+    u8 r;
+
+    memcpy((void*)HOST_FLASH_BASE, snapshot, HOST_FLASH_SIZE);
+    now = snapshot_now;
+    host_set_rtc(now);
+    for(r = 0; r < LOG_RING_COUNT; r++) submitted_count[r] = snapshot_submitted[r];
+}
+
+/**
+ * @brief  预写入：各环都已回绕，写入页只剩几个空槽，使W中每个环都要封页、擦除最旧页和开新页
+ */
+static void warm_up(void)
+{
+    Step_t s;
+    u32 i;
+    u8 r;
+
+    fake_config[CONFIG_LOG_OPERATION_PAGES] = 2;
+    fake_config[CONFIG_LOG_ALARM_PAGES] = 2;
+    host_flash_reset();
+    now = 1750000000;
+    host_set_rtc(now);
+    DataLogger_Init();
+
+    for(i = 0; i < (LOG_PAGE_COUNT - 4) * LOG_RECORDS_PER_PAGE + 300; i++)
+    {
+        s.kind = OP_SENSOR;
+        s.value = 2 * i + 1;
+        run(&s);
+        if(i % 10 == 0)
+        {
+            s.kind = OP_OPERATION;
+            run(&s);
+            s.kind = OP_ALARM;
+            run(&s);
+        }
+    }
+    DataLogger_Flush();
+
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        s.kind = r;
+        s.value = 1;
+        while(log_rings[r].current_offset != LOG_SLOTS_PER_PAGE - 4)
+        {
+            run(&s);
+            DataLogger_Flush();
+        }
+    }
+}
+
+/**
+ * @brief  W中第k步编程/擦除到一半时掉电，重启后检查；重启恢复过程中如有编程/擦除，
+ *         再在其中每一步掉电，再次重启检查
+ * @param  seed: 加到步数上，改变中途掉电时留下的随机内容
+ * @retval 1-第k步是页擦除
+ */
+static u8 cut_at(u32 k, u32 seed)
+{
+    u32 durable[LOG_RING_COUNT], bound[LOG_RING_COUNT], cut_submitted[LOG_RING_COUNT];
+    u32 base, j, init_steps;
+    volatile u32 i, done = 0;
+    u8 r, in_erase;
+
+    restore();
+    DataLogger_Init();
+    host_flash_steps += seed;
+    base = host_flash_steps;
+    host_power_cut_at(base + k);
+    if(setjmp(host_power_lost) == 0)
+    {
+        for(i = 0; i < w_count; i++)
+        {
+            run(&w[i]);
+            done = i + 1;
+        }
+    }
+    host_power_cut_at(0);
+    in_erase = host_power_lost_in_erase;
+
+    // 掉电前已完成的操作写入的记录不丢；正在执行的操作最多擦掉它要擦的页
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        durable[r] = dry_newest[done][r];
+        bound[r] = dry_oldest[done < w_count ? done + 1 : done][r];
+    }
+    memcpy(cut_image, (void*)HOST_FLASH_BASE, HOST_FLASH_SIZE);
+    for(r = 0; r < LOG_RING_COUNT; r++) cut_submitted[r] = submitted_count[r];
+
+    base = host_flash_steps;
+    DataLogger_Init();
+    init_steps = host_flash_steps - base;
+    if(!check_after_boot(durable, bound)) bad_boot++;
+    if(!check_resume()) bad_resume++;
+
+    for(j = 1; j <= init_steps; j++)
+    {
+        memcpy((void*)HOST_FLASH_BASE, cut_image, HOST_FLASH_SIZE);
+        for(r = 0; r < LOG_RING_COUNT; r++) submitted_count[r] = cut_submitted[r];
+        host_power_cut_at(host_flash_steps + j);
+        if(setjmp(host_power_lost) == 0) DataLogger_Init();
+        host_power_cut_at(0);
+        DataLogger_Init();
+        if(!check_after_boot(durable, bound)) bad_boot++;
+        nested_cuts++;
+    }
+    return in_erase;
+}
+
+/**
+ * @brief  每一步掉电：预写入后固定的一段写入W，干跑记下每个操作完成后的步数和各环首末记录，
+ *         再从同一Flash内容出发在W的每一步掉电
+ */
+static void test_power_loss(void)
+{
+    static u8 erase_step[W_STEPS_MAX + 1];
+    u32 count, base, total, k, t, cuts = 0, erase_cuts = 0;
+    u32 i;
+    u8 r;
+
+    warm_up();
+    for(r = 0; r < LOG_RING_COUNT; r++)
+        CHECK(LOG_PAGE_HEADER(log_rings[r].current_page)->seq >= log_rings[r].page_count);
+
+    // W：交替写入各类记录，偶尔主动写入暂存区
+    w_count = 0;
+    for(i = 0; i < W_ROUNDS; i++)
+    {
+        w[w_count].kind = OP_SENSOR;    w[w_count++].value = 2 * i + 1;
+        w[w_count].kind = OP_SENSOR;    w[w_count++].value = 2 * i;
+        w[w_count].kind = OP_OPERATION; w[w_count++].value = i;
+        if(i % 2 == 0) { w[w_count].kind = OP_ALARM; w[w_count++].value = i; }
+        if(i % 4 == 3) { w[w_count].kind = OP_FLUSH; w[w_count++].value = 0; }
+    }
+
+    memcpy(snapshot, (void*)HOST_FLASH_BASE, HOST_FLASH_SIZE);
+    snapshot_now = now;
+    for(r = 0; r < LOG_RING_COUNT; r++) snapshot_submitted[r] = submitted_count[r];
+    DataLogger_Init();
+    base = host_flash_steps;
+    for(r = 0; r < LOG_RING_COUNT; r++)
+        ring_contents(r, &dry_oldest[0][r], &dry_newest[0][r], &count);
+    for(i = 0; i < w_count; i++)
+    {
+        run(&w[i]);
+        dry_steps[i] = host_flash_steps - base;
+        for(r = 0; r < LOG_RING_COUNT; r++)
+            CHECK(ring_contents(r, &dry_oldest[i + 1][r], &dry_newest[i + 1][r], &count));
+    }
+    total = dry_steps[w_count - 1];
+    CHECK(total > 200 && total <= W_STEPS_MAX);
+    for(r = 0; r < LOG_RING_COUNT; r++)
+        CHECK(log_rings[r].current_offset < LOG_SLOTS_PER_PAGE - 4);      // 每个环都开了新页
+    CHECK_EQ(host_flash_misuse, 0);
+
+    for(k = 1; k <= total && k <= W_STEPS_MAX; k++)
+    {
+        erase_step[k] = cut_at(k, 0);
+        cuts++;
+    }
+    for(k = 1; k <= total && k <= W_STEPS_MAX; k++)
+    {
+        if(!erase_step[k]) continue;
+        for(t = 1; t < ERASE_TRIALS; t++) cut_at(k, t * 7919);
+        erase_cuts++;
+    }
+    CHECK_EQ(cuts, total);
+    CHECK(erase_cuts >= LOG_RING_COUNT);
+    CHECK(nested_cuts > 0);
+    CHECK_EQ(bad_boot, 0);
+    CHECK_EQ(bad_resume, 0);
+    CHECK_EQ(host_flash_misuse, 0);
+    printf("power: %lu steps, %lu erase steps x %u, %lu cuts during recovery\n", (unsigned long)total,
+           (unsigned long)erase_cuts, ERASE_TRIALS, (unsigned long)nested_cuts);
+}
+
+/**
+ * @brief  擦除中途掉电留下的页：页头和第一个记录槽已全为0xFF，后面的槽里残留部分未擦除的位，
+ *         擦除计数也已擦掉。重启后该页作为预擦除页要先擦净，写入跨过这一页的记录完整可读
+ */
+static void test_torn_erase(void)
+{
+    LogRing_t* ring = &log_rings[LOG_RING_SENSOR];
+    volatile u32* word;
+    u32 i, erases, torn = 0;
+    u16 next;
+    Step_t s;
+
+    restore();
+    DataLogger_Init();
+    next = DataLogger_RingPage(ring, ring->current_page, 1);
+    word = (volatile u32*)LOG_PAGE_ADDR(next);
+    srand(19);
+    for(i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        word[i] = 0xFFFFFFFF;
+        if(i >= (LOG_HEADER_SLOTS + 1) * LOG_RECORD_SIZE / 4 && rand() % 8 == 0)
+        {
+            word[i] &= ~(1u << (rand() % 32));
+            torn++;
+        }
+    }
+    CHECK(torn > 0);
+
+    erases = host_flash_erases;
+    DataLogger_Init();
+    CHECK_EQ(host_flash_erases, erases + 1);
+    CHECK(DataLogger_PageBlank(next));
+    CHECK(LOG_PAGE_HEADER(next)->erase_count != 0xFFFFFFFF);
+
+    // 写入跨过这一页：每条传感器记录单独占一个槽
+    s.kind = OP_SENSOR;
+    for(i = 0; i < 40; i++)
+    {
+        s.value = 2 * i + 1;
+        run(&s);
+    }
+    DataLogger_Flush();
+    CHECK_EQ(ring->current_page, next);
+    CHECK(check_after_boot(0, 0));
+    DataLogger_Init();
+    CHECK(check_after_boot(0, 0));
+    CHECK_EQ(host_flash_misuse, 0);
+}
+
+int main(void)
+{
+    test_power_loss();
+    test_torn_erase();
+    return host_report("log_power");
+}
@@ -0,0 +1,168 @@
+/**
+ * @file   test_lsens.c
+ * @brief  光敏传感器过采样：按ADC3连续转换+DMA2通道5循环传输的方式向缓冲区写入恒定、斜坡和
+ *         锯齿（数值0~4095回绕）样本流，缓冲区多次回绕，每次半传输/传输完成中断后的过采样值
+ *         与最近256个样本的暴力求和一致，最新样本随DMA位置正确回绕；
+ *         Lsens_Raw_To_Percent在0、满量程、越界和各百分比分界处的取值
+ */
+#include "host.h"
+#include "lsens.h"
+#include <string.h>
+
+void DMA2_Channel4_5_IRQHandler(void);
+
+// ===== ADC3：连续转换由测试驱动，校准立即完成 =====
+
+void ADC_DeInit(ADC_TypeDef* ADCx) {}
+void ADC_Init(ADC_TypeDef* ADCx, ADC_InitTypeDef* ADC_InitStruct) {}
+void ADC_RegularChannelConfig(ADC_TypeDef* ADCx, uint8_t ADC_Channel, uint8_t Rank, uint8_t ADC_SampleTime) {}
+void ADC_DMACmd(ADC_TypeDef* ADCx, FunctionalState NewState) {}
+void ADC_Cmd(ADC_TypeDef* ADCx, FunctionalState NewState) {}
+void ADC_ResetCalibration(ADC_TypeDef* ADCx) {}
+FlagStatus ADC_GetResetCalibrationStatus(ADC_TypeDef* ADCx) { return RESET; }
+void ADC_StartCalibration(ADC_TypeDef* ADCx) {}
+FlagStatus ADC_GetCalibrationStatus(ADC_TypeDef* ADCx) { return RESET; }
+void ADC_SoftwareStartConvCmd(ADC_TypeDef* ADCx, FunctionalState NewState) {}
+
+#define STREAM_MAX  (LSENS_BUF_LEN * 12)
+
+static u16 stream[STREAM_MAX];      // 已转换的全部样本
+static u32 stream_count;
+static u32 bad_raw, bad_adc;
+
+/**
+ * @brief  ADC完成一次转换：DMA把样本写入当前位置，到半满和写满时置标志并进中断，写满后循环
+ */
+static void adc_sample(u16 value)
+{
+    DMA_Channel_TypeDef* ch = LSENS_DMA_CH;
+    volatile u16* buf = (volatile u16*)(uintptr_t)ch->CMAR;
+
+    buf[LSENS_BUF_LEN - ch->CNDTR] = value;
+    stream[stream_count++] = value;
+    ch->CNDTR--;
+    if(ch->CNDTR == LSENS_BUF_LEN / 2)
+    {
+        DMA2->ISR = DMA_ISR_GIF5 | DMA_ISR_HTIF5;
+        DMA2_Channel4_5_IRQHandler();
+    }
+    if(ch->CNDTR == 0)
+    {
+        ch->CNDTR = LSENS_BUF_LEN;
+        DMA2->ISR = DMA_ISR_GIF5 | DMA_ISR_TCIF5;
+        DMA2_Channel4_5_IRQHandler();
+    }
+}
+
+/**
+ * @brief  暴力计算：最近一次半满/写满时刻之前的256个样本之和右移4位
+ */
+static u16 expected_raw(void)
+{
+    u32 end = stream_count - stream_count % (LSENS_BUF_LEN / 2);
+    u32 start = (end > LSENS_BUF_LEN) ? end - LSENS_BUF_LEN : 0;
+    u32 sum = 0, i;
+
+    for(i = start; i < end; i++) sum += stream[i];
+    return (u16)(sum >> LSENS_OVERSAMPLE_SHIFT);
+}
+
+// 每个样本之后比较过采样值和最新样本
+static void feed(u16 value)
+{
+    adc_sample(value);
+    if(Lsens_Get_Raw() != expected_raw()) bad_raw++;
+    if(Lsens_Get_Adc() != value) bad_adc++;
+}
+
+/**
+ * @brief  恒定样本：过采样值为样本的16倍，满量程时为LSENS_RAW_MAX；
+ *         交替v和v+1时得到12位分辨率以下的中间值
+ */
+static void test_constant(void)
+{
+    static const u16 levels[] = {0, 1, 2048, 4094, 4095};
+    u32 i, k;
+
+    Lsens_Init();
+    CHECK_EQ(LSENS_DMA_CH->CNDTR, LSENS_BUF_LEN);
+    CHECK(LSENS_DMA_CH->CCR & DMA_CCR1_CIRC);
+    CHECK_EQ(Lsens_Get_Raw(), 0);
+
+    for(k = 0; k < sizeof(levels) / sizeof(levels[0]); k++)
+    {
+        for(i = 0; i < LSENS_BUF_LEN; i++) feed(levels[k]);
+        CHECK_EQ(Lsens_Get_Raw(), levels[k] * 16);
+        CHECK_EQ(Lsens_Get_Adc(), levels[k]);
+    }
+    CHECK_EQ(Lsens_Get_Raw(), LSENS_RAW_MAX);
+    CHECK_EQ(Lsens_Get_Val(), 0);
+
+    for(i = 0; i < LSENS_BUF_LEN; i++) feed(1000 + (i & 1));
+    CHECK_EQ(Lsens_Get_Raw(), 1000 * 16 + 8);
+    for(i = 0; i < LSENS_BUF_LEN; i++) feed(0);
+    CHECK_EQ(Lsens_Get_Val(), 100);
+    CHECK_EQ(bad_raw, 0);
+    CHECK_EQ(bad_adc, 0);
+}
+
+/**
+ * @brief  斜坡和锯齿样本流：缓冲区回绕多次，每个样本后过采样值都等于最近的半缓冲边界前
+ *         256个样本的和，最新样本在DMA位置回到缓冲区开头时取缓冲区末尾
+ */
+static void test_streams(void)
+{
+    u32 i;
+
+    stream_count = 0;
+    bad_raw = bad_adc = 0;
+    for(i = 0; i < LSENS_BUF_LEN * 5; i++) feed((u16)(i * 4095 / (LSENS_BUF_LEN * 5)));
+    for(i = 0; i < LSENS_BUF_LEN * 5; i++) feed((u16)((i * 97) % 4096));
+    // 半缓冲之间改变的样本在下一个边界才计入
+    for(i = 0; i < LSENS_BUF_LEN + 100; i++) feed((i < LSENS_BUF_LEN) ? 4095 : 0);
+    CHECK_EQ(Lsens_Get_Raw(), LSENS_RAW_MAX);
+    for(i = 0; i < LSENS_BUF_LEN / 2 - 100; i++) feed(0);
+    CHECK_EQ(Lsens_Get_Raw(), LSENS_RAW_MAX / 2);
+    CHECK_EQ(bad_raw, 0);
+    CHECK_EQ(bad_adc, 0);
+    CHECK(stream_count > LSENS_BUF_LEN * 10);
+}
+
+/**
+ * @brief  百分比换算：光照越强ADC值越小；0为100%，满量程及以上为0%，其间单调不增且每个百分比都能取到；
+ *         分界点手算：raw*100/65520取整，655->100%、656->99%、65519->1%
+ */
+static void test_percent(void)
+{
+    u8 seen[101];
+    u32 raw, bad = 0;
+    u8 p, last = 100;
+
+    CHECK_EQ(LSENS_RAW_MAX, 65520);
+    CHECK_EQ(Lsens_Raw_To_Percent(0), 100);
+    CHECK_EQ(Lsens_Raw_To_Percent(655), 100);
+    CHECK_EQ(Lsens_Raw_To_Percent(656), 99);
+    CHECK_EQ(Lsens_Raw_To_Percent(32760), 50);
+    CHECK_EQ(Lsens_Raw_To_Percent(65519), 1);
+    CHECK_EQ(Lsens_Raw_To_Percent(LSENS_RAW_MAX), 0);
+    CHECK_EQ(Lsens_Raw_To_Percent(0xFFFF), 0);
+
+    memset(seen, 0, sizeof(seen));
+    for(raw = 0; raw <= 0xFFFF; raw++)
+    {
+        p = Lsens_Raw_To_Percent((u16)raw);
+        if(p > last || p > 100) bad++;
+        else seen[p] = 1;
+        last = p;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK(memchr(seen, 0, sizeof(seen)) == 0);
+}
+
+int main(void)
+{
+    test_constant();
+    test_streams();
+    test_percent();
+    return host_report("lsens");
+}
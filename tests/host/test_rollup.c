@@ -0,0 +1,253 @@
+/**
+ * @file   test_rollup.c
+ * @brief  小时/日汇总：随机样本跨越多个整点和零点，期间多次重启（含停机跨过零点），
+ *         各时段汇总的样本数、累加值、最值和操作/报警计数与逐条扫描Flash的结果一致；
+ *         DataLogger_GetDailyStats读汇总和汇总缺失时扫描记录得到的结果都与逐条扫描一致
+ * @note   Flash内容由log_flash.c独立读出作为参照；重启前先写入暂存记录，
+ *         否则复位丢失的暂存记录已计入此前写入Flash的汇总，两者本就不一致
+ */
+#include "host.h"
+#include "fakes.h"
+#include "log_flash.h"
+#include "data_logger.h"
+#include "data_rollup.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SLOTS_MAX       (LOG_PAGE_COUNT * LOG_SLOTS_PER_PAGE)
+#define SAMPLES_MAX     (SLOTS_MAX * LOG_PACK_SAMPLES)
+
+#define START_TIME      1750000000      // 某日15:06:40
+#define RUN_SECONDS     (58 * 3600)     // 跨过两个零点，小时汇总环不回绕
+
+static LogFlashSlot_t slots[SLOTS_MAX];
+static SensorLogRecord_t samples[SAMPLES_MAX];
+static SensorLogRecord_t records[SAMPLES_MAX];
+static u32 record_count;
+static u32 now;
+static u32 written;                     // 写入的记录数
+static u32 reboots;
+
+static void advance(u32 seconds)
+{
+    now += seconds;
+    host_set_rtc(now);
+    system_time_ms += seconds * 1000;
+}
+
+/**
+ * @brief  重启：写入暂存记录后按复位后的顺序重新初始化，汇总的当前时段从记录重放
+ */
+static void reboot(void)
+{
+    DataLogger_Flush();
+    DataLogger_Init();
+    reboots++;
+}
+
+/**
+ * @brief  逐条扫描Flash，列出各环的全部记录（压缩记录展开）
+ */
+static void scan(void)
+{
+    u32 n, k;
+    u8 r;
+
+    record_count = 0;
+    for(r = 0; r < LOG_RING_COUNT; r++)
+    {
+        n = log_flash_slots(r, slots, SLOTS_MAX);
+        if(n == 0) continue;
+        k = log_flash_expand(slots, n, samples, SAMPLES_MAX);
+        memcpy(&records[record_count], samples, k * sizeof(SensorLogRecord_t));
+        record_count += k;
+    }
+}
+
+/**
+ * @brief  用扫描得到的记录计算[start, start + seconds)的汇总
+ * @retval 1-该时段有记录
+ */
+static u8 expect(u32 start, u32 seconds, LogRollup_t* out)
+{
+    const SensorLogRecord_t* s;
+    u8 found = 0;
+    u32 i;
+
+    memset(out, 0, sizeof(*out));
+    out->period_start = start;
+    out->temp_min = out->humi_min = out->light_min = 0xFF;
+    for(i = 0; i < record_count; i++)
+    {
+        s = &records[i];
+        if(s->timestamp < start || s->timestamp - start >= seconds) continue;
+        found = 1;
+        if(s->log_type == LOG_TYPE_OPERATION) out->operations++;
+        if(s->log_type == LOG_TYPE_ALARM) out->alarms++;
+        if(s->log_type != LOG_TYPE_SENSOR) continue;
+        out->samples++;
+        out->temp_sum += s->temperature;
+        out->humi_sum += s->humidity;
+        out->light_sum += s->light;
+        if(s->temperature < out->temp_min) out->temp_min = s->temperature;
+        if(s->temperature > out->temp_max) out->temp_max = s->temperature;
+        if(s->humidity < out->humi_min) out->humi_min = s->humidity;
+        if(s->humidity > out->humi_max) out->humi_max = s->humidity;
+        if(s->light < out->light_min) out->light_min = s->light;
+        if(s->light > out->light_max) out->light_max = s->light;
+    }
+    return found;
+}
+
+static void check_rollup(const LogRollup_t* a, const LogRollup_t* b)
+{
+    CHECK_EQ(a->period_start, b->period_start);
+    CHECK_EQ(a->samples, b->samples);
+    CHECK_EQ(a->temp_sum, b->temp_sum);
+    CHECK_EQ(a->humi_sum, b->humi_sum);
+    CHECK_EQ(a->light_sum, b->light_sum);
+    CHECK_EQ(a->operations, b->operations);
+    CHECK_EQ(a->alarms, b->alarms);
+    if(b->samples == 0) return;
+    CHECK_EQ(a->temp_min, b->temp_min);
+    CHECK_EQ(a->temp_max, b->temp_max);
+    CHECK_EQ(a->humi_min, b->humi_min);
+    CHECK_EQ(a->humi_max, b->humi_max);
+    CHECK_EQ(a->light_min, b->light_min);
+    CHECK_EQ(a->light_max, b->light_max);
+}
+
+/**
+ * @brief  逐个时段比较汇总与扫描结果，无记录的时段不应有汇总
+ * @retval 比较的有记录时段数
+ */
+static u32 check_periods(u8 period, u32 seconds)
+{
+    LogRollup_t got, want;
+    u32 t, periods = 0;
+
+    for(t = START_TIME - START_TIME % seconds; t <= now; t += seconds)
+    {
+        if(expect(t, seconds, &want))
+        {
+            CHECK(DataRollup_Get(period, t + rand() % seconds, &got) == 0);
+            check_rollup(&got, &want);
+            periods++;
+        }
+        else
+        {
+            CHECK(DataRollup_Get(period, t, &got) != 0);
+        }
+    }
+    return periods;
+}
+
+/**
+ * @brief  逐日比较日统计与扫描结果（平均值取整方式与固件相同）
+ */
+static void check_daily(void)
+{
+    LogRollup_t want;
+    u8 temp, humi, light;
+    u16 ops;
+    u32 t;
+
+    for(t = START_TIME - START_TIME % ROLLUP_DAY_SECONDS; t <= now; t += ROLLUP_DAY_SECONDS)
+    {
+        expect(t, ROLLUP_DAY_SECONDS, &want);
+        CHECK(DataLogger_GetDailyStats(t + rand() % ROLLUP_DAY_SECONDS, &temp, &humi, &light, &ops) == 0);
+        CHECK_EQ(ops, want.operations);
+        CHECK_EQ(temp, want.samples ? want.temp_sum / want.samples : 0);
+        CHECK_EQ(humi, want.samples ? want.humi_sum / want.samples : 0);
+        CHECK_EQ(light, want.samples ? want.light_sum / want.samples : 0);
+    }
+}
+
+/**
+ * @brief  随机写入：样本间隔1~300秒，偶尔停采一两个小时（留下无记录的整点），
+ *         数值取满量程随机值（压缩和不压缩的记录都有），穿插操作和报警记录；
+ *         随机时刻重启，其中一次停机跨过零点
+ */
+static void test_rollup(void)
+{
+    u32 end = START_TIME + RUN_SECONDS;
+    u32 hours, days, midnight;
+    u8 down = 0;
+    int temp = 25, humi = 50, light = 60;
+
+    srand(16);
+    host_flash_reset();
+    now = START_TIME;
+    host_set_rtc(now);
+    DataLogger_Init();
+    DataRollup_EraseAll();
+
+    while(now < end)
+    {
+        advance(1 + rand() % 300);
+        if(rand() % 400 == 0) advance(3600 + rand() % 3600);
+        if(rand() % 4 == 0)
+        {
+            temp = rand() % 256;
+            humi = rand() % 256;
+            light = rand() % 101;
+        }
+        else
+        {
+            temp = (temp + rand() % 3 + 255) % 256;
+            humi = (humi + rand() % 5 + 254) % 256;
+            light = (light + rand() % 3 + 100) % 101;
+        }
+        CHECK(DataLogger_WriteSensorData(temp, humi, light, 0, 0, 0, 1, 0) == 0);
+        written++;
+        if(rand() % 7 == 0)
+        {
+            CHECK(DataLogger_WriteOperation(OP_FAN_ON, 0, 1, 1) == 0);
+            written++;
+        }
+        if(rand() % 29 == 0)
+        {
+            CHECK(DataLogger_WriteAlarm(ALARM_LOW_LIGHT_LOG, 1, light, 20) == 0);
+            written++;
+        }
+        if(rand() % 150 == 0) reboot();
+
+        // 第二天18点后停机，次日凌晨1点后上电：停机前的当前小时和当天只在RAM中
+        midnight = now - now % ROLLUP_DAY_SECONDS;
+        if(!down && now - START_TIME > ROLLUP_DAY_SECONDS && now - midnight > 18 * 3600)
+        {
+            DataLogger_Flush();
+            advance(ROLLUP_DAY_SECONDS - (now - midnight) + 3600 + rand() % 600);
+            DataLogger_Init();
+            reboots++;
+            down = 1;
+        }
+    }
+    DataLogger_Flush();
+
+    scan();
+    CHECK_EQ(record_count, written);
+    hours = check_periods(ROLLUP_HOUR, ROLLUP_HOUR_SECONDS);
+    days = check_periods(ROLLUP_DAY, ROLLUP_DAY_SECONDS);
+    check_daily();
+
+    // 结束前重启一次，重放后仍一致
+    reboot();
+    check_periods(ROLLUP_HOUR, ROLLUP_HOUR_SECONDS);
+    check_periods(ROLLUP_DAY, ROLLUP_DAY_SECONDS);
+    check_daily();
+    CHECK(days >= 3);
+    printf("rollup: %lu records, %lu hours, %lu days, %lu reboots\n",
+           (unsigned long)written, (unsigned long)hours, (unsigned long)days, (unsigned long)reboots);
+
+    // 汇总被清空后（只重建当前时段），日统计改为扫描记录，结果不变
+    DataRollup_EraseAll();
+    DataLogger_Init();
+    check_daily();
+}
+
+int main(void)
+{
+    test_rollup();
+    return host_report("rollup");
+}
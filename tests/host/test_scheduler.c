@@ -0,0 +1,199 @@
+/**
+ * @file   test_scheduler.c
+ * @brief  协作式调度器：在模拟的1ms时钟下运行Scheduler_Run，检查释放时刻、优先级、
+ *         超期/跳过统计和32位计数回绕
+ */
+#include "host.h"
+#include "scheduler.h"
+#include <string.h>
+
+#define LOG_MAX 4096
+
+typedef struct
+{
+    u32 start[LOG_MAX];
+    u32 count;
+    u32 cost;               // 每次执行消耗的时间(ms)
+    u32 cost_once_at;       // 第几次执行时额外消耗cost_once(ms)
+    u32 cost_once;
+} TaskLog_t;
+
+static TaskLog_t logs[4];
+static char order[64];
+static u8 order_len;
+static jmp_buf run_end;
+static u32 run_until;
+
+static void task_run(u8 k)
+{
+    TaskLog_t* l = &logs[k];
+
+    if(l->count < LOG_MAX) l->start[l->count] = system_time_ms;
+    l->count++;
+    if(order_len < sizeof(order) - 1) order[order_len++] = 'A' + k;
+    system_time_ms += l->cost;
+    if(l->count == l->cost_once_at) system_time_ms += l->cost_once;
+}
+
+static void task_a(void) { task_run(0); }
+static void task_b(void) { task_run(1); }
+static void task_c(void) { task_run(2); }
+static void task_d(void) { task_run(3); }
+
+// WFI：等到下一个1ms节拍，到达run_until后结束Scheduler_Run
+static void wfi_tick(void)
+{
+    system_time_ms++;
+    if((s32)(system_time_ms - run_until) >= 0) longjmp(run_end, 1);
+}
+
+static void run_for(u32 ms)
+{
+    run_until = system_time_ms + ms;
+    host_set_wfi_hook(wfi_tick);
+    if(setjmp(run_end) == 0) Scheduler_Run();
+    host_set_wfi_hook(0);
+}
+
+static void reset(u32 now)
+{
+    system_time_ms = now;
+    memset(logs, 0, sizeof(logs));
+    memset(order, 0, sizeof(order));
+    order_len = 0;
+    Scheduler_Init();
+}
+
+/**
+ * @brief  各任务按固定周期释放，偏移错开，不随执行时间漂移
+ */
+static void test_periodic(void)
+{
+    u32 i, bad = 0;
+
+    reset(1000);
+    logs[1].cost = 3;
+    Scheduler_Add_Task("fast", task_a, 10, 0, 0);
+    Scheduler_Add_Task("slow", task_b, 50, 0, 5);
+    Scheduler_Add_Task("sec", task_c, 1000, 0, 0);
+    run_for(10000);
+
+    CHECK_EQ(logs[0].count, 1000);
+    CHECK_EQ(logs[1].count, 200);
+    CHECK_EQ(logs[2].count, 10);
+    for(i = 0; i < logs[0].count; i++)
+    {
+        // fast任务注册在前，slow任务的3ms执行时间不会推迟它的释放
+        if(logs[0].start[i] != 1000 + i * 10) bad++;
+    }
+    for(i = 0; i < logs[1].count; i++)
+    {
+        if(logs[1].start[i] != 1005 + i * 50) bad++;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(Scheduler_Get_Task(0)->max_latency_ms, 0);
+    CHECK_EQ(Scheduler_Get_Task(1)->max_exec_ms, 3);
+    CHECK_EQ(Scheduler_Get_Task(1)->overrun_count, 0);
+    CHECK_EQ(Scheduler_Get_Task(2)->skip_count, 0);
+}
+
+/**
+ * @brief  同时到期的任务按注册顺序执行；低优先级任务被前面任务的执行时间推迟，延迟计入统计
+ */
+static void test_priority(void)
+{
+    reset(0);
+    logs[0].cost = 4;
+    Scheduler_Add_Task("a", task_a, 100, 0, 0);
+    Scheduler_Add_Task("b", task_b, 100, 0, 0);
+    Scheduler_Add_Task("c", task_c, 100, 0, 0);
+    run_for(250);
+
+    CHECK(strncmp(order, "ABCABCABC", 9) == 0);
+    CHECK_EQ(logs[1].start[1], 104);
+    CHECK_EQ(Scheduler_Get_Task(1)->max_latency_ms, 4);
+    CHECK_EQ(Scheduler_Get_Task(2)->max_latency_ms, 4);
+}
+
+/**
+ * @brief  执行超过期限计为超期；错过多个周期只补执行一次，之后回到原来的释放网格
+ */
+static void test_overrun(void)
+{
+    u32 i, bad = 0;
+
+    reset(0);
+    logs[0].cost_once_at = 5;
+    logs[0].cost_once = 35;
+    Scheduler_Add_Task("a", task_a, 10, 5, 0);
+    run_for(200);
+
+    CHECK_EQ(Scheduler_Get_Task(0)->overrun_count, 1);
+    CHECK_EQ(Scheduler_Get_Task(0)->skip_count, 2);
+    CHECK_EQ(Scheduler_Get_Task(0)->max_exec_ms, 35);
+    CHECK_EQ(logs[0].start[5], 75);             // 第5次(t=40)执行到75，补执行一次t=70的释放
+    CHECK_EQ(Scheduler_Get_Task(0)->max_latency_ms, 5);
+    for(i = 0; i < logs[0].count; i++)
+    {
+        if(i != 5 && logs[0].start[i] % 10 != 0) bad++;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(logs[0].count, 18);
+}
+
+/**
+ * @brief  system_time_ms回绕前后释放间隔不变
+ */
+static void test_wrap(void)
+{
+    u32 i, bad = 0;
+
+    reset(0xFFFFFF00);
+    Scheduler_Add_Task("a", task_a, 10, 0, 0);
+    run_for(1000);
+
+    CHECK_EQ(logs[0].count, 100);
+    for(i = 1; i < logs[0].count; i++)
+    {
+        if(logs[0].start[i] - logs[0].start[i - 1] != 10) bad++;
+    }
+    CHECK_EQ(bad, 0);
+}
+
+/**
+ * @brief  禁止的任务不执行，重新使能后从当前时刻释放；非法参数和任务表满时注册失败
+ */
+static void test_enable_and_limits(void)
+{
+    u8 id, i;
+
+    reset(0);
+    id = Scheduler_Add_Task("a", task_a, 10, 0, 0);
+    Scheduler_Set_Enable(id, 0);
+    run_for(100);
+    CHECK_EQ(logs[0].count, 0);
+    Scheduler_Set_Enable(id, 1);
+    CHECK_EQ(Scheduler_Get_Task(id)->next_release, 100);
+    run_for(100);
+    CHECK_EQ(logs[0].count, 10);
+
+    CHECK_EQ(Scheduler_Add_Task("bad", 0, 10, 0, 0), SCHED_INVALID_ID);
+    CHECK_EQ(Scheduler_Add_Task("bad", task_b, 0, 0, 0), SCHED_INVALID_ID);
+    for(i = Scheduler_Get_Task_Count(); i < SCHED_MAX_TASKS; i++)
+        CHECK(Scheduler_Add_Task("d", task_d, 1000, 0, 0) != SCHED_INVALID_ID);
+    CHECK_EQ(Scheduler_Add_Task("full", task_d, 1000, 0, 0), SCHED_INVALID_ID);
+    CHECK(Scheduler_Get_Task(SCHED_MAX_TASKS) == 0);
+
+    Scheduler_Reset_Stats();
+    CHECK_EQ(Scheduler_Get_Task(id)->run_count, 0);
+}
+
+int main(void)
+{
+    test_periodic();
+    test_priority();
+    test_overrun();
+    test_wrap();
+    test_enable_and_limits();
+    return host_report("scheduler");
+}
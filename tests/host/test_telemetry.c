@@ -0,0 +1,598 @@
+/**
+ * @file   test_telemetry.c
+ * @brief  二进制遥测：CRC-16校验值，COBS编解码与独立实现的参考解码交叉检查，坏帧拒收，
+ *         APP端按0x00分帧时坏帧只丢一帧；经USART3发送环回环检查GET、SUBSCRIBE的快照和增量
+ *         能在APP端还原设备状态，AT事务和日志导出期间暂停推送；从发布事件到APP端状态一致的
+ *         延迟不超过订阅间隔加一个任务周期（HOST_VERBOSE=1时打印最小/平均/最大值）；比较每次状态更新的字节数
+ */
+#include "host.h"
+#include "fakes.h"
+#include "telemetry.h"
+#include "greenhouse_control.h"
+#include "crc16.h"
+#include "usart3.h"
+#include "event_bus.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_MAX     4096
+
+void DMA1_Channel2_IRQHandler(void);
+
+// ===== 被测模块依赖的外部函数 =====
+
+GreenhouseStatus_t greenhouse_status;
+static u8 fan_percent;
+static u8 export_active;
+
+u8 Fan_Get_Speed_Percent(void)
+{
+    return fan_percent;
+}
+
+u8 LogExport_Active(void)
+{
+    return export_active;
+}
+
+// ===== 参考实现：逐字节COBS解码（不限帧长，含0xFF分块） =====
+
+static int ref_cobs_decode(const u8* in, u32 size, u8* out)
+{
+    u32 i = 0, n = 0;
+    u8 code, k;
+
+    while(i < size)
+    {
+        code = in[i++];
+        if(code == 0) return -1;
+        for(k = 1; k < code; k++)
+        {
+            if(i >= size || in[i] == 0) return -1;
+            out[n++] = in[i++];
+        }
+        if(code != 0xFF && i < size) out[n++] = 0;
+    }
+    return n;
+}
+
+// 随机payload：按mode偏向0x00、0xFF或全随机
+static void random_payload(u8* p, u8 len, u8 mode)
+{
+    u8 i;
+
+    for(i = 0; i < len; i++)
+    {
+        switch(mode)
+        {
+            case 0:  p[i] = rand(); break;
+            case 1:  p[i] = (rand() % 2) ? 0 : rand(); break;
+            case 2:  p[i] = 0; break;
+            default: p[i] = (rand() % 2) ? 0xFF : 0; break;
+        }
+    }
+}
+
+/**
+ * @brief  CRC-16/CCITT-FALSE的标准校验值，分段累加与整段相同
+ */
+static void test_crc(void)
+{
+    static const u8 check[] = "123456789";
+
+    CHECK_EQ(crc16_ccitt(0xFFFF, check, 9), 0x29B1);
+    CHECK_EQ(crc16_ccitt(crc16_ccitt(0xFFFF, check, 4), check + 4, 5), 0x29B1);
+    CHECK_EQ(crc16_ccitt(0xFFFF, check, 0), 0xFFFF);
+}
+
+/**
+ * @brief  编码：两端为帧界、帧内无0x00、长度不超过TLM_FRAME_MAX，参考解码得到
+ *         type|len|payload|crc；Telemetry_Frame_Decode还原type和payload
+ */
+static void test_codec(void)
+{
+    u8 payload[TLM_PAYLOAD_MAX + 1], got[TLM_PAYLOAD_MAX], frame[TLM_FRAME_MAX], raw[TLM_FRAME_MAX];
+    u32 i, j, zeros = 0, bad_ref = 0, bad_dec = 0, too_long = 0;
+    u16 n, crc;
+    u8 len, type, got_type, got_len;
+    int m;
+
+    srand(22);
+    for(i = 0; i < 20000; i++)
+    {
+        len = rand() % (TLM_PAYLOAD_MAX + 1);
+        type = (i % 7 == 0) ? 0 : rand();
+        random_payload(payload, len, i % 4);
+        n = Telemetry_Frame_Encode(type, payload, len, frame);
+        if(n > TLM_FRAME_MAX || n < 6) too_long++;
+        CHECK(frame[0] == 0 && frame[n - 1] == 0);
+        for(j = 1; j + 1 < n; j++)
+            if(frame[j] == 0) zeros++;
+
+        m = ref_cobs_decode(frame + 1, n - 2, raw);
+        crc = crc16_ccitt(0xFFFF, raw, len + 2);
+        if(m != len + 4 || raw[0] != type || raw[1] != len || memcmp(raw + 2, payload, len) != 0 ||
+           raw[len + 2] != (crc & 0xFF) || raw[len + 3] != (crc >> 8)) bad_ref++;
+
+        got_len = 0xEE;
+        if(Telemetry_Frame_Decode(frame + 1, n - 2, &got_type, got, &got_len) != 0 ||
+           got_type != type || got_len != len || memcmp(got, payload, len) != 0) bad_dec++;
+    }
+    CHECK_EQ(too_long, 0);
+    CHECK_EQ(zeros, 0);
+    CHECK_EQ(bad_ref, 0);
+    CHECK_EQ(bad_dec, 0);
+
+    CHECK_EQ(Telemetry_Frame_Encode(TLM_STATUS, payload, TLM_PAYLOAD_MAX + 1, frame), 0);
+    CHECK_EQ(sizeof(TelemetryStatus_t), 22);
+    CHECK(sizeof(TelemetryStatus_t) + 4 <= TLM_PAYLOAD_MAX);       // 全部字段都变化的增量
+}
+
+/**
+ * @brief  坏帧：任一比特翻转、截断、加长或空帧都被拒收
+ */
+static void test_reject(void)
+{
+    u8 payload[TLM_PAYLOAD_MAX], got[TLM_PAYLOAD_MAX], frame[TLM_FRAME_MAX], bad[TLM_FRAME_MAX + 1];
+    u32 i, accepted = 0, trials = 0;
+    u16 n, k, b;
+    u8 type, len;
+
+    srand(23);
+    for(i = 0; i < 200; i++)
+    {
+        len = rand() % (TLM_PAYLOAD_MAX + 1);
+        random_payload(payload, len, i % 4);
+        n = Telemetry_Frame_Encode(rand(), payload, len, frame);
+
+        // 帧界之间的每个比特
+        for(k = 1; k + 1 < n; k++)
+        {
+            for(b = 0; b < 8; b++)
+            {
+                memcpy(bad, frame, n);
+                bad[k] ^= 1 << b;
+                trials++;
+                if(Telemetry_Frame_Decode(bad + 1, n - 2, &type, got, &len) == 0) accepted++;
+            }
+        }
+        // 截断和多出一个字节
+        for(k = 0; k + 2 < n; k++)
+        {
+            trials++;
+            if(Telemetry_Frame_Decode(frame + 1, k, &type, got, &len) == 0) accepted++;
+        }
+        memcpy(bad, frame, n - 1);
+        bad[n - 1] = 0x5A;
+        trials++;
+        if(Telemetry_Frame_Decode(bad + 1, n - 1, &type, got, &len) == 0) accepted++;
+    }
+    CHECK(trials > 20000);
+    CHECK_EQ(accepted, 0);
+}
+
+// ===== APP端：按0x00分帧，逐帧解码 =====
+
+typedef struct
+{
+    u8 buf[TLM_FRAME_MAX];
+    u16 n;
+    u8 overflow;
+    u32 frames;                 // 解码成功的帧
+    u32 errors;                 // 解码失败的帧
+    u8 types[256];              // 按顺序记录的帧类型
+    u32 count;
+    TelemetryStatus_t mirror;   // 由快照和增量还原的设备状态
+    u8 synced;
+    u32 last_delta_ms;
+    u32 min_gap_ms;             // 相邻两个增量的最小间隔
+    u32 status_bytes;           // TLM_STATUS帧的线路字节数
+    u32 delta_bytes;            // TLM_DELTA帧的线路字节数
+    u32 deltas;
+    u8 ack[2];
+    u8 timing;                  // 记录事件到达APP的延迟
+    u32 pub_ms[64];             // 尚未到达APP的事件的发布时刻
+    u8 pub_n;
+    u32 lat_min, lat_max, lat_sum, lat_count;
+} App_t;
+
+static App_t app;
+
+static void app_reset(void)
+{
+    memset(&app, 0, sizeof(app));
+    app.min_gap_ms = 0xFFFFFFFF;
+    app.lat_min = 0xFFFFFFFF;
+}
+
+static void app_frame(const u8* data, u16 size)
+{
+    u8 payload[TLM_PAYLOAD_MAX];
+    u8 type, len, i, k;
+    u32 mask;
+
+    if(Telemetry_Frame_Decode(data, size, &type, payload, &len) != 0)
+    {
+        app.errors++;
+        return;
+    }
+    app.frames++;
+    if(app.count < sizeof(app.types)) app.types[app.count++] = type;
+    switch(type)
+    {
+        case TLM_STATUS:
+            if(len == sizeof(TelemetryStatus_t)) memcpy(&app.mirror, payload, len);
+            app.synced = (len == sizeof(TelemetryStatus_t));
+            app.status_bytes += size + 2;
+            break;
+
+        case TLM_DELTA:
+            mask = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((u32)payload[3] << 24);
+            k = 4;
+            for(i = 0; i < sizeof(TelemetryStatus_t); i++)
+                if(mask & ((u32)1 << i)) ((u8*)&app.mirror)[i] = payload[k++];
+            CHECK_EQ(k, len);
+            if(app.deltas > 0 && system_time_ms - app.last_delta_ms < app.min_gap_ms)
+                app.min_gap_ms = system_time_ms - app.last_delta_ms;
+            app.last_delta_ms = system_time_ms;
+            app.deltas++;
+            app.delta_bytes += size + 2;
+            break;
+
+        case TLM_ACK:
+            app.ack[0] = payload[0];
+            app.ack[1] = payload[1];
+            break;
+    }
+}
+
+// 接收线路字节：0x00为帧界，两个帧界之间为一帧，空帧（连续的0x00）忽略
+static void app_feed(const u8* data, u32 size)
+{
+    u32 i;
+
+    for(i = 0; i < size; i++)
+    {
+        if(data[i] == 0)
+        {
+            if(app.n > 0 && !app.overflow) app_frame(app.buf, app.n);
+            else if(app.overflow) app.errors++;
+            app.n = 0;
+            app.overflow = 0;
+        }
+        else if(app.n < sizeof(app.buf)) app.buf[app.n++] = data[i];
+        else app.overflow = 1;
+    }
+}
+
+/**
+ * @brief  坏帧和丢字节只影响所在的帧：帧首的0x00让APP重新同步，后面的帧照常解码
+ */
+static void test_stream(void)
+{
+    static u8 stream[64 * TLM_FRAME_MAX];
+    u8 payload[TLM_PAYLOAD_MAX], frame[TLM_FRAME_MAX];
+    u32 len = 0, i, sent_ok = 0, damaged = 0;
+    u16 n, k;
+
+    srand(24);
+    app_reset();
+    for(i = 0; i < 64; i++)
+    {
+        random_payload(payload, sizeof(TelemetryStatus_t), i % 4);
+        n = Telemetry_Frame_Encode(TLM_STATUS, payload, sizeof(TelemetryStatus_t), frame);
+        switch(i % 4)
+        {
+            case 1:     // 帧内一个字节出错（不为0x00）
+                k = 1 + rand() % (n - 2);
+                frame[k] = (frame[k] == 0x7E) ? 0x7F : 0x7E;
+                memcpy(stream + len, frame, n);
+                len += n;
+                damaged++;
+                break;
+            case 2:     // 丢了帧尾，下一帧的起始0x00结束它
+                memcpy(stream + len, frame, n / 2);
+                len += n / 2;
+                damaged++;
+                break;
+            default:
+                memcpy(stream + len, frame, n);
+                len += n;
+                sent_ok++;
+                break;
+        }
+    }
+    app_feed(stream, len);
+    CHECK_EQ(app.frames, sent_ok);
+    CHECK_EQ(app.errors, damaged);
+}
+
+// ===== 设备端回环 =====
+
+static u8 capture[CAPTURE_MAX];
+
+// 排空USART3发送环，交给APP，返回字节数
+static u32 drain(void)
+{
+    u32 n = host_dma_drain(DMA1_Channel2, 2, DMA1_Channel2_IRQHandler, capture, sizeof(capture));
+
+    app_feed(capture, n);
+    return n;
+}
+
+static void send_to_device(u8 type, const u8* payload, u8 len)
+{
+    u8 frame[TLM_FRAME_MAX];
+    u16 n = Telemetry_Frame_Encode(type, payload, len, frame);
+
+    Telemetry_Receive(frame + 1, n - 2);
+}
+
+static void current(TelemetryStatus_t* s)
+{
+    s->run_time = greenhouse_status.system_run_time;
+    s->temperature = greenhouse_status.temperature;
+    s->humidity = greenhouse_status.humidity;
+    s->light = greenhouse_status.light;
+    s->work_mode = greenhouse_status.work_mode;
+    s->fan_status = greenhouse_status.fan_status;
+    s->fan_speed = fan_percent;
+    s->pump_status = greenhouse_status.pump_status;
+    s->light_status = greenhouse_status.light_status;
+    s->alarm_flags = greenhouse_status.alarm_flags;
+    s->sensor_error = greenhouse_status.sensor_error;
+    s->fan_switches = greenhouse_status.fan_run_status.switch_count;
+    s->pump_switches = greenhouse_status.pump_run_status.switch_count;
+    s->light_switches = greenhouse_status.light_run_status.switch_count;
+    s->alarm_count = greenhouse_status.alarm_count;
+}
+
+// APP端还原的状态与设备一致；运行时间的变化不发布事件，随下一个增量或快照发出，只要求不超前
+static u8 mirror_ok(void)
+{
+    TelemetryStatus_t s;
+
+    current(&s);
+    return app.synced && app.mirror.run_time <= s.run_time &&
+           memcmp((u8*)&s + 4, (u8*)&app.mirror + 4, sizeof(s) - 4) == 0;
+}
+
+// 发布主题并记下发布时刻
+static void publish(u8 topic)
+{
+    if(app.timing && app.pub_n < sizeof(app.pub_ms) / sizeof(app.pub_ms[0]))
+        app.pub_ms[app.pub_n++] = system_time_ms;
+    Event_Publish(topic);
+}
+
+// 发送环排空后APP端状态已一致：此前发布的事件都已随帧到达，记录各自的延迟
+static void app_latency(void)
+{
+    u32 lat;
+    u8 i;
+
+    if(app.pub_n == 0 || !mirror_ok()) return;
+    for(i = 0; i < app.pub_n; i++)
+    {
+        lat = system_time_ms - app.pub_ms[i];
+        if(lat < app.lat_min) app.lat_min = lat;
+        if(lat > app.lat_max) app.lat_max = lat;
+        app.lat_sum += lat;
+        app.lat_count++;
+    }
+    app.pub_n = 0;
+}
+
+// 随机改变一项状态并发布对应主题
+static void random_change(void)
+{
+    switch(rand() % 6)
+    {
+        case 0:
+            greenhouse_status.temperature = 15 + rand() % 20;
+            greenhouse_status.humidity = 30 + rand() % 60;
+            publish(EVT_TOPIC_SENSOR);
+            break;
+        case 1:
+            greenhouse_status.light = rand() % 101;
+            publish(EVT_TOPIC_SENSOR);
+            break;
+        case 2:
+            greenhouse_status.fan_status = !greenhouse_status.fan_status;
+            fan_percent = greenhouse_status.fan_status ? 100 : 0;
+            greenhouse_status.fan_run_status.switch_count++;
+            publish(EVT_TOPIC_DEVICE);
+            break;
+        case 3:
+            greenhouse_status.pump_status = !greenhouse_status.pump_status;
+            greenhouse_status.pump_run_status.switch_count++;
+            publish(EVT_TOPIC_DEVICE);
+            break;
+        case 4:
+            greenhouse_status.alarm_flags ^= 1 << (rand() % 4);
+            greenhouse_status.alarm_count++;
+            publish(EVT_TOPIC_ALARM);
+            break;
+        default:
+            greenhouse_status.work_mode = !greenhouse_status.work_mode;
+            publish(EVT_TOPIC_MODE);
+            break;
+    }
+}
+
+// 主循环推进ms毫秒：每10ms运行事件总线和遥测任务并排空发送环，每秒运行时间加1
+static void run_ms(u32 ms)
+{
+    u32 t;
+
+    for(t = 0; t < ms; t += 10)
+    {
+        system_time_ms += 10;
+        if(system_time_ms % 1000 == 0) greenhouse_status.system_run_time++;
+        Event_Task();
+        Telemetry_Task();
+        drain();
+        app_latency();
+    }
+}
+
+/**
+ * @brief  GET回复快照；SUBSCRIBE先ACK再快照，之后的状态变化以增量推送，两次增量至少间隔
+ *         period_ms，APP端还原的状态与设备一致；间隔过小的订阅被拒绝；UNSUBSCRIBE后停止推送
+ */
+static void test_loopback(void)
+{
+    u8 period[2];
+    u32 i, bytes, lagging = 0;
+
+    app_reset();
+    greenhouse_status.temperature = 24;
+    greenhouse_status.humidity = 55;
+    greenhouse_status.light = 70;
+    send_to_device(TLM_GET, 0, 0);
+    drain();
+    CHECK_EQ(app.count, 1);
+    CHECK_EQ(app.types[0], TLM_STATUS);
+    CHECK(mirror_ok());
+    CHECK(!Telemetry_Subscribed());
+
+    // 间隔低于下限
+    period[0] = (TLM_PERIOD_MIN - 1) & 0xFF;
+    period[1] = (TLM_PERIOD_MIN - 1) >> 8;
+    send_to_device(TLM_SUBSCRIBE, period, 2);
+    drain();
+    CHECK_EQ(app.ack[0], TLM_SUBSCRIBE);
+    CHECK_EQ(app.ack[1], 1);
+    CHECK(!Telemetry_Subscribed());
+
+    // 未知类型
+    send_to_device(0x7F, 0, 0);
+    drain();
+    CHECK_EQ(app.ack[0], 0x7F);
+    CHECK_EQ(app.ack[1], 1);
+
+    app_reset();
+    period[0] = 200 & 0xFF;
+    period[1] = 200 >> 8;
+    send_to_device(TLM_SUBSCRIBE, period, 2);
+    drain();
+    CHECK(Telemetry_Subscribed());
+    CHECK_EQ(app.count, 2);
+    CHECK_EQ(app.types[0], TLM_ACK);
+    CHECK_EQ(app.types[1], TLM_STATUS);
+    CHECK_EQ(app.ack[1], 0);
+    CHECK(mirror_ok());
+
+    srand(25);
+    app.timing = 1;
+    for(i = 0; i < 2000; i++)
+    {
+        random_change();
+        run_ms(10 * (1 + rand() % 15));
+        // 最后一次推送之后period_ms内的变化可能尚未发出
+        if(!mirror_ok() && system_time_ms - app.last_delta_ms > 200 + 10) lagging++;
+    }
+    run_ms(300);
+    CHECK(mirror_ok());
+    CHECK_EQ(lagging, 0);
+    CHECK_EQ(app.errors, 0);
+    CHECK(app.deltas > 500);
+    CHECK(app.min_gap_ms >= 200);
+
+    // 事件到APP的延迟：发布后在下一个任务周期发出，或等到距上次推送满订阅间隔
+    app.timing = 0;
+    CHECK_EQ(app.pub_n, 0);
+    CHECK_EQ(app.lat_count, 2000);
+    CHECK(app.lat_min >= 10);
+    CHECK(app.lat_max <= 200 + 10);
+
+    // 没有变化时按TLM_KEYFRAME_PERIODS个间隔发完整快照
+    app.count = 0;
+    run_ms(200 * TLM_KEYFRAME_PERIODS + 100);
+    CHECK(app.count >= 1 && app.types[0] == TLM_STATUS);
+
+    if(getenv("HOST_VERBOSE"))
+    {
+        fprintf(stderr, "telemetry: %u deltas, %.1f bytes per delta on the wire\n",
+                app.deltas, (double)app.delta_bytes / app.deltas);
+        fprintf(stderr, "telemetry: event to app latency min %u avg %.1f max %u ms (period 200 ms)\n",
+                app.lat_min, (double)app.lat_sum / app.lat_count, app.lat_max);
+    }
+
+    // AT事务和日志导出期间不发送，结束后补发
+    fake_at_busy = 1;
+    random_change();
+    run_ms(1000);
+    CHECK(!mirror_ok());
+    fake_at_busy = 0;
+    export_active = 1;
+    random_change();
+    run_ms(1000);
+    CHECK(!mirror_ok());
+    export_active = 0;
+    run_ms(300);
+    CHECK(mirror_ok());
+
+    send_to_device(TLM_UNSUBSCRIBE, 0, 0);
+    drain();
+    CHECK(!Telemetry_Subscribed());
+    CHECK_EQ(app.ack[0], TLM_UNSUBSCRIBE);
+    bytes = 0;
+    for(i = 0; i < 50; i++)
+    {
+        random_change();
+        system_time_ms += 100;
+        Event_Task();
+        Telemetry_Task();
+        bytes += drain();
+    }
+    CHECK_EQ(bytes, 0);
+}
+
+/**
+ * @brief  每次状态更新的字节数：文本STATUS回复（与Greenhouse_Cmd_Status格式相同）、
+ *         TLM_STATUS帧和单项变化的TLM_DELTA帧
+ */
+static void test_size(void)
+{
+    char text[512];
+    u8 frame[TLM_FRAME_MAX];
+    u8 payload[TLM_PAYLOAD_MAX];
+    TelemetryStatus_t s;
+    u32 text_len;
+    u16 status_len, delta_len;
+
+    greenhouse_status.temperature = 25;
+    greenhouse_status.humidity = 61;
+    greenhouse_status.light = 73;
+    text_len = snprintf(text, sizeof(text),
+                        "=== System Status ===\r\nTemperature: %d°C\r\nHumidity: %d%%\r\nLight: %d%%\r\n"
+                        "Mode: %s\r\nFan: %s\r\nPump: %s\r\nLight: %s\r\n====================\r\n",
+                        greenhouse_status.temperature, greenhouse_status.humidity, greenhouse_status.light,
+                        "Auto", "OFF", "OFF", "OFF");
+    current(&s);
+    status_len = Telemetry_Frame_Encode(TLM_STATUS, (const u8*)&s, sizeof(s), frame);
+    payload[0] = 1 << 4;        // 只有温度变化
+    payload[1] = payload[2] = payload[3] = 0;
+    payload[4] = 26;
+    delta_len = Telemetry_Frame_Encode(TLM_DELTA, payload, 5, frame);
+
+    CHECK(status_len <= TLM_FRAME_MAX);
+    CHECK(status_len * 3 < text_len);
+    CHECK(delta_len * 10 < text_len);
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "bytes per update: text STATUS %u, TLM_STATUS %u, TLM_DELTA (one field) %u\n",
+                text_len, status_len, delta_len);
+}
+
+int main(void)
+{
+    test_crc();
+    test_codec();
+    test_reject();
+    test_stream();
+    Telemetry_Init();
+    test_loopback();
+    test_size();
+    return host_report("telemetry");
+}
@@ -0,0 +1,294 @@
+/**
+ * @file   test_tftlcd.c
+ * @brief  LCD像素流：在FSMC总线上挂一个HX8357DN面板模型（0x2A/0x2B开窗、0x2C连续写、
+ *         每像素高低字节两次写入），把字符、字符串、填充和图片的输出与逐点绘制的参考结果
+ *         逐像素比较，并统计命令写和数据写的次数
+ */
+#include "host.h"
+#include "tftlcd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PANEL_W     320
+#define PANEL_H     480
+#define JUNK        0x1234          // 未被绘制的像素
+
+typedef struct
+{
+    u16 fb[PANEL_H][PANEL_W];
+    u16 sc, ec, sp, ep;             // 窗口列/行范围
+    u16 x, y;                       // 写入位置
+    u8 cmd;
+    u8 arg_n;
+    u8 args[4];
+    u8 byte_n;
+    u8 hi;
+    u32 cmds;                       // 命令写次数
+    u32 data;                       // 数据写次数（含开窗参数）
+    u32 pixels;                     // 写入的像素数
+} Panel_t;
+
+static Panel_t panel;
+static u16 ref[PANEL_H][PANEL_W];
+
+static void panel_write(u32 addr, u16 v)
+{
+    Panel_t* p = &panel;
+
+    if(addr == (u32)&TFTLCD->LCD_CMD)
+    {
+        p->cmds++;
+        p->cmd = (u8)v;
+        p->arg_n = 0;
+        p->byte_n = 0;
+        if(v == 0x2C)
+        {
+            p->x = p->sc;
+            p->y = p->sp;
+        }
+        return;
+    }
+    p->data++;
+    if(p->cmd == 0x2A || p->cmd == 0x2B)
+    {
+        if(p->arg_n < 4) p->args[p->arg_n++] = (u8)v;
+        if(p->arg_n == 4)
+        {
+            u16 s = (p->args[0] << 8) | p->args[1], e = (p->args[2] << 8) | p->args[3];
+            if(p->cmd == 0x2A) { p->sc = s; p->ec = e; }
+            else { p->sp = s; p->ep = e; }
+        }
+    }
+    else if(p->cmd == 0x2C)
+    {
+        // 每像素两次写入：先高字节后低字节
+        if(p->byte_n == 0)
+        {
+            p->hi = (u8)v;
+            p->byte_n = 1;
+            return;
+        }
+        p->byte_n = 0;
+        p->pixels++;
+        if(p->x < PANEL_W && p->y < PANEL_H) p->fb[p->y][p->x] = (p->hi << 8) | (v & 0xFF);
+        if(++p->x > p->ec)
+        {
+            p->x = p->sc;
+            if(++p->y > p->ep) p->y = p->sp;
+        }
+    }
+}
+
+static u16 panel_read(u32 addr)
+{
+    (void)addr;
+    return 0;
+}
+
+static void panel_clear(void)
+{
+    u32 i;
+
+    for(i = 0; i < PANEL_W * PANEL_H; i++) (&panel.fb[0][0])[i] = JUNK;
+    for(i = 0; i < PANEL_W * PANEL_H; i++) (&ref[0][0])[i] = JUNK;
+    panel.cmds = panel.data = panel.pixels = 0;
+}
+
+static void ref_fill(int x0, int y0, int x1, int y1, u16 color)
+{
+    int x, y;
+
+    for(y = y0; y <= y1 && y < PANEL_H; y++)
+        for(x = x0; x <= x1 && x < PANEL_W; x++) ref[y][x] = color;
+}
+
+static u32 diff(void)
+{
+    u32 i, bad = 0;
+
+    for(i = 0; i < PANEL_W * PANEL_H; i++)
+        if((&panel.fb[0][0])[i] != (&ref[0][0])[i]) bad++;
+    return bad;
+}
+
+/**
+ * @brief  参考输出：原逐点绘制方式（叠加方式只画前景点）画在背景色的字符格上，
+ *         结果存入ref，面板恢复为调用前的内容
+ */
+static void ref_char(u16 x, u16 y, u8 c, u8 size)
+{
+    static u16 save[PANEL_H][PANEL_W];
+
+    memcpy(save, panel.fb, sizeof(save));
+    memcpy(panel.fb, ref, sizeof(ref));
+    ref_fill(x, y, x + size / 2 - 1, y + size - 1, BACK_COLOR);
+    memcpy(panel.fb, ref, sizeof(ref));
+    LCD_ShowChar(x, y, c, size, 1);
+    memcpy(ref, panel.fb, sizeof(ref));
+    memcpy(panel.fb, save, sizeof(save));
+}
+
+// 原LCD_ShowString：逐个字符，超出宽度换行，超出高度停止
+static void ref_string(u16 x, u16 y, u16 width, u16 height, u8 size, const char* p)
+{
+    u16 x0 = x;
+
+    width += x;
+    height += y;
+    while(*p >= ' ' && *p <= '~')
+    {
+        if(x >= width) { x = x0; y += size; }
+        if(y >= height) break;
+        ref_char(x, y, *p, size);
+        x += size / 2;
+        p++;
+    }
+}
+
+/**
+ * @brief  单个字符：全部可显示字符和三种字号，整格输出与逐点结果一致，每个字符只开一次窗
+ */
+static void test_char(void)
+{
+    static const u8 sizes[3] = {12, 16, 24};
+    u8 s, c;
+    u32 bad = 0, cmd_bad = 0, cmds_pixel = 0;
+
+    FRONT_COLOR = RED;
+    BACK_COLOR = DARKBLUE;
+    for(s = 0; s < 3; s++)
+    {
+        for(c = ' '; c <= '~'; c++)
+        {
+            panel_clear();
+            ref_char(37, 101, c, sizes[s]);
+            cmds_pixel += panel.cmds;
+            panel.cmds = panel.pixels = 0;
+            LCD_ShowChar(37, 101, c, sizes[s], 0);
+            if(panel.cmds != 3) cmd_bad++;
+            if(panel.pixels != (u32)sizes[s] / 2 * sizes[s]) cmd_bad++;
+            if(diff() != 0) bad++;
+        }
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(cmd_bad, 0);
+    CHECK(cmds_pixel > 3 * 95 * 3 * 10);           // 逐点方式每个前景点3次命令写
+
+    // 越出屏幕的字符仍逐点绘制并裁剪
+    panel_clear();
+    ref_char(PANEL_W - 5, 200, 'W', 16);
+    panel.cmds = panel.pixels = 0;
+    LCD_ShowChar(PANEL_W - 5, 200, 'W', 16, 0);
+    CHECK_EQ(diff(), 0);
+    CHECK_EQ(panel.cmds, 3 * panel.pixels);
+    panel_clear();
+    LCD_ShowChar(100, PANEL_H - 10, 'g', 24, 0);
+    CHECK(panel.pixels > 0);
+    CHECK_EQ(panel.cmds, 3 * panel.pixels);
+}
+
+/**
+ * @brief  字符串：一行内连续的字符合并为一个窗口，换行、高度截止和屏幕边缘裁剪与原实现一致
+ */
+static void test_string(void)
+{
+    static const char text[] = "Greenhouse T=25.3C H=61% {ok} ~|";
+    u8 size;
+
+    FRONT_COLOR = BLACK;
+    BACK_COLOR = LGRAY;
+    for(size = 12; size <= 24; size += 4)
+    {
+        if(size == 20) continue;
+        panel_clear();
+        ref_string(8, 20, 300, 200, size, text);
+        panel.cmds = 0;
+        LCD_ShowString(8, 20, 300, 200, size, (u8*)text);
+        CHECK_EQ(diff(), 0);
+        // 每行一个窗口
+        CHECK_EQ(panel.cmds, 3 * ((sizeof(text) - 1 + 300 / (size / 2) - 1) / (300 / (size / 2))));
+    }
+
+    // 只有一行高度：第二行不显示
+    panel_clear();
+    ref_string(0, 0, 100, 16, 16, text);
+    LCD_ShowString(0, 0, 100, 16, 16, (u8*)text);
+    CHECK_EQ(diff(), 0);
+
+    // 框宽超出屏幕：屏幕外的部分逐点裁剪
+    panel_clear();
+    ref_string(260, 300, 200, 48, 16, text);
+    LCD_ShowString(260, 300, 200, 48, 16, (u8*)text);
+    CHECK_EQ(diff(), 0);
+
+    // 遇到非显示字符结束
+    panel_clear();
+    ref_string(0, 0, 320, 100, 16, "AB");
+    panel.cmds = 0;
+    LCD_ShowString(0, 0, 320, 100, 16, (u8*)"AB\nCD");
+    CHECK_EQ(diff(), 0);
+    CHECK_EQ(panel.cmds, 3);
+}
+
+/**
+ * @brief  单色填充、颜色数组填充和图片：整块只开一次窗，每像素两次数据写
+ */
+static void test_fill(void)
+{
+    static u16 colors[90 * 70];
+    static u8 pic[2 * 64 * 50 + 1];
+    u32 i, x, y, setup;
+
+    panel_clear();
+    LCD_Fill(10, 20, 109, 69, GREEN);
+    ref_fill(10, 20, 109, 69, GREEN);
+    CHECK_EQ(diff(), 0);
+    CHECK_EQ(panel.cmds, 3);
+    setup = panel.data - 2 * panel.pixels;
+    CHECK_EQ(setup, 8);
+    CHECK_EQ(panel.pixels, 100 * 50);
+
+    // 起点大于终点时不绘制
+    panel_clear();
+    LCD_Fill(50, 50, 49, 60, RED);
+    CHECK_EQ(panel.cmds + panel.data, 0);
+
+    srand(5);
+    for(i = 0; i < 90 * 70; i++) colors[i] = rand();
+    panel_clear();
+    LCD_Color_Fill(200, 300, 289, 369, colors);
+    for(y = 0; y < 70; y++)
+        for(x = 0; x < 90; x++) ref[300 + y][200 + x] = colors[y * 90 + x];
+    CHECK_EQ(diff(), 0);
+    CHECK_EQ(panel.cmds, 3);
+    CHECK_EQ(panel.data, 8 + 2 * 90 * 70);
+
+    // 图片数据低字节在前；半字对齐和不对齐两种起始地址
+    for(i = 0; i < sizeof(pic); i++) pic[i] = rand();
+    for(i = 0; i < 2; i++)
+    {
+        const u8* p = pic + i;
+
+        panel_clear();
+        LCD_ShowPicture(3, 400, 64, 50, (u8*)p);
+        for(y = 0; y < 50; y++)
+            for(x = 0; x < 64; x++)
+                ref[400 + y][3 + x] = p[2 * (y * 64 + x)] | (p[2 * (y * 64 + x) + 1] << 8);
+        CHECK_EQ(diff(), 0);
+        CHECK_EQ(panel.cmds, 3);
+        CHECK_EQ(panel.pixels, 64 * 50);
+    }
+}
+
+int main(void)
+{
+    host_fsmc_trap(panel_write, panel_read);
+    LCD_Display_Dir(0);
+    CHECK_EQ(tftlcd_data.width, PANEL_W);
+    CHECK_EQ(tftlcd_data.height, PANEL_H);
+
+    test_char();
+    test_string();
+    test_fill();
+    return host_report("tftlcd");
+}
@@ -0,0 +1,360 @@
+/**
+ * @file   test_usart3.c
+ * @brief  USART3接收行队列：逐字节驱动USART3_IRQHandler，检查成批命令不丢、行/二进制帧分帧、
+ *         超长行、溢出、队列满和游离0x00的丢弃计数；
+ *         发送环：接收半行时u3_printf不影响该行，环满时的部分写入和丢弃计数，
+ *         入队吞吐量（HOST_VERBOSE=1时打印）
+ */
+#include "host.h"
+#include "usart3.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void USART3_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+
+static u8 tx_out[USART3_TX_RING_LEN * 4];
+
+static void rx_byte(u8 c, u8 overrun)
+{
+    host_usart_rx(USART3, c, overrun, USART3_IRQHandler);
+}
+
+static void rx_bytes(const void* data, u32 len)
+{
+    const u8* p = (const u8*)data;
+
+    while(len--) rx_byte(*p++, 0);
+}
+
+static void rx_str(const char* s)
+{
+    rx_bytes(s, strlen(s));
+}
+
+// 取出一行并与期望比较（期望为空指针表示队列应为空）
+static void expect_line(const void* line, u16 len)
+{
+    char buf[USART3_LINE_LEN + 1];
+    u16 n;
+
+    n = USART3_Get_Line(buf, sizeof(buf));
+    CHECK_EQ(n, len);
+    if(n == len && line != 0) CHECK(memcmp(buf, line, len) == 0);
+}
+
+/**
+ * @brief  主循环每隔一段字节取一次行：几百条命令连续到达，全部按顺序取出，无丢弃
+ */
+static void test_burst(void)
+{
+    char cmd[USART3_LINE_LEN], buf[USART3_LINE_LEN];
+    u32 dropped = USART3_Get_Dropped();
+    u32 i, sent = 0, got = 0, bad = 0, bytes = 0, n, poll;
+    u8 k;
+
+    srand(3);
+    for(poll = 16; poll <= 48; poll += 32)
+    {
+        for(i = 0; i < 500; i++)
+        {
+            n = sprintf(cmd, "CMD%u_%.*s%s", sent, rand() % 20, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", (i & 1) ? "\r\n" : "\n");
+            for(k = 0; k < n; k++)
+            {
+                rx_byte(cmd[k], 0);
+                // 主循环的处理间隔：每poll个字节取空一次队列
+                if(++bytes % poll == 0)
+                {
+                    while(USART3_Get_Line(buf, sizeof(buf)) > 0)
+                    {
+                        if(strncmp(buf, "CMD", 3) != 0 || (u32)atoi(buf + 3) != got) bad++;
+                        got++;
+                    }
+                }
+            }
+            sent++;
+        }
+        while(USART3_Get_Line(buf, sizeof(buf)) > 0)
+        {
+            if(strncmp(buf, "CMD", 3) != 0 || (u32)atoi(buf + 3) != got) bad++;
+            got++;
+        }
+    }
+    CHECK_EQ(got, sent);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(USART3_Get_Dropped(), dropped);
+}
+
+/**
+ * @brief  队列满时新行整行丢弃并计数，取走一行后恢复接收；'\r'被忽略，空行不入队
+ */
+static void test_queue_full(void)
+{
+    char line[8];
+    u32 dropped = USART3_Get_Dropped();
+    u8 i;
+
+    for(i = 0; i < USART3_LINE_QUEUE; i++)
+    {
+        sprintf(line, "L%u\r\n", i);
+        rx_str(line);
+    }
+    rx_str("\n\r\n");
+    CHECK_EQ(USART3_Line_Available(), USART3_LINE_QUEUE);
+    rx_str("LOST\n");
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 1);
+    expect_line("L0", 2);
+    rx_str("NEXT\n");
+    for(i = 1; i < USART3_LINE_QUEUE; i++)
+    {
+        sprintf(line, "L%u", i);
+        expect_line(line, strlen(line));
+    }
+    expect_line("NEXT", 4);
+    expect_line(0, 0);
+}
+
+/**
+ * @brief  超长行和溢出的行整行丢弃，下一行照常接收；取行时按缓冲区大小截断
+ */
+static void test_long_and_overrun(void)
+{
+    char line[USART3_LINE_LEN + 8];
+    u32 dropped = USART3_Get_Dropped();
+    char small[5];
+
+    memset(line, 'x', sizeof(line));
+    rx_bytes(line, USART3_LINE_LEN);
+    rx_str("\n");
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 1);
+    rx_bytes(line, USART3_LINE_LEN - 1);
+    rx_str("\n");
+    expect_line(line, USART3_LINE_LEN - 1);
+
+    rx_str("OVER");
+    rx_byte('R', 1);
+    rx_str("UN\nOK\n");
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 2);
+    expect_line("OK", 2);
+
+    rx_str("TRUNCATE\n");
+    CHECK_EQ(USART3_Get_Line(small, sizeof(small)), 4);
+    CHECK(strcmp(small, "TRUN") == 0);
+
+    rx_str("A\nB\n");
+    USART3_Flush_Lines();
+    CHECK_EQ(USART3_Line_Available(), 0);
+    expect_line(0, 0);
+}
+
+/**
+ * @brief  二进制帧：0x00 <数据> 0x00入队为0x00加数据，帧内'\r'、'\n'是数据；
+ *         重复的起始0x00重新开始一帧；截断文本行的0x00计为丢弃一行
+ */
+static void test_binary(void)
+{
+    static const u8 frame[] = {0x00, 0x11, '\n', 0x22, '\r', 0x33, 0x00};
+    static const u8 line[] = {0x00, 0x11, '\n', 0x22, '\r', 0x33};
+    u32 dropped = USART3_Get_Dropped();
+
+    rx_bytes(frame, sizeof(frame));
+    rx_str("TEXT\n");
+    expect_line(line, sizeof(line));
+    expect_line("TEXT", 4);
+
+    rx_byte(0x00, 0);
+    rx_bytes(frame, sizeof(frame));
+    expect_line(line, sizeof(line));
+    CHECK_EQ(USART3_Get_Dropped(), dropped);
+
+    // 文本行被游离的0x00截断
+    rx_str("HALF");
+    rx_bytes(frame, sizeof(frame));
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 1);
+    expect_line(line, sizeof(line));
+    expect_line(0, 0);
+}
+
+/**
+ * @brief  二进制帧被丢弃（溢出、超长、队列满）时跳到它的结束0x00，帧的剩余部分和
+ *         其后的文本都不被当作新帧
+ */
+static void test_binary_skip(void)
+{
+    u8 big[USART3_LINE_LEN + 4];
+    char line[8];
+    u32 dropped = USART3_Get_Dropped();
+    u8 i;
+
+    rx_byte(0x00, 0);
+    rx_byte(0x44, 0);
+    rx_byte(0x55, 1);
+    rx_bytes("\x66\x77", 2);
+    rx_byte(0x00, 0);
+    rx_str("AFTER\n");
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 1);
+    expect_line("AFTER", 5);
+
+    memset(big, 0x5A, sizeof(big));
+    big[0] = 0x00;
+    big[sizeof(big) - 1] = 0x00;
+    rx_bytes(big, sizeof(big));
+    rx_str("AFTER\n");
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 2);
+    expect_line("AFTER", 5);
+
+    for(i = 0; i < USART3_LINE_QUEUE; i++)
+    {
+        sprintf(line, "Q%u\n", i);
+        rx_str(line);
+    }
+    rx_bytes("\x00\x01\x02\x00", 4);
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 3);
+    USART3_Flush_Lines();
+    rx_str("AFTER\n");
+    expect_line("AFTER", 5);
+    expect_line(0, 0);
+    CHECK_EQ(USART3_Get_Dropped(), dropped + 3);
+}
+
+// DMA把发送环中已启动的数据全部送出，返回送出的字节数，内容追加到tx_out
+static u32 tx_drain(u32 at)
+{
+    return host_dma_drain(DMA1_Channel2, 2, DMA1_Channel2_IRQHandler, tx_out + at, sizeof(tx_out) - at);
+}
+
+/**
+ * @brief  接收一行的中途发送：u3_printf只写发送环，接收中的行完整到达；
+ *         每收一个字节发送一次并不时送出，收发内容都不串
+ */
+static void test_tx_during_rx(void)
+{
+    char expect_tx[64];
+    u32 n = 0, i;
+    u32 rx_dropped = USART3_Get_Dropped();
+    u32 tx_dropped = USART3_Get_TX_Dropped();
+    const char* cmd = "SET_TEMP_THRESHOLD 30 20";
+
+    tx_drain(0);
+    rx_str("STA");
+    CHECK_EQ(u3_printf("T:%d H:%d\r\n", 25, 60), 11);
+    n += tx_drain(n);
+    rx_str("TUS\n");
+    expect_line("STATUS", 6);
+    CHECK_EQ(n, 11);
+    CHECK(memcmp(tx_out, "T:25 H:60\r\n", 11) == 0);
+
+    // 逐字节交错：每个接收字节后入队一段回应，每4个字节送出一次
+    n = 0;
+    for(i = 0; cmd[i] != 0; i++)
+    {
+        rx_byte(cmd[i], 0);
+        u3_printf("<%c>", cmd[i]);
+        if(i % 4 == 3) n += tx_drain(n);
+    }
+    n += tx_drain(n);
+    rx_str("\r\n");
+    expect_line(cmd, strlen(cmd));
+    expect_line(0, 0);
+    CHECK_EQ(n, strlen(cmd) * 3);
+    for(i = 0; cmd[i] != 0; i++)
+    {
+        sprintf(expect_tx, "<%c>", cmd[i]);
+        if(memcmp(tx_out + i * 3, expect_tx, 3) != 0) break;
+    }
+    CHECK_EQ(i, strlen(cmd));
+    CHECK_EQ(USART3_Get_Dropped(), rx_dropped);
+    CHECK_EQ(USART3_Get_TX_Dropped(), tx_dropped);
+}
+
+/**
+ * @brief  发送环满：USART3_Write只接受剩余空间并把其余计入丢弃，u3_printf返回0；
+ *         送出后空间恢复，送出的字节与接受的字节一致（环内起点不为0，跨越环尾）
+ */
+static void test_tx_backpressure(void)
+{
+    static u8 data[USART3_TX_RING_LEN + 100];
+    u32 queued, dropped, n, i;
+
+    tx_drain(0);
+    CHECK_EQ(USART3_TX_Free(), USART3_TX_RING_LEN);
+    for(i = 0; i < sizeof(data); i++) data[i] = (u8)(i * 7 + 3);
+    queued = USART3_Get_TX_Queued();
+    dropped = USART3_Get_TX_Dropped();
+
+    CHECK_EQ(USART3_Write(data, 200), 200);
+    CHECK_EQ(USART3_TX_Free(), USART3_TX_RING_LEN - 200);
+    // DMA尚未完成：已启动的块也占着空间
+    CHECK_EQ(USART3_Write(data + 200, sizeof(data) - 200), USART3_TX_RING_LEN - 200);
+    CHECK_EQ(USART3_TX_Free(), 0);
+    CHECK_EQ(USART3_Get_TX_Dropped(), dropped + 100);
+    CHECK_EQ(u3_printf("FULL\r\n"), 0);
+    CHECK_EQ(USART3_Write(data, 1), 0);
+    CHECK_EQ(USART3_Get_TX_Dropped(), dropped + 100 + 6 + 1);
+    CHECK_EQ(USART3_Get_TX_Queued(), queued + USART3_TX_RING_LEN);
+
+    n = tx_drain(0);
+    CHECK_EQ(n, USART3_TX_RING_LEN);
+    CHECK(memcmp(tx_out, data, USART3_TX_RING_LEN) == 0);
+    CHECK_EQ(USART3_TX_Free(), USART3_TX_RING_LEN);
+
+    // 恢复后照常发送
+    CHECK_EQ(u3_printf("OK\r\n"), 4);
+    CHECK_EQ(tx_drain(0), 4);
+    CHECK(memcmp(tx_out, "OK\r\n", 4) == 0);
+    CHECK_EQ(USART3_Get_TX_Queued(), queued + USART3_TX_RING_LEN + 4);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief  入队吞吐量：典型状态行反复u3_printf，环快满时送出；不丢字节，
+ *         入队耗时远小于115200波特率下的发送时间
+ */
+static void test_tx_throughput(void)
+{
+    enum { CALLS = 20000 };
+    u32 dropped = USART3_Get_TX_Dropped();
+    u32 queued = USART3_Get_TX_Queued();
+    u32 bytes = 0, drained = 0, i;
+    double t0, t_enqueue = 0, wire_ns;
+
+    tx_drain(0);
+    for(i = 0; i < CALLS; i++)
+    {
+        if(USART3_TX_Free() < 64) drained += tx_drain(0);
+        t0 = now_ns();
+        bytes += u3_printf("T:%d H:%d L:%d F:%d\r\n", i % 50, i % 100, i % 101, i & 1);
+        t_enqueue += now_ns() - t0;
+    }
+    drained += tx_drain(0);
+    CHECK_EQ(drained, bytes);
+    CHECK_EQ(USART3_Get_TX_Queued(), queued + bytes);
+    CHECK_EQ(USART3_Get_TX_Dropped(), dropped);
+
+    wire_ns = bytes * 10 * 1e9 / 115200;
+    CHECK(t_enqueue < wire_ns);
+    if(getenv("HOST_VERBOSE"))
+        fprintf(stderr, "usart3: %u u3_printf, %lu bytes, %.0f ns/call, %.1f MB/s enqueue, %.0f ns/call on the wire at 115200\n",
+                CALLS, (unsigned long)bytes, t_enqueue / CALLS, bytes * 1e3 / t_enqueue, wire_ns / CALLS);
+}
+
+int main(void)
+{
+    test_burst();
+    test_queue_full();
+    test_long_and_overrun();
+    test_binary();
+    test_binary_skip();
+    test_tx_during_rx();
+    test_tx_backpressure();
+    test_tx_throughput();
+    return host_report("usart3");
+}
@@ -0,0 +1,269 @@
+/**
+ * @file   test_ws2812.c
+ * @brief  WS2812 DMA波形：已知帧编码后的BRR表与手算结果逐项一致；按TIM4的更新/CC1/CC3事件
+ *         驱动三个DMA通道合成PE6波形，每位周期、T0H/T1H、T0L/T1L和帧尾锁存低电平符合WS2812B时序，
+ *         由波形解出的位与发送的帧一致；锁存结束后才清除忙标志并调用完成回调
+ * @note   TIM4计数时钟72MHz；时序窗口取WS2812B手册的标称值±150ns，锁存低电平至少50us
+ */
+#include "host.h"
+#include "ws2812.h"
+#include <string.h>
+
+void DMA1_Channel5_IRQHandler(void);
+void TIM4_IRQHandler(void);
+
+#define P       RGB_LED         // 0码在T0H处写入BRR的值
+#define NS(t)   ((t) * 1000 / 72)
+
+// 手算：T0H = 25/72MHz = 347ns，T1H = 56/72MHz = 778ns，一位 = 90/72MHz = 1250ns，锁存 = 80us
+#define TICKS_T0H       25
+#define TICKS_T1H       56
+#define TICKS_BIT       90
+#define TICKS_LATCH     (80 * 72)
+
+/* ===== TIM4 + DMA1通道1/5/7 + PE6模型 ===== */
+
+static u8 pin;                              // PE6电平
+static u32 tick;                            // 72MHz时钟计数
+static u32 rise[RGB_FRAME_BITS + 1];        // 各上升沿时刻
+static u32 fall[RGB_FRAME_BITS + 1];        // 各下降沿时刻
+static u32 rises, falls;
+static u32 sent[8];                         // 各DMA通道本帧已传输的次数
+static u32 latch_end;                       // 锁存结束（TIM4更新中断）时刻
+static u32 done_calls;
+
+static void on_done(void)
+{
+    done_calls++;
+}
+
+static void gpio_write(u32 addr, u32 value)
+{
+    if(!(value & RGB_LED)) return;
+    if(addr == (u32)(uintptr_t)&GPIOE->BSRR && !pin)
+    {
+        pin = 1;
+        if(rises <= RGB_FRAME_BITS) rise[rises] = tick;
+        rises++;
+    }
+    if(addr == (u32)(uintptr_t)&GPIOE->BRR && pin)
+    {
+        pin = 0;
+        if(falls <= RGB_FRAME_BITS) fall[falls] = tick;
+        falls++;
+    }
+}
+
+/**
+ * @brief  TIM4的一个DMA请求：通道n使能且有剩余数据时传输一个半字，传输完成时置TC并调用中断
+ */
+static void dma_request(u16 dier, DMA_Channel_TypeDef* ch, u8 n, void (*irq)(void))
+{
+    const u16* mem = (const u16*)(uintptr_t)ch->CMAR;
+    u32 tc = (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << ((n - 1) * 4);
+    u16 value;
+
+    if(!(TIM4->CR1 & TIM_CR1_CEN) || !(TIM4->DIER & dier)) return;
+    if(!(ch->CCR & DMA_CCR1_EN) || ch->CNDTR == 0) return;
+    value = (ch->CCR & DMA_CCR1_MINC) ? mem[sent[n]] : mem[0];
+    *(volatile u32*)(uintptr_t)ch->CPAR = value;
+    gpio_write(ch->CPAR, value);
+    sent[n]++;
+    ch->CNDTR--;
+    if(ch->CNDTR == 0)
+    {
+        DMA1->ISR |= tc;
+        if((ch->CCR & DMA_CCR1_TCIE) && irq) irq();
+    }
+}
+
+/**
+ * @brief  在计数值cnt处发生一个定时器事件；中断处理函数重设计数器时返回1
+ */
+static u8 tim_event(u16 cnt, void (*event)(void))
+{
+    TIM4->CNT = cnt;
+    event();
+    return TIM4->CNT != cnt;
+}
+
+static void ev_cc1(void) { dma_request(TIM_DIER_CC1DE, DMA1_Channel1, 1, 0); }
+static void ev_cc3(void) { dma_request(TIM_DIER_CC3DE, DMA1_Channel5, 5, DMA1_Channel5_IRQHandler); }
+static void ev_update(void)
+{
+    dma_request(TIM_DIER_UDE, DMA1_Channel7, 7, 0);
+    if(TIM4->DIER & TIM_DIER_UIE)
+    {
+        TIM4->SR |= TIM_SR_UIF;
+        TIM4_IRQHandler();
+        latch_end = tick;
+    }
+}
+
+/**
+ * @brief  运行TIM4直到帧发送完成（忙标志清除）或超时
+ */
+static void run_frame(void)
+{
+    u32 base = tick, period;
+
+    memset(sent, 0, sizeof(sent));
+    rises = falls = 0;
+    latch_end = 0;
+    while(RGB_LED_Busy() && tick < base + 10 * TICKS_LATCH + RGB_DMA_BUF_LEN * TICKS_BIT)
+    {
+        if(!(TIM4->CR1 & TIM_CR1_CEN)) break;
+        period = TIM4->ARR + 1;
+        base = tick;
+        tick = base + TIM4->CCR1;
+        if(TIM4->CCR1 < period && tim_event(TIM4->CCR1, ev_cc1)) continue;
+        tick = base + TIM4->CCR3;
+        if(TIM4->CCR3 < period && tim_event(TIM4->CCR3, ev_cc3)) continue;
+        tick = base + period;
+        tim_event(0, ev_update);
+    }
+}
+
+/* ===== 测试 ===== */
+
+/**
+ * @brief  编码：占位项后每位一项，高位先发，1码为0、0码为引脚掩码；不写出len*8+1项之外
+ */
+static void test_encode(void)
+{
+    static const u8 frame_a[] = {0xFF, 0x00, 0xA5};
+    static const u16 golden_a[] =
+    {
+        P,
+        0, 0, 0, 0, 0, 0, 0, 0,             // 0xFF
+        P, P, P, P, P, P, P, P,             // 0x00
+        0, P, 0, P, P, 0, P, 0,             // 0xA5 = 1010 0101
+    };
+    static const u8 frame_b[] = {0x80, 0x01};
+    static const u16 golden_b[] =
+    {
+        P,
+        0, P, P, P, P, P, P, P,             // 0x80
+        P, P, P, P, P, P, P, 0,             // 0x01
+    };
+    u16 out[32];
+
+    memset(out, 0xEE, sizeof(out));
+    RGB_Encode_Frame(frame_a, sizeof(frame_a), P, out);
+    CHECK(memcmp(out, golden_a, sizeof(golden_a)) == 0);
+    CHECK_EQ(out[25], 0xEEEE);
+
+    memset(out, 0xEE, sizeof(out));
+    RGB_Encode_Frame(frame_b, sizeof(frame_b), P, out);
+    CHECK(memcmp(out, golden_b, sizeof(golden_b)) == 0);
+    CHECK_EQ(out[17], 0xEEEE);
+
+    memset(out, 0xEE, sizeof(out));
+    RGB_Encode_Frame(frame_a, 0, P, out);
+    CHECK_EQ(out[0], P);
+    CHECK_EQ(out[1], 0xEEEE);
+}
+
+/**
+ * @brief  检查一帧波形：每位的高电平宽度只有T0H/T1H两种，解出的位与frame一致；
+ *         最后一位拉低后保持低电平直到锁存结束
+ */
+static void check_waveform(const u8* frame)
+{
+    u32 i, high, low, bit, bad_bits = 0, bad_t0 = 0, bad_t1 = 0, t0 = 0, t1 = 0;
+
+    CHECK_EQ(rises, RGB_FRAME_BITS);
+    CHECK_EQ(falls, RGB_FRAME_BITS);
+    if(rises != RGB_FRAME_BITS || falls != RGB_FRAME_BITS) return;
+
+    for(i = 0; i < RGB_FRAME_BITS; i++)
+    {
+        high = fall[i] - rise[i];
+        low = (i + 1 < RGB_FRAME_BITS) ? rise[i + 1] - fall[i] : TICKS_BIT - high;
+        bit = (frame[i / 8] >> (7 - i % 8)) & 1;
+        if((high == TICKS_T1H) != bit) bad_bits++;
+        if(i + 1 < RGB_FRAME_BITS && rise[i + 1] - rise[i] != TICKS_BIT) bad_bits++;
+        if(bit)
+        {
+            t1++;
+            if(NS(high) < 650 || NS(high) > 950 || NS(low) < 300 || NS(low) > 600) bad_t1++;
+        }
+        else
+        {
+            t0++;
+            if(NS(high) < 250 || NS(high) > 550 || NS(low) < 700 || NS(low) > 1000) bad_t0++;
+        }
+    }
+    CHECK_EQ(bad_bits, 0);
+    CHECK_EQ(bad_t0, 0);
+    CHECK_EQ(bad_t1, 0);
+    CHECK(t0 > 0 && t1 > 0);
+
+    // 帧尾：最后一位的T1H拉低之后计时锁存，期间保持低电平
+    CHECK_EQ(pin, 0);
+    CHECK_EQ(latch_end - (rise[RGB_FRAME_BITS - 1] + TICKS_T1H), TICKS_LATCH);
+    CHECK(latch_end - fall[RGB_FRAME_BITS - 1] >= 50 * 72);
+}
+
+/**
+ * @brief  整帧经DMA发送：BRR表与手算一致，波形时序正确，锁存结束后清除忙标志并回调一次；
+ *         连续发送第二帧
+ */
+static void test_waveform(void)
+{
+    static u8 frame[RGB_FRAME_BYTES];
+    const u16* table;
+    u16 i;
+
+    RGB_LED_Init();
+    RGB_LED_Set_Done_Callback(on_done);
+    CHECK_EQ(TIM4->ARR, TICKS_BIT - 1);
+    CHECK_EQ(TIM4->CCR1, TICKS_T0H);
+    CHECK_EQ(TIM4->CCR3, TICKS_T1H);
+
+    frame[0] = 0xFF;
+    frame[1] = 0x00;
+    frame[2] = 0xA5;
+    for(i = 3; i < RGB_FRAME_BYTES; i++) frame[i] = (u8)(i * 37 + 11);
+    RGB_LED_Send_Frame(frame);
+    CHECK(RGB_LED_Busy());
+    CHECK_EQ(DMA1_Channel7->CNDTR, RGB_FRAME_BITS);
+    CHECK_EQ(DMA1_Channel1->CNDTR, RGB_DMA_BUF_LEN);
+    CHECK_EQ(DMA1_Channel5->CNDTR, RGB_DMA_BUF_LEN);
+
+    // 通道1的内存即BRR表：首个LED为test_encode中的帧
+    table = (const u16*)(uintptr_t)DMA1_Channel1->CMAR;
+    CHECK_EQ(table[0], P);
+    CHECK_EQ(table[1], 0);
+    CHECK_EQ(table[9], P);
+    CHECK_EQ(table[17], 0);
+    CHECK_EQ(table[18], P);
+    CHECK_EQ(table[24], 0);
+
+    run_frame();
+    CHECK(!RGB_LED_Busy());
+    CHECK_EQ(done_calls, 1);
+    CHECK_EQ(TIM4->CR1 & TIM_CR1_CEN, 0);
+    CHECK_EQ(TIM4->DIER & (TIM_DIER_UDE | TIM_DIER_CC1DE | TIM_DIER_CC3DE | TIM_DIER_UIE), 0);
+    check_waveform(frame);
+
+    // 第二帧：定时器周期恢复为一位
+    RGB_LED_Red();
+    CHECK_EQ(TIM4->ARR, TICKS_BIT - 1);
+    for(i = 0; i < RGB_LED_COUNT; i++)
+    {
+        frame[i * 3] = 0;
+        frame[i * 3 + 1] = 0xFF;
+        frame[i * 3 + 2] = 0;
+    }
+    run_frame();
+    CHECK_EQ(done_calls, 2);
+    check_waveform(frame);
+}
+
+int main(void)
+{
+    test_encode();
+    test_waveform();
+    return host_report("ws2812");
+}
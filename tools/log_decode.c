@@ -0,0 +1,250 @@
+/**
+ * @file   log_decode.c
+ * @brief  解码蓝牙日志导出流，打印记录或保存原始记录槽
+ *
+ * 用法: log_decode [-r raw.bin] [-q] [capture.bin]
+ *   capture.bin  串口/蓝牙收到的原始字节流（省略时读标准输入）
+ *   -r raw.bin   按导出顺序保存各记录槽的16字节原始数据
+ *   -q           不逐条打印记录，只打印统计
+ * 每条记录一行：pos,timestamp,type,字段...；压缩传感器记录展开为多行sensor。
+ * 结束时打印续传位置，断线后发送"EXPORT <pos>"继续导出；有校验错误时返回1
+ */
+#include "log_decode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint16_t LogDecode_Crc16(uint16_t crc, const uint8_t* data, size_t len)
+{
+    uint8_t b;
+
+    while(len--)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for(b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+uint8_t LogDecode_SlotValid(const uint8_t* slot)
+{
+    uint8_t crc = 0, i, b;
+
+    for(i = 0; i < LOG_DECODE_SLOT_SIZE - 1; i++)
+    {
+        crc ^= slot[i];
+        for(b = 0; b < 8; b++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    if(crc == 0xFF) crc = 0xFE;
+    return slot[LOG_DECODE_SLOT_SIZE - 1] == crc;
+}
+
+void LogDecode_Init(LogDecoder_t* dec, LogDecode_Frame_t frame, void* user)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->frame = frame;
+    dec->user = user;
+}
+
+static uint32_t LogDecode_U32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief  丢弃缓冲区首字节，从其后重新查找同步字
+ */
+static void LogDecode_Resync(LogDecoder_t* dec)
+{
+    uint8_t rest[LOG_DECODE_FRAME_MAX];
+    uint16_t n = dec->fill - 1;
+
+    memcpy(rest, dec->buf + 1, n);
+    dec->fill = 0;
+    dec->skipped++;
+    LogDecode_Feed(dec, rest, n);
+}
+
+void LogDecode_Feed(LogDecoder_t* dec, const uint8_t* data, size_t len)
+{
+    uint16_t need, crc;
+    uint8_t type, plen;
+
+    while(len--)
+    {
+        if(dec->fill == 0 && *data != LOG_DECODE_SYNC1)
+        {
+            dec->skipped++;
+            data++;
+            continue;
+        }
+        dec->buf[dec->fill++] = *data++;
+        if(dec->fill == 2 && dec->buf[1] != LOG_DECODE_SYNC2)
+        {
+            LogDecode_Resync(dec);
+            continue;
+        }
+        if(dec->fill < 4) continue;
+
+        type = dec->buf[2];
+        plen = dec->buf[3];
+        if((type != LOG_DECODE_DATA && type != LOG_DECODE_END) || plen > LOG_DECODE_PAYLOAD_MAX ||
+           plen % LOG_DECODE_SLOT_SIZE != 0 || (type == LOG_DECODE_END && plen != 0))
+        {
+            dec->crc_errors++;
+            LogDecode_Resync(dec);
+            continue;
+        }
+        need = LOG_DECODE_HEADER_LEN + plen + 2;
+        if(dec->fill < need) continue;
+
+        crc = LogDecode_Crc16(0xFFFF, dec->buf + 2, need - 4);
+        if((dec->buf[need - 2] | (dec->buf[need - 1] << 8)) != crc)
+        {
+            dec->crc_errors++;
+            LogDecode_Resync(dec);
+            continue;
+        }
+        dec->frames++;
+        dec->fill = 0;
+        if(dec->frame)
+            dec->frame(dec->user, type, LogDecode_U32(dec->buf + 4), dec->buf + LOG_DECODE_HEADER_LEN, plen);
+    }
+}
+
+#ifndef LOG_DECODE_NO_MAIN
+
+typedef struct
+{
+    FILE* raw;
+    int quiet;
+    uint32_t records;
+    uint32_t next_pos;      // 续传位置
+    int ended;
+} LogDecodeOut_t;
+
+#define PACK_DT(d)      (((d) & 0x0F) + 1)
+#define PACK_DTEMP(d)   ((int8_t)((((d) >> 4) & 0x07) ^ 0x04) - 4)
+#define PACK_DHUMI(d)   ((int8_t)((((d) >> 7) & 0x0F) ^ 0x08) - 8)
+#define PACK_DLIGHT(d)  ((int8_t)((((d) >> 11) & 0x1F) ^ 0x10) - 16)
+
+static void LogDecode_PrintSlot(uint32_t pos, const uint8_t* s)
+{
+    uint32_t ts = LogDecode_U32(s);
+    int temp, humi, light, i;
+    uint16_t d;
+
+    switch(s[4])
+    {
+        case 0x01:
+            printf("0x%08X,%u,sensor,%u,%u,%u,fan=%u,pump=%u,light=%u,mode=%u,alarms=0x%02X\n",
+                   pos, ts, s[5], s[6], s[7], s[8], s[9], s[10], s[11], s[12]);
+            break;
+        case 0x05:
+            // 压缩记录：第一个样本完整保存，其后为16位增量（0xFFFF未使用）
+            temp = s[5];
+            humi = s[6] & 0x7F;
+            light = s[7] & 0x7F;
+            for(i = 0; i < 4; i++)
+            {
+                if(i > 0)
+                {
+                    d = s[9 + (i - 1) * 2] | (s[10 + (i - 1) * 2] << 8);
+                    if(d == 0xFFFF) break;
+                    ts += PACK_DT(d);
+                    temp += PACK_DTEMP(d);
+                    humi += PACK_DHUMI(d);
+                    light += PACK_DLIGHT(d);
+                }
+                printf("0x%08X,%u,sensor,%d,%d,%d,fan=%u,pump=%u,light=%u,mode=%u,alarms=0x%02X\n",
+                       pos, ts, temp, humi, light, s[6] >> 7, s[7] >> 7, (s[8] >> 6) & 1, s[8] >> 7, s[8] & 0x3F);
+            }
+            break;
+        case 0x02:
+            printf("0x%08X,%u,operation,op=%u,old=%u,new=%u,trigger=%u\n", pos, ts, s[5], s[6], s[7], s[8]);
+            break;
+        case 0x03:
+            printf("0x%08X,%u,alarm,type=%u,level=%u,value=%u,threshold=%u\n", pos, ts, s[5], s[6], s[7], s[8]);
+            break;
+        case 0x04:
+            printf("0x%08X,%u,system,%u,%u,%u\n", pos, ts, s[5], s[6], s[7]);
+            break;
+        default:
+            printf("0x%08X,%u,unknown(0x%02X)\n", pos, ts, s[4]);
+            break;
+    }
+}
+
+static void LogDecode_Frame(void* user, uint8_t type, uint32_t pos, const uint8_t* payload, uint8_t len)
+{
+    LogDecodeOut_t* out = (LogDecodeOut_t*)user;
+    uint8_t i, n = len / LOG_DECODE_SLOT_SIZE;
+
+    if(type == LOG_DECODE_END)
+    {
+        out->ended = 1;
+        out->next_pos = pos;
+        return;
+    }
+    for(i = 0; i < n; i++)
+    {
+        const uint8_t* s = payload + i * LOG_DECODE_SLOT_SIZE;
+        if(out->raw) fwrite(s, 1, LOG_DECODE_SLOT_SIZE, out->raw);
+        if(!out->quiet)
+        {
+            if(LogDecode_SlotValid(s)) LogDecode_PrintSlot(pos + i, s);
+            else printf("0x%08X,commit mismatch\n", pos + i);
+        }
+    }
+    out->records += n;
+    out->next_pos = pos + n;
+}
+
+int main(int argc, char** argv)
+{
+    LogDecoder_t dec;
+    LogDecodeOut_t out;
+    FILE* in = stdin;
+    uint8_t buf[4096];
+    size_t n;
+    int i;
+
+    memset(&out, 0, sizeof(out));
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            out.raw = fopen(argv[++i], "wb");
+            if(out.raw == 0) { perror(argv[i]); return 2; }
+        }
+        else if(strcmp(argv[i], "-q") == 0)
+        {
+            out.quiet = 1;
+        }
+        else if(argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: %s [-r raw.bin] [-q] [capture.bin]\n", argv[0]);
+            return 2;
+        }
+        else
+        {
+            in = fopen(argv[i], "rb");
+            if(in == 0) { perror(argv[i]); return 2; }
+        }
+    }
+
+    LogDecode_Init(&dec, LogDecode_Frame, &out);
+    while((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        LogDecode_Feed(&dec, buf, n);
+    if(out.raw) fclose(out.raw);
+
+    fprintf(stderr, "%u frames, %u records, %u bad frames, %u stray bytes\n",
+            dec.frames, out.records, dec.crc_errors, dec.skipped);
+    if(out.ended) fprintf(stderr, "export complete at 0x%08X\n", out.next_pos);
+    else if(dec.frames > 0) fprintf(stderr, "export interrupted, resume with: EXPORT 0x%08X\n", out.next_pos);
+    return dec.crc_errors ? 1 : 0;
+}
+
+#endif
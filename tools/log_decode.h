@@ -0,0 +1,41 @@
+/**
+ * @file   log_decode.h
+ * @brief  日志二进制导出流（EXPORT命令）的PC端解码
+ * @note   帧格式见APP/data_logger/log_export.h，记录槽格式见APP/data_logger/data_logger.h
+ */
+#ifndef _log_decode_H
+#define _log_decode_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_DECODE_SYNC1        0xA5
+#define LOG_DECODE_SYNC2        0x5A
+#define LOG_DECODE_DATA         0x01
+#define LOG_DECODE_END          0x02
+#define LOG_DECODE_HEADER_LEN   8
+#define LOG_DECODE_SLOT_SIZE    16
+#define LOG_DECODE_PAYLOAD_MAX  (8 * LOG_DECODE_SLOT_SIZE)
+#define LOG_DECODE_FRAME_MAX    (LOG_DECODE_HEADER_LEN + LOG_DECODE_PAYLOAD_MAX + 2)
+
+// 收到一个校验正确的帧
+typedef void (*LogDecode_Frame_t)(void* user, uint8_t type, uint32_t pos,
+                                  const uint8_t* payload, uint8_t len);
+
+typedef struct
+{
+    LogDecode_Frame_t frame;
+    void* user;
+    uint8_t buf[LOG_DECODE_FRAME_MAX];
+    uint16_t fill;
+    uint32_t frames;        // 校验正确的帧数
+    uint32_t crc_errors;    // 校验错误或长度非法而丢弃的帧数
+    uint32_t skipped;       // 帧外丢弃的字节数
+} LogDecoder_t;
+
+void LogDecode_Init(LogDecoder_t* dec, LogDecode_Frame_t frame, void* user);
+void LogDecode_Feed(LogDecoder_t* dec, const uint8_t* data, size_t len);
+uint16_t LogDecode_Crc16(uint16_t crc, const uint8_t* data, size_t len);
+uint8_t LogDecode_SlotValid(const uint8_t* slot);   // 提交字节是否与前15字节的CRC-8相符
+
+#endif